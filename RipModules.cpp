@@ -5,6 +5,11 @@
 #include "modules/candyadv.h"
 #include "modules/humongous.h"
 #include "modules/legoisland.h"
+#include "utils/MembufStream.h"
+#include "utils/IsoImage.h"
+#include <fstream>
+#include <algorithm>
+#include <cstring>
 
 namespace Ripper
 {
@@ -12,26 +17,36 @@ namespace Ripper
 
 RipModules::RipModules()
 {
+	// formats that may be XOR encoded have no fixed magic bytes:
+	// their check_header tries the encodings instead
 	#ifdef ENABLE_INDIAN
-	rippers.push_back(new IndCup::IndianRip());
+	add_module(new IndCup::IndianRip(), ModuleSignature(5));
 	#endif
 	#ifdef ENABLE_MOHAWK
-	rippers.push_back(new Mohawk::MohawkRip());
+	add_module(new Mohawk::MohawkRip(), ModuleSignature(12));
 	#endif
 	#ifdef ENABLE_ATLAS
-	rippers.push_back(new Atlas::AtlasRip());
+	add_module(new Atlas::AtlasRip(), ModuleSignature(68));
 	#endif
 	#ifdef ENABLE_CANDYADV
-	rippers.push_back(new CandyAdv::CandyAdvRip());
+	add_module(new CandyAdv::CandyAdvRip(),
+		ModuleSignature(17, 0, std::string(CandyAdv::cndadv_chunkid, 4)));
 	#endif
 	#ifdef ENABLE_HUMONGOUS
-	rippers.push_back(new Humongous::HERip());
+	add_module(new Humongous::HERip(), ModuleSignature(16));
 	#endif
 	#ifdef ENABLE_LEGOISLAND
-	rippers.push_back(new LegoIsland::LegoIslandRip());
+	add_module(new LegoIsland::LegoIslandRip(),
+		ModuleSignature(16, 0, std::string(LegoIsland::RIFF_hd, 4)));
 	#endif
 }
 
+void RipModules::add_module(RipModule* mod, const ModuleSignature& sig)
+{
+	rippers.push_back(mod);
+	signatures.push_back(sig);
+}
+
 RipModules::~RipModules()
 {
 	for (int i = 0; i < rippers.size(); i++)
@@ -48,6 +63,61 @@ int RipModules::num_mods()
 	return rippers.size();
 }
 
+void RipModules::detect(const std::string& filename,
+	const RipperFormats::RipperSettings& ripset, std::vector<int>& candidates)
+{
+	// a file in a disc image is already in memory
+	RipUtil::IsoImage* image;
+	const RipUtil::IsoEntry* entry;
+	if (RipUtil::find_image_file(filename, image, entry))
+	{
+		int len = std::min(entry->size, DetectConsts::header_size);
+		std::vector<char> header(len + 1);
+		image->copy_data(*entry, 0, len, &header.front());
+		detect(&header.front(), len, entry->size, ripset, candidates);
+		return;
+	}
+
+	std::ifstream ifs(filename.c_str(), std::ios_base::binary);
+	if (!ifs.good())
+		throw(RipUtil::FileOpenException(filename));
+	ifs.seekg(0, ifs.end);
+	int fsize = static_cast<int>(ifs.tellg());
+	ifs.seekg(0, ifs.beg);
+
+	char header[DetectConsts::header_size];
+	int len = std::min(fsize, DetectConsts::header_size);
+	ifs.read(header, len);
+	len = ifs.gcount();
+	detect(header, len, fsize, ripset, candidates);
+}
+
+void RipModules::detect(const char* header, int len, int fsize,
+	const RipperFormats::RipperSettings& ripset, std::vector<int>& candidates)
+{
+	for (int i = 0; i < (int)rippers.size(); i++)
+	{
+		if (matches_signature(i, header, len, fsize, ripset))
+			candidates.push_back(i);
+	}
+}
+
+bool RipModules::matches_signature(int n, const char* header, int len, int fsize,
+	const RipperFormats::RipperSettings& ripset)
+{
+	const ModuleSignature& sig = signatures[n];
+	// check_header can rely on getting minsize bytes, up to header_size
+	if (fsize < sig.minsize || len < std::min(sig.minsize, DetectConsts::header_size))
+		return false;
+	if (!sig.magic.empty())
+	{
+		if (sig.offset + (int)sig.magic.size() > len
+			|| std::memcmp(header + sig.offset, sig.magic.c_str(), sig.magic.size()) != 0)
+			return false;
+	}
+	return rippers[n]->check_header(header, len, fsize, ripset);
+}
+
 
 
 };	// end namespace Ripper
\ No newline at end of file
@@ -1,6 +1,7 @@
 /*	Definitions for enabled rip modules */
 
 #include "modules/RipModule.h"
+#include <string>
 #include <vector>
 
 class RipModule;
@@ -9,6 +10,23 @@ namespace Ripper
 {
 
 
+namespace DetectConsts
+{
+	// bytes read from the start of a file to detect its format
+	const static int header_size = 64;
+};
+
+// what a module's files look like from the outside
+struct ModuleSignature
+{
+	ModuleSignature(int minsize, int offset = 0, const std::string& magic = "")
+		: minsize(minsize), offset(offset), magic(magic) { };
+
+	int minsize;			// smallest file the module accepts
+	int offset;				// position of magic in the file
+	std::string magic;		// bytes every file has at offset (empty if none)
+};
+
 class RipModules
 {
 public:
@@ -17,8 +35,22 @@ public:
 	
 	int num_mods();
 	RipModule* operator[](int n);
+
+	// read the start of filename once and put the modules that could
+	// rip it in candidates, in module order
+	void detect(const std::string& filename, const RipperFormats::RipperSettings& ripset,
+		std::vector<int>& candidates);
+	// the same, given the first len bytes of an input of fsize bytes
+	void detect(const char* header, int len, int fsize,
+		const RipperFormats::RipperSettings& ripset, std::vector<int>& candidates);
+	// could module n rip a file of fsize bytes starting with header?
+	bool matches_signature(int n, const char* header, int len, int fsize,
+		const RipperFormats::RipperSettings& ripset);
 private:
+	void add_module(RipModule* mod, const ModuleSignature& sig);
+
 	std::vector<RipModule*> rippers;
+	std::vector<ModuleSignature> signatures;
 };
 
 
@@ -4,10 +4,12 @@
 #include "utils/MembufStream.h"
 #include "utils/IMAADPCMDecoder.h"
 #include "utils/BitmapData.h"
+#include "utils/DefaultException.h"
 #include "modules/common.h"
 
 #include <string>
 #include <cstring>
+#include <cctype>
 #include <vector>
 
 using namespace RipUtil;
@@ -30,6 +32,39 @@ void format_PCMData(RipUtil::PCMData& dat, const RipperSettings& ripset)
 		dat.set_end(ripset.audend);
 }
 
+void parse_selector(const std::string& spec, AssetSelector& sel)
+{
+	sel.clear();
+	std::string::size_type pos = 0;
+	while (pos < spec.size())
+	{
+		std::string::size_type end = spec.find(',', pos);
+		if (end == std::string::npos)
+			end = spec.size();
+		std::string pair = spec.substr(pos, end - pos);
+		std::string::size_type eq = pair.find('=');
+		if (eq == std::string::npos || eq == 0)
+			throw(DefaultException("bad -select spec \"" + spec
+				+ "\" (expected key=value,key=value...)"));
+		std::string key = pair.substr(0, eq);
+		for (std::string::size_type i = 0; i < key.size(); i++)
+			key[i] = std::tolower(key[i]);
+		sel[key] = pair.substr(eq + 1);
+		pos = end + 1;
+	}
+}
+
+int get_selector_int(const AssetSelector& sel, const std::string& key)
+{
+	AssetSelector::const_iterator it = sel.find(key);
+	if (it == sel.end())
+		return RipConsts::not_set;
+	const std::string& val = (*it).second;
+	if (val.empty() || val.find_first_not_of("0123456789") != std::string::npos)
+		throw(DefaultException("-select " + key + " must be a number, not \"" + val + "\""));
+	return from_string<int>(val);
+}
+
 
 };	// end namespace Ripper
 
@@ -3,11 +3,13 @@
 #include "utils/MembufStream.h"
 #include "utils/PCMData.h"
 #include "utils/BitmapData.h"
+#include "utils/ShardedOutputSink.h"
 #include "utils/DatManip.h"
 
 #include <string>
 #include <cstring>
 #include <vector>
+#include <map>
 
 namespace RipperFormats {
 
@@ -36,6 +38,23 @@ namespace RipConsts
 	const static double default_loop_silence = 1.0;
 	// default looping style
 	const static RipUtil::PCMData::LoopStyle default_loopstyle = RipUtil::PCMData::fadeloop;
+	// default audio output format
+	const static RipUtil::PCMData::AudioFormat default_audioformat = RipUtil::PCMData::waveformat;
+	// default image output format
+	const static RipUtil::BitmapData::ImageFormat default_imageformat = RipUtil::BitmapData::bmpformat;
+	// default number of encoder threads (0 = one per hardware thread)
+	const static int default_threads = 0;
+	// default number of background I/O threads (0 = write synchronously)
+	const static int default_io_threads = 0;
+	// default limit on output waiting for the I/O threads (MB)
+	const static int default_write_queue = 64;
+	// default output directory layout
+	const static RipUtil::ShardedOutputSink::ShardLayout default_shardlayout
+		= RipUtil::ShardedOutputSink::flatlayout;
+	// default number of inputs ripped at once in batch mode
+	const static int default_jobs = 1;
+	// default limit on the input held in memory by all batch workers (MB)
+	const static int default_batch_memory = 1024;
 	// a really crappy attempt to stave off magic constants
 	const static int not_set = -1;
 
@@ -57,9 +76,19 @@ public:
 		ripstrings(true), 
 		ripdata(false),
 		bufsize(RipConsts::default_bufsize),
+		threads(RipConsts::default_threads),
+		iothreads(RipConsts::default_io_threads),
+		writequeue(RipConsts::default_write_queue),
+		iouring(false), dryrun(false), incremental(false),
+		resume(false), listcontents(false), index(false), jobs(RipConsts::default_jobs),
+		batchmemory(RipConsts::default_batch_memory),
+		workshard(0), workshards(1), maxmemory(RipConsts::not_set),
+		shardlayout(RipConsts::default_shardlayout),
+		shardfanout(RipUtil::ShardConsts::default_fanout),
 		startentry(RipConsts::not_set), endentry(RipConsts::not_set),
 		guesspalettes(true), palettenum(RipConsts::not_set),
 		backgroundcolor(0xFF00FF),
+		imageformat(RipConsts::default_imageformat),
 		normalize(false),
 		audsign(DatManip::has_nosign), audend(DatManip::le),
 		channels(RipConsts::not_set), samprate(RipConsts::not_set), 
@@ -68,7 +97,8 @@ public:
 		loopstyle(RipConsts::default_loopstyle),
 		loopfadelen(RipConsts::default_loop_fade),
 		loopfadesil(RipConsts::default_loop_silence),
-		decode_audio(false) { };
+		decode_audio(false),
+		audioformat(RipConsts::default_audioformat) { };
 
 	// command line params for use by individual modules
 	int argc;
@@ -76,6 +106,8 @@ public:
 
 	// general
 	std::string outpath;	// output file path/prefix
+	std::string archive;	// if set, write all output into this .tar/.zip
+	std::string checksum;	// if set, write a manifest of output hashes here instead of the output
 	bool ripallraw;			// output raw files with no decoding
 	bool copycommon;		// copy common formats directly to output
 	int encoding;			// XOR decryption byte
@@ -85,13 +117,32 @@ public:
 	bool ripstrings;		// rip text strings?
 	bool ripdata;			// rip other (nondecodable) data?
 	int bufsize;			// size of input read buffer
+	int threads;			// number of threads for parallel encoding
+	int iothreads;			// number of background output threads
+	int writequeue;			// max MB of output waiting to be written
+	bool iouring;			// write plain files through batched io_uring?
+	bool dryrun;			// decode and encode everything, but discard the output?
+	bool incremental;		// skip assets whose output from the last run is current?
+	bool resume;			// journal finished units, and skip those an interrupted run finished?
+	bool listcontents;		// list what each input contains instead of ripping it?
+	bool index;				// save each input's contents next to it, and use them on later runs?
+	std::string indexdir;	// if set, save and use contents indexes here instead
+	int jobs;				// number of inputs ripped at once in batch mode
+	int batchmemory;		// max MB of input held by all batch workers at once
+	int workshard;			// this process's share of the work (from 0), when split
+	int workshards;			// over this many processes with --shard
+	int maxmemory;			// if set, MB of memory the run keeps within (see MemoryBudget.h)
+	RipUtil::ShardedOutputSink::ShardLayout shardlayout;	// output subdirectory layout (-layout)
+	int shardfanout;		// number of directories for the hash layout
 	int startentry;			// ignore all graphics entries before this number
 	int endentry;			// ignore all graphics entries after this number
+	std::string select;		// if set, rip only the one asset it names (see parse_selector())
 
 	// graphics
 	bool guesspalettes;		// if set, guess palettes; otherwise, use grayscale
 	int palettenum;			// if set, color all graphics with this palette
 	int backgroundcolor;	// value to be used as background/transparent fill (BGR)
+	RipUtil::BitmapData::ImageFormat imageformat;	// output format for graphics
 
 	// audio
 	DatManip::Sign audsign;	// sample signedness
@@ -107,6 +158,7 @@ public:
 	double loopfadelen;		// loop fade length
 	double loopfadesil;		// trailing silence for fade loops
 	bool decode_audio;		// decode audio where unnecessary, but possible?
+	RipUtil::PCMData::AudioFormat audioformat;	// output format for audio
 };
 
 // container for results of ripping
@@ -124,6 +176,18 @@ struct RipResults
 	int strings_ripped;
 	int palettes_ripped;
 	int data_ripped;
+
+	// add the counts of another rip to these
+	void add(const RipResults& r)
+	{
+		graphics_ripped += r.graphics_ripped;
+		animations_ripped += r.animations_ripped;
+		animation_frames_ripped += r.animation_frames_ripped;
+		audio_ripped += r.audio_ripped;
+		strings_ripped += r.strings_ripped;
+		palettes_ripped += r.palettes_ripped;
+		data_ripped += r.data_ripped;
+	}
 };
 
 // container for file format info
@@ -136,6 +200,21 @@ struct FileFormatData
 	int encoding;			// XOR decryption byte
 };
 
+// an entry in the listing of a file's contents
+struct ContentsEntry
+{
+	ContentsEntry(int dep = 0, const std::string& typ = "", int off = 0, int sz = 0,
+		int idnum = RipConsts::not_set, const std::string& nm = "")
+		: depth(dep), type(typ), offset(off), size(sz), id(idnum), name(nm) { };
+
+	int depth;				// nesting level in the file's structure
+	std::string type;		// chunk or resource type
+	int offset;				// address in the file
+	int size;				// length in bytes
+	int id;					// resource ID, if it has one
+	std::string name;		// resource name or description, if it has one
+};
+
 // check for recognized data formats and return format info
 //  FileFormatData check_file_format(const std::string& filename, 
 //	int bufsize = default_bufsize);
@@ -143,6 +222,17 @@ struct FileFormatData
 // format a PCMData object according to a RipperSettings object
 void format_PCMData(RipUtil::PCMData& dat, const RipperSettings& ripset);
 
+// an asset named with -select, as key=value pairs ("room=12,akos=345");
+// what keys there are is up to the module ripping it
+typedef std::map<std::string, std::string> AssetSelector;
+
+// split the -select spec into sel; throws DefaultException if it's malformed
+void parse_selector(const std::string& spec, AssetSelector& sel);
+
+// the value of key in sel as a number, or RipConsts::not_set if
+// it isn't there; throws DefaultException if it isn't a number
+int get_selector_int(const AssetSelector& sel, const std::string& key);
+
 
 };	// end namespace Ripper
 
@@ -0,0 +1,281 @@
+#include "benchmark.h"
+#include "utils/DatManip.h"
+#include "utils/BitmapData.h"
+#include "utils/OutputSink.h"
+#include "utils/UringOutputSink.h"
+#include "utils/ArchiveOutputSink.h"
+#include "utils/ShardedOutputSink.h"
+#include "utils/InputFiles.h"
+#include "utils/MembufStream.h"
+#include "RipModules.h"
+#include "RipperFormats.h"
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+#include <set>
+
+using std::cout;
+using namespace RipUtil;
+
+namespace BenchmarkConsts
+{
+	const static int default_frames = 20000;
+	const static int default_width = 64;
+	const static int default_height = 64;
+	// distinct frames to cycle through
+	const static int frame_variants = 16;
+};
+
+// write every frame through sink, returning the wall time taken
+static double time_output(OutputSink& sink, std::vector<BitmapData>& frames,
+	const std::vector<std::string>& names)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < names.size(); i++)
+		frames[i % frames.size()].write(sink, names[i], BitmapData::bmpformat);
+	sink.flush();
+	return std::chrono::duration<double>(
+		std::chrono::steady_clock::now() - start).count();
+}
+
+static void print_rate(const std::string& backend, int files, long long bytes, double secs)
+{
+	if (secs <= 0)
+		secs = 1e-9;
+	cout << backend << ": " << files << " files, " << bytes << " bytes in "
+		<< secs << " secs (" << files / secs << " files/sec, "
+		<< bytes / secs / 1000000 << " MB/sec)" << '\n';
+}
+
+// names of the frames written by one backend, numbered like the
+// output of a ripper (rooms of 1000 images in costumes of 100)
+static std::vector<std::string> frame_names(const std::string& dir,
+	const std::string& backend, int numframes)
+{
+	std::vector<std::string> names;
+	for (int i = 0; i < numframes; i++)
+	{
+		names.push_back(dir + "/" + backend + "-room-" + to_string(i / 1000)
+			+ "-akos-" + to_string((i / 100) % 10) + "-im-" + to_string(i % 100));
+	}
+	return names;
+}
+
+static void remove_frames(const std::vector<std::string>& names)
+{
+	for (size_t i = 0; i < names.size(); i++)
+		std::remove((names[i] + ".bmp").c_str());
+}
+
+// remove frames written through a sharded sink, and the directories
+// it created
+static void remove_sharded_frames(const ShardedOutputSink& sink,
+	const std::string& dir, const std::vector<std::string>& names)
+{
+	std::set<std::string> dirs;
+	for (size_t i = 0; i < names.size(); i++)
+	{
+		std::string name = sink.get_shard_name(names[i] + ".bmp");
+		std::remove(name.c_str());
+		for (std::string::size_type slash = name.find_last_of('/');
+			slash != std::string::npos && slash > dir.length();
+			slash = name.find_last_of('/', slash - 1))
+			dirs.insert(name.substr(0, slash));
+	}
+	// children sort after their parents
+	for (std::set<std::string>::reverse_iterator it = dirs.rbegin(); it != dirs.rend(); ++it)
+		std::remove(it->c_str());
+}
+
+int run_output_benchmark(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		cout << "usage: " << argv[0]
+			<< " --benchmark_output <dir> [frames] [width] [height]" << '\n';
+		return 1;
+	}
+	std::string dir = argv[2];
+	int numframes = (argc > 3) ? from_string<int>(argv[3]) : BenchmarkConsts::default_frames;
+	int width = (argc > 4) ? from_string<int>(argv[4]) : BenchmarkConsts::default_width;
+	int height = (argc > 5) ? from_string<int>(argv[5]) : BenchmarkConsts::default_height;
+
+	// 8-bit palettized frames with some variation between them
+	std::vector<BitmapData> frames;
+	for (int i = 0; i < BenchmarkConsts::frame_variants; i++)
+	{
+		BitmapData frame(width, height, 8, true);
+		for (int j = 0; j < 256; j++)
+			frame.get_palette()[j] = (j * 0x010203 + i) & 0xFFFFFF;
+		int* pixels = frame.get_pixels();
+		for (int j = 0; j < width * height; j++)
+			pixels[j] = (j * 7 + i * 13 + j / width) & 0xFF;
+		frames.push_back(frame);
+	}
+	long long framebytes = 0;
+	{
+		// size of one encoded frame
+		std::vector<std::string> names = frame_names(dir, "size", 1);
+		FileOutputSink sink;
+		frames[0].write(sink, names[0], BitmapData::bmpformat);
+		framebytes = sink.get_file_size();
+		remove_frames(names);
+	}
+	long long totalbytes = framebytes * numframes;
+
+	cout << "Writing " << numframes << " " << width << "x" << height
+		<< " frames to " << dir << '\n';
+
+	// FileOutputSink (stdio, or mmap for files of mmap_min_size and up),
+	// one open/write/close per file
+	{
+		std::vector<std::string> names = frame_names(dir, "stream", numframes);
+		FileOutputSink sink;
+		print_rate("stdio/mmap", numframes, totalbytes, time_output(sink, frames, names));
+		remove_frames(names);
+	}
+
+	// FileOutputSink into per-resource and hashed subdirectories
+	{
+		std::vector<std::string> names = frame_names(dir, "resource", numframes);
+		FileOutputSink file;
+		ShardedOutputSink sink(file, ShardedOutputSink::resourcelayout);
+		print_rate("stdio/mmap, resource dirs", numframes, totalbytes,
+			time_output(sink, frames, names));
+		remove_sharded_frames(sink, dir, names);
+	}
+	{
+		std::vector<std::string> names = frame_names(dir, "hash", numframes);
+		FileOutputSink file;
+		ShardedOutputSink sink(file, ShardedOutputSink::hashlayout);
+		print_rate("stdio/mmap, " + to_string(ShardConsts::default_fanout) + " hash dirs",
+			numframes, totalbytes, time_output(sink, frames, names));
+		remove_sharded_frames(sink, dir, names);
+	}
+
+	// batched io_uring submissions
+	{
+		std::vector<std::string> names = frame_names(dir, "uring", numframes);
+		UringOutputSink sink;
+		double secs = time_output(sink, frames, names);
+		print_rate(sink.using_uring() ? "io_uring" : "io_uring (unavailable, fallback)",
+			numframes, totalbytes, secs);
+		remove_frames(names);
+	}
+
+	// single archives
+	const char* archives[] = { "tar", "zip" };
+	for (int i = 0; i < 2; i++)
+	{
+		std::string archivename = dir + "/benchmark." + archives[i];
+		std::vector<std::string> names = frame_names(dir, archives[i], numframes);
+		ArchiveOutputSink* sink = create_archive_sink(archivename);
+		double secs = time_output(*sink, frames, names);
+		print_rate(archives[i], numframes, sink->get_archive_size(), secs);
+		delete sink;
+		std::remove(archivename.c_str());
+	}
+
+	return 0;
+}
+
+static void print_detect_rate(const std::string& method, int files, int recognized, double secs)
+{
+	if (secs <= 0)
+		secs = 1e-9;
+	cout << method << ": " << files << " files, " << recognized << " recognized in "
+		<< secs << " secs (" << files / secs << " files/sec)" << '\n';
+}
+
+// detect the way the ripper used to: load each file, then run every
+// module's can_rip, reopening the file in between
+static double time_detect_all(Ripper::RipModules& mods, const std::vector<std::string>& files,
+	const RipperFormats::RipperSettings& ripset, int& recognized)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < files.size(); i++)
+	{
+		try
+		{
+			MembufStream stream(files[i], MembufStream::rb);
+			for (int j = 0; j < mods.num_mods(); j++)
+			{
+				RipperFormats::FileFormatData fmtdat;
+				if (mods[j]->can_rip(stream, ripset, fmtdat))
+					++recognized;
+				stream.reset();
+			}
+		}
+		catch (std::exception&)
+		{
+
+		}
+	}
+	return std::chrono::duration<double>(
+		std::chrono::steady_clock::now() - start).count();
+}
+
+// detect through the signature registry: read each header once, and
+// load the file only for the modules it matches
+static double time_detect_registry(Ripper::RipModules& mods, const std::vector<std::string>& files,
+	const RipperFormats::RipperSettings& ripset, int& recognized)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < files.size(); i++)
+	{
+		try
+		{
+			std::vector<int> candidates;
+			mods.detect(files[i], ripset, candidates);
+			if (candidates.empty())
+				continue;
+			MembufStream stream(files[i], MembufStream::rb);
+			for (size_t j = 0; j < candidates.size(); j++)
+			{
+				RipperFormats::FileFormatData fmtdat;
+				if (mods[candidates[j]]->can_rip(stream, ripset, fmtdat))
+					++recognized;
+				stream.rewind();
+			}
+		}
+		catch (std::exception&)
+		{
+
+		}
+	}
+	return std::chrono::duration<double>(
+		std::chrono::steady_clock::now() - start).count();
+}
+
+int run_detect_benchmark(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		cout << "usage: " << argv[0] << " --benchmark_detect <inputs...>" << '\n';
+		return 1;
+	}
+	std::vector<std::string> files;
+	for (int i = 2; i < argc; i++)
+		collect_input_files(argv[i], files);
+
+	Ripper::RipModules mods;
+	RipperFormats::RipperSettings ripset;
+	cout << "Detecting formats of " << files.size() << " files with "
+		<< mods.num_mods() << " modules" << '\n';
+
+	// the first pass also brings the files into the page cache,
+	// so run it once untimed
+	int recognized = 0;
+	time_detect_all(mods, files, ripset, recognized);
+
+	recognized = 0;
+	double secs = time_detect_all(mods, files, ripset, recognized);
+	print_detect_rate("can_rip on every module", files.size(), recognized, secs);
+
+	recognized = 0;
+	secs = time_detect_registry(mods, files, ripset, recognized);
+	print_detect_rate("signature registry", files.size(), recognized, secs);
+
+	return 0;
+}
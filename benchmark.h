@@ -0,0 +1,24 @@
+/*	Benchmarks
+	Output backends: writes a synthetic set of small frame bitmaps (the
+	typical AKOS/AWIZ output) through each output sink and reports
+	files/sec and MB/sec
+	Format detection: times recognizing a set of input files by trying
+	every module against signature registry lookup */
+
+#include <string>
+
+
+
+// run the benchmark; called with the full command line when it is
+// "allrip --benchmark_output <dir> [frames] [width] [height]"
+// returns the program exit code
+int run_output_benchmark(int argc, char** argv);
+
+// run the detection benchmark; called with the full command line when it is
+// "allrip --benchmark_detect <inputs...>" (files, directories or @listfiles)
+// returns the program exit code
+int run_detect_benchmark(int argc, char** argv);
+
+
+
+#pragma once
@@ -0,0 +1,211 @@
+/*	Disc image check
+	Builds a small ISO9660 image with files recorded in one and in several
+	extents, reads it back through IsoImage and checks which files it
+	lists and what's in them.
+	Usage: isocheck [dir], the image being written to dir (default: the
+	current directory) and removed afterwards; exits with 0 if every
+	check passed. Built and run by "make check" */
+
+#include "../utils/IsoImage.h"
+#include "../utils/DatManip.h"
+#include "../utils/DefaultException.h"
+#include "../utils/InputFiles.h"
+#include "../utils/MembufStream.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+using std::cout;
+using namespace RipUtil;
+
+namespace IsoCheckConsts
+{
+	const static int iso_sectors = 27;
+	const static int iso_root = 18;			// sector of the root directory
+	// SPLIT.BIN: three extents in a row
+	const static int split_extent = 19;
+	const static int split_size = 2 * IsoConsts::sector_size + 100;
+	// GAP.BIN: two extents with a sector between them
+	const static int gap_extent = 22;
+	const static int gap_second_extent = 24;
+	const static int gap_size = IsoConsts::sector_size + 10;
+	const static int plain_extent = 25;
+	// ORPHAN.BIN: a flagged extent that no last one follows
+	const static int orphan_extent = 26;
+};
+
+// store n at p in both byte orders, as ISO9660 keeps its numbers
+static void put_both32(char* p, int n)
+{
+	for (int i = 0; i < 4; i++)
+	{
+		p[i] = (char)(n >> (i * 8));
+		p[7 - i] = (char)(n >> (i * 8));
+	}
+}
+
+// a directory record for name, of size bytes at sector extent
+static std::string iso_record(const std::string& name, int extent, int size, int flags)
+{
+	std::string rec(33, '\0');
+	put_both32(&rec[2], extent);
+	put_both32(&rec[10], size);
+	rec[25] = (char)flags;
+	// volume sequence number
+	rec[28] = 1;
+	rec[31] = 1;
+	rec[32] = (char)name.size();
+	rec += name;
+	if (rec.size() % 2)
+		rec += '\0';
+	rec[0] = (char)rec.size();
+	return rec;
+}
+
+// the data of SPLIT.BIN and GAP.BIN, different in each extent
+static char file_byte(int i)
+{
+	return (char)(i * 7 + i / IsoConsts::sector_size);
+}
+
+// the test image, as IsoCheckConsts lays it out
+static std::string build_iso()
+{
+	std::string image(IsoCheckConsts::iso_sectors * IsoConsts::sector_size, '\0');
+	char* sectors = &image[0];
+
+	// primary volume descriptor and terminator
+	char* pvd = sectors + IsoConsts::first_descriptor * IsoConsts::sector_size;
+	pvd[0] = 1;
+	std::memcpy(pvd + 1, "CD001", 5);
+	pvd[6] = 1;
+	std::string root = iso_record(std::string(1, '\0'), IsoCheckConsts::iso_root,
+		IsoConsts::sector_size, 0x02);
+	std::memcpy(pvd + 156, root.data(), root.size());
+	char* term = pvd + IsoConsts::sector_size;
+	term[0] = (char)255;
+	std::memcpy(term + 1, "CD001", 5);
+	term[6] = 1;
+
+	std::string dir = root + iso_record(std::string(1, '\1'), IsoCheckConsts::iso_root,
+		IsoConsts::sector_size, 0x02);
+	for (int i = 0; i < 3; i++)
+	{
+		int size = (i < 2) ? IsoConsts::sector_size : 100;
+		dir += iso_record("SPLIT.BIN;1", IsoCheckConsts::split_extent + i, size,
+			(i < 2) ? 0x80 : 0);
+	}
+	dir += iso_record("GAP.BIN;1", IsoCheckConsts::gap_extent, IsoConsts::sector_size, 0x80);
+	dir += iso_record("GAP.BIN;1", IsoCheckConsts::gap_second_extent, 10, 0);
+	dir += iso_record("ORPHAN.BIN;1", IsoCheckConsts::orphan_extent, 100, 0x80);
+	dir += iso_record("PLAIN.TXT;1", IsoCheckConsts::plain_extent, 5, 0);
+	std::memcpy(sectors + IsoCheckConsts::iso_root * IsoConsts::sector_size, dir.data(),
+		dir.size());
+
+	char* split = sectors + IsoCheckConsts::split_extent * IsoConsts::sector_size;
+	for (int i = 0; i < IsoCheckConsts::split_size; i++)
+		split[i] = file_byte(i);
+	char* gap = sectors + IsoCheckConsts::gap_extent * IsoConsts::sector_size;
+	char* gapsecond = sectors + IsoCheckConsts::gap_second_extent * IsoConsts::sector_size;
+	for (int i = 0; i < IsoCheckConsts::gap_size; i++)
+	{
+		if (i < IsoConsts::sector_size)
+			gap[i] = file_byte(i);
+		else
+			gapsecond[i - IsoConsts::sector_size] = file_byte(i);
+	}
+	// the sector between the extents isn't part of the file
+	std::memset(gap + IsoConsts::sector_size, 'x', IsoConsts::sector_size);
+	std::memcpy(sectors + IsoCheckConsts::plain_extent * IsoConsts::sector_size, "plain", 5);
+	return image;
+}
+
+// does entry hold size bytes made by file_byte()?
+static bool has_file_bytes(const IsoImage& iso, const IsoEntry& entry, int size)
+{
+	if (entry.size != size)
+		return false;
+	std::string data(size, '\0');
+	iso.copy_data(entry, 0, size, &data[0]);
+	for (int i = 0; i < size; i++)
+	{
+		if (data[i] != file_byte(i))
+			return false;
+	}
+	return true;
+}
+
+// print the outcome of a check, counting the failed ones
+static void check(bool passed, const std::string& what, int& failures)
+{
+	cout << (passed ? "ok      " : "FAILED  ") << what << '\n';
+	if (!passed)
+		++failures;
+}
+
+int main(int argc, char** argv)
+{
+	std::string dir = (argc > 1) ? argv[1] : ".";
+	std::string isoname = dir + "/allrip-check.iso";
+	std::string image = build_iso();
+	{
+		std::ofstream ofs(isoname.c_str(), std::ios_base::binary);
+		ofs.write(image.data(), image.size());
+		if (!ofs.good())
+		{
+			cout << "could not write " << isoname << '\n';
+			return 1;
+		}
+	}
+
+	int failures = 0;
+	try
+	{
+		IsoImage iso(isoname);
+		const IsoEntry* split = iso.find("split.bin");
+		check(split != 0, "file in contiguous extents is listed", failures);
+		if (split)
+		{
+			check(iso.in_one_piece(*split), "file in contiguous extents is in one piece",
+				failures);
+			check(has_file_bytes(iso, *split, IsoCheckConsts::split_size),
+				"file in contiguous extents reads whole", failures);
+		}
+		const IsoEntry* gap = iso.find("gap.bin");
+		check(gap != 0, "file in separate extents is listed", failures);
+		if (gap)
+		{
+			check(!iso.in_one_piece(*gap), "file in separate extents is in pieces", failures);
+			check(has_file_bytes(iso, *gap, IsoCheckConsts::gap_size),
+				"file in separate extents reads whole, without the gap", failures);
+
+			// as a ripper reads its input
+			MembufStream* stream = open_input(isoname + "/GAP.BIN", MembufStream::def_bufsize);
+			std::string data(IsoCheckConsts::gap_size, '\0');
+			stream->read(&data[0], IsoCheckConsts::gap_size);
+			bool same = (stream->get_fsize() == IsoCheckConsts::gap_size);
+			for (int i = 0; same && i < IsoCheckConsts::gap_size; i++)
+				same = (data[i] == file_byte(i));
+			delete stream;
+			check(same, "file in separate extents opens as an input", failures);
+		}
+		check(iso.find("orphan.bin") == 0, "file without a last extent is left out", failures);
+		check(iso.get_skipped().size() == 1
+			&& iso.get_skipped()[0].compare(0, 11, "ORPHAN.BIN:") == 0,
+			"file without a last extent is reported", failures);
+		const IsoEntry* plain = iso.find("PLAIN.TXT");
+		check(plain != 0 && plain->size == 5
+			&& std::memcmp(iso.get_data(*plain), "plain", 5) == 0,
+			"file in one extent is listed", failures);
+		check(iso.get_entries().size() == 3, "no other files are listed", failures);
+	}
+	catch (DefaultException& e)
+	{
+		check(false, e.what(), failures);
+	}
+	std::remove(isoname.c_str());
+
+	cout << (failures ? to_string(failures) + " checks failed" : "all checks passed") << '\n';
+	return failures ? 1 : 0;
+}
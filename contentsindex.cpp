@@ -0,0 +1,219 @@
+#include "contentsindex.h"
+#include "utils/Checksums.h"
+#include "utils/InputFiles.h"
+#include "utils/IsoImage.h"
+#include "utils/DatManip.h"
+#include "utils/DefaultException.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+using namespace RipperFormats;
+using namespace RipUtil;
+
+// what tells one version of an input from another
+struct InputKey
+{
+	InputKey()
+		: size(0), mtime(0), hash(0) { };
+
+	long long size;
+	long long mtime;
+	unsigned long long hash;	// of the first key_bytes
+};
+
+// get the key of filename; false if it can't be read
+static bool get_input_key(const std::string& filename, InputKey& key)
+{
+	// a file in a disc image changes with the image
+	IsoImage* image;
+	const IsoEntry* entry;
+	if (find_image_file(filename, image, entry))
+	{
+		key.size = entry->size;
+		key.mtime = image->get_mtime();
+		XXHash64 imagehash;
+		std::vector<char> keybytes(std::min(entry->size, IndexConsts::key_bytes) + 1);
+		image->copy_data(*entry, 0, keybytes.size() - 1, &keybytes.front());
+		imagehash.update(&keybytes.front(), keybytes.size() - 1);
+		key.hash = imagehash.digest();
+		return true;
+	}
+#ifdef _WIN32
+	struct _stati64 st;
+	if (_stati64(filename.c_str(), &st) != 0)
+#else
+	struct stat st;
+	if (stat(filename.c_str(), &st) != 0)
+#endif
+		return false;
+	key.size = st.st_size;
+	key.mtime = st.st_mtime;
+
+	std::ifstream ifs(filename.c_str(), std::ios_base::binary);
+	if (!ifs.good())
+		return false;
+	std::vector<char> buf(IndexConsts::key_bytes);
+	ifs.read(&buf.front(), buf.size());
+	XXHash64 hash;
+	hash.update(&buf.front(), ifs.gcount());
+	key.hash = hash.digest();
+	return true;
+}
+
+// append n little-endian bytes of val
+static void put_int(std::string& out, long long val, int n)
+{
+	for (int i = 0; i < n; i++)
+		out += (char)((val >> (i * 8)) & 0xFF);
+}
+
+// append a string, preceded by its 2-byte length
+static void put_string(std::string& out, const std::string& s)
+{
+	std::string str = s.substr(0, 0xFFFF);
+	put_int(out, str.size(), 2);
+	out += str;
+}
+
+// read n little-endian bytes at pos, advancing it
+static long long get_int(const std::string& in, int& pos, int n)
+{
+	if ((size_t)(pos + n) > in.size())
+		throw(DefaultException("index ends unexpectedly"));
+	unsigned long long val = 0;
+	for (int i = 0; i < n; i++)
+		val |= (unsigned long long)(unsigned char)in[pos + i] << (i * 8);
+	pos += n;
+	// sign extend
+	if (n < 8 && (val & (1ULL << (n * 8 - 1))))
+		val |= ~0ULL << (n * 8);
+	return val;
+}
+
+static std::string get_string(const std::string& in, int& pos)
+{
+	int len = get_int(in, pos, 2) & 0xFFFF;
+	if ((size_t)(pos + len) > in.size())
+		throw(DefaultException("index ends unexpectedly"));
+	std::string s = in.substr(pos, len);
+	pos += len;
+	return s;
+}
+
+std::string get_index_path(const std::string& filename,
+	const RipperFormats::RipperSettings& ripset)
+{
+	if (ripset.indexdir == "")
+	{
+		// there's no saving an index next to a file in a disc image
+		IsoImage* image;
+		const IsoEntry* entry;
+		if (!ripset.index || find_image_file(filename, image, entry))
+			return "";
+		return filename + index_extension;
+	}
+
+	// cached indexes are named by what's in them, so a changed or
+	// moved input never picks up the wrong one
+	InputKey key;
+	if (!get_input_key(filename, key))
+		return "";
+	XXHash64 hash;
+	hash.update((const char*)&key.size, sizeof(key.size));
+	hash.update((const char*)&key.mtime, sizeof(key.mtime));
+	hash.update((const char*)&key.hash, sizeof(key.hash));
+	char name[17];
+	std::sprintf(name, "%016llx", hash.digest());
+
+	std::string dir = ripset.indexdir;
+	if (dir[dir.length() - 1] != '/' && dir[dir.length() - 1] != '\\')
+		dir += '/';
+	return dir + name + index_extension;
+}
+
+bool load_contents_index(const std::string& path, const std::string& filename,
+	ContentsIndex& index)
+{
+	std::ifstream ifs(path.c_str(), std::ios_base::binary);
+	if (!ifs.good())
+		return false;
+	std::ostringstream data;
+	data << ifs.rdbuf();
+	std::string in = data.str();
+
+	InputKey key;
+	if (!get_input_key(filename, key))
+		return false;
+
+	// anything malformed is as good as no index
+	try
+	{
+		int pos = 0;
+		if (in.compare(0, 4, "ARIX") != 0)
+			return false;
+		pos += 4;
+		if (get_int(in, pos, 4) != IndexConsts::version)
+			return false;
+		if (get_int(in, pos, 8) != key.size
+			|| get_int(in, pos, 8) != key.mtime
+			|| (unsigned long long)get_int(in, pos, 8) != key.hash)
+			return false;
+
+		ContentsIndex loaded;
+		loaded.module = get_string(in, pos);
+		loaded.encoding = get_int(in, pos, 4);
+		int numentries = get_int(in, pos, 4);
+		for (int i = 0; i < numentries; i++)
+		{
+			ContentsEntry entry;
+			entry.depth = get_int(in, pos, 2);
+			entry.offset = get_int(in, pos, 4);
+			entry.size = get_int(in, pos, 4);
+			entry.id = get_int(in, pos, 4);
+			entry.type = get_string(in, pos);
+			entry.name = get_string(in, pos);
+			loaded.contents.push_back(entry);
+		}
+		index = loaded;
+	}
+	catch (DefaultException&)
+	{
+		return false;
+	}
+	return true;
+}
+
+bool save_contents_index(const std::string& path, const std::string& filename,
+	const ContentsIndex& index)
+{
+	InputKey key;
+	if (!get_input_key(filename, key))
+		return false;
+
+	std::string out = "ARIX";
+	put_int(out, IndexConsts::version, 4);
+	put_int(out, key.size, 8);
+	put_int(out, key.mtime, 8);
+	put_int(out, key.hash, 8);
+	put_string(out, index.module);
+	put_int(out, index.encoding, 4);
+	put_int(out, index.contents.size(), 4);
+	for (size_t i = 0; i < index.contents.size(); i++)
+	{
+		const ContentsEntry& entry = index.contents[i];
+		put_int(out, entry.depth, 2);
+		put_int(out, entry.offset, 4);
+		put_int(out, entry.size, 4);
+		put_int(out, entry.id, 4);
+		put_string(out, entry.type);
+		put_string(out, entry.name);
+	}
+
+	std::ofstream ofs(path.c_str(), std::ios_base::binary | std::ios_base::trunc);
+	ofs.write(out.c_str(), out.size());
+	return ofs.good();
+}
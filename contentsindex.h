@@ -0,0 +1,50 @@
+/*	Contents indexes
+	The contents of an input, as listed by the module that rips it, saved
+	to a compact binary file: next to the input, or in a cache directory
+	under a name made from the input's size, modification time and a
+	hash of its start. Later runs read it back to list the input without
+	loading it, and to go straight to its module and to the parts of the
+	file they need */
+
+#include "RipperFormats.h"
+#include <string>
+#include <vector>
+
+
+
+namespace IndexConsts
+{
+	// bytes at the start of an input hashed into its key
+	const static int key_bytes = 65536;
+	// current version of the index file format
+	const static int version = 1;
+};
+
+// what's saved about an input
+struct ContentsIndex
+{
+	ContentsIndex()
+		: encoding(0) { };
+
+	std::string module;			// name of the module that listed it
+	int encoding;				// XOR decoding byte the module found
+	std::vector<RipperFormats::ContentsEntry> contents;
+};
+
+// path of the index for filename with the settings in ripset,
+// or "" if indexing is off
+std::string get_index_path(const std::string& filename,
+	const RipperFormats::RipperSettings& ripset);
+
+// read the index at path into index; false if there isn't one, or it
+// was made from a different version of filename
+bool load_contents_index(const std::string& path, const std::string& filename,
+	ContentsIndex& index);
+
+// write the index for filename to path; false if it can't be written
+bool save_contents_index(const std::string& path, const std::string& filename,
+	const ContentsIndex& index);
+
+
+
+#pragma once
@@ -0,0 +1,346 @@
+#include "daemon.h"
+#include "riprun.h"
+#include "launch.h"
+#include "RipModules.h"
+#include "RipperFormats.h"
+#include "utils/DatManip.h"
+#include "utils/WorkerThreads.h"
+#include "utils/MemoryBudget.h"
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+
+#ifndef _WIN32
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <csignal>
+#include <cerrno>
+#include <cstring>
+#endif
+
+using std::cout;
+using std::cerr;
+using namespace Ripper;
+using namespace RipperFormats;
+using namespace RipUtil;
+
+namespace DaemonConsts
+{
+	// longest request line accepted from a client
+	const static int max_request = 65536;
+	// connections waiting to be accepted
+	const static int backlog = 64;
+};
+
+#ifndef _WIN32
+
+// a connected client
+struct DaemonClient
+{
+	int serial;					// tells apart clients given the same socket
+	std::string pending;		// input not yet read as requests
+};
+
+// a rip job received from a client
+struct DaemonJob
+{
+	int client;							// socket of the client it came from
+	int serial;							// and that client's serial
+	std::string id;						// client's name for the job
+	std::string fprefix;
+	std::vector<std::string> args;		// program name, input, then params
+};
+
+// send a whole line to a client, ignoring clients that have gone away
+static void send_line(int fd, const std::string& line)
+{
+	std::string text = line + '\n';
+	for (size_t pos = 0; pos < text.size(); )
+	{
+		int n = send(fd, text.c_str() + pos, text.size() - pos, MSG_NOSIGNAL);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return;
+		pos += n;
+	}
+}
+
+// split a request into its tab-separated fields
+static void split_fields(const std::string& line, std::vector<std::string>& fields)
+{
+	std::string::size_type start = 0;
+	while (true)
+	{
+		std::string::size_type tab = line.find('\t', start);
+		fields.push_back(line.substr(start, tab - start));
+		if (tab == std::string::npos)
+			break;
+		start = tab + 1;
+	}
+}
+
+// turn a request line into a job; false if it's malformed
+static bool parse_request(const std::string& line, const std::string& progname,
+	int client, int serial, DaemonJob& job)
+{
+	std::vector<std::string> fields;
+	split_fields(line, fields);
+	if (fields.size() < 3 || fields[1] == "" || fields[2] == "")
+		return false;
+
+	job.client = client;
+	job.serial = serial;
+	job.id = fields[0];
+	job.fprefix = fields[2];
+	job.args.push_back(progname);
+	job.args.push_back(fields[1]);
+	for (size_t i = 3; i < fields.size(); i++)
+		job.args.push_back(fields[i]);
+	return true;
+}
+
+// start a job in a worker process; returns its pid, with fd set to the
+// pipe its totals come back through. the worker closes the daemon's own
+// sockets and pipes, daemonfds. throws if the job's params are bad or
+// the worker can't be started
+static int start_job(RipModules& mods, const DaemonJob& job, int workerthreads,
+	const std::vector<int>& daemonfds, int& fd)
+{
+	// the worker gets its own copy of these, so they only need to
+	// last until it's started
+	std::vector<char*> argv;
+	for (size_t i = 0; i < job.args.size(); i++)
+		argv.push_back(const_cast<char*>(job.args[i].c_str()));
+	RipperSettings ripset;
+	configure_parameters(argv.size(), &argv.front(), ripset);
+	ripset.argc = argv.size();
+	ripset.argv = &argv.front();
+
+	return start_worker(mods, job.args[1], job.fprefix, ripset,
+		ripset.threads ? ripset.threads : workerthreads, get_memory_budget(), fd, daemonfds);
+}
+
+// the line sent back for a finished job
+static std::string job_result(const DaemonJob& job, const RipTotals& totals, bool finished)
+{
+	if (!finished)
+		return job.id + " error worker process died";
+	if (totals.failed)
+		return job.id + " error could not rip " + job.args[1];
+
+	const RipResults& r = totals.results;
+	return job.id + " ok " + to_string(totals.ripped)
+		+ " " + to_string(r.graphics_ripped)
+		+ " " + to_string(r.animations_ripped)
+		+ " " + to_string(r.animation_frames_ripped)
+		+ " " + to_string(r.audio_ripped)
+		+ " " + to_string(r.strings_ripped)
+		+ " " + to_string(r.palettes_ripped)
+		+ " " + to_string(r.data_ripped);
+}
+
+// is the client a job came from still connected?
+static bool client_connected(std::map<int, DaemonClient>& clients, const DaemonJob& job)
+{
+	return (clients.count(job.client) && clients[job.client].serial == job.serial);
+}
+
+// queue the complete request lines received from a client
+static void read_requests(DaemonClient& client, const std::string& progname,
+	int fd, std::deque<DaemonJob>& queue)
+{
+	std::string& pending = client.pending;
+	std::string::size_type newline;
+	while ((newline = pending.find('\n')) != std::string::npos)
+	{
+		std::string line = pending.substr(0, newline);
+		pending.erase(0, newline + 1);
+		if (!line.empty() && line[line.length() - 1] == '\r')
+			line.erase(line.length() - 1);
+		if (line.empty())
+			continue;
+
+		DaemonJob job;
+		if (parse_request(line, progname, fd, client.serial, job))
+			queue.push_back(job);
+		else
+			send_line(fd, line.substr(0, line.find('\t')) + " error bad request");
+	}
+}
+
+int run_daemon(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		cout << "usage: " << argv[0] << " --daemon <socket> [-jobs N] [-threads N]" << '\n';
+		return 1;
+	}
+	std::string path = argv[2];
+
+	// every worker starts from a copy of this process, with the
+	// modules already set up
+	RipModules mods;
+	if (mods.num_mods() == 0)
+		return 5;
+
+	RipperSettings daemonset;
+	configure_parameters(argc, argv, daemonset);
+	set_worker_threads(daemonset.threads);
+	int jobs = std::max(1, daemonset.jobs);
+	int workerthreads = daemonset.threads ? daemonset.threads
+		: std::max(1, get_worker_threads() / jobs);
+
+	sockaddr_un addr;
+	std::memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (path.length() >= sizeof(addr.sun_path))
+	{
+		cerr << "Error: socket path " << path << " is too long" << '\n';
+		return 3;
+	}
+	std::strcpy(addr.sun_path, path.c_str());
+
+	int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+	// replace the socket left behind by an earlier run
+	unlink(path.c_str());
+	if (listener < 0 || bind(listener, (sockaddr*)&addr, sizeof(addr)) != 0
+		|| listen(listener, DaemonConsts::backlog) != 0)
+	{
+		cerr << "Error: can't listen on " << path << ": " << std::strerror(errno) << '\n';
+		return 3;
+	}
+	fcntl(listener, F_SETFD, FD_CLOEXEC);
+	// clients may disconnect before their results are sent
+	signal(SIGPIPE, SIG_IGN);
+	cout << "Listening on " << path << " with " << jobs << " workers" << '\n';
+	cout.flush();
+
+	std::map<int, DaemonClient> clients;	// socket -> client
+	int numclients = 0;
+	std::deque<DaemonJob> queue;
+	std::map<int, DaemonJob> running;		// worker pipe -> job
+	std::map<int, int> workerpids;			// worker pipe -> pid
+	while (true)
+	{
+		while (!queue.empty() && (int)running.size() < jobs)
+		{
+			DaemonJob job = queue.front();
+			queue.pop_front();
+			// the client may have gone away while this was queued
+			if (!client_connected(clients, job))
+				continue;
+			std::vector<int> daemonfds(1, listener);
+			for (std::map<int, DaemonClient>::iterator it = clients.begin(); it != clients.end(); ++it)
+				daemonfds.push_back(it->first);
+			for (std::map<int, DaemonJob>::iterator it = running.begin(); it != running.end(); ++it)
+				daemonfds.push_back(it->first);
+			// a bad job fails on its own, and the daemon carries on
+			try
+			{
+				int fd;
+				int pid = start_job(mods, job, workerthreads, daemonfds, fd);
+				running[fd] = job;
+				workerpids[fd] = pid;
+			}
+			catch (std::exception& e)
+			{
+				send_line(job.client, job.id + " error " + e.what());
+			}
+		}
+
+		std::vector<pollfd> fds;
+		pollfd pfd;
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+		pfd.fd = listener;
+		fds.push_back(pfd);
+		for (std::map<int, DaemonClient>::iterator it = clients.begin(); it != clients.end(); ++it)
+		{
+			pfd.fd = it->first;
+			fds.push_back(pfd);
+		}
+		for (std::map<int, DaemonJob>::iterator it = running.begin(); it != running.end(); ++it)
+		{
+			pfd.fd = it->first;
+			fds.push_back(pfd);
+		}
+		if (poll(&fds.front(), fds.size(), -1) < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			cerr << "Error: poll failed: " << std::strerror(errno) << '\n';
+			return 3;
+		}
+
+		for (size_t i = 0; i < fds.size(); i++)
+		{
+			if (!fds[i].revents)
+				continue;
+			int fd = fds[i].fd;
+
+			// new connection
+			if (fd == listener)
+			{
+				int client = accept(listener, 0, 0);
+				if (client >= 0)
+				{
+					fcntl(client, F_SETFD, FD_CLOEXEC);
+					clients[client].serial = ++numclients;
+					clients[client].pending = "";
+				}
+			}
+			// a worker finished: report to the client that asked for it
+			else if (running.count(fd))
+			{
+				RipTotals totals;
+				bool finished = finish_worker(fd, totals);
+				int status;
+				while (waitpid(workerpids[fd], &status, 0) < 0 && errno == EINTR)
+					;
+				DaemonJob& job = running[fd];
+				if (client_connected(clients, job))
+					send_line(job.client, job_result(job, totals, finished));
+				running.erase(fd);
+				workerpids.erase(fd);
+			}
+			// requests from a client
+			else if (clients.count(fd))
+			{
+				char buf[4096];
+				int n = recv(fd, buf, sizeof(buf), 0);
+				if (n < 0 && errno == EINTR)
+					continue;
+				if (n > 0)
+				{
+					clients[fd].pending.append(buf, n);
+					read_requests(clients[fd], argv[0], fd, queue);
+				}
+				if (n <= 0 || clients[fd].pending.size() > DaemonConsts::max_request)
+				{
+					close(fd);
+					clients.erase(fd);
+				}
+			}
+		}
+	}
+	return 0;
+}
+
+#else
+
+int run_daemon(int argc, char** argv)
+{
+	cout << "Daemon mode needs Unix domain sockets, which this build doesn't support" << '\n';
+	return 1;
+}
+
+#endif
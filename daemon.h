@@ -0,0 +1,23 @@
+/*	Daemon mode
+	Listens on a Unix domain socket for rip jobs, so that a pipeline
+	ripping many small files doesn't pay for process startup and module
+	setup on every one. Each request is one line of tab-separated fields:
+		<id>	<input file>	<output prefix>	[<param>	...]
+	where the params are the usual command line params. Jobs run on a
+	pool of worker processes, and a line is sent back for each as it
+	completes:
+		<id> ok <ripped> <graphics> <animations> <frames> <audio> <strings> <palettes> <raw>
+		<id> error <message> */
+
+#include <string>
+
+
+
+// run the daemon; called with the full command line when it is
+// "allrip --daemon <socket> [-jobs N] [-threads N]"
+// returns the program exit code
+int run_daemon(int argc, char** argv);
+
+
+
+#pragma once
@@ -1,6 +1,8 @@
 #include "launch.h"
 #include "utils/DatManip.h"
 #include "utils/PCMData.h"
+#include "utils/DefaultException.h"
+#include "utils/MemoryBudget.h"
 
 #include <iostream>
 
@@ -39,6 +41,18 @@ void configure_parameters(int argc, char** argv, RipperFormats::RipperSettings&
 			ripset.normalize = true;
 		else if (quickstrcmp(argv[i], "--decode_audio"))
 			ripset.decode_audio = true;
+		else if (quickstrcmp(argv[i], "--iouring"))
+			ripset.iouring = true;
+		else if (quickstrcmp(argv[i], "--dryrun"))
+			ripset.dryrun = true;
+		else if (quickstrcmp(argv[i], "--incremental"))
+			ripset.incremental = true;
+		else if (quickstrcmp(argv[i], "--resume"))
+			ripset.resume = true;
+		else if (quickstrcmp(argv[i], "--list"))
+			ripset.listcontents = true;
+		else if (quickstrcmp(argv[i], "--index"))
+			ripset.index = true;
 	}
 
 	// second pass: two-flag params
@@ -47,6 +61,12 @@ void configure_parameters(int argc, char** argv, RipperFormats::RipperSettings&
 		if (quickstrcmp(argv[i], "-output")
 			|| quickstrcmp(argv[i], "-o"))
 			ripset.outpath = argv[i + 1];
+		else if (quickstrcmp(argv[i], "-archive")
+			|| quickstrcmp(argv[i], "-ar"))
+			ripset.archive = argv[i + 1];
+		else if (quickstrcmp(argv[i], "-checksum")
+			|| quickstrcmp(argv[i], "-cs"))
+			ripset.checksum = argv[i + 1];
 		else if (quickstrcmp(argv[i], "-encoding")
 			|| quickstrcmp(argv[i], "-e"))
 			ripset.encoding = from_string<int>(argv[i + 1]);
@@ -115,5 +135,115 @@ void configure_parameters(int argc, char** argv, RipperFormats::RipperSettings&
 		else if (quickstrcmp(argv[i], "-loopfadesil")
 			|| quickstrcmp(argv[i], "-ls"))
 			ripset.loopfadesil = from_string<double>(argv[i + 1]);
+		else if (quickstrcmp(argv[i], "-audioformat")
+			|| quickstrcmp(argv[i], "-af"))
+		{
+			if (quickstrcmp(argv[i + 1], "wav"))
+				ripset.audioformat = PCMData::waveformat;
+			else if (quickstrcmp(argv[i + 1], "flac"))
+				ripset.audioformat = PCMData::flacformat;
+		}
+		else if (quickstrcmp(argv[i], "-imageformat")
+			|| quickstrcmp(argv[i], "-if"))
+		{
+			if (quickstrcmp(argv[i + 1], "bmp"))
+				ripset.imageformat = BitmapData::bmpformat;
+			else if (quickstrcmp(argv[i + 1], "png"))
+				ripset.imageformat = BitmapData::pngformat;
+		}
+		else if (quickstrcmp(argv[i], "-threads")
+			|| quickstrcmp(argv[i], "-th"))
+			ripset.threads = from_string<int>(argv[i + 1]);
+		else if (quickstrcmp(argv[i], "-layout")
+			|| quickstrcmp(argv[i], "-lo"))
+		{
+			if (quickstrcmp(argv[i + 1], "flat"))
+				ripset.shardlayout = ShardedOutputSink::flatlayout;
+			else if (quickstrcmp(argv[i + 1], "resource"))
+				ripset.shardlayout = ShardedOutputSink::resourcelayout;
+			else if (quickstrcmp(argv[i + 1], "hash"))
+				ripset.shardlayout = ShardedOutputSink::hashlayout;
+		}
+		else if (quickstrcmp(argv[i], "-fanout")
+			|| quickstrcmp(argv[i], "-fo"))
+			ripset.shardfanout = from_string<int>(argv[i + 1]);
+		else if (quickstrcmp(argv[i], "-iothreads")
+			|| quickstrcmp(argv[i], "-io"))
+			ripset.iothreads = from_string<int>(argv[i + 1]);
+		else if (quickstrcmp(argv[i], "-writequeue")
+			|| quickstrcmp(argv[i], "-wq"))
+			ripset.writequeue = from_string<int>(argv[i + 1]);
+		else if (quickstrcmp(argv[i], "-jobs")
+			|| quickstrcmp(argv[i], "-j"))
+			ripset.jobs = from_string<int>(argv[i + 1]);
+		else if (quickstrcmp(argv[i], "-batchmemory")
+			|| quickstrcmp(argv[i], "-bm"))
+			ripset.batchmemory = from_string<int>(argv[i + 1]);
+		else if (quickstrcmp(argv[i], "-indexdir")
+			|| quickstrcmp(argv[i], "-ix"))
+			ripset.indexdir = argv[i + 1];
+		else if (quickstrcmp(argv[i], "-select")
+			|| quickstrcmp(argv[i], "-sel"))
+			ripset.select = argv[i + 1];
+		else if (quickstrcmp(argv[i], "--shard"))
+		{
+			// "i/n": the ith of n shards, counting from 1
+			std::string spec = argv[i + 1];
+			std::string::size_type slash = spec.find('/');
+			int shard = from_string<int>(spec.substr(0, slash));
+			int shards = (slash == std::string::npos) ? 0
+				: from_string<int>(spec.substr(slash + 1));
+			if (shards < 1 || shard < 1 || shard > shards)
+				throw(DefaultException("--shard takes i/n, with i from 1 to n (e.g. --shard 2/8)"));
+			ripset.workshard = shard - 1;
+			ripset.workshards = shards;
+		}
+		else if (quickstrcmp(argv[i], "--max-memory")
+			|| quickstrcmp(argv[i], "-maxmemory")
+			|| quickstrcmp(argv[i], "-mm"))
+		{
+			ripset.maxmemory = from_string<int>(argv[i + 1]);
+			if (ripset.maxmemory < 1)
+				throw(DefaultException("--max-memory takes a number of MB"));
+		}
+	}
+
+	// the budget is checked where there's no ripset to hand
+	set_memory_budget(ripset.maxmemory == RipperFormats::RipConsts::not_set
+		? MemoryBudgetConsts::unlimited : (long long)ripset.maxmemory * 1024 * 1024);
+}
+
+// get the command line params that affect output content, as one string
+// (everything but the params that only change how it's written)
+std::string get_output_settings(int argc, char** argv)
+{
+	std::string settings;
+	// skip the input files
+	int i = 1;
+	while (i < argc && argv[i][0] != '-')
+		++i;
+	for (; i < argc; i++)
+	{
+		if (quickstrcmp(argv[i], "--iouring")
+			|| quickstrcmp(argv[i], "--incremental")
+			|| quickstrcmp(argv[i], "--resume")
+			|| quickstrcmp(argv[i], "--index"))
+			continue;
+		if (i + 1 < argc
+			&& (quickstrcmp(argv[i], "-bufsize") || quickstrcmp(argv[i], "-b")
+			|| quickstrcmp(argv[i], "-threads") || quickstrcmp(argv[i], "-th")
+			|| quickstrcmp(argv[i], "-iothreads") || quickstrcmp(argv[i], "-io")
+			|| quickstrcmp(argv[i], "-writequeue") || quickstrcmp(argv[i], "-wq")
+			|| quickstrcmp(argv[i], "-jobs") || quickstrcmp(argv[i], "-j")
+			|| quickstrcmp(argv[i], "-batchmemory") || quickstrcmp(argv[i], "-bm")
+			|| quickstrcmp(argv[i], "-indexdir") || quickstrcmp(argv[i], "-ix")
+			|| quickstrcmp(argv[i], "--max-memory") || quickstrcmp(argv[i], "-maxmemory")
+			|| quickstrcmp(argv[i], "-mm")))
+		{
+			++i;
+			continue;
+		}
+		settings += std::string(argv[i]) + '\n';
 	}
+	return settings;
 }
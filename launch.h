@@ -10,6 +10,10 @@ void print_base_usage_text();
 // configure RipperSettings from command line params
 void configure_parameters(int argc, char** argv, RipperFormats::RipperSettings& ripset);
 
+// get the command line params that affect output content, as one string
+// (everything but the params that only change how it's written)
+std::string get_output_settings(int argc, char** argv);
+
 
 
 #pragma once
\ No newline at end of file
@@ -1,10 +1,22 @@
 #include "launch.h"
+#include "benchmark.h"
+#include "daemon.h"
 #include "utils/DatManip.h"
 #include "RipperFormats.h"
 #include "RipModules.h"
+#include "utils/WorkerThreads.h"
+#include "utils/OutputStats.h"
+#include "utils/MemoryBudget.h"
+#include "utils/InputFiles.h"
+#include "utils/IsoImage.h"
+#include "utils/MembufStream.h"
+#include "riprun.h"
+#include <chrono>
 #include <ctime>
 #include <iostream>
 #include <string>
+#include <vector>
+#include <map>
 
 using std::cout;
 using std::cerr;
@@ -55,12 +67,23 @@ int main(int argc, char** argv)
 		return 1;
 	}
 	
+	// run a benchmark instead of ripping
+	if (quickstrcmp(argv[1], "--benchmark_output"))
+		return run_output_benchmark(argc, argv);
+	if (quickstrcmp(argv[1], "--benchmark_detect"))
+		return run_detect_benchmark(argc, argv);
+	// serve rip jobs over a socket
+	if (quickstrcmp(argv[1], "--daemon"))
+		return run_daemon(argc, argv);
+
 	RipperSettings ripset;
 	configure_parameters(argc, argv, ripset);
 	ripset.argc = argc;
 	ripset.argv = argv;
+	set_worker_threads(ripset.threads);
 
 	int timer = std::clock();
+	std::chrono::steady_clock::time_point walltimer = std::chrono::steady_clock::now();
 	
 //	for (int i = 0; i < mods.num_mods(); i++)
 //	{
@@ -68,53 +91,100 @@ int main(int argc, char** argv)
 //	}
 //	cout << mods.num_mods() << " mods loaded" << '\n';
 
-	std::string filename = argv[1];
-	std::string shortfname = get_short_filename(filename);
-	std::string fprefix = shortfname;
-	if (ripset.outpath != "")
-		fprefix = ripset.outpath;
-
-	MembufStream stream(filename, MembufStream::rb);
-
-	FileFormatData fmtdat;
-	RipResults results;
-	bool ripped = false;
-
 	if (mods.num_mods() == 0)
 	{
 //		cout << "Ripper was built with no modules!" << '\n';
 		return 5;
 	}
-	for (int i = 0; i < mods.num_mods(); i++)
+
+	// inputs are the leading params: several of them, a directory, a
+	// disc image or an @listfile make a batch
+	int numargs = 1;
+	while (numargs < argc && argv[numargs][0] != '-')
+		++numargs;
+	std::string filename = argv[1];
+	bool batch = (numargs > 2 || filename[0] == '@' || is_directory(filename)
+		|| is_iso_image(filename));
+
+	RipTotals totals;
+	if (!batch)
+	{
+		std::string fprefix = get_short_filename(filename);
+		if (ripset.outpath != "")
+			fprefix = ripset.outpath;
+
+		OutputSinks sinks;
+		open_output_sinks(ripset, sinks);
+		if (rip_input(mods, filename, fprefix, ripset, MembufStream::def_bufsize,
+			*sinks.sink, totals.results))
+			++totals.ripped;
+		close_output_sinks(ripset, sinks, totals);
+	}
+	else
 	{
-		if (mods[i]->can_rip(stream, ripset, fmtdat))
+		std::vector<std::string> inputs;
+		for (int i = 1; i < numargs; i++)
+			collect_input_files(argv[i], inputs);
+
+		// each input's output is prefixed with its name, numbered if
+		// several inputs share one
+		std::string outdir = ripset.outpath;
+		if (outdir != "" && outdir[outdir.length() - 1] != '/'
+			&& outdir[outdir.length() - 1] != '\\')
+			outdir += '/';
+		std::vector<std::string> prefixes;
+		std::map<std::string, int> namecounts;
+		for (size_t i = 0; i < inputs.size(); i++)
 		{
-			cout << "Input file: " << shortfname << '\n';
-//			cout << "mod " << i << " (" << mods[i]->module_name << ") " <<  "can rip" << '\n';
-			results = mods[i]->rip(stream, fprefix, ripset, fmtdat);
-			ripped = true;
-//			cout << "Rip results:" << '\n'
-//				<< '\n';
-//			cout << "Graphics ripped: " << results.graphics_ripped << '\n'
-//				<< "Animations ripped: " << results.animations_ripped << '\n'
-//				<< "Animation frames ripped: " << results.animation_frames_ripped << '\n'
-//				<< "Audio files ripped: " << results.audio_ripped << '\n'
-//				<< "Strings ripped: " << results.strings_ripped << '\n'
-//				<< "Raw files ripped: " << results.data_ripped << '\n'
-//				<< "Total: " << results.graphics_ripped + results.animation_frames_ripped 
-//					+ results.audio_ripped + results.strings_ripped
-//					+ results.data_ripped << '\n';
+			std::string shortfname = get_short_filename(inputs[i]);
+			int count = ++namecounts[shortfname];
+			if (count > 1)
+				shortfname += "-" + to_string(count);
+			prefixes.push_back(outdir + shortfname);
 		}
-		stream.reset();
-	}
 
-	if (!ripped)
-	{
-		cout << "No module could recognize this file: no output" << '\n';
+		rip_batch(mods, inputs, prefixes, ripset, totals);
+		cout << "Batch: " << inputs.size() << " inputs, " << totals.ripped << " ripped, "
+			<< totals.unrecognized << " not recognized, " << totals.failed << " failed" << '\n';
 	}
 
 	timer = clock() - timer;
 	cout << "Time elapsed: " << (double)timer/CLOCKS_PER_SEC << " secs" << '\n';
+	if (batch)
+	{
+		cout << "Wall time: " << std::chrono::duration<double>(
+			std::chrono::steady_clock::now() - walltimer).count() << " secs" << '\n';
+	}
+	print_output_stats(cout);
+	print_budget_fallbacks(cout);
+
+	RipResults& results = totals.results;
+	if (ripset.dryrun)
+	{
+		double wallsecs = std::chrono::duration<double>(
+			std::chrono::steady_clock::now() - walltimer).count();
+		if (wallsecs <= 0)
+			wallsecs = 1e-9;
+		cout << "Dry run: " << totals.discardedfiles << " files, "
+			<< totals.discardedbytes << " bytes discarded in "
+			<< wallsecs << " secs (" << totals.discardedfiles / wallsecs
+			<< " files/sec, " << totals.discardedbytes / wallsecs / 1000000
+			<< " MB/sec)" << '\n';
+	}
+	if (ripset.dryrun || batch)
+	{
+		cout << "Graphics ripped: " << results.graphics_ripped << '\n'
+			<< "Animations ripped: " << results.animations_ripped << '\n'
+			<< "Animation frames ripped: " << results.animation_frames_ripped << '\n'
+			<< "Audio files ripped: " << results.audio_ripped << '\n'
+			<< "Strings ripped: " << results.strings_ripped << '\n'
+			<< "Palettes ripped: " << results.palettes_ripped << '\n'
+			<< "Raw files ripped: " << results.data_ripped << '\n';
+	}
+
+	// some inputs of a batch failed
+	if (totals.failed)
+		return 3;
 
 //	wait_for_key();
 	return 0;
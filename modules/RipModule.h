@@ -3,6 +3,7 @@
 	extracting data from a file */
 
 #include "../utils/MembufStream.h"
+#include "../utils/OutputSink.h"
 #include "../RipperFormats.h"
 
 class RipModule
@@ -37,16 +38,36 @@ public:
 
 	// return module name 
 
+	// given the first len bytes of a file of fsize bytes, return false
+	// if it can't be in this module's format; a cheap check run before
+	// can_rip, so that the whole file is only loaded for likely matches
+	virtual bool check_header(const char* header, int len, int fsize,
+		const RipperFormats::RipperSettings& ripset) { return true; }
+
 	// given a stream positioned at file start, return true if
 	// this module is capable of extracting data from it
 	virtual bool can_rip(RipUtil::MembufStream& stream, const RipperFormats::RipperSettings& ripset,
 		RipperFormats::FileFormatData& fmtdat) =0;
 
 	// given a stream positioned at file start and the rip settings,
-	// rip data from the file
-	virtual RipperFormats::RipResults rip(RipUtil::MembufStream& stream, const std::string& fprefix,
+	// rip data from the file, writing all output files to sink
+	virtual RipperFormats::RipResults rip(RipUtil::MembufStream& stream, RipUtil::OutputSink& sink,
+		const std::string& fprefix,
 		const RipperFormats::RipperSettings& ripset, const RipperFormats::FileFormatData& fmtdat) =0;
 
+	// given a stream positioned at file start, list its contents from
+	// the container structure alone, without decoding any of them;
+	// return false if the module can't list contents
+	virtual bool list_contents(RipUtil::MembufStream& stream, const RipperFormats::RipperSettings& ripset,
+		const RipperFormats::FileFormatData& fmtdat,
+		std::vector<RipperFormats::ContentsEntry>& contents) { return false; }
+
+	// give the module the contents of its next input, as listed when it
+	// was indexed, so it can go straight to the parts it needs instead
+	// of walking the file; 0 if there's no index
+	void set_indexed_contents(const std::vector<RipperFormats::ContentsEntry>* contents)
+		{ indexcontents = contents; }
+
 protected:
 	RipModule(const std::string& name, const std::string& desc,
 		bool hasext, const std::string& ext,
@@ -60,7 +81,10 @@ protected:
 		supports_graphics(grp),
 		supports_animations(ani),
 		supports_audio(aud),
-		supports_strings(str) { };
+		supports_strings(str), indexcontents(0) { };
+
+	// contents from the input's index, if it has one
+	const std::vector<RipperFormats::ContentsEntry>* indexcontents;
 private:
 };
 
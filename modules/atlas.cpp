@@ -4,6 +4,7 @@
 #include "common.h"
 #include "../RipperFormats.h"
 #include "../utils/DatManip.h"
+#include "../utils/DefaultException.h"
 
 #include <vector>
 #include <fstream>
@@ -18,6 +19,13 @@ namespace Atlas
 {
 
 	// needs a stronger test
+	bool AtlasRip::check_header(const char* header, int len, int fsize,
+		const RipperFormats::RipperSettings& ripset)
+	{
+		int version = to_int(header, 4, DatManip::le);
+		return (version <= 4);
+	}
+
 	bool AtlasRip::can_rip(RipUtil::MembufStream& stream, const RipperFormats::RipperSettings& ripset,
 		RipperFormats::FileFormatData& fmtdat)
 	{
@@ -82,59 +90,46 @@ namespace Atlas
 		return false;
 	}
 
-	RipperFormats::RipResults AtlasRip::rip(RipUtil::MembufStream& stream, const std::string& fprefix, 
+	RipperFormats::RipResults AtlasRip::rip(RipUtil::MembufStream& stream, RipUtil::OutputSink& sink,
+		const std::string& fprefix, 
 		const RipperFormats::RipperSettings& ripset, const RipperFormats::FileFormatData& fmtdat)
 	{
 		check_params(ripset);
 
 		RipResults results;
 
-		stream.seekg(addrtableaddr);
-		int addrtable = stream.read_int(4, DatManip::le);
-		int addrtableentries = stream.read_int(4, DatManip::le);
-		stream.seekg(addrtable);
-//		printf("%d\n", stream.tellg());
-//		stream.seek_off(8);
-		// most games, but not all, start with a null entry
-		int firstend = stream.read_int(4, DatManip::le);
-		int firstlen = stream.read_int(4, DatManip::le);
-		if (firstend != 0)
-			stream.seek_off(-8);
 		std::vector<AtlasAddrTableEntry> entries;
-		int entriesread = 0;
-		while (!stream.eof() && entriesread < addrtableentries)
+		read_addr_table(stream, entries);
+
+		// -select: one entry, by its number as --list shows it
+		int first = 0;
+		int last = entries.size() - 1;
+		if (ripset.select != "")
 		{
-			AtlasAddrTableEntry entry;
-			entry.address = stream.read_int(4, DatManip::le);
-			entry.length = stream.read_int(4, DatManip::le);
-			// some games just don't know when to quit
-			if (entriesread > 0 && (entry.address < 68 
-				|| entry.address > stream.get_fsize()
-				|| entry.address + entry.length > stream.get_fsize()))
-				break;
-			entries.push_back(entry);
-			++entriesread;
-//			printf("%d %d\n", entry.address, entry.length);
-//			char c;
-//			std::cin >> c;
+			AssetSelector sel;
+			parse_selector(ripset.select, sel);
+			first = get_selector_int(sel, "entry");
+			if (sel.size() != 1 || first == RipConsts::not_set)
+				throw(DefaultException("-select for Atlas files takes entry=<number>"));
+			if (first > last)
+				throw(DefaultException("-select entry " + to_string(first)
+					+ " is past the last entry, " + to_string(last)));
+			last = first;
 		}
-		stream.clear();
-//		printf("%d\n", entries.size());
-		int files_ripped = 0;
+		int files_ripped = first;
 
 		if (ripset.ripallraw)
 		{
-			for (int i = 0; i < entries.size(); i++)
+			for (int i = first; i <= last; i++)
 			{
+				if (!sink.begin_asset(entries[i].address))
+					continue;
 				stream.seekg(entries[i].address);
-				char* outbytes = new char[entries[i].length];
-				stream.read(outbytes, entries[i].length);
-				std::ofstream ofs((fprefix + "-data-"
-					+ to_string(i)).c_str(), std::ios_base::binary);
-				ofs.write(outbytes, entries[i].length);
-				delete[] outbytes;
+				sink.write_file_from(fprefix + "-data-"
+					+ to_string(i), stream, entries[i].length);
 				++results.data_ripped;
 			}
+			sink.end_asset();
 			return results;
 		}
 
@@ -143,8 +138,30 @@ namespace Atlas
 		int lastbmapnum = -2;
 		
 		char hdcheck[4];
-		for (int i = 0; i < entries.size(); i++)
+		// a selected frame table needs the bitmap before it
+		if (ripset.select != "" && !copybmp && first > 0)
+		{
+			stream.seekg(entries[first].address);
+			stream.read(hdcheck, 4);
+			bool isdata = !quickcmp(hdcheck, "BM", 2) && !quickcmp(hdcheck, "RIFF", 4);
+			stream.seekg(entries[first - 1].address);
+			stream.read(hdcheck, 4);
+			if (isdata && quickcmp(hdcheck, "BM", 2))
+			{
+				stream.seekg(entries[first - 1].address);
+				CommFor::bmp::read_bmp_bitmapdata(stream, lastbmap);
+				lastbmapnum = first - 1;
+			}
+		}
+		for (int i = first; i <= last; i++)
 		{
+			// entries are assets of their own, except in split mode,
+			// where a bitmap is written out along with the entry after it
+			if (copybmp && !sink.begin_asset(entries[i].address))
+			{
+				++files_ripped;
+				continue;
+			}
 			stream.seekg(entries[i].address);
 			stream.read(hdcheck, 4);
 			if (quickcmp(hdcheck, "BM", 2))
@@ -154,14 +171,8 @@ namespace Atlas
 					if (copybmp)
 					{
 						stream.seekg(entries[i].address);
-						char* outbytes = new char[entries[i].length];
-						stream.read(outbytes, entries[i].length);
-
-						std::ofstream ofs((fprefix + "-bmp-"
-							+ to_string(files_ripped) + ".bmp").c_str(),
-							std::ios_base::binary);
-						ofs.write(outbytes, entries[i].length);
-						delete[] outbytes;
+						sink.write_file_from(fprefix + "-bmp-"
+							+ to_string(files_ripped) + ".bmp", stream, entries[i].length);
 						++results.graphics_ripped;
 					}
 					else
@@ -169,8 +180,8 @@ namespace Atlas
 						// last entry was bmp, but has no frame identifier
 						if (lastbmapnum >= 0 && !lastbmap_ripped)
 						{
-							write_bitmapdata_bmp(lastbmap, fprefix + "-bmp-" 
-								+ to_string(lastbmapnum) + ".bmp");
+							write_bitmapdata(sink, lastbmap, fprefix + "-bmp-" 
+								+ to_string(lastbmapnum), ripset.imageformat);
 							++results.graphics_ripped;
 						}
 						stream.seekg(entries[i].address);
@@ -187,7 +198,7 @@ namespace Atlas
 /*						stream.seekg(entries[i].address);
 						BitmapData bmp;
 						CommFor::bmp::read_bmp_bitmapdata(stream, bmp);
-						write_bitmapdata_bmp(bmp, "test-" + to_string(i) + ".bmp");
+						write_bitmapdata(sink, bmp, "test-" + to_string(i), ripset.imageformat);
 						++results.graphics_ripped; */
 					}
 				}
@@ -197,13 +208,8 @@ namespace Atlas
 				if (ripset.ripaudio)
 				{
 					stream.seekg(entries[i].address);
-					char* outbytes = new char[entries[i].length];
-					stream.read(outbytes, entries[i].length);
-					std::ofstream ofs((fprefix + "-wave-"
-						+ to_string(files_ripped) + ".wav").c_str(),
-						std::ios_base::binary);
-					ofs.write(outbytes, entries[i].length);
-					delete[] outbytes;
+					sink.write_file_from(fprefix + "-wave-"
+						+ to_string(files_ripped) + ".wav", stream, entries[i].length);
 					++results.audio_ripped;
 				}
 			}
@@ -234,8 +240,8 @@ namespace Atlas
 
 							BitmapData bmap;
 							lastbmap.copy_rect(bmap, up_x, up_y, low_x - up_x, low_y - up_y);
-							write_bitmapdata_bmp(bmap, fprefix + "-anim-" 
-								+ to_string(lastbmapnum) + "-frame-" + to_string(j + 1) + ".bmp");
+							write_bitmapdata(sink, bmap, fprefix + "-anim-" 
+								+ to_string(lastbmapnum) + "-frame-" + to_string(j + 1), ripset.imageformat);
 							++results.animation_frames_ripped;
 						}
 						lastbmap_ripped = true;
@@ -244,8 +250,8 @@ namespace Atlas
 					// last entry was bmp, but this data entry is not a frame identifier
 					else if (!lastbmap_ripped && lastbmapnum >= 0)
 					{
-						write_bitmapdata_bmp(lastbmap, fprefix + "-bmp-" 
-							+ to_string(lastbmapnum) + ".bmp");
+						write_bitmapdata(sink, lastbmap, fprefix + "-bmp-" 
+							+ to_string(lastbmapnum), ripset.imageformat);
 						lastbmap_ripped = true;
 						++results.graphics_ripped;
 					}
@@ -253,22 +259,82 @@ namespace Atlas
 				if (ripset.ripdata)
 				{
 					stream.seekg(entries[i].address);
-					char* outbytes = new char[entries[i].length];
-					stream.read(outbytes, entries[i].length);
-					std::ofstream ofs((fprefix + "-data-"
-						+ to_string(files_ripped)).c_str(),
-						std::ios_base::binary);
-					ofs.write(outbytes, entries[i].length);
-					delete[] outbytes;
+					sink.write_file_from(fprefix + "-data-"
+						+ to_string(files_ripped), stream, entries[i].length);
 					++results.data_ripped;
 				}
 			}
 
 			++files_ripped;
 		}
+		sink.end_asset();
+		// a selected bitmap has no following entry to write it out
+		if (ripset.select != "" && lastbmapnum == first && !lastbmap_ripped)
+		{
+			write_bitmapdata(sink, lastbmap, fprefix + "-bmp-" 
+				+ to_string(lastbmapnum), ripset.imageformat);
+			++results.graphics_ripped;
+		}
 		return results;
 	}
 
+	bool AtlasRip::list_contents(RipUtil::MembufStream& stream, const RipperFormats::RipperSettings& ripset,
+		const RipperFormats::FileFormatData& fmtdat, std::vector<RipperFormats::ContentsEntry>& contents)
+	{
+		std::vector<AtlasAddrTableEntry> entries;
+		read_addr_table(stream, entries);
+
+		char hdcheck[4];
+		for (size_t i = 0; i < entries.size(); i++)
+		{
+			stream.seekg(entries[i].address);
+			stream.read(hdcheck, 4);
+			std::string type = "data";
+			if (quickcmp(hdcheck, "BM", 2))
+				type = "BMP";
+			else if (quickcmp(hdcheck, "RIFF", 4))
+				type = "RIFF";
+			contents.push_back(ContentsEntry(0, type, entries[i].address, entries[i].length, i));
+		}
+		stream.clear();
+		return true;
+	}
+
+	void AtlasRip::read_addr_table(RipUtil::MembufStream& stream,
+		std::vector<AtlasAddrTableEntry>& entries)
+	{
+		stream.seekg(addrtableaddr);
+		int addrtable = stream.read_int(4, DatManip::le);
+		int addrtableentries = stream.read_int(4, DatManip::le);
+		stream.seekg(addrtable);
+//		printf("%d\n", stream.tellg());
+//		stream.seek_off(8);
+		// most games, but not all, start with a null entry
+		int firstend = stream.read_int(4, DatManip::le);
+		int firstlen = stream.read_int(4, DatManip::le);
+		if (firstend != 0)
+			stream.seek_off(-8);
+		int entriesread = 0;
+		while (!stream.eof() && entriesread < addrtableentries)
+		{
+			AtlasAddrTableEntry entry;
+			entry.address = stream.read_int(4, DatManip::le);
+			entry.length = stream.read_int(4, DatManip::le);
+			// some games just don't know when to quit
+			if (entriesread > 0 && (entry.address < 68 
+				|| entry.address > stream.get_fsize()
+				|| entry.address + entry.length > stream.get_fsize()))
+				break;
+			entries.push_back(entry);
+			++entriesread;
+//			printf("%d %d\n", entry.address, entry.length);
+//			char c;
+//			std::cin >> c;
+		}
+		stream.clear();
+//		printf("%d\n", entries.size());
+	}
+
 	void AtlasRip::check_params(const RipperFormats::RipperSettings& ripset)
 	{
 		for (int i = 0; i < ripset.argc; i++)
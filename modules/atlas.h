@@ -5,6 +5,7 @@
 #include "../utils/MembufStream.h"
 
 #include <string>
+#include <vector>
 
 namespace Atlas
 {
@@ -22,11 +23,18 @@ public:
 				unsupported),
 		copybmp(true) { };
 
+	bool check_header(const char* header, int len, int fsize,
+		const RipperFormats::RipperSettings& ripset);
+
 	bool can_rip(RipUtil::MembufStream& stream, const RipperFormats::RipperSettings& ripset,
 		RipperFormats::FileFormatData& fmtdat);
 
-	RipperFormats::RipResults rip(RipUtil::MembufStream& stream, const std::string& fprefix, 
+	RipperFormats::RipResults rip(RipUtil::MembufStream& stream, RipUtil::OutputSink& sink,
+		const std::string& fprefix, 
 		const RipperFormats::RipperSettings& ripset, const RipperFormats::FileFormatData& fmtdat);
+
+	bool list_contents(RipUtil::MembufStream& stream, const RipperFormats::RipperSettings& ripset,
+		const RipperFormats::FileFormatData& fmtdat, std::vector<RipperFormats::ContentsEntry>& contents);
 private:
 
 	enum FormatSubtype
@@ -53,6 +61,9 @@ private:
 
 	bool copybmp;
 
+	// read the entries of the address table
+	void read_addr_table(RipUtil::MembufStream& stream, std::vector<AtlasAddrTableEntry>& entries);
+
 	// check command line parameters and configure accordingly
 	void check_params(const RipperFormats::RipperSettings& ripset);
 
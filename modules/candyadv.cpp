@@ -16,6 +16,15 @@ namespace CandyAdv
 {
 
 
+bool CandyAdvRip::check_header(const char* header, int len, int fsize,
+	const RipperFormats::RipperSettings& ripset)
+{
+	// the chunk and its offset table must fit in the file
+	int chunklen = to_int(header + 4, 4, DatManip::le);
+	int numentries = to_int(header + 8, 2, DatManip::le);
+	return (chunklen <= fsize && 10 + numentries * 8 <= fsize);
+}
+
 bool CandyAdvRip::can_rip(RipUtil::MembufStream& stream, const RipperFormats::RipperSettings& ripset,
 		RipperFormats::FileFormatData& fmtdat)
 {
@@ -46,7 +55,8 @@ bool CandyAdvRip::can_rip(RipUtil::MembufStream& stream, const RipperFormats::Ri
 	return true;
 }
 
-RipperFormats::RipResults CandyAdvRip::rip(RipUtil::MembufStream& stream, const std::string& fprefix,
+RipperFormats::RipResults CandyAdvRip::rip(RipUtil::MembufStream& stream, RipUtil::OutputSink& sink,
+		const std::string& fprefix,
 		const RipperFormats::RipperSettings& ripset, const RipperFormats::FileFormatData& fmtdat)
 {
 	RipResults results;
@@ -68,23 +78,15 @@ RipperFormats::RipResults CandyAdvRip::rip(RipUtil::MembufStream& stream, const
 			if (!subchunkentries.size())
 			{
 				stream.seekg(baseoff);
-				char* outbytes = new char[entries[i].length];
-				stream.read(outbytes, entries[i].length);
-				std::ofstream ofs((fprefix + "-chunk-" + to_string(i)).c_str(), std::ios_base::binary);
-				ofs.write(outbytes, entries[i].length);
-				delete[] outbytes;
+				sink.write_file_from(fprefix + "-chunk-" + to_string(i), stream, entries[i].length);
 			}
 			else
 			{
 				for (int j = 0; j < subchunkentries.size(); j++)
 				{
 					stream.seekg(baseoff + subchunkentries[j].offset);
-					char* dat = new char[subchunkentries[j].length];
-					stream.read(dat, subchunkentries[j].length);
-					std::ofstream ofs((fprefix + "-chunk-" + to_string(i)
-						+ "-data-" + to_string(entriesread++)).c_str(), std::ios_base::binary);
-					ofs.write(dat, subchunkentries[j].length);
-					delete[] dat;
+					sink.write_file_from(fprefix + "-chunk-" + to_string(i)
+						+ "-data-" + to_string(entriesread++), stream, subchunkentries[j].length);
 					++results.data_ripped;
 				}
 			}
@@ -172,8 +174,8 @@ RipperFormats::RipResults CandyAdvRip::rip(RipUtil::MembufStream& stream, const
 					bmap.set_palette_8bit_grayscale();
 
 				cndadv_decode_image(stream, grptab.entries[j], bmap);
-				write_bitmapdata_8bitpalettized_bmp(bmap, fprefix + "-anim-"
-					+ to_string(i) + "-frame-" + to_string(j) + ".bmp");
+				write_bitmapdata_8bitpalettized(sink, bmap, fprefix + "-anim-"
+					+ to_string(i) + "-frame-" + to_string(j), ripset.imageformat);
 				++results.animation_frames_ripped;
 			}
 			++results.animations_ripped;
@@ -215,7 +217,7 @@ RipperFormats::RipResults CandyAdvRip::rip(RipUtil::MembufStream& stream, const
 					background.set_palette_8bit_grayscale();
 
 				cndadv_read_blockdata(stream, background, 640, 480, 32, 32);
-				write_bitmapdata_8bitpalettized_bmp(background, fprefix + "-bmap-" + to_string(i) + ".bmp");
+				write_bitmapdata_8bitpalettized(sink, background, fprefix + "-bmap-" + to_string(i), ripset.imageformat);
 				++results.graphics_ripped;
 			}
 
@@ -237,8 +239,8 @@ RipperFormats::RipResults CandyAdvRip::rip(RipUtil::MembufStream& stream, const
 						bmap.set_palette_8bit_grayscale();
 
 					cndadv_decode_image(stream, grpanitab.entries[j], bmap);
-					write_bitmapdata_8bitpalettized_bmp(bmap, fprefix + "-bmap-" + to_string(i)
-						+ "-anim-" + to_string(j) + ".bmp");
+					write_bitmapdata_8bitpalettized(sink, bmap, fprefix + "-bmap-" + to_string(i)
+						+ "-anim-" + to_string(j), ripset.imageformat);
 					++results.animation_frames_ripped;
 				}
 				++results.animations_ripped;
@@ -263,17 +265,21 @@ RipperFormats::RipResults CandyAdvRip::rip(RipUtil::MembufStream& stream, const
 				PCMData wave(sndlen, 1, 11025, 8);
 				wave.set_signed(DatManip::has_sign);
 				stream.read(wave.get_waveform(), sndlen);
+				wave.convert_signedness(DatManip::has_nosign);
 				if (ripset.numloops > 0)
 				{
 					wave.set_looping(true);
 					wave.set_loopstart(0);
 					wave.set_loopend(sndlen);
-					wave.add_loop(wave.get_loopstart(), wave.get_loopend(), ripset.numloops - 1,
-						ripset.loopstyle, ripset.loopfadelen, ripset.loopfadesil);
+					write_pcmdata_looped(sink, wave, fprefix + "-roomsnd-"
+						+ to_string(i), ripset.audioformat, 
+						wave.get_loopstart(), wave.get_loopend(),
+						ripset.numloops - 1, ripset.loopstyle, ripset.loopfadelen, 
+						ripset.loopfadesil);
 				}
-				wave.convert_signedness(DatManip::has_nosign);
-				write_pcmdata_wave(wave, fprefix + "-roomsnd-"
-					+ to_string(i) + ".wav");
+				else
+					write_pcmdata(sink, wave, fprefix + "-roomsnd-"
+						+ to_string(i), ripset.audioformat);
 				++results.audio_ripped;
 			}
 		}
@@ -296,6 +302,8 @@ RipperFormats::RipResults CandyAdvRip::rip(RipUtil::MembufStream& stream, const
 			wave.resize_wave(subchunkentries[i].length);
 			stream.read(wave.get_waveform(), subchunkentries[i].length);
 
+			wave.convert_signedness(DatManip::has_nosign);
+
 			// set loop
 			// sounds that loop always do so beginning to end
 			// looped sounds aren't marked, so this is hardcoded
@@ -309,13 +317,14 @@ RipperFormats::RipResults CandyAdvRip::rip(RipUtil::MembufStream& stream, const
 				wave.set_looping(true);
 				wave.set_loopstart(0);
 				wave.set_loopend(subchunkentries[i].length);
-				wave.add_loop(wave.get_loopstart(), wave.get_loopend(), ripset.numloops - 1,
+				write_pcmdata_looped(sink, wave, fprefix + "-snd-" + 
+					to_string(results.audio_ripped++), ripset.audioformat, 
+					wave.get_loopstart(), wave.get_loopend(), ripset.numloops - 1,
 					ripset.loopstyle, ripset.loopfadelen, ripset.loopfadesil);
 			}
-
-			wave.convert_signedness(DatManip::has_nosign);
-			write_pcmdata_wave(wave, fprefix + "-snd-" + 
-				to_string(results.audio_ripped++) + ".wav");
+			else
+				write_pcmdata(sink, wave, fprefix + "-snd-" + 
+					to_string(results.audio_ripped++), ripset.audioformat);
 		}
 	}
 
@@ -323,6 +332,30 @@ RipperFormats::RipResults CandyAdvRip::rip(RipUtil::MembufStream& stream, const
 	return results;
 }
 
+bool CandyAdvRip::list_contents(RipUtil::MembufStream& stream, const RipperFormats::RipperSettings& ripset,
+	const RipperFormats::FileFormatData& fmtdat, std::vector<RipperFormats::ContentsEntry>& contents)
+{
+	stream.seekg(0);
+	std::vector<CandyAdvOfftabEntry> entries;
+	cndadv_read_offtab(stream, entries);
+
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		int baseoff = entries[i].offset;
+		contents.push_back(ContentsEntry(0, "chunk", baseoff, entries[i].length, i));
+
+		stream.seekg(baseoff);
+		std::vector<CandyAdvOfftabEntry> subchunkentries;
+		cndadv_read_offtab(stream, subchunkentries);
+		for (size_t j = 0; j < subchunkentries.size(); j++)
+		{
+			contents.push_back(ContentsEntry(1, "data", baseoff + subchunkentries[j].offset,
+				subchunkentries[j].length, j));
+		}
+	}
+	return true;
+}
+
 void CandyAdvRip::cndadv_read_offtab(RipUtil::MembufStream& stream, 
 	std::vector<CandyAdvOfftabEntry>& entries)
 {
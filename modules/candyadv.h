@@ -35,12 +35,19 @@ public:
 		RipModule::unsupported,
 		RipModule::unsupported) { };
 
+	bool check_header(const char* header, int len, int fsize,
+		const RipperFormats::RipperSettings& ripset);
+
 	bool can_rip(RipUtil::MembufStream& stream, const RipperFormats::RipperSettings& ripset,
 		RipperFormats::FileFormatData& fmtdat);
 
-	RipperFormats::RipResults rip(RipUtil::MembufStream& stream, const std::string& fprefix,
+	RipperFormats::RipResults rip(RipUtil::MembufStream& stream, RipUtil::OutputSink& sink,
+		const std::string& fprefix,
 		const RipperFormats::RipperSettings& ripset, const RipperFormats::FileFormatData& fmtdat);
 
+	bool list_contents(RipUtil::MembufStream& stream, const RipperFormats::RipperSettings& ripset,
+		const RipperFormats::FileFormatData& fmtdat, std::vector<RipperFormats::ContentsEntry>& contents);
+
 
 private:
 	
@@ -9,9 +9,11 @@
 #include "../utils/DatManip.h"
 #include "../utils/ErrorLog.h"
 #include "../utils/logger.h"
+#include "../utils/DefaultException.h"
+#include "../utils/MemoryBudget.h"
 #include "../RipperFormats.h"
 #include "common.h"
-#include <fstream>
+#include <sstream>
 #include <string>
 #include <cstring>
 #include <iostream>
@@ -26,6 +28,25 @@ namespace Humongous
 {
 
 
+bool HERip::check_header(const char* header, int len, int fsize,
+	const RipperFormats::RipperSettings& ripset)
+{
+	// can_rip tries the given encoding, then 0x69, then none
+	char encodings[3] = { (char)ripset.encoding, 0x69, 0 };
+	for (int i = (ripset.encoding != 0) ? 0 : 1; i < 3; i++)
+	{
+		// first chunk is a container as big as the file
+		char hdcheck[8];
+		for (int j = 0; j < 8; j++)
+			hdcheck[j] = header[j] ^ encodings[i];
+		if ((quickcmp(hdcheck, id_LECF, 4) || quickcmp(hdcheck, id_TLKB, 4)
+			|| quickcmp(hdcheck, id_SONG, 4) || quickcmp(hdcheck, id_MRAW, 4))
+			&& to_int(hdcheck + 4, 4) == fsize)
+			return true;
+	}
+	return false;
+}
+
 bool HERip::can_rip(RipUtil::MembufStream& stream, const RipperFormats::RipperSettings& ripset,
 		RipperFormats::FileFormatData& fmtdat)
 {
@@ -159,7 +180,8 @@ bool HERip::can_rip(RipUtil::MembufStream& stream, const RipperFormats::RipperSe
 	return false;
 }
 
-RipperFormats::RipResults HERip::rip(RipUtil::MembufStream& stream, const std::string& fprefix,
+RipperFormats::RipResults HERip::rip(RipUtil::MembufStream& stream, RipUtil::OutputSink& sink,
+		const std::string& fprefix,
 		const RipperFormats::RipperSettings& ripset, const RipperFormats::FileFormatData& fmtdat)
 {
 	disablelog ? logger.disable() :
@@ -181,39 +203,41 @@ RipperFormats::RipResults HERip::rip(RipUtil::MembufStream& stream, const std::s
 	{
 		logger.qprint("decoding only");
 
-		std::ofstream ofs((fprefix + "-decoded").c_str(),
-		    std::ios_base::binary);
-		char* outbytes = new char[stream.get_fsize()];
-		stream.read(outbytes, stream.get_fsize());
-		ofs.write(outbytes, stream.get_fsize());
-		delete[] outbytes;
+		sink.write_file_from(fprefix + "-decoded", stream, stream.get_fsize());
 		return results;
 	}
 
+	if (ripset.select != "")
+	{
+		if (formatsubtype != lecf_type1 && formatsubtype != lecf_type2)
+			throw(DefaultException("-select only applies to HE room files (.he1, .(a))"));
+		check_selector(ripset);
+	}
+
 	// HE1/(A) data file
 	if (formatsubtype == lecf_type1 || formatsubtype == lecf_type2)
 	{
-		rip_lecf(stream, fprefix, ripset, fmtdat, results);
+		rip_lecf(stream, sink, fprefix, ripset, fmtdat, results);
 	}
 	// HE2 dialog file
 	else if (formatsubtype == tlkb_type1)
 	{
-		rip_tlkb(stream, fprefix, ripset, fmtdat, results);
+		rip_tlkb(stream, sink, fprefix, ripset, fmtdat, results);
 	}
 	// HE4, type 1 or 2
 	else if (formatsubtype == song_type1 || formatsubtype == song_type2)
 	{
-		rip_song_type12(stream, fprefix, ripset, fmtdat, results);
+		rip_song_type12(stream, sink, fprefix, ripset, fmtdat, results);
 	}
 	// HE4, type 3 or 4
 	else if (formatsubtype == song_type3 || formatsubtype == song_type4)
 	{
-		rip_song_type34(stream, fprefix, ripset, fmtdat, results);
+		rip_song_type34(stream, sink, fprefix, ripset, fmtdat, results);
 	}
 	// DMU music file
 	else if (formatsubtype == song_dmu)
 	{
-		rip_song_dmu(stream, fprefix, ripset, fmtdat, results);
+		rip_song_dmu(stream, sink, fprefix, ripset, fmtdat, results);
 	}
 
 	if (logger.get_errflag())
@@ -232,6 +256,134 @@ RipperFormats::RipResults HERip::rip(RipUtil::MembufStream& stream, const std::s
 	return results;
 }
 
+bool HERip::list_contents(RipUtil::MembufStream& stream, const RipperFormats::RipperSettings& ripset,
+	const RipperFormats::FileFormatData& fmtdat, std::vector<RipperFormats::ContentsEntry>& contents)
+{
+	if (encoding != -1)
+		stream.set_decoding_byte(encoding);
+
+	stream.seekg(0);
+
+	// HE4: the song header lists the songs
+	if (formatsubtype == song_type1 || formatsubtype == song_type2
+		|| formatsubtype == song_type3 || formatsubtype == song_type4)
+	{
+		SputmChunkHead songhd;
+		read_sputm_chunkhead(stream, songhd);
+		contents.push_back(ContentsEntry(0, songhd.name, songhd.address, songhd.size));
+
+		SONGHeader song_header;
+		if (formatsubtype == song_type1 || formatsubtype == song_type2)
+		{
+			SputmChunkHead sghdhd;
+			read_sputm_chunkhead(stream, sghdhd);
+			stream.seekg(sghdhd.address);
+			read_songhead_type1(stream, song_header);
+		}
+		else
+			read_songhead_type234(stream, song_header);
+
+		for (std::vector<SONGEntry>::size_type i = 0;
+			i < song_header.song_entries.size(); i++)
+		{
+			const SONGEntry& songe = song_header.song_entries[i];
+			stream.seekg(songe.address);
+			SputmChunkHead hdcheck;
+			read_sputm_chunkhead(stream, hdcheck);
+			contents.push_back(ContentsEntry(1, hdcheck.name, songe.address, songe.length,
+				songe.idnum));
+		}
+	}
+	// everything else is a tree of chunks
+	else
+		list_chunks(stream, stream.get_fsize(), 0, contents);
+
+	return true;
+}
+
+void HERip::list_chunks(RipUtil::MembufStream& stream, int end, int depth,
+	std::vector<RipperFormats::ContentsEntry>& contents)
+{
+	int rmnum = 0;
+	while (stream.tellg() + 8 <= end)
+	{
+		SputmChunkHead hd;
+		read_sputm_chunkhead(stream, hd);
+		// stop at anything that doesn't fit in its container
+		if (hd.size < 8 || hd.nextaddr() > end)
+			break;
+
+		contents.push_back(ContentsEntry(depth, hd.name, hd.address, hd.size));
+		// rooms are listed with what they contain
+		if (hd.type == lflf)
+		{
+			int roomentry = contents.size() - 1;
+			list_chunks(stream, hd.nextaddr(), depth + 1, contents);
+
+			std::map<std::string, int> counts;
+			for (int i = roomentry + 1; i < (int)contents.size(); i++)
+				++counts[contents[i].type];
+			std::string summary;
+			for (std::map<std::string, int>::iterator it = counts.begin();
+				it != counts.end(); ++it)
+			{
+				if (summary != "")
+					summary += ", ";
+				summary += it->first + " " + to_string(it->second);
+			}
+			contents[roomentry].name = "room " + to_string(rmnum++) + " (" + summary + ")";
+		}
+		else if (hd.type == lecf || hd.type == tlkb)
+			list_chunks(stream, hd.nextaddr(), depth + 1, contents);
+
+		stream.seekg(hd.nextaddr());
+	}
+}
+
+void HERip::check_selector(const RipperFormats::RipperSettings& ripset)
+{
+	AssetSelector sel;
+	parse_selector(ripset.select, sel);
+
+	int room = get_selector_int(sel, "room");
+	if (room == RipConsts::not_set)
+		throw(DefaultException("-select for Humongous files needs a room, "
+			"e.g. room=12,akos=345"));
+	roomstart = room;
+	roomend = room;
+
+	// text and music are written for the whole file, not per asset
+	extdmurip = false;
+	tlkerip = false;
+	metadatarip = false;
+
+	// with no entry named, the whole room is ripped
+	if (sel.size() == 1)
+		return;
+
+	const static int numtypes = 8;
+	const static char* types[numtypes] = { "rmim", "obim", "akos", "awiz", "char",
+		"digi", "talk", "wsou" };
+	bool* ripflags[numtypes] = { &rmimrip, &obimrip, &akosrip, &awizrip, &charrip,
+		&digirip, &talkrip, &wsourip };
+	int found = 0;
+	for (int i = 0; i < numtypes; i++)
+	{
+		int num = get_selector_int(sel, types[i]);
+		if (num != RipConsts::not_set)
+		{
+			*(ripflags[i]) = true;
+			selindex = num;
+			++found;
+		}
+		else
+			*(ripflags[i]) = false;
+	}
+	if (found != 1 || sel.size() != 2)
+		throw(DefaultException("-select for Humongous files takes a room and at most "
+			"one of rmim, obim, akos, awiz, char, digi, talk or wsou"));
+}
+
 void HERip::check_params(const RipperFormats::RipperSettings& ripset)
 {
 	if (!ripset.ripgraphics)
@@ -454,16 +606,14 @@ void HERip::check_params(const RipperFormats::RipperSettings& ripset)
 	}
 }
 
-void HERip::rip_lecf(RipUtil::MembufStream& stream, const std::string& fprefix,
+void HERip::rip_lecf(RipUtil::MembufStream& stream, RipUtil::OutputSink& sink,
+	const std::string& fprefix,
 	const RipperFormats::RipperSettings& ripset, const RipperFormats::FileFormatData& fmtdat,
 	RipperFormats::RipResults& results)
 {
-	// clear any files we need to write to
-	if (metadatarip)
-	{
-		std::ofstream((fprefix + "-metadata.txt").c_str(),
-		    std::ios_base::trunc);
-	}
+	// text outputs are collected across all rooms and written at the end
+	std::ostringstream tlke;
+	std::ostringstream metadata;
 
 	SputmChunkHead lecf_hd;
 	SputmChunk loffc;
@@ -471,6 +621,26 @@ void HERip::rip_lecf(RipUtil::MembufStream& stream, const std::string& fprefix,
 	read_chunk_if_exists(stream, loffc, loff);
 
 	int rmnum = 0;
+	// the index says where each room starts, so rooms before the first
+	// one wanted needn't be walked
+	if (indexcontents && roomstart != not_set)
+	{
+		int room = 0;
+		for (size_t i = 0; i < indexcontents->size(); i++)
+		{
+			const ContentsEntry& entry = (*indexcontents)[i];
+			if (entry.depth != 1 || entry.type != "LFLF")
+				continue;
+			if (room == roomstart)
+			{
+				logger.print("skipping to room " + to_string(room));
+				stream.seekg(entry.offset);
+				rmnum = room;
+				break;
+			}
+			++room;
+		}
+	}
 	while (stream.tellg() < lecf_hd.nextaddr())
 	{
 		if (roomend != not_set && rmnum > roomend)
@@ -488,133 +658,205 @@ void HERip::rip_lecf(RipUtil::MembufStream& stream, const std::string& fprefix,
 			continue;
 		}
 
+		// rooms finished by an interrupted run are skipped, keeping
+		// only their text output (saved as "<tlke length>\n<tlke><metadata>");
+		// rooms left to another shard have none
+		std::string roomtext;
+		if (!sink.begin_unit(stream.tellg(), roomtext))
+		{
+			logger.print("skipping finished room " + to_string(rmnum));
+			std::string::size_type split = roomtext.find('\n');
+			if (split != std::string::npos)
+			{
+				int tlkelen = from_string<int>(roomtext.substr(0, split));
+				tlke << roomtext.substr(split + 1, tlkelen);
+				metadata << roomtext.substr(split + 1 + tlkelen);
+			}
+			SputmChunkHead skiphd;
+			read_sputm_chunkhead(stream, skiphd);
+			stream.seekg(skiphd.nextaddr());
+			++rmnum;
+			continue;
+		}
+		std::ostringstream roomtlke;
+		std::ostringstream roommetadata;
+
 		int starttime = std::clock();
 
 		std::string rmstr = "-room-" + to_string(rmnum);
 
 		logger.print("reading room " + to_string(rmnum) + "...");
 
-		LFLFChunk lflfc;
-		read_lflf(stream, lflfc);
-
-		logger.print("...finished read");
-			
-		starttime = std::clock() - starttime;
-		logger.qprint("\tread time: " + to_string((double)starttime/CLOCKS_PER_SEC)
-			+ " s");
-		logger.qprint("\tread stats:");
-		if (lflfc.rmim_chunk.images.size())
-			logger.qprint("\t\tRMIM: " + to_string(lflfc.rmim_chunk.images.size()));
-		if (lflfc.obim_chunks.size())
-			logger.qprint("\t\tOBIM: " + to_string(lflfc.obim_chunks.size()));
-		if (lflfc.akos_chunks.size())
-			logger.qprint("\t\tAKOS: " + to_string(lflfc.akos_chunks.size()));
-		if (lflfc.awiz_chunks.size())
-			logger.qprint("\t\tAWIZ: " + to_string(lflfc.awiz_chunks.size()));
-		if (lflfc.mult_chunks.size())
-			logger.qprint("\t\tMULT: " + to_string(lflfc.mult_chunks.size()));
-		if (lflfc.char_chunks.size())
-			logger.qprint("\t\tCHAR: " + to_string(lflfc.char_chunks.size()));
-		if (lflfc.digi_chunks.size())
-			logger.qprint("\t\tDIGI: " + to_string(lflfc.digi_chunks.size()));
-		if (lflfc.talk_chunks.size())
-			logger.qprint("\t\tTALK: " + to_string(lflfc.talk_chunks.size()));
-		if (lflfc.wsou_chunks.size())
-			logger.qprint("\t\tWSOU: " + to_string(lflfc.wsou_chunks.size()));
-
-		if (!stream.eof())
+		// a room too big to hold decoded within the memory budget is
+		// read once for each kind of asset being ripped, keeping only
+		// that kind each time
+		int roomaddr = stream.tellg();
+		SputmChunkHead roomhd;
+		read_sputm_chunkhead(stream, roomhd);
+		long long roomshare = get_budget_share(MemoryBudgetConsts::unit_share);
+		std::vector<int> passes;
+		if (roomshare != MemoryBudgetConsts::unlimited && roomhd.size > roomshare)
 		{
-			stream.seekg(lflfc.nextaddr());
+			count_budget_fallback("Humongous rooms read once per kind of asset");
+			if (rmimrip)
+				passes.push_back(lflf_read_rmim);
+			if (obimrip)
+				passes.push_back(lflf_read_obim);
+			if (akosrip || metadatarip)
+				passes.push_back(lflf_read_akos);
+			if (awizrip)
+				passes.push_back(lflf_read_awiz);
+			if (charrip)
+				passes.push_back(lflf_read_char);
+			if (digirip || talkrip)
+				passes.push_back(lflf_read_sound);
+			if (wsourip)
+				passes.push_back(lflf_read_wsou);
 		}
-		else if (stream.eof() && lflfc.nextaddr() < lecf_hd.nextaddr())
+		if (!passes.size())
+			passes.push_back(lflf_read_all);
+
+		for (size_t pass = 0; pass < passes.size(); pass++)
 		{
-			logger.error("stream unexpectedly reached end of file -- "
-				"probably hit a misaligned chunk, recovering to next room");
-			stream.clear();
-			stream.seekg(lflfc.nextaddr());
-		}
+			if (pass > 0)
+				starttime = std::clock();
+			stream.seekg(roomaddr);
+			LFLFChunk lflfc;
+			read_lflf(stream, lflfc, passes[pass]);
 
-		// set alternate transparency color, if requested
-		if (!alttrans)
-			transcol = lflfc.trns_chunk.trns_val;
+			logger.print("...finished read");
+			
+			starttime = std::clock() - starttime;
+			logger.qprint("\tread time: " + to_string((double)starttime/CLOCKS_PER_SEC)
+				+ " s");
+			logger.qprint("\tread stats:");
+			if (lflfc.rmim_chunk.images.size())
+				logger.qprint("\t\tRMIM: " + to_string(lflfc.rmim_chunk.images.size()));
+			if (lflfc.obim_chunks.size())
+				logger.qprint("\t\tOBIM: " + to_string(lflfc.obim_chunks.size()));
+			if (lflfc.akos_chunks.size())
+				logger.qprint("\t\tAKOS: " + to_string(lflfc.akos_chunks.size()));
+			if (lflfc.awiz_chunks.size())
+				logger.qprint("\t\tAWIZ: " + to_string(lflfc.awiz_chunks.size()));
+			if (lflfc.mult_chunks.size())
+				logger.qprint("\t\tMULT: " + to_string(lflfc.mult_chunks.size()));
+			if (lflfc.char_chunks.size())
+				logger.qprint("\t\tCHAR: " + to_string(lflfc.char_chunks.size()));
+			if (lflfc.digi_chunks.size())
+				logger.qprint("\t\tDIGI: " + to_string(lflfc.digi_chunks.size()));
+			if (lflfc.talk_chunks.size())
+				logger.qprint("\t\tTALK: " + to_string(lflfc.talk_chunks.size()));
+			if (lflfc.wsou_chunks.size())
+				logger.qprint("\t\tWSOU: " + to_string(lflfc.wsou_chunks.size()));
+
+			if (!stream.eof())
+			{
+				stream.seekg(lflfc.nextaddr());
+			}
+			else if (stream.eof() && lflfc.nextaddr() < lecf_hd.nextaddr())
+			{
+				logger.error("stream unexpectedly reached end of file -- "
+					"probably hit a misaligned chunk, recovering to next room");
+				stream.clear();
+				stream.seekg(lflfc.nextaddr());
+			}
 
-		if (rmimrip && lflfc.rmim_chunk.type == rmim)
-		{
-			logger.print("\tripping RMIM");
-			rip_rmim(lflfc, ripset, fprefix + rmstr, results, transcol);
-		}
+			// set alternate transparency color, if requested
+			if (!alttrans)
+				transcol = lflfc.trns_chunk.trns_val;
 
-		if (obimrip && lflfc.obim_chunks.size())
-		{
-			logger.print("\tripping OBIM");
-			rip_obim(lflfc, ripset, fprefix + rmstr, results, transcol);
-		}
+			if (rmimrip && lflfc.rmim_chunk.type == rmim)
+			{
+				logger.print("\tripping RMIM");
+				rip_rmim(lflfc, ripset, sink, fprefix + rmstr, results, transcol, selindex);
+			}
 
-		if (akosrip && lflfc.akos_chunks.size())
-		{
-			logger.print("\tripping AKOS");
-			rip_akos(lflfc, ripset, fprefix + rmstr, results, transcol);
-		}
+			if (obimrip && lflfc.obim_chunks.size())
+			{
+				logger.print("\tripping OBIM");
+				rip_obim(lflfc, ripset, sink, fprefix + rmstr, results, transcol, selindex);
+			}
 
-		if (awizrip && lflfc.awiz_chunks.size())
-		{
-			logger.print("\tripping AWIZ");
-			rip_awiz(lflfc, ripset, fprefix + rmstr, results, transcol);
-		}
+			if (akosrip && lflfc.akos_chunks.size())
+			{
+				logger.print("\tripping AKOS");
+				rip_akos(lflfc, ripset, sink, fprefix + rmstr, results, transcol, selindex);
+			}
 
-		if (charrip && lflfc.char_chunks.size())
-		{
-			logger.print("\tripping CHAR");
-			rip_char(lflfc, ripset, fprefix + rmstr, results, transcol);
-		}
+			if (awizrip && lflfc.awiz_chunks.size())
+			{
+				logger.print("\tripping AWIZ");
+				rip_awiz(lflfc, ripset, sink, fprefix + rmstr, results, transcol, selindex);
+			}
 
-		if (digirip && lflfc.digi_chunks.size())
-		{
-			logger.print("\tripping DIGI");
-			rip_sound(lflfc.digi_chunks, ripset, fprefix + rmstr + "-digi-",
-				results);
-		}
+			if (charrip && lflfc.char_chunks.size())
+			{
+				logger.print("\tripping CHAR");
+				rip_char(lflfc, ripset, sink, fprefix + rmstr, results, transcol, selindex);
+			}
 
-		if (talkrip && lflfc.talk_chunks.size())
-		{
-			logger.print("\tripping TALK");
-			rip_sound(lflfc.talk_chunks, ripset, fprefix + rmstr + "-talk-",
-				results);
-		}
+			if (digirip && lflfc.digi_chunks.size())
+			{
+				logger.print("\tripping DIGI");
+				rip_sound(lflfc.digi_chunks, ripset, sink, fprefix + rmstr + "-digi-",
+					results, selindex);
+			}
 
-		if (wsourip && lflfc.wsou_chunks.size())
-		{
-			logger.print("\tripping WSOU");
-			rip_wsou(lflfc, ripset, fprefix + rmstr, results,
-				// override decoding settings if normaliziation requested
-				ripset.normalize ? true : ripset.decode_audio);
-		}
+			if (talkrip && lflfc.talk_chunks.size())
+			{
+				logger.print("\tripping TALK");
+				rip_sound(lflfc.talk_chunks, ripset, sink, fprefix + rmstr + "-talk-",
+					results, selindex);
+			}
 
-		if (extdmurip && lflfc.fmus_chunks.size())
-		{
-			rip_extdmu(lflfc, fprefix, ripset, fmtdat, results);
-		}
+			if (wsourip && lflfc.wsou_chunks.size())
+			{
+				logger.print("\tripping WSOU");
+				rip_wsou(lflfc, ripset, sink, fprefix + rmstr, results,
+					// override decoding settings if normaliziation requested
+					ripset.normalize ? true : ripset.decode_audio, selindex);
+			}
 
-		if (tlkerip && lflfc.tlke_chunks.size())
-		{
-			logger.print("\tripping TLKE");
-			rip_tlke(lflfc, ripset, fprefix + "-tlke.txt",
-				rmnum, results);
-		}
+			if (extdmurip && pass == 0 && lflfc.fmus_chunks.size())
+			{
+				rip_extdmu(lflfc, sink, fprefix, ripset, fmtdat, results);
+			}
 
-		if (metadatarip)
-		{
-			logger.print("\tripping metadata");
-			rip_metadata(lflfc, ripset, fprefix + "-metadata.txt", 
-				rmnum, results);
+			if (tlkerip && pass == 0 && lflfc.tlke_chunks.size())
+			{
+				logger.print("\tripping TLKE");
+				rip_tlke(lflfc, ripset, roomtlke, rmnum, results);
+			}
+
+			if (metadatarip && (passes[pass] & lflf_read_akos || passes.size() == 1))
+			{
+				logger.print("\tripping metadata");
+				rip_metadata(lflfc, ripset, roommetadata, rmnum, results);
+			}
 		}
 
+		tlke << roomtlke.str();
+		metadata << roommetadata.str();
+		sink.end_unit(to_string(roomtlke.str().size()) + "\n"
+			+ roomtlke.str() + roommetadata.str());
+
 	++rmnum;
 
 	}
+
+	// only create the TLKE file if there were TLKEs to rip
+	std::string text = tlke.str();
+	if (text.size())
+		sink.write_file(fprefix + "-tlke.txt", text.c_str(), text.size());
+	if (metadatarip)
+	{
+		text = metadata.str();
+		sink.write_file(fprefix + "-metadata.txt", text.c_str(), text.size());
+	}
 }
 
-void HERip::rip_tlkb(RipUtil::MembufStream& stream, const std::string& fprefix,
+void HERip::rip_tlkb(RipUtil::MembufStream& stream, RipUtil::OutputSink& sink,
+	const std::string& fprefix,
 	const RipperFormats::RipperSettings& ripset, const RipperFormats::FileFormatData& fmtdat,
 	RipperFormats::RipResults& results)
 {
@@ -641,9 +883,9 @@ void HERip::rip_tlkb(RipUtil::MembufStream& stream, const std::string& fprefix,
 			if (ripset.normalize)
 				soundc.wave.normalize();
 
-			write_pcmdata_wave(soundc.wave, fprefix
-				+ "-tlkb-talk-" + to_string(sndnum)
-				+ ".wav",
+			write_pcmdata(sink, soundc.wave, fprefix
+				+ "-tlkb-talk-" + to_string(sndnum),
+				ripset.audioformat,
 				ripset.ignorebytes,
 				ripset.ignoreend);
 
@@ -665,9 +907,9 @@ void HERip::rip_tlkb(RipUtil::MembufStream& stream, const std::string& fprefix,
 				if (ripset.normalize)
 					wave.normalize();
 
-				write_pcmdata_wave(wave, fprefix
-					+ "-tlkb-wsou-" + to_string(sndnum)
-					+ ".wav",
+				write_pcmdata(sink, wave, fprefix
+					+ "-tlkb-wsou-" + to_string(sndnum),
+					ripset.audioformat,
 					ripset.ignorebytes,
 					ripset.ignoreend);
 
@@ -675,11 +917,9 @@ void HERip::rip_tlkb(RipUtil::MembufStream& stream, const std::string& fprefix,
 			}
 			else
 			{
-				std::ofstream ofs((fprefix
+				sink.write_file(fprefix
 					+ "-tlkb-wsou-" + to_string(sndnum)
-					+ ".wav").c_str(),
-					    std::ios_base::binary);
-				ofs.write(riffe.riffdat, riffe.riffdat_size);
+					+ ".wav", riffe.riffdat, riffe.riffdat_size);
 
 				++results.audio_ripped;
 			}
@@ -761,7 +1001,8 @@ void HERip::rip_tlkb(RipUtil::MembufStream& stream, const std::string& fprefix,
 	}
 }
 
-void HERip::rip_song_type12(RipUtil::MembufStream& stream, const std::string& fprefix,
+void HERip::rip_song_type12(RipUtil::MembufStream& stream, RipUtil::OutputSink& sink,
+	const std::string& fprefix,
 	const RipperFormats::RipperSettings& ripset, const RipperFormats::FileFormatData& fmtdat,
 	RipperFormats::RipResults& results)
 {
@@ -778,10 +1019,11 @@ void HERip::rip_song_type12(RipUtil::MembufStream& stream, const std::string& fp
 	read_songhead_type1(stream, song_header);
 	stream.seekg(sghdhd.nextaddr());
 
-	rip_song_entries(stream, song_header, fprefix, ripset, results);
+	rip_song_entries(stream, song_header, sink, fprefix, ripset, results);
 }
 
-void HERip::rip_song_type34(RipUtil::MembufStream& stream, const std::string& fprefix,
+void HERip::rip_song_type34(RipUtil::MembufStream& stream, RipUtil::OutputSink& sink,
+	const std::string& fprefix,
 	const RipperFormats::RipperSettings& ripset, const RipperFormats::FileFormatData& fmtdat,
 	RipperFormats::RipResults& results)
 {
@@ -793,11 +1035,12 @@ void HERip::rip_song_type34(RipUtil::MembufStream& stream, const std::string& fp
 	SONGHeader song_header;
 	read_songhead_type234(stream, song_header);
 
-	rip_song_entries(stream, song_header, fprefix, ripset, results);
+	rip_song_entries(stream, song_header, sink, fprefix, ripset, results);
 }
 
 void HERip::rip_song_entries(RipUtil::MembufStream& stream, const SONGHeader& song_header,
-	const std::string& fprefix, const RipperFormats::RipperSettings& ripset, 
+	RipUtil::OutputSink& sink, const std::string& fprefix,
+	const RipperFormats::RipperSettings& ripset, 
 	RipperFormats::RipResults& results)
 {
 	for (std::vector<SONGEntry>::size_type i = 0;
@@ -829,9 +1072,9 @@ void HERip::rip_song_entries(RipUtil::MembufStream& stream, const SONGHeader& so
 			if (ripset.normalize)
 				soundc.wave.normalize();
 
-			write_pcmdata_wave(soundc.wave, fprefix
-				+ "-song-digi-" + to_string(i)
-				+ ".wav",
+			write_pcmdata(sink, soundc.wave, fprefix
+				+ "-song-digi-" + to_string(i),
+				ripset.audioformat,
 				ripset.ignorebytes,
 				ripset.ignoreend);
 
@@ -852,9 +1095,9 @@ void HERip::rip_song_entries(RipUtil::MembufStream& stream, const SONGHeader& so
 				if (ripset.normalize)
 					wave.normalize();
 
-				write_pcmdata_wave(wave, fprefix
-					+ "-song-riff-" + to_string(i)
-					+ ".wav",
+				write_pcmdata(sink, wave, fprefix
+					+ "-song-riff-" + to_string(i),
+					ripset.audioformat,
 					ripset.ignorebytes,
 					ripset.ignoreend);
 
@@ -864,13 +1107,9 @@ void HERip::rip_song_entries(RipUtil::MembufStream& stream, const SONGHeader& so
 			{
 				// RIFF uses little-endian, noninclusive chunk sizes
 				int sz = set_end(hdcheck.size, 4, DatManip::le) + 8;
-				char* data = new char[sz];
-				stream.read(data, sz);
-				std::ofstream ofs((fprefix
+				sink.write_file_from(fprefix
 					+ "-song-riff-" + to_string(i)
-					+ ".wav").c_str(), std::ios_base::binary);
-				ofs.write(data, sz);
-				delete[] data;
+					+ ".wav", stream, sz);
 
 				++results.audio_ripped;
 			}
@@ -886,9 +1125,9 @@ void HERip::rip_song_entries(RipUtil::MembufStream& stream, const SONGHeader& so
 			if (ripset.normalize)
 				wave.normalize();
 
-			write_pcmdata_wave(wave, fprefix
-				+ "-song-unheadered-" + to_string(i)
-				+ ".wav",
+			write_pcmdata(sink, wave, fprefix
+				+ "-song-unheadered-" + to_string(i),
+				ripset.audioformat,
 				ripset.ignorebytes,
 				ripset.ignoreend);
 
@@ -907,7 +1146,8 @@ void HERip::rip_song_entries(RipUtil::MembufStream& stream, const SONGHeader& so
 	}
 }
 
-void HERip::rip_song_dmu(RipUtil::MembufStream& stream, const std::string& fprefix,
+void HERip::rip_song_dmu(RipUtil::MembufStream& stream, RipUtil::OutputSink& sink,
+	const std::string& fprefix,
 	const RipperFormats::RipperSettings& ripset, const RipperFormats::FileFormatData& fmtdat,
 	RipperFormats::RipResults& results)
 {
@@ -924,15 +1164,16 @@ void HERip::rip_song_dmu(RipUtil::MembufStream& stream, const std::string& fpref
 	if (ripset.normalize)
 		soundc.wave.normalize();
 
-	write_pcmdata_wave(soundc.wave, fprefix
-		+ ".wav",
+	write_pcmdata(sink, soundc.wave, fprefix,
+		ripset.audioformat,
 		ripset.ignorebytes,
 		ripset.ignoreend);
 
 	++results.audio_ripped;
 }
 
-void HERip::rip_extdmu(const LFLFChunk& lflfc, const std::string& fprefix, 
+void HERip::rip_extdmu(const LFLFChunk& lflfc, RipUtil::OutputSink& sink,
+	const std::string& fprefix, 
 	const RipperFormats::RipperSettings& ripset, 
 	const RipperFormats::FileFormatData& fmtdat, 
 	RipperFormats::RipResults& results)
@@ -957,7 +1198,7 @@ void HERip::rip_extdmu(const LFLFChunk& lflfc, const std::string& fprefix,
 		if (file_exists(filepath))
 		{
 			RipUtil::MembufStream dmustream(filepath, RipUtil::MembufStream::rb);
-			rip_song_dmu(dmustream, fprefix + "-" + strip_extension(filename), 
+			rip_song_dmu(dmustream, sink, fprefix + "-" + strip_extension(filename), 
 				ripset, fmtdat, results);
 		}
 		else
@@ -29,43 +29,57 @@ public:
 		rmimrip(true), obimrip(true), akosrip(true), awizrip(true), charrip(true),
 		digirip(true), talkrip(true), wsourip(true), extdmurip(true), tlkerip(true),
 		metadatarip(true), alttrans(false), transcol(not_set),
-		disablelog(false) { };
+		disablelog(false), selindex(not_set) { };
+
+	bool check_header(const char* header, int len, int fsize,
+		const RipperFormats::RipperSettings& ripset);
 
 	bool can_rip(RipUtil::MembufStream& stream, const RipperFormats::RipperSettings& ripset,
 		RipperFormats::FileFormatData& fmtdat);
 
-	RipperFormats::RipResults rip(RipUtil::MembufStream& stream, const std::string& fprefix,
+	RipperFormats::RipResults rip(RipUtil::MembufStream& stream, RipUtil::OutputSink& sink,
+		const std::string& fprefix,
 		const RipperFormats::RipperSettings& ripset, const RipperFormats::FileFormatData& fmtdat);
 
-	void rip_lecf(RipUtil::MembufStream& stream, const std::string& fprefix,
+	void rip_lecf(RipUtil::MembufStream& stream, RipUtil::OutputSink& sink,
+		const std::string& fprefix,
 		const RipperFormats::RipperSettings& ripset, const RipperFormats::FileFormatData& fmtdat,
 		RipperFormats::RipResults& results);
 
-	void rip_tlkb(RipUtil::MembufStream& stream, const std::string& fprefix,
+	void rip_tlkb(RipUtil::MembufStream& stream, RipUtil::OutputSink& sink,
+		const std::string& fprefix,
 		const RipperFormats::RipperSettings& ripset, const RipperFormats::FileFormatData& fmtdat,
 		RipperFormats::RipResults& results);
 
-	void rip_song_type12(RipUtil::MembufStream& stream, const std::string& fprefix,
+	void rip_song_type12(RipUtil::MembufStream& stream, RipUtil::OutputSink& sink,
+		const std::string& fprefix,
 		const RipperFormats::RipperSettings& ripset, const RipperFormats::FileFormatData& fmtdat,
 		RipperFormats::RipResults& results);
 
-	void rip_song_type34(RipUtil::MembufStream& stream, const std::string& fprefix,
+	void rip_song_type34(RipUtil::MembufStream& stream, RipUtil::OutputSink& sink,
+		const std::string& fprefix,
 		const RipperFormats::RipperSettings& ripset, const RipperFormats::FileFormatData& fmtdat,
 		RipperFormats::RipResults& results);
 
 	void rip_song_entries(RipUtil::MembufStream& stream, const SONGHeader& song_header,
-		const std::string& fprefix, const RipperFormats::RipperSettings& ripset, 
+		RipUtil::OutputSink& sink, const std::string& fprefix,
+		const RipperFormats::RipperSettings& ripset, 
 		RipperFormats::RipResults& results);
 
-	void rip_song_dmu(RipUtil::MembufStream& stream, const std::string& fprefix,
+	void rip_song_dmu(RipUtil::MembufStream& stream, RipUtil::OutputSink& sink,
+		const std::string& fprefix,
 		const RipperFormats::RipperSettings& ripset, const RipperFormats::FileFormatData& fmtdat,
 		RipperFormats::RipResults& results);
 
-	void rip_extdmu(const LFLFChunk& lflfc, const std::string& fprefix, 
+	void rip_extdmu(const LFLFChunk& lflfc, RipUtil::OutputSink& sink,
+		const std::string& fprefix, 
 		const RipperFormats::RipperSettings& ripset, 
 		const RipperFormats::FileFormatData& fmtdat, 
 		RipperFormats::RipResults& results);
 
+	bool list_contents(RipUtil::MembufStream& stream, const RipperFormats::RipperSettings& ripset,
+		const RipperFormats::FileFormatData& fmtdat, std::vector<RipperFormats::ContentsEntry>& contents);
+
 private:
 	const static int not_set = -1;	// placeholder for unset data
 
@@ -102,11 +116,20 @@ private:
 
 	bool disablelog;
 
+	int selindex;		// number of the one entry of its type to rip, if any
+
+	// list the chunks from the get position up to end, and those in
+	// any rooms or other containers among them
+	void list_chunks(RipUtil::MembufStream& stream, int end, int depth,
+		std::vector<RipperFormats::ContentsEntry>& contents);
+
 	void check_params(const RipperFormats::RipperSettings& ripset);
+	// narrow the rip down to the room and entry named with -select
+	void check_selector(const RipperFormats::RipperSettings& ripset);
 
 };
 
 
 };	// end of namespace Humongous
 
-#pragma once
\ No newline at end of file
+#pragma once
\ No newline at end of file
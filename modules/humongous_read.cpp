@@ -189,7 +189,7 @@ bool read_chunk_if_exists(RipUtil::MembufStream& stream, SputmChunk& dest,
 
 
 
-void read_lflf(RipUtil::MembufStream& stream, LFLFChunk& lflfc)
+void read_lflf(RipUtil::MembufStream& stream, LFLFChunk& lflfc, int parts)
 {
 	logger.qprint("\tinitiating LFLF read at " + to_string(stream.tellg()));
 
@@ -208,6 +208,8 @@ void read_lflf(RipUtil::MembufStream& stream, LFLFChunk& lflfc)
 
 		case rmim:
 		{
+			if (!(parts & lflf_read_rmim))
+				break;
 			read_rmim(stream, lflfc.rmim_chunk);
 			break;
 		}
@@ -252,6 +254,8 @@ void read_lflf(RipUtil::MembufStream& stream, LFLFChunk& lflfc)
 
 		case obim:
 		{
+			if (!(parts & lflf_read_obim))
+				break;
 			OBIMChunk obimc;
 			read_obim(stream, obimc);
 			lflfc.obim_chunks[obimc.imhd_chunk.id] = obimc;
@@ -357,6 +361,8 @@ void read_lflf(RipUtil::MembufStream& stream, LFLFChunk& lflfc)
 			}
 			else if (souncheck.type == digi
 			|| souncheck.type == talk) { /* fall through */ }
+			else if (!(parts & lflf_read_sound))
+				break;
 			else
 			{
 				logger.warning("unrecognized SOUN subchunk "
@@ -379,6 +385,8 @@ void read_lflf(RipUtil::MembufStream& stream, LFLFChunk& lflfc)
 
 		case digi: case talk:
 		{
+			if (!(parts & lflf_read_sound))
+				break;
 			SoundChunk soundc;
 			read_digi_talk(stream, soundc);
 			if (soundc.type == digi)
@@ -393,6 +401,8 @@ void read_lflf(RipUtil::MembufStream& stream, LFLFChunk& lflfc)
 
 		case wsou:
 		{
+			if (!(parts & lflf_read_wsou))
+				break;
 			WSOUChunk wsouc;
 			read_wsou(stream, wsouc);
 			lflfc.wsou_chunks.push_back(wsouc);
@@ -401,6 +411,8 @@ void read_lflf(RipUtil::MembufStream& stream, LFLFChunk& lflfc)
 
 		case akos:
 		{
+			if (!(parts & lflf_read_akos))
+				break;
 			AKOSChunk akosc;
 			read_akos(stream, akosc);
 			lflfc.akos_chunks.push_back(akosc);
@@ -409,12 +421,16 @@ void read_lflf(RipUtil::MembufStream& stream, LFLFChunk& lflfc)
 
 		case chunk_char:
 		{
+			if (!(parts & lflf_read_char))
+				break;
 			read_char(stream, lflfc.char_chunks);
 			break;
 		}
 
 		case awiz:
 		{
+			if (!(parts & lflf_read_awiz))
+				break;
 			AWIZChunk awizc;
 			read_awiz(stream, awizc);
 			lflfc.awiz_chunks.push_back(awizc);
@@ -423,6 +439,8 @@ void read_lflf(RipUtil::MembufStream& stream, LFLFChunk& lflfc)
 
 		case mult:
 		{
+			if (!(parts & lflf_read_awiz))
+				break;
 			read_mult(stream, lflfc.mult_chunks);
 			break;
 		}
@@ -55,8 +55,24 @@ template<typename T> int read_chunks_while_exist(RipUtil::MembufStream& stream,
 
 // helper functions for LFLF reading
 
-// read from stream into an LFLFChunk (no ordering enforced)
-void read_lflf(RipUtil::MembufStream& stream, LFLFChunk& lflfc);
+// parts of an LFLF that read_lflf() can skip, to read a large room
+// one kind of asset at a time
+enum LFLFReadParts
+{
+	lflf_read_rmim = 0x01,
+	lflf_read_obim = 0x02,
+	lflf_read_akos = 0x04,
+	lflf_read_awiz = 0x08,	// and MULT
+	lflf_read_char = 0x10,
+	lflf_read_sound = 0x20,	// SOUN samples, DIGI and TALK
+	lflf_read_wsou = 0x40,
+	lflf_read_all = 0x7F
+};
+
+// read from stream into an LFLFChunk (no ordering enforced), reading
+// only the parts given (the smaller chunks are always read)
+void read_lflf(RipUtil::MembufStream& stream, LFLFChunk& lflfc,
+	int parts = lflf_read_all);
 
 // rooms/general
 void read_rmim(RipUtil::MembufStream& stream, RMIMChunk& rmimc);
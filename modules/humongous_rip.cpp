@@ -41,17 +41,19 @@ int akos_2color_decoding_hack_rle_images = 0;
 int akos_2color_decoding_hack_bitmap_images = 0;
 bool akos_2color_decoding_hack_was_user_overriden = false;
 
-// misc stuff
-bool cleared_tlke_file = false;
-
 
 void rip_rmim(const LFLFChunk& lflfc, const RipperFormats::RipperSettings& ripset,
-	const std::string& fprefix, RipperFormats::RipResults& results, int transind)
+	RipUtil::OutputSink& sink, const std::string& fprefix, RipperFormats::RipResults& results, int transind,
+	int only)
 {
 	for (std::vector<RMIMChunk>::size_type i = 0; 
 		i < lflfc.rmim_chunk.images.size(); i++)
 	{
+		if (only != RipConsts::not_set && (int)i != only)
+			continue;
 		const IMxxChunk& imxxc = lflfc.rmim_chunk.images[i];
+		if (!sink.begin_asset(imxxc.address))
+			continue;
 		
 		BitmapData bmp;
 		decode_imxx(imxxc, bmp, lflfc.rmhd_chunk.width, lflfc.rmhd_chunk.height,
@@ -60,8 +62,8 @@ void rip_rmim(const LFLFChunk& lflfc, const RipperFormats::RipperSettings& ripse
 		{
 			bmp.set_palettized(true);
 			bmp.set_palette(lflfc.apals[0]);
-			write_bitmapdata_8bitpalettized_bmp(bmp, fprefix + "-rmim-" 
-				+ to_string(i) + ".bmp");
+			write_bitmapdata_8bitpalettized(sink, bmp, fprefix + "-rmim-" 
+				+ to_string(i), ripset.imageformat);
 			++results.graphics_ripped;
 		}
 		else if (lflfc.apals.size())	// multiple palettes: use full filenames
@@ -71,20 +73,24 @@ void rip_rmim(const LFLFChunk& lflfc, const RipperFormats::RipperSettings& ripse
 				j < lflfc.apals.size(); j++)
 			{
 				bmp.set_palette(lflfc.apals[j]);
-				write_bitmapdata_8bitpalettized_bmp(bmp, fprefix + "-rmim-" 
-					+ to_string(i) + "-apal-" + to_string(j) + ".bmp");
+				write_bitmapdata_8bitpalettized(sink, bmp, fprefix + "-rmim-" 
+					+ to_string(i) + "-apal-" + to_string(j), ripset.imageformat);
 				++results.graphics_ripped;
 			}
 		}
 	}
+	sink.end_asset();
 }
 
 void rip_obim(const LFLFChunk& lflfc, const RipperFormats::RipperSettings& ripset,
-	const std::string& fprefix, RipperFormats::RipResults& results, int transind)
+	RipUtil::OutputSink& sink, const std::string& fprefix, RipperFormats::RipResults& results, int transind,
+	int only)
 {
 	for (std::map<int, OBIMChunk>::const_iterator obim_it = lflfc.obim_chunks.begin(); 
 			obim_it != lflfc.obim_chunks.end(); obim_it++)
 		{
+			if (only != RipConsts::not_set && (*obim_it).first != only)
+				continue;
 			std::map<int, OBCDChunk>::const_iterator obcd_it 
 				= lflfc.obcd_chunks.find((*obim_it).first);
 			// check if this OBIM has a corresponding OBCD
@@ -95,6 +101,8 @@ void rip_obim(const LFLFChunk& lflfc, const RipperFormats::RipperSettings& ripse
 				for (std::vector<IMxxChunk>::size_type i = 0;
 					i < (*obim_it).second.images.size(); i++)
 				{
+					if (!sink.begin_asset((*obim_it).second.images[i].address))
+						continue;
 					BitmapData bmp;
 					decode_imxx((*obim_it).second.images[i], bmp, width, height,
 						lflfc.trns_chunk.trns_val, transind);
@@ -102,8 +110,8 @@ void rip_obim(const LFLFChunk& lflfc, const RipperFormats::RipperSettings& ripse
 					{
 						bmp.set_palettized(true);
 						bmp.set_palette(lflfc.apals[0]);
-						write_bitmapdata_8bitpalettized_bmp(bmp, fprefix + "-obim-" 
-							+ to_string((*obim_it).first) + "-im-" + to_string(i) + ".bmp");
+						write_bitmapdata_8bitpalettized(sink, bmp, fprefix + "-obim-" 
+							+ to_string((*obim_it).first) + "-im-" + to_string(i), ripset.imageformat);
 						++results.graphics_ripped;
 					}
 					else if (lflfc.apals.size())
@@ -113,9 +121,9 @@ void rip_obim(const LFLFChunk& lflfc, const RipperFormats::RipperSettings& ripse
 							j < lflfc.apals.size(); j++)
 						{
 							bmp.set_palette(lflfc.apals[j]);
-							write_bitmapdata_8bitpalettized_bmp(bmp, fprefix + "-obim-" 
+							write_bitmapdata_8bitpalettized(sink, bmp, fprefix + "-obim-" 
 								+ to_string((*obim_it).first) + "-im-" + to_string(i) 
-								+ "-apal-" + to_string(j) + ".bmp");
+								+ "-apal-" + to_string(j), ripset.imageformat);
 							++results.graphics_ripped;
 						}
 					}
@@ -126,15 +134,21 @@ void rip_obim(const LFLFChunk& lflfc, const RipperFormats::RipperSettings& ripse
 				logger.error("OBIM with ID " + to_string((*obim_it).first) + " has no corresponding OBCD");
 			}
 		}
+	sink.end_asset();
 }
 
 void rip_akos(const LFLFChunk& lflfc, const RipperFormats::RipperSettings& ripset,
-	const std::string& fprefix, RipperFormats::RipResults& results, int transind)
+	RipUtil::OutputSink& sink, const std::string& fprefix, RipperFormats::RipResults& results, int transind,
+	int only)
 {
 	for (std::vector<AKOSChunk>::size_type i = 0;
 		i < lflfc.akos_chunks.size(); i++)
 	{
+		if (only != RipConsts::not_set && (int)i != only)
+			continue;
 		const AKOSChunk& akosc = lflfc.akos_chunks[i];
+		if (!sink.begin_asset(akosc.address))
+			continue;
 
 		for (std::vector<AKOFEntry>::size_type j = 0; j < akosc.akof_entries.size(); j++)
 		{
@@ -154,8 +168,8 @@ void rip_akos(const LFLFChunk& lflfc, const RipperFormats::RipperSettings& ripse
 						lflfc.trns_chunk.trns_val, transind,
 						akosc.colormap, true,
 						lflfc.remp_chunk.colormap, false);
-				write_bitmapdata_8bitpalettized_bmp(bmp, fprefix + "-akos-" 
-					+ to_string(i) + "-im-" + to_string(j) + ".bmp");
+				write_bitmapdata_8bitpalettized(sink, bmp, fprefix + "-akos-" 
+					+ to_string(i) + "-im-" + to_string(j), ripset.imageformat);
 				++results.animation_frames_ripped;
 			} 
 			// if palette not full, use room palette(s)
@@ -172,8 +186,8 @@ void rip_akos(const LFLFChunk& lflfc, const RipperFormats::RipperSettings& ripse
 						lflfc.trns_chunk.trns_val, transind,
 						akosc.colormap, true,
 						lflfc.remp_chunk.colormap, false);
-				write_bitmapdata_8bitpalettized_bmp(bmp, fprefix + "-akos-" 
-					+ to_string(i) + "-im-" + to_string(j) + ".bmp");
+				write_bitmapdata_8bitpalettized(sink, bmp, fprefix + "-akos-" 
+					+ to_string(i) + "-im-" + to_string(j), ripset.imageformat);
 				++results.animation_frames_ripped;
 			}
 			else if (lflfc.apals.size())
@@ -192,9 +206,9 @@ void rip_akos(const LFLFChunk& lflfc, const RipperFormats::RipperSettings& ripse
 							lflfc.trns_chunk.trns_val, transind,
 							akosc.colormap, true,
 							lflfc.remp_chunk.colormap, false);
-					write_bitmapdata_8bitpalettized_bmp(bmp, fprefix + "-akos-" 
+					write_bitmapdata_8bitpalettized(sink, bmp, fprefix + "-akos-" 
 						+ to_string(i) + "-im-" + to_string(j)
-						+ "-apal-" + to_string(k) + ".bmp");
+						+ "-apal-" + to_string(k), ripset.imageformat);
 				++results.animation_frames_ripped;
 				}
 			}
@@ -215,20 +229,21 @@ void rip_akos(const LFLFChunk& lflfc, const RipperFormats::RipperSettings& ripse
 			{
 				decode_auxd(auxdc, bmp, lflfc.trns_chunk.trns_val, transind);
 
-				write_bitmapdata_8bitpalettized_bmp(bmp, fprefix
+				write_bitmapdata_8bitpalettized(sink, bmp, fprefix
 					+ "-akos-" + to_string(i)
-					+ "-auxd-" + to_string(j)
-					+ ".bmp");
+					+ "-auxd-" + to_string(j), ripset.imageformat);
 
 				++results.animation_frames_ripped;
 			}
 		}
 		++results.animations_ripped;
 	}
+	sink.end_asset();
 }
 
 void rip_awiz(const LFLFChunk& lflfc, const RipperFormats::RipperSettings& ripset,
-	const std::string& fprefix, RipperFormats::RipResults& results, int transind)
+	RipUtil::OutputSink& sink, const std::string& fprefix, RipperFormats::RipResults& results, int transind,
+	int only)
 {
 	// rewrite these to call a common function
 
@@ -236,7 +251,11 @@ void rip_awiz(const LFLFChunk& lflfc, const RipperFormats::RipperSettings& ripse
 	for (std::vector<AWIZChunk>::size_type i = 0;
 		i < lflfc.awiz_chunks.size(); i++)
 	{
+		if (only != RipConsts::not_set && (int)i != only)
+			continue;
 		const AWIZChunk& awizc = lflfc.awiz_chunks[i];
+		if (!sink.begin_asset(awizc.address))
+			continue;
 
 		// some games have "empty" AWIZs just to make us mad
 		if (awizc.wizd_chunk.type == wizd)
@@ -248,16 +267,16 @@ void rip_awiz(const LFLFChunk& lflfc, const RipperFormats::RipperSettings& ripse
 			{
 				decode_awiz(awizc, bmp, awizc.palette,
 					lflfc.trns_chunk.trns_val, transind);
-				write_bitmapdata_8bitpalettized_bmp(bmp, fprefix
-					+ "-awiz-" + to_string(i) + ".bmp");
+				write_bitmapdata_8bitpalettized(sink, bmp, fprefix
+					+ "-awiz-" + to_string(i), ripset.imageformat);
 				++results.graphics_ripped;
 			}
 			else if (lflfc.apals.size() == 1)
 			{
 				decode_awiz(awizc, bmp, lflfc.apals[0],
 					lflfc.trns_chunk.trns_val, transind);
-				write_bitmapdata_8bitpalettized_bmp(bmp, fprefix
-					+ "-awiz-" + to_string(i) + ".bmp");
+				write_bitmapdata_8bitpalettized(sink, bmp, fprefix
+					+ "-awiz-" + to_string(i), ripset.imageformat);
 				++results.graphics_ripped;
 			}
 			else if (lflfc.apals.size())
@@ -267,9 +286,9 @@ void rip_awiz(const LFLFChunk& lflfc, const RipperFormats::RipperSettings& ripse
 				{
 					decode_awiz(awizc, bmp, lflfc.apals[j],
 						lflfc.trns_chunk.trns_val, transind);
-					write_bitmapdata_8bitpalettized_bmp(bmp, fprefix
+					write_bitmapdata_8bitpalettized(sink, bmp, fprefix
 						+ "-awiz-" + to_string(i) 
-						+ "-apal-" + to_string(j) + ".bmp");
+						+ "-apal-" + to_string(j), ripset.imageformat);
 					++results.graphics_ripped;
 				}
 			}
@@ -278,7 +297,7 @@ void rip_awiz(const LFLFChunk& lflfc, const RipperFormats::RipperSettings& ripse
 
 	// rip MULT-embedded AWIZ
 	for (std::vector<MULTChunk>::size_type i = 0; 
-		i < lflfc.mult_chunks.size(); i++)
+		only == RipConsts::not_set && i < lflfc.mult_chunks.size(); i++)
 	{
 		const MULTChunk& multc = lflfc.mult_chunks[i];
 
@@ -286,6 +305,8 @@ void rip_awiz(const LFLFChunk& lflfc, const RipperFormats::RipperSettings& ripse
 			j < multc.awiz_chunks.size(); j++)
 		{
 			const AWIZChunk& awizc = multc.awiz_chunks[j];
+			if (!sink.begin_asset(awizc.address))
+				continue;
 
 			if (awizc.wizd_chunk.type == wizd)
 			{
@@ -297,9 +318,9 @@ void rip_awiz(const LFLFChunk& lflfc, const RipperFormats::RipperSettings& ripse
 					decode_awiz(awizc, bmp, multc.defa_chunk.palette,
 						lflfc.trns_chunk.trns_val, transind,
 						multc.defa_chunk.rmap_chunk.colormap, multc.defa_chunk.rmap_chunk.colormap.size() != 0);
-					write_bitmapdata_8bitpalettized_bmp(bmp, fprefix
+					write_bitmapdata_8bitpalettized(sink, bmp, fprefix
 						+ "-mult-" + to_string(i)
-						+ "-awiz-" + to_string(j) + ".bmp");
+						+ "-awiz-" + to_string(j), ripset.imageformat);
 					++results.graphics_ripped;
 				}
 				else 
@@ -308,9 +329,9 @@ void rip_awiz(const LFLFChunk& lflfc, const RipperFormats::RipperSettings& ripse
 					decode_awiz(awizc, bmp, awizc.palette,
 						lflfc.trns_chunk.trns_val, transind,
 						multc.defa_chunk.rmap_chunk.colormap, multc.defa_chunk.rmap_chunk.colormap.size() != 0);
-					write_bitmapdata_8bitpalettized_bmp(bmp, fprefix
+					write_bitmapdata_8bitpalettized(sink, bmp, fprefix
 						+ "-mult-" + to_string(i)
-						+ "-awiz-" + to_string(j) + ".bmp");
+						+ "-awiz-" + to_string(j), ripset.imageformat);
 					++results.graphics_ripped;
 				}
 				else if (lflfc.apals.size() == 1)
@@ -318,9 +339,9 @@ void rip_awiz(const LFLFChunk& lflfc, const RipperFormats::RipperSettings& ripse
 					decode_awiz(awizc, bmp, lflfc.apals[0],
 						lflfc.trns_chunk.trns_val, transind,
 						multc.defa_chunk.rmap_chunk.colormap, multc.defa_chunk.rmap_chunk.colormap.size() != 0);
-					write_bitmapdata_8bitpalettized_bmp(bmp, fprefix
+					write_bitmapdata_8bitpalettized(sink, bmp, fprefix
 						+ "-mult-" + to_string(i)
-						+ "-awiz-" + to_string(j) + ".bmp");
+						+ "-awiz-" + to_string(j), ripset.imageformat);
 					++results.graphics_ripped;
 				}
 				else if (lflfc.apals.size() != 0)
@@ -331,20 +352,22 @@ void rip_awiz(const LFLFChunk& lflfc, const RipperFormats::RipperSettings& ripse
 						decode_awiz(awizc, bmp, lflfc.apals[k],
 							lflfc.trns_chunk.trns_val, transind,
 							multc.defa_chunk.rmap_chunk.colormap, multc.defa_chunk.rmap_chunk.colormap.size() != 0);
-						write_bitmapdata_8bitpalettized_bmp(bmp, fprefix
+						write_bitmapdata_8bitpalettized(sink, bmp, fprefix
 							+ "-mult-" + to_string(i)
 							+ "-awiz-" + to_string(j) 
-							+ "-apal-" + to_string(k) + ".bmp");
+							+ "-apal-" + to_string(k), ripset.imageformat);
 						++results.graphics_ripped;
 					}
 				}
 			}
 		}
 	}
+	sink.end_asset();
 }
 
 void rip_char(const LFLFChunk& lflfc, const RipperFormats::RipperSettings& ripset,
-	const std::string& fprefix, RipperFormats::RipResults& results, int transind)
+	RipUtil::OutputSink& sink, const std::string& fprefix, RipperFormats::RipResults& results, int transind,
+	int only)
 {
 	// chars have variable palettes; this one is arbitrary, but
 	// should at least provide distinct tones
@@ -360,7 +383,11 @@ void rip_char(const LFLFChunk& lflfc, const RipperFormats::RipperSettings& ripse
 	for (std::vector<CHARChunk>::size_type i = 0;
 		i < lflfc.char_chunks.size(); i++)
 	{
+		if (only != RipConsts::not_set && (int)i != only)
+			continue;
 		const CHARChunk& charc = lflfc.char_chunks[i];
+		if (!sink.begin_asset(charc.address))
+			continue;
 		for (std::vector<CHAREntry>::size_type j = 0;
 			j < charc.char_entries.size(); j++)
 		{
@@ -368,52 +395,60 @@ void rip_char(const LFLFChunk& lflfc, const RipperFormats::RipperSettings& ripse
 			BitmapData bmp;
 			decode_char(bmp, chare, charc.compr, testpal,
 				lflfc.trns_chunk.trns_val, transind);
-			write_bitmapdata_8bitpalettized_bmp(bmp, fprefix
+			write_bitmapdata_8bitpalettized(sink, bmp, fprefix
 				+ "-char-" + to_string(i)
-				+ "-num-" + to_string(j)
-				+ ".bmp");
+				+ "-num-" + to_string(j), ripset.imageformat);
 			++results.graphics_ripped;
 		}
 	}
+	sink.end_asset();
 }
 
 void rip_sound(std::vector<SoundChunk>& sound_chunks, 
-	const RipperFormats::RipperSettings& ripset, const std::string& fprefix,
-	RipperFormats::RipResults& results)
+	const RipperFormats::RipperSettings& ripset, RipUtil::OutputSink& sink, const std::string& fprefix,
+	RipperFormats::RipResults& results, int only)
 {
 	for (std::vector<SoundChunk>::size_type i = 0;
 		i < sound_chunks.size(); i++)
 	{
+		if (only != RipConsts::not_set && (int)i != only)
+			continue;
 		SoundChunk& soundc = sound_chunks[i];
+		if (!sink.begin_asset(soundc.address))
+			continue;
 
 		if (ripset.normalize)
 			soundc.wave.normalize();
 
-		write_pcmdata_wave(soundc.wave, fprefix
-			+ to_string(i)
-			+ ".wav",
+		write_pcmdata(sink, soundc.wave, fprefix
+			+ to_string(i),
+			ripset.audioformat,
 			ripset.ignorebytes,
 			ripset.ignoreend);
 
 		++results.audio_ripped;
 	}
+	sink.end_asset();
 }
 
 void rip_wsou(const LFLFChunk& lflfc, const RipperFormats::RipperSettings& ripset,
-	const std::string& fprefix, RipperFormats::RipResults& results,
-	bool decode_audio)
+	RipUtil::OutputSink& sink, const std::string& fprefix, RipperFormats::RipResults& results,
+	bool decode_audio, int only)
 {
 	for (std::vector<WSOUChunk>::size_type i = 0;
 		i < lflfc.wsou_chunks.size(); i++)
 	{
+		if (only != RipConsts::not_set && (int)i != only)
+			continue;
+		if (!sink.begin_asset(lflfc.wsou_chunks[i].address))
+			continue;
 		const RIFFEntry& riff_entry = lflfc.wsou_chunks[i].riff_entry;
 
 		if (!decode_audio)
 		{
-			std::ofstream ofs((fprefix
+			sink.write_file(fprefix
 				+ "-wsou-" + to_string(i)
-				+ ".wav").c_str(), std::ios_base::binary);
-			ofs.write(riff_entry.riffdat, riff_entry.riffdat_size);
+				+ ".wav", riff_entry.riffdat, riff_entry.riffdat_size);
 		}
 		else
 		{
@@ -423,46 +458,37 @@ void rip_wsou(const LFLFChunk& lflfc, const RipperFormats::RipperSettings& ripse
 				wave);
 			if (ripset.normalize)
 				wave.normalize();
-			write_pcmdata_wave(wave, fprefix
-				+ "-wsou-" + to_string(i)
-				+ ".wav",
+			write_pcmdata(sink, wave, fprefix
+				+ "-wsou-" + to_string(i),
+				ripset.audioformat,
 				ripset.ignorebytes,
 				ripset.ignoreend);
 		}
 
 		++results.audio_ripped;
 	}
+	sink.end_asset();
 }
 
 void rip_tlke(LFLFChunk& lflfc, const RipperFormats::RipperSettings& ripset,
-	const std::string& filename, int rmnum, RipperFormats::RipResults& results)
+	std::ostream& ostr, int rmnum, RipperFormats::RipResults& results)
 {
-	// only create the TLKE file if there are TLKEs to rip
-	if (!cleared_tlke_file)
-	{
-		std::ofstream(filename.c_str(), std::ios_base::trunc);
-		cleared_tlke_file = true;
-	}
-
-	std::ofstream ofs(filename.c_str(), std::ios_base::app);
-
-	ofs << "room " << rmnum << '\n';
+	ostr << "room " << rmnum << '\n';
 	for (std::vector<TLKEChunk>::size_type i = 0;
 		i < lflfc.tlke_chunks.size(); i++)
 	{
-		ofs << '\t' << lflfc.tlke_chunks[i].text_chunk.text << '\n';
+		ostr << '\t' << lflfc.tlke_chunks[i].text_chunk.text << '\n';
 		++results.strings_ripped;
 	}
-	ofs << '\n';
+	ostr << '\n';
 }
 
 void rip_metadata(const LFLFChunk& lflfc, const RipperFormats::RipperSettings& ripset,
-	const std::string& filename, int rmnum, RipperFormats::RipResults& results)
+	std::ostream& ostr, int rmnum, RipperFormats::RipResults& results)
 {
-	std::ofstream ofs(filename.c_str(), std::ios_base::app);
-	ofs << "room " << rmnum << '\n';
+	ostr << "room " << rmnum << '\n';
 	
-	ofs << '\t' << "TRNS: " << lflfc.trns_chunk.trns_val << '\n';
+	ostr << '\t' << "TRNS: " << lflfc.trns_chunk.trns_val << '\n';
 
 	for (std::vector<AKOSChunk>::size_type i = 0;
 		i < lflfc.akos_chunks.size(); i++)
@@ -474,28 +500,28 @@ void rip_metadata(const LFLFChunk& lflfc, const RipperFormats::RipperSettings& r
 			|| akosc.file_compr.size()
 			|| akosc.sqdb_chunk.seqi_chunks.size())
 		{
-			ofs << '\t' << "AKOS " << i << ":" << '\n';
+			ostr << '\t' << "AKOS " << i << ":" << '\n';
 			if (akosc.file_date.size())
 			{
-				ofs << '\t' << '\t' << "SP2C: " << akosc.file_date << '\n';
+				ostr << '\t' << '\t' << "SP2C: " << akosc.file_date << '\n';
 			}
 			if (akosc.file_name.size())
 			{
-				ofs << '\t' << '\t' << "SPLF: " << akosc.file_name << '\n';
+				ostr << '\t' << '\t' << "SPLF: " << akosc.file_name << '\n';
 			}
 			if (akosc.file_compr.size())
 			{
-				ofs << '\t' << '\t' << "CLRS: " << akosc.file_compr << '\n';
+				ostr << '\t' << '\t' << "CLRS: " << akosc.file_compr << '\n';
 			}
 			if (akosc.sqdb_chunk.seqi_chunks.size())
 			{
-				ofs << '\t' << '\t' << "SQDB:" << '\n';
+				ostr << '\t' << '\t' << "SQDB:" << '\n';
 				for (std::vector<SEQIChunk>::size_type j = 0;
 					j < akosc.sqdb_chunk.seqi_chunks.size(); j++)
 				{
 					const SEQIChunk& seqic = akosc.sqdb_chunk.seqi_chunks[j];
 
-					ofs << '\t' << '\t' << '\t' << "SEQI " << j << ": "
+					ostr << '\t' << '\t' << '\t' << "SEQI " << j << ": "
 						<< seqic.name_val << '\n';
 				}
 			}
@@ -509,13 +535,13 @@ void rip_metadata(const LFLFChunk& lflfc, const RipperFormats::RipperSettings& r
 
 		if (obcdc.obna_val.size())
 		{
-			ofs << '\t' << "OBCD " << (*it).first << ":" << '\n';
+			ostr << '\t' << "OBCD " << (*it).first << ":" << '\n';
 
-			ofs << '\t' << '\t' << "OBNA: " << obcdc.obna_val << '\n';
+			ostr << '\t' << '\t' << "OBNA: " << obcdc.obna_val << '\n';
 		}
 	}
 
-	ofs << '\n';
+	ostr << '\n';
 }
 
 
@@ -8,6 +8,7 @@
 #include "../utils/BitmapData.h"
 #include "../RipperFormats.h"
 #include <string>
+#include <ostream>
 #include <map>
 #include <vector>
 
@@ -42,46 +43,51 @@ extern bool akos_2color_decoding_hack_was_user_overriden;
 
 
 // Top-level rippers
+// (only: if set, rip just the entry with this number -- the object ID
+// for OBIM, the AWIZ number for AWIZ, whose MULTs are then skipped)
 
 void rip_rmim(const LFLFChunk& lflfc, const RipperFormats::RipperSettings& ripset,
-	const std::string& fprefix, RipperFormats::RipResults& results,
-	int transind);
+	RipUtil::OutputSink& sink, const std::string& fprefix, RipperFormats::RipResults& results,
+	int transind, int only = RipperFormats::RipConsts::not_set);
 
 void rip_obim(const LFLFChunk& lflfc, const RipperFormats::RipperSettings& ripset,
-	const std::string& fprefix, RipperFormats::RipResults& results,
-	int transind);
+	RipUtil::OutputSink& sink, const std::string& fprefix, RipperFormats::RipResults& results,
+	int transind, int only = RipperFormats::RipConsts::not_set);
 
 void rip_akos(const LFLFChunk& lflfc, const RipperFormats::RipperSettings& ripset,
-	const std::string& fprefix, RipperFormats::RipResults& results,
-	int transind);
+	RipUtil::OutputSink& sink, const std::string& fprefix, RipperFormats::RipResults& results,
+	int transind, int only = RipperFormats::RipConsts::not_set);
 
 void rip_awiz(const LFLFChunk& lflfc, const RipperFormats::RipperSettings& ripset,
-	const std::string& fprefix, RipperFormats::RipResults& results,
-	int transind);
+	RipUtil::OutputSink& sink, const std::string& fprefix, RipperFormats::RipResults& results,
+	int transind, int only = RipperFormats::RipConsts::not_set);
 
 void rip_char(const LFLFChunk& lflfc, const RipperFormats::RipperSettings& ripset,
-	const std::string& fprefix, RipperFormats::RipResults& results,
-	int transind);
+	RipUtil::OutputSink& sink, const std::string& fprefix, RipperFormats::RipResults& results,
+	int transind, int only = RipperFormats::RipConsts::not_set);
 
 void rip_sound(std::vector<SoundChunk>& sound_chunks, 
-	const RipperFormats::RipperSettings& ripset, const std::string& fprefix,
-	RipperFormats::RipResults& results);
+	const RipperFormats::RipperSettings& ripset, RipUtil::OutputSink& sink, const std::string& fprefix,
+	RipperFormats::RipResults& results,
+	int only = RipperFormats::RipConsts::not_set);
 
 void rip_digi(LFLFChunk& lflfc, const RipperFormats::RipperSettings& ripset,
-	const std::string& fprefix, RipperFormats::RipResults& results);
+	RipUtil::OutputSink& sink, const std::string& fprefix, RipperFormats::RipResults& results);
 
 void rip_talk(LFLFChunk& lflfc, const RipperFormats::RipperSettings& ripset,
-	const std::string& fprefix, RipperFormats::RipResults& results);
+	RipUtil::OutputSink& sink, const std::string& fprefix, RipperFormats::RipResults& results);
 
 void rip_wsou(const LFLFChunk& lflfc, const RipperFormats::RipperSettings& ripset,
-	const std::string& fprefix, RipperFormats::RipResults& results,
-	bool decode_audio);
+	RipUtil::OutputSink& sink, const std::string& fprefix, RipperFormats::RipResults& results,
+	bool decode_audio, int only = RipperFormats::RipConsts::not_set);
 
+// print the room's TLKE strings to ostr
 void rip_tlke(LFLFChunk& lflfc, const RipperFormats::RipperSettings& ripset,
-	const std::string& filename, int rmnum, RipperFormats::RipResults& results);
+	std::ostream& ostr, int rmnum, RipperFormats::RipResults& results);
 
+// print the room's metadata to ostr
 void rip_metadata(const LFLFChunk& lflfc, const RipperFormats::RipperSettings& ripset,
-	const std::string& filename, int rmnum, RipperFormats::RipResults& results);
+	std::ostream& ostr, int rmnum, RipperFormats::RipResults& results);
 
 // RMIM and OBIM decoding
 
@@ -185,4 +191,4 @@ void draw_and_update_pos(RipUtil::BitmapData& bmap, RipUtil::DrawPos& pos, int c
 
 };	// end of namespace Humongous
 
-#pragma once
\ No newline at end of file
+#pragma once
\ No newline at end of file
@@ -12,6 +12,18 @@ namespace IndCup
 {
 
 
+bool IndianRip::check_header(const char* header, int len, int fsize,
+	const RipperFormats::RipperSettings& ripset)
+{
+	// first 4 bytes give address of file table, which must be in the file
+	char decoding = (ripset.encoding != RipConsts::not_set) ? ripset.encoding : 0;
+	char hdcheck[4];
+	for (int i = 0; i < 4; i++)
+		hdcheck[i] = header[i] ^ decoding;
+	int hdaddrcheck = to_int(hdcheck, 4);
+	return (hdaddrcheck >= 0 && hdaddrcheck < fsize);
+}
+
 bool IndianRip::can_rip(RipUtil::MembufStream& stream, const RipperFormats::RipperSettings& ripset,
 	RipperFormats::FileFormatData& fmtdat)
 {
@@ -68,7 +80,8 @@ bool IndianRip::can_rip(RipUtil::MembufStream& stream, const RipperFormats::Ripp
 	return false;
 }
 
-RipResults IndianRip::rip(RipUtil::MembufStream& stream, const std::string& fprefix,
+RipResults IndianRip::rip(RipUtil::MembufStream& stream, RipUtil::OutputSink& sink,
+	const std::string& fprefix,
 	const RipperFormats::RipperSettings& ripset, const RipperFormats::FileFormatData& fmtdat)
 {
 	check_params(ripset.argc, ripset.argv);
@@ -80,24 +93,7 @@ RipResults IndianRip::rip(RipUtil::MembufStream& stream, const std::string& fpre
 
 	// read the file table
 	std::vector<AddrTabEnt> entries;
-	int filetab_addr = stream.read_int(4);
-	stream.seekg(filetab_addr);
-	// skip count table
-	int counttab_entries = stream.read_int(2);
-	int addrtab_entries = stream.read_int(2);
-	stream.seek_off(counttab_entries * 2 + 2);
-	// read address table
-	for (int i = 0; i < addrtab_entries; i++)
-	{
-		AddrTabEnt entry;
-		entry.address = stream.read_int(4);
-		// use the current address to find length of previous
-		if (i > 0)
-			entries[i - 1].length = entry.address - entries[i - 1].address;
-		if (i == addrtab_entries - 1)
-			entry.length = filetab_addr - entry.address;
-		entries.push_back(entry);
-	}
+	read_addr_table(stream, entries);
 
 	// seeking all the way back across the file would take a long time,
 	// so we reset it and start from the beginning
@@ -110,30 +106,11 @@ RipResults IndianRip::rip(RipUtil::MembufStream& stream, const std::string& fpre
 		i = 0; i < entries.size(); i++)
 	{
 		stream.seekg(entries[i].address);
-		int id = stream.read_int(2);
-		entries[i].id = id;
-
-		// 0x8001: palette-included bitmap
-		if (id == 0x8001)
-			entries[i].dattype = pal_bitmap;
-		// 0x8002: bitmap
-		else if (id == 0x8002)
-			entries[i].dattype = bitmap;
-		// 0x8006: animation
-		else if (id == 0x8006)
-			entries[i].dattype = animation;
-		// "FORM": AIFF
-		else if (id == 0x464F)
-		{
-			if (stream.read_int(2) == 0x524D)
-				entries[i].dattype = aiff;
-			stream.seek_off(-2);
-		}
-		// palettes are unheadered, so we can only check for sanity
-		else if ((id <= 256) && entries[i].length <= 770)
+		read_datatype(stream, entries[i]);
+
+		if (entries[i].dattype == palette)
 		{
-			entries[i].dattype = palette;
-			int numcolors = id;
+			int numcolors = entries[i].id;
 			BitmapPalette pal;
 
 			// fill first palette with background color
@@ -153,10 +130,6 @@ RipResults IndianRip::rip(RipUtil::MembufStream& stream, const std::string& fpre
 			}
 			palettes.push_back(pal);
 		}
-		else
-		{
-			entries[i].dattype = datatype_unknown;
-		}
 	}
 
 	int palettenum;
@@ -183,9 +156,6 @@ RipResults IndianRip::rip(RipUtil::MembufStream& stream, const std::string& fpre
 		for (std::vector<AddrTabEnt>::size_type
 			i = 0; i < entries.size(); i++)
 		{
-			char* outbytes = new char[entries[i].length];
-			stream.read(outbytes, entries[i].length);
-
 			std::string filename = fprefix;
 			switch (entries[i].dattype) {
 			case datatype_none:
@@ -211,10 +181,7 @@ RipResults IndianRip::rip(RipUtil::MembufStream& stream, const std::string& fpre
 			}
 			filename += to_string(i);
 
-			std::ofstream ofs(filename.c_str(),
-				std::ios_base::binary);
-			ofs.write(outbytes, entries[i].length);
-			delete[] outbytes;
+			sink.write_file_from(filename, stream, entries[i].length);
 			++(results.data_ripped);
 		}
 		return results;
@@ -230,11 +197,8 @@ RipResults IndianRip::rip(RipUtil::MembufStream& stream, const std::string& fpre
 
 			if (entries[i].dattype == datatype_unknown && ripset.ripdata)
 			{
-				std::ofstream ofs((fprefix + "-data-" + to_string(++raws_ripped)).c_str(),
-					std::ios_base::binary);
-				char* out = new char[entries[i].length];
-				stream.read(out, entries[i].length);
-				ofs.write(out, entries[i].length);
+				sink.write_file_from(fprefix + "-data-" + to_string(++raws_ripped),
+					stream, entries[i].length);
 			}
 			else if (entries[i].dattype == pal_bitmap && ripset.ripgraphics)
 			{
@@ -250,8 +214,8 @@ RipResults IndianRip::rip(RipUtil::MembufStream& stream, const std::string& fpre
 				bmap.set_palettized(true);
 				bmap.set_palette(pal);
 				indcup_read_bitmap(stream, bmap, ripset);
-				write_bitmapdata_8bitpalettized_bmp(bmap, fprefix + "-pal_bmap-"
-					+ to_string(++pal_bmaps_ripped) + ".bmp");
+				write_bitmapdata_8bitpalettized(sink, bmap, fprefix + "-pal_bmap-"
+					+ to_string(++pal_bmaps_ripped), ripset.imageformat);
 			}
 			else if (entries[i].dattype == bitmap && ripset.ripgraphics)
 			{
@@ -264,8 +228,8 @@ RipResults IndianRip::rip(RipUtil::MembufStream& stream, const std::string& fpre
 					bmap.set_palette(palettes[palettenum]);
 				else
 					bmap.set_palette_8bit_grayscale();
-				write_bitmapdata_8bitpalettized_bmp(bmap, fprefix + "-bmap-"
-					+ to_string(++bmaps_ripped) + ".bmp");
+				write_bitmapdata_8bitpalettized(sink, bmap, fprefix + "-bmap-"
+					+ to_string(++bmaps_ripped), ripset.imageformat);
 			}
 			else if (entries[i].dattype == animation && ripset.ripanimations)
 			{
@@ -339,9 +303,9 @@ RipResults IndianRip::rip(RipUtil::MembufStream& stream, const std::string& fpre
 							seqsize.centery + it->yoffset,
 							0);
 
-						write_bitmapdata_8bitpalettized_bmp(bmp, fprefix + "-ani-"
+						write_bitmapdata_8bitpalettized(sink, bmp, fprefix + "-ani-"
 							+ to_string(anis_ripped + 1) + "-frame-"
-							+ to_string(++framenum) + ".bmp");
+							+ to_string(++framenum), ripset.imageformat);
 					}
 				}
 				else
@@ -354,9 +318,9 @@ RipResults IndianRip::rip(RipUtil::MembufStream& stream, const std::string& fpre
 						else
 							it->image.set_palette_8bit_grayscale();
 
-						write_bitmapdata_8bitpalettized_bmp(it->image, fprefix + "-ani-"
+						write_bitmapdata_8bitpalettized(sink, it->image, fprefix + "-ani-"
 							+ to_string(anis_ripped + 1) + "-frame-"
-							+ to_string(++framenum) + ".bmp");
+							+ to_string(++framenum), ripset.imageformat);
 					}
 				}
 
@@ -370,36 +334,32 @@ RipResults IndianRip::rip(RipUtil::MembufStream& stream, const std::string& fpre
 					stream.seek_off(4);
 					int filelen = stream.read_int(4);
 					stream.seek_off(-8);
-					char* outbytes = new char[filelen];
-					stream.read(outbytes, filelen);
-					std::ofstream ofs((fprefix + "-aiff-"
-						+ to_string(aiffs_ripped++ + 1) + ".aif").c_str(),
-						std::ios_base::binary);
-					ofs.write(outbytes, filelen);
-					delete[] outbytes;
+					sink.write_file_from(fprefix + "-aiff-"
+						+ to_string(aiffs_ripped++ + 1) + ".aif", stream, filelen);
 				}
 				else
 				{
 					PCMData wave;
 					indcup_read_aiff(stream, wave, ripset);
-					if (wave.get_looping() && ripset.numloops > 0)
-						wave.add_loop(wave.get_loopstart(), wave.get_loopend(),
-						ripset.numloops - 1, ripset.loopstyle, ripset.loopfadelen, 
-						ripset.loopfadesil);
+					int loopstart = wave.get_loopstart();
+					int loopend = wave.get_loopend();
 					if (ripset.normalize)
 						wave.normalize();
 					format_PCMData(wave, ripset);
-					write_pcmdata_wave(wave, fprefix + "-aiff-"
-						+ to_string(++aiffs_ripped) + ".wav");
+					if (wave.get_looping() && ripset.numloops > 0)
+						write_pcmdata_looped(sink, wave, fprefix + "-aiff-"
+							+ to_string(++aiffs_ripped), ripset.audioformat, 
+							loopstart, loopend, ripset.numloops - 1, ripset.loopstyle, 
+							ripset.loopfadelen, ripset.loopfadesil);
+					else
+						write_pcmdata(sink, wave, fprefix + "-aiff-"
+							+ to_string(++aiffs_ripped), ripset.audioformat);
 				}
 			}
 			else if (entries[i].dattype == palette && ripset.ripdata)
 			{
-				std::ofstream ofs((fprefix + "-pal-" 
-					+ to_string(pals_ripped++ + 1)).c_str(), std::ios_base::binary);
-				char* out = new char[entries[i].length];
-				stream.read(out, entries[i].length);
-				ofs.write(out, entries[i].length);
+				sink.write_file_from(fprefix + "-pal-" + to_string(pals_ripped++ + 1),
+					stream, entries[i].length);
 			}
 		} // end entry-number ripping limiter
 		// change the palette whenever we reach a new one
@@ -429,6 +389,98 @@ void IndianRip::check_params(int argc, char* argv[])
 	}
 }
 
+bool IndianRip::list_contents(RipUtil::MembufStream& stream, const RipperFormats::RipperSettings& ripset,
+	const RipperFormats::FileFormatData& fmtdat, std::vector<RipperFormats::ContentsEntry>& contents)
+{
+	stream.reset();
+	stream.set_decoding_byte(fmtdat.encoding);
+
+	std::vector<AddrTabEnt> entries;
+	read_addr_table(stream, entries);
+	stream.reset();
+
+	for (std::vector<AddrTabEnt>::size_type
+		i = 0; i < entries.size(); i++)
+	{
+		stream.seekg(entries[i].address);
+		read_datatype(stream, entries[i]);
+
+		std::string type;
+		switch (entries[i].dattype) {
+		case datatype_none:
+		case datatype_unknown:
+			type = "unknown";
+			break;
+		case bitmap:
+			type = "bitmap";
+			break;
+		case pal_bitmap:
+			type = "pal_bitmap";
+			break;
+		case animation:
+			type = "animation";
+			break;
+		case palette:
+			type = "palette";
+			break;
+		case aiff:
+			type = "aiff";
+			break;
+		}
+		contents.push_back(ContentsEntry(0, type, entries[i].address, entries[i].length, i));
+	}
+	return true;
+}
+
+void IndianRip::read_addr_table(RipUtil::MembufStream& stream, std::vector<AddrTabEnt>& entries)
+{
+	int filetab_addr = stream.read_int(4);
+	stream.seekg(filetab_addr);
+	// skip count table
+	int counttab_entries = stream.read_int(2);
+	int addrtab_entries = stream.read_int(2);
+	stream.seek_off(counttab_entries * 2 + 2);
+	// read address table
+	for (int i = 0; i < addrtab_entries; i++)
+	{
+		AddrTabEnt entry;
+		entry.address = stream.read_int(4);
+		// use the current address to find length of previous
+		if (i > 0)
+			entries[i - 1].length = entry.address - entries[i - 1].address;
+		if (i == addrtab_entries - 1)
+			entry.length = filetab_addr - entry.address;
+		entries.push_back(entry);
+	}
+}
+
+void IndianRip::read_datatype(RipUtil::MembufStream& stream, AddrTabEnt& entry)
+{
+	int id = stream.read_int(2);
+	entry.id = id;
+	entry.dattype = datatype_unknown;
+
+	// 0x8001: palette-included bitmap
+	if (id == 0x8001)
+		entry.dattype = pal_bitmap;
+	// 0x8002: bitmap
+	else if (id == 0x8002)
+		entry.dattype = bitmap;
+	// 0x8006: animation
+	else if (id == 0x8006)
+		entry.dattype = animation;
+	// "FORM": AIFF
+	else if (id == 0x464F)
+	{
+		if (stream.read_int(2) == 0x524D)
+			entry.dattype = aiff;
+		stream.seek_off(-2);
+	}
+	// palettes are unheadered, so we can only check for sanity
+	else if ((id <= 256) && entry.length <= 770)
+		entry.dattype = palette;
+}
+
 int IndianRip::indcup_read_color(MembufStream& stream)
 {
 	int color = 0;
@@ -22,13 +22,20 @@ public:
 		ripseq(true) { };
 
 	// our usual check_format; set formatsubtype before returning true
+	bool check_header(const char* header, int len, int fsize,
+		const RipperFormats::RipperSettings& ripset);
+
 	bool can_rip(RipUtil::MembufStream& stream, const RipperFormats::RipperSettings& ripset,
 		RipperFormats::FileFormatData& fmtdat);
 
 	// our usual ripping procedure
-	RipperFormats::RipResults rip(RipUtil::MembufStream& stream, const std::string& fprefix,
+	RipperFormats::RipResults rip(RipUtil::MembufStream& stream, RipUtil::OutputSink& sink,
+		const std::string& fprefix,
 		const RipperFormats::RipperSettings& ripset, const RipperFormats::FileFormatData& fmtdat);
 
+	bool list_contents(RipUtil::MembufStream& stream, const RipperFormats::RipperSettings& ripset,
+		const RipperFormats::FileFormatData& fmtdat, std::vector<RipperFormats::ContentsEntry>& contents);
+
 private:
 
 	void check_params(int argc, char* argv[]);
@@ -157,6 +164,12 @@ private:
 	}
 
 
+	// read the file's address table
+	void read_addr_table(RipUtil::MembufStream& stream, std::vector<AddrTabEnt>& entries);
+
+	// read the ID at the start of an entry and set its type from it
+	void read_datatype(RipUtil::MembufStream& stream, AddrTabEnt& entry);
+
 	// read a color from an Indian in the Cupboard palette
 	// return color in 24-bit BGR form
 	int indcup_read_color(RipUtil::MembufStream& stream);
@@ -10,7 +10,7 @@
 #include "../utils/DefaultException.h"
 
 #include <vector>
-#include <fstream>
+#include <sstream>
 #include <string>
 #include <iostream>
 #include <map>
@@ -25,6 +25,15 @@ namespace LegoIsland
 {
 
 
+bool LegoIslandRip::check_header(const char* header, int len, int fsize,
+	const RipperFormats::RipperSettings& ripset)
+{
+	// the same tests as can_rip, on the header bytes
+	return ((to_int(header + 4, 4, DatManip::le) + 8) == fsize
+		&& quickcmp(OMNI_hd, header + 8, 4)
+		&& quickcmp(MxHd_hd, header + 12, 4));
+}
+
 bool LegoIslandRip::can_rip(RipUtil::MembufStream& stream, const RipperFormats::RipperSettings& ripset,
 	RipperFormats::FileFormatData& fmtdat)
 {
@@ -36,6 +45,9 @@ bool LegoIslandRip::can_rip(RipUtil::MembufStream& stream, const RipperFormats::
 	3. Are next 4 bytes "OMNI"?
 	4. Are next 4 bytes "MxHd"? */
 
+	if (stream.get_fsize() < 16)
+		return false;
+
 	stream.seekg(0);
 
 	char hdcheck[4];
@@ -58,20 +70,35 @@ bool LegoIslandRip::can_rip(RipUtil::MembufStream& stream, const RipperFormats::
 	return true;
 }
 
-RipperFormats::RipResults LegoIslandRip::rip(RipUtil::MembufStream& stream, const std::string& fprefix, 
+RipperFormats::RipResults LegoIslandRip::rip(RipUtil::MembufStream& stream, RipUtil::OutputSink& sink,
+	const std::string& fprefix, 
 	const RipperFormats::RipperSettings& ripset, const RipperFormats::FileFormatData& fmtdat)
 {
 	logger.open(fprefix + "-log.txt");
 
 	RipResults results;
 
+	// -select: one object, by its ID or its name, as --list shows them
+	int selid = RipConsts::not_set;
+	std::string selname;
+	if (ripset.select != "")
+	{
+		AssetSelector sel;
+		parse_selector(ripset.select, sel);
+		selid = get_selector_int(sel, "id");
+		if (sel.count("name"))
+			selname = sel["name"];
+		if (sel.size() != 1 || (selid == RipConsts::not_set && selname == ""))
+			throw(DefaultException("-select for LEGO Island files takes id=<ID> or name=<name>"));
+	}
+
 	stream.reset();
 
 	RIFFOMNIChunk riffomnic;
 	readRIFFOMNI(stream, riffomnic);
 	
 	if (reporting)
-		logRIFFOMNI(riffomnic, fprefix + "-report.txt");
+		logRIFFOMNI(riffomnic, sink, fprefix + "-report.txt");
 
 	std::map<int, MxObChunk*> MxObIDMap;
 	std::map<int, std::vector<MxChChunk*> > MxChIDMap;
@@ -108,6 +135,20 @@ RipperFormats::RipResults LegoIslandRip::rip(RipUtil::MembufStream& stream, cons
 		std::vector<MxChChunk*>& mxchs = (*it).second;
 
 		MxObChunk& header = *(MxObIDMap[id]);
+		if (ripset.select != ""
+			&& (selid != RipConsts::not_set ? id != selid : header.name != selname))
+			continue;
+		// skip objects finished by an interrupted run, or whose output
+		// is current or left to another shard
+		std::string state;
+		if (!sink.begin_unit(header.address(), state))
+			continue;
+		if (!sink.begin_asset(header.address()))
+		{
+			sink.end_unit();
+			continue;
+		}
+
 		switch (header.mxobid)
 		{
 		// type 1 and 2 don't exist?
@@ -126,7 +167,7 @@ RipperFormats::RipResults LegoIslandRip::rip(RipUtil::MembufStream& stream, cons
 				if (quickcmp(smkcheck, "SMK2", 4))
 				{
 					if (rip_smackers)
-						rip_typeid3_smacker(stream, id, mxchs, header, fprefix);
+						rip_typeid3_smacker(stream, id, mxchs, header, sink, fprefix);
 				}
 				// image set
 				else
@@ -142,20 +183,20 @@ RipperFormats::RipResults LegoIslandRip::rip(RipUtil::MembufStream& stream, cons
 					if (quickcmp(compcheck, "BABL", 4))
 					{
 						if (rip_flcs)
-							rip_typeid3_flcs(stream, id, mxchs, header, fprefix);
+							rip_typeid3_flcs(stream, id, mxchs, header, sink, fprefix);
 					}
 					// phoneme
 					else
 					{
 						if (rip_phonemes)
-							rip_typeid3_phonemes(stream, id, mxchs, header, fprefix);
+							rip_typeid3_phonemes(stream, id, mxchs, header, sink, fprefix);
 					}
 				}
 			}
 			break;
 		case (4):	// wave file
 			if (rip_waves)
-				rip_typeid4_wave(stream, id, mxchs, header, fprefix);
+				rip_typeid4_wave(stream, id, mxchs, header, sink, fprefix);
 			break;
 		case (6):	// dunno
 			break;
@@ -167,7 +208,7 @@ RipperFormats::RipResults LegoIslandRip::rip(RipUtil::MembufStream& stream, cons
 			break;
 		case (10):	// bitmap
 			if (rip_bmaps)
-				rip_typeid10_image(stream, id, mxchs, header, fprefix);
+				rip_typeid10_image(stream, id, mxchs, header, sink, fprefix);
 			break;
 		case (11):	// model or animation
 			break;
@@ -177,6 +218,8 @@ RipperFormats::RipResults LegoIslandRip::rip(RipUtil::MembufStream& stream, cons
 				+ " (address: " + to_string(header.address()) + ")");
 			break;
 		}
+		sink.end_asset();
+		sink.end_unit();
 	}
 
 	return results;
@@ -248,6 +291,9 @@ void LegoIslandRip::check_params(const RipperFormats::RipperSettings& ripset)
 		}
 	}
 
+	audioformat = ripset.audioformat;
+	imageformat = ripset.imageformat;
+
 	if (ripset.loopfadelen != RipperFormats::RipConsts::not_set)
 	{
 		loopfadelen = ripset.loopfadelen;
@@ -260,7 +306,7 @@ void LegoIslandRip::check_params(const RipperFormats::RipperSettings& ripset)
 
 void LegoIslandRip::rip_typeid3(
 	RipUtil::MembufStream& stream, int id, std::vector<MxChChunk*>& mxchs, 
-	MxObChunk& header, const std::string& fprefix)
+	MxObChunk& header, RipUtil::OutputSink& sink, const std::string& fprefix)
 {
 	MxChChunk& objheader = *(mxchs[0]);
 
@@ -273,37 +319,33 @@ void LegoIslandRip::rip_typeid3(
 
 	if (quickcmp(smkcheck, "SMK", 3))
 	{
-		rip_typeid3_smacker(stream, id, mxchs, header, fprefix);
+		rip_typeid3_smacker(stream, id, mxchs, header, sink, fprefix);
 	}
 	else
 	{
-		rip_typeid3_images(stream, id, mxchs, header, fprefix);
+		rip_typeid3_images(stream, id, mxchs, header, sink, fprefix);
 	}
 }
 
 void LegoIslandRip::rip_typeid3_smacker(
 	RipUtil::MembufStream& stream, int id, std::vector<MxChChunk*>& mxchs, 
-	MxObChunk& header, const std::string& fprefix)
+	MxObChunk& header, RipUtil::OutputSink& sink, const std::string& fprefix)
 {
-	std::ofstream ofs((fprefix + "-smk-"
-		+ to_string(id) + ".smk").c_str(), std::ios_base::binary);
+	sink.open(fprefix + "-smk-" + to_string(id) + ".smk");
 
 	// concatenate SMK data contents of each chunk into one file
 	for (int i = 0; i < mxchs.size(); i++)
 	{
 		stream.seekg((*mxchs[i]).datastart() + 14);
 		unsigned int length = (*mxchs[i]).data_nopad_size() - 14;
-
-		char* copydat = new char[length];
-		stream.read(copydat, length);
-		ofs.write(copydat, length);
-		delete[] copydat;
+		sink.write_from(stream, length);
 	}
+	sink.close();
 }
 
 void LegoIslandRip::rip_typeid3_images(
 	RipUtil::MembufStream& stream, int id, std::vector<MxChChunk*>& mxchs, 
-	MxObChunk& header, const std::string& fprefix)
+	MxObChunk& header, RipUtil::OutputSink& sink, const std::string& fprefix)
 {
 	MxChChunk& objheader = *(mxchs[0]);
 
@@ -314,17 +356,17 @@ void LegoIslandRip::rip_typeid3_images(
 
 	if (quickcmp(compcheck, "BABL", 4))
 	{
-		rip_typeid3_flcs(stream, id, mxchs, header, fprefix);
+		rip_typeid3_flcs(stream, id, mxchs, header, sink, fprefix);
 	}
 	else
 	{
-		rip_typeid3_phonemes(stream, id, mxchs, header, fprefix);
+		rip_typeid3_phonemes(stream, id, mxchs, header, sink, fprefix);
 	}
 }
 
 void LegoIslandRip::rip_typeid3_flcs(
 	RipUtil::MembufStream& stream, int id, std::vector<MxChChunk*>& mxchs, 
-	MxObChunk& header, const std::string& fprefix)
+	MxObChunk& header, RipUtil::OutputSink& sink, const std::string& fprefix)
 {
 	MxChChunk& objheader = *(mxchs[0]);
 
@@ -365,8 +407,8 @@ void LegoIslandRip::rip_typeid3_flcs(
 
 	decode_lego_type2_rle8(bmpbase, imgdat, length);
 
-	write_bitmapdata_8bitpalettized_bmp(bmpbase, fprefix
-		+ "-flc-" + to_string(id) + "-1" + ".bmp");
+	write_bitmapdata_8bitpalettized(sink, bmpbase, fprefix
+		+ "-flc-" + to_string(id) + "-1", imageformat);
 
 	for (int i = 2; i < mxchs.size() - 1; i++)
 	{
@@ -399,14 +441,14 @@ void LegoIslandRip::rip_typeid3_flcs(
 
 		delete[] imgdat;
 
-		write_bitmapdata_8bitpalettized_bmp(bmp, fprefix + "-flc-"
-		+ to_string(id) + "-" + to_string(i) + ".bmp");
+		write_bitmapdata_8bitpalettized(sink, bmp, fprefix + "-flc-"
+		+ to_string(id) + "-" + to_string(i), imageformat);
 	}
 }
 
 void LegoIslandRip::rip_typeid3_phonemes(
 	RipUtil::MembufStream& stream, int id, std::vector<MxChChunk*>& mxchs, 
-	MxObChunk& header, const std::string& fprefix)
+	MxObChunk& header, RipUtil::OutputSink& sink, const std::string& fprefix)
 {
 	MxChChunk& objheader = *(mxchs[0]);
 
@@ -447,8 +489,8 @@ void LegoIslandRip::rip_typeid3_phonemes(
 
 	decode_lego_rle8(bmpbase, imgdat, length);
 				
-	write_bitmapdata_8bitpalettized_bmp(bmpbase, fprefix + "-phoneme-"
-		+ to_string(id) + "-1" + ".bmp");
+	write_bitmapdata_8bitpalettized(sink, bmpbase, fprefix + "-phoneme-"
+		+ to_string(id) + "-1", imageformat);
 
 	for (int i = 2; i < mxchs.size() - 1; i++)
 	{
@@ -498,14 +540,14 @@ void LegoIslandRip::rip_typeid3_phonemes(
 		// put previous frame in buffer for use by next frame
 		bmpbase.blit_bitmapdata(bmp, 0, 0);
 
-		write_bitmapdata_8bitpalettized_bmp(bmpbase, fprefix + "-phoneme-"
-		+ to_string(id) + "-" + to_string(i) + ".bmp");
+		write_bitmapdata_8bitpalettized(sink, bmpbase, fprefix + "-phoneme-"
+		+ to_string(id) + "-" + to_string(i), imageformat);
 	}
 }
 
 void LegoIslandRip::rip_typeid4_wave(
 	RipUtil::MembufStream& stream, int id, std::vector<MxChChunk*>& mxchs, 
-	MxObChunk& header, const std::string& fprefix)
+	MxObChunk& header, RipUtil::OutputSink& sink, const std::string& fprefix)
 {
 	PCMData wave;
 	wave.set_channels(1);
@@ -519,6 +561,12 @@ void LegoIslandRip::rip_typeid4_wave(
 	stream.seek_off(6);
 	wave.set_sampwidth(stream.read_int(2, DatManip::le));
 
+	// allocate space for all sample blocks at once
+	int totalsize = 0;
+	for (size_t i = 1; i < mxchs.size() - 1; i++)
+		totalsize += (*mxchs[i]).data_nopad_size() - 14;
+	wave.reserve_wave(totalsize);
+
 	// copy all sample blocks into wave data
 	for (int i = 1; i < mxchs.size() - 1; i++)
 	{
@@ -544,16 +592,17 @@ void LegoIslandRip::rip_typeid4_wave(
 	{
 		wave.set_loopstart(0);
 		wave.set_loopend(wave.get_wavesize()/(wave.get_sampwidth()/8));
-		wave.add_loop(wave.get_loopstart(), wave.get_loopend(), 0,
+		write_pcmdata_looped(sink, wave, fprefix + "-wav-" + to_string(id), audioformat,
+			wave.get_loopstart(), wave.get_loopend(), 0,
 			RipUtil::PCMData::fadeloop, loopfadelen, loopendsilence);
 	}
-
-	write_pcmdata_wave(wave, fprefix + "-wav-" + to_string(id) + ".wav");
+	else
+		write_pcmdata(sink, wave, fprefix + "-wav-" + to_string(id), audioformat);
 }
 
 void LegoIslandRip::rip_typeid10_image(
 	RipUtil::MembufStream& stream, int id, std::vector<MxChChunk*>& mxchs, 
-	MxObChunk& header, const std::string& fprefix)
+	MxObChunk& header, RipUtil::OutputSink& sink, const std::string& fprefix)
 {
 	BitmapData bmp;
 
@@ -625,8 +674,8 @@ void LegoIslandRip::rip_typeid10_image(
 
 	delete[] bmpdata;
 
-	write_bitmapdata_8bitpalettized_bmp(bmp, fprefix + "-bmp-"
-		+ to_string(id) + ".bmp");
+	write_bitmapdata_8bitpalettized(sink, bmp, fprefix + "-bmp-"
+		+ to_string(id), imageformat);
 }
 
 void LegoIslandRip::decode_lego_rle8(RipUtil::BitmapData& bmp, const char* source, int length)
@@ -896,6 +945,44 @@ void LegoIslandRip::read_cstring_stream(RipUtil::MembufStream& stream, std::stri
 		dest += c;
 }
 
+bool LegoIslandRip::list_contents(RipUtil::MembufStream& stream, const RipperFormats::RipperSettings& ripset,
+	const RipperFormats::FileFormatData& fmtdat, std::vector<RipperFormats::ContentsEntry>& contents)
+{
+	stream.reset();
+
+	RIFFOMNIChunk riffomnic;
+	readRIFFOMNI(stream, riffomnic);
+
+	contents.push_back(ContentsEntry(0, "MxOf", riffomnic.mxofc.address(), riffomnic.mxofc.size(),
+		RipConsts::not_set, to_string(riffomnic.mxofc.numentries) + " objects"));
+	for (size_t i = 0; i < riffomnic.listmxstc.entries.size(); i++)
+	{
+		MxStChunk& mxstc = riffomnic.listmxstc.entries[i];
+		contents.push_back(ContentsEntry(0, "MxSt", mxstc.address(), mxstc.size()));
+
+		listMxObs(mxstc.mxobc, 1, contents);
+		for (size_t j = 0; j < mxstc.listmxchc.entries.size(); j++)
+		{
+			listMxObs(mxstc.listmxchc.entries[j], 1, contents);
+		}
+
+		contents.push_back(ContentsEntry(1, "MxDa", mxstc.listmxdac.address(), mxstc.listmxdac.size(),
+			RipConsts::not_set, to_string(mxstc.listmxdac.entries.size()) + " MxCh chunks"));
+	}
+	return true;
+}
+
+void LegoIslandRip::listMxObs(MxObChunk& mxobc, int depth, std::vector<RipperFormats::ContentsEntry>& contents)
+{
+	contents.push_back(ContentsEntry(depth, "MxOb", mxobc.address(), mxobc.size(), mxobc.thingid,
+		mxobc.name + " (type " + to_string(mxobc.mxobid) + ")"));
+
+	for (size_t i = 0; i < mxobc.listmxchc.entries.size(); i++)
+	{
+		listMxObs(mxobc.listmxchc.entries[i], depth + 1, contents);
+	}
+}
+
 void LegoIslandRip::addMxObs(MxObChunk& mxobc, std::map<int, MxObChunk*>& MxObIDMap)
 {
 	// add this MxOb to map
@@ -1319,109 +1406,112 @@ void LegoIslandRip::readMxCh(RipUtil::MembufStream& stream, MxChChunk& dest)
 	stream.seekg(dest.nextaddress());
 };
 
-void LegoIslandRip::printMxObInfo(MxObChunk& mxobc, std::ofstream& ofs)
+void LegoIslandRip::printMxObInfo(MxObChunk& mxobc, std::ostream& ostr)
 {
-	ofs << '\t' << '\t' << '\t' << "MxOb" << '\n';
-	ofs << '\t' << '\t' << '\t' << '\t' << "Address: " << mxobc.address() << '\n';
-	ofs << '\t' << '\t' << '\t' << '\t' << "Length: " << mxobc.datasize() << '\n';
-	ofs << '\t' << '\t' << '\t' << '\t' << "Type ID: " << mxobc.mxobid << '\n';
-	ofs << '\t' << '\t' << '\t' << '\t' << "Type: " << mxobc.typecstr << '\n';
-	ofs << '\t' << '\t' << '\t' << '\t' << "unk1: " << mxobc.unk1 << '\n';
-	ofs << '\t' << '\t' << '\t' << '\t' << "Name: " << mxobc.name << '\n';
-	ofs << '\t' << '\t' << '\t' << '\t' << "Obj ID: " << mxobc.thingid << '\n';
-	ofs << '\t' << '\t' << '\t' << '\t' << "unk5: " << mxobc.unk5 << '\n';
-	ofs << '\t' << '\t' << '\t' << '\t' << "unk6: " << mxobc.unk6 << '\n';
-	ofs << '\t' << '\t' << '\t' << '\t' << "unk7: " << mxobc.unk7 << '\n';
-	ofs << '\t' << '\t' << '\t' << '\t' << "unk8: " << mxobc.unk8 << '\n';
-	ofs << '\t' << '\t' << '\t' << '\t' << "objinf_runlen: " << mxobc.objinf_runlen << '\n';
-	ofs << '\t' << '\t' << '\t' << '\t' << "objinf: " << mxobc.objinf << '\n';
-	ofs << '\t' << '\t' << '\t' << '\t' << "filename: " << mxobc.filename << '\n';
+	ostr << '\t' << '\t' << '\t' << "MxOb" << '\n';
+	ostr << '\t' << '\t' << '\t' << '\t' << "Address: " << mxobc.address() << '\n';
+	ostr << '\t' << '\t' << '\t' << '\t' << "Length: " << mxobc.datasize() << '\n';
+	ostr << '\t' << '\t' << '\t' << '\t' << "Type ID: " << mxobc.mxobid << '\n';
+	ostr << '\t' << '\t' << '\t' << '\t' << "Type: " << mxobc.typecstr << '\n';
+	ostr << '\t' << '\t' << '\t' << '\t' << "unk1: " << mxobc.unk1 << '\n';
+	ostr << '\t' << '\t' << '\t' << '\t' << "Name: " << mxobc.name << '\n';
+	ostr << '\t' << '\t' << '\t' << '\t' << "Obj ID: " << mxobc.thingid << '\n';
+	ostr << '\t' << '\t' << '\t' << '\t' << "unk5: " << mxobc.unk5 << '\n';
+	ostr << '\t' << '\t' << '\t' << '\t' << "unk6: " << mxobc.unk6 << '\n';
+	ostr << '\t' << '\t' << '\t' << '\t' << "unk7: " << mxobc.unk7 << '\n';
+	ostr << '\t' << '\t' << '\t' << '\t' << "unk8: " << mxobc.unk8 << '\n';
+	ostr << '\t' << '\t' << '\t' << '\t' << "objinf_runlen: " << mxobc.objinf_runlen << '\n';
+	ostr << '\t' << '\t' << '\t' << '\t' << "objinf: " << mxobc.objinf << '\n';
+	ostr << '\t' << '\t' << '\t' << '\t' << "filename: " << mxobc.filename << '\n';
 
 	if (mxobc.listmxchc.listtype() == MxCh)
 	{
-		ofs << '\t' << '\t' << '\t' << '\t' << "LISTMxCh" << '\n';
-		ofs << '\t' << '\t' << '\t' << '\t' << '\t' << "Address: " << mxobc.listmxchc.address() << '\n';
-		ofs << '\t' << '\t' << '\t' << '\t' << '\t' << "Length: " << mxobc.listmxchc.datasize() << '\n';
-		ofs << '\t' << '\t' << '\t' << '\t' << '\t' << "Entries: " << mxobc.listmxchc.entries.size() << '\n';
-		ofs << "!!!=== START ENTRY LIST (" << mxobc.listmxchc.entries.size() << " ENTRIES) ===!!!" << '\n';
+		ostr << '\t' << '\t' << '\t' << '\t' << "LISTMxCh" << '\n';
+		ostr << '\t' << '\t' << '\t' << '\t' << '\t' << "Address: " << mxobc.listmxchc.address() << '\n';
+		ostr << '\t' << '\t' << '\t' << '\t' << '\t' << "Length: " << mxobc.listmxchc.datasize() << '\n';
+		ostr << '\t' << '\t' << '\t' << '\t' << '\t' << "Entries: " << mxobc.listmxchc.entries.size() << '\n';
+		ostr << "!!!=== START ENTRY LIST (" << mxobc.listmxchc.entries.size() << " ENTRIES) ===!!!" << '\n';
 		for (int i = 0; i < mxobc.listmxchc.entries.size(); i++)
 		{
-			printMxObInfo(mxobc.listmxchc.entries[i], ofs);
+			printMxObInfo(mxobc.listmxchc.entries[i], ostr);
 		}
-		ofs << "!!!=== END ENTRY LIST (" << mxobc.listmxchc.entries.size() << " ENTRIES) ===!!!" << '\n';
+		ostr << "!!!=== END ENTRY LIST (" << mxobc.listmxchc.entries.size() << " ENTRIES) ===!!!" << '\n';
 	}
 }
 
-void LegoIslandRip::logRIFFOMNI(RIFFOMNIChunk& src, std::string filename)
+void LegoIslandRip::logRIFFOMNI(RIFFOMNIChunk& src, RipUtil::OutputSink& sink, std::string filename)
 {
-	std::ofstream ofs(filename.c_str(), std::ios_base::binary | std::ios_base::trunc);
+	std::ostringstream ostr;
 	
-	ofs << "RIFF/OMNI: length " << src.datasize() << '\n';
-
-	ofs << '\t' << "MxHd" << '\n';
-	ofs << '\t' << '\t' << "Address: " << src.mxhdc.address() << '\n';
-	ofs << '\t' << '\t' << "Length: " << src.mxhdc.datasize() << '\n';
-	ofs << '\t' << '\t' << "unk1: " << src.mxhdc.unk1 << '\n';
-	ofs << '\t' << '\t' << "unk2: " << src.mxhdc.unk2 << '\n';
-	ofs << '\t' << '\t' << "unk3: " << src.mxhdc.unk3 << '\n';
-	ofs << '\t' << '\t' << "unk4: " << src.mxhdc.unk4 << '\n';
-	ofs << '\t' << '\t' << "unk5: " << src.mxhdc.unk5 << '\n';
-
-	ofs << '\t' << "MxOf" << '\n';
-	ofs << '\t' << '\t' << "Address: " << src.mxofc.address() << '\n';
-	ofs << '\t' << '\t' << "Length: " << src.mxofc.datasize() << '\n';
-	ofs << '\t' << '\t' << "Reported entries: " << src.mxofc.numentries << '\n';
-	ofs << '\t' << '\t' << "Actual entries: " << src.mxofc.entries.size() << '\n';
-//	ofs << '\t' << '\t' << "Address table: " << '\n';
+	ostr << "RIFF/OMNI: length " << src.datasize() << '\n';
+
+	ostr << '\t' << "MxHd" << '\n';
+	ostr << '\t' << '\t' << "Address: " << src.mxhdc.address() << '\n';
+	ostr << '\t' << '\t' << "Length: " << src.mxhdc.datasize() << '\n';
+	ostr << '\t' << '\t' << "unk1: " << src.mxhdc.unk1 << '\n';
+	ostr << '\t' << '\t' << "unk2: " << src.mxhdc.unk2 << '\n';
+	ostr << '\t' << '\t' << "unk3: " << src.mxhdc.unk3 << '\n';
+	ostr << '\t' << '\t' << "unk4: " << src.mxhdc.unk4 << '\n';
+	ostr << '\t' << '\t' << "unk5: " << src.mxhdc.unk5 << '\n';
+
+	ostr << '\t' << "MxOf" << '\n';
+	ostr << '\t' << '\t' << "Address: " << src.mxofc.address() << '\n';
+	ostr << '\t' << '\t' << "Length: " << src.mxofc.datasize() << '\n';
+	ostr << '\t' << '\t' << "Reported entries: " << src.mxofc.numentries << '\n';
+	ostr << '\t' << '\t' << "Actual entries: " << src.mxofc.entries.size() << '\n';
+//	ostr << '\t' << '\t' << "Address table: " << '\n';
 //	for (int i = 0; i < src.mxofc.entries.size(); i++)
 //	{
-//		ofs << '\t' << '\t' << src.mxofc.entries[i] << '\n';
+//		ostr << '\t' << '\t' << src.mxofc.entries[i] << '\n';
 //	}
 
-	ofs << '\t' << "LIST/MxSt" << '\n';
-	ofs << '\t' << '\t' << "Address: " << src.listmxstc.address() << '\n';
-	ofs << '\t' << '\t' << "Length: " << src.listmxstc.datasize() << '\n';
-	ofs << '\t' << '\t' << "Entries: " << src.listmxstc.entries.size() << '\n';
+	ostr << '\t' << "LIST/MxSt" << '\n';
+	ostr << '\t' << '\t' << "Address: " << src.listmxstc.address() << '\n';
+	ostr << '\t' << '\t' << "Length: " << src.listmxstc.datasize() << '\n';
+	ostr << '\t' << '\t' << "Entries: " << src.listmxstc.entries.size() << '\n';
 	for (int i = 0; i < src.listmxstc.entries.size(); i++)
 	{
 		MxStChunk& mxstc = src.listmxstc.entries[i];
-		ofs << '\t' << '\t' << "MxSt " << i << '\n';
-		ofs << '\t' << '\t' << '\t' << "Address: " << mxstc.address() << '\n';
-		ofs << '\t' << '\t' << '\t' << "Length: " << mxstc.datasize() << '\n';
+		ostr << '\t' << '\t' << "MxSt " << i << '\n';
+		ostr << '\t' << '\t' << '\t' << "Address: " << mxstc.address() << '\n';
+		ostr << '\t' << '\t' << '\t' << "Length: " << mxstc.datasize() << '\n';
 
 		if (mxstc.mxobc.type() == MxOb)
 		{
-			printMxObInfo(mxstc.mxobc, ofs);
+			printMxObInfo(mxstc.mxobc, ostr);
 		}
 		if (mxstc.listmxchc.listtype() == MxCh)
 		{
-			ofs << '\t' << '\t' << '\t' << "LISTMxCh" << '\n';
-			ofs << '\t' << '\t' << '\t' << '\t' << "Address: " << mxstc.listmxchc.address() << '\n';
-			ofs << '\t' << '\t' << '\t' << '\t' << "Length: " << mxstc.listmxchc.datasize() << '\n';
-			ofs << '\t' << '\t' << '\t' << '\t' << "Entries: " << mxstc.listmxchc.entries.size() << '\n';
+			ostr << '\t' << '\t' << '\t' << "LISTMxCh" << '\n';
+			ostr << '\t' << '\t' << '\t' << '\t' << "Address: " << mxstc.listmxchc.address() << '\n';
+			ostr << '\t' << '\t' << '\t' << '\t' << "Length: " << mxstc.listmxchc.datasize() << '\n';
+			ostr << '\t' << '\t' << '\t' << '\t' << "Entries: " << mxstc.listmxchc.entries.size() << '\n';
 			for (int i = 0; i < mxstc.listmxchc.entries.size(); i++)
 			{
-				printMxObInfo(mxstc.listmxchc.entries[i], ofs);
+				printMxObInfo(mxstc.listmxchc.entries[i], ostr);
 			}
 		}
 		if (mxstc.listmxdac.listtype() == MxDa)
 		{
-			ofs << '\t' << '\t' << '\t' << "LISTMxDa" << '\n';
-			ofs << '\t' << '\t' << '\t' << '\t' << "Address: " << mxstc.listmxdac.address() << '\n';
-			ofs << '\t' << '\t' << '\t' << '\t' << "Length: " << mxstc.listmxdac.datasize() << '\n';
-			ofs << '\t' << '\t' << '\t' << '\t' << "Entries: " << mxstc.listmxdac.entries.size() << '\n';
+			ostr << '\t' << '\t' << '\t' << "LISTMxDa" << '\n';
+			ostr << '\t' << '\t' << '\t' << '\t' << "Address: " << mxstc.listmxdac.address() << '\n';
+			ostr << '\t' << '\t' << '\t' << '\t' << "Length: " << mxstc.listmxdac.datasize() << '\n';
+			ostr << '\t' << '\t' << '\t' << '\t' << "Entries: " << mxstc.listmxdac.entries.size() << '\n';
 			for (int i = 0; i < mxstc.listmxdac.entries.size(); i++)
 			{
 				MxChChunk& mxchc = mxstc.listmxdac.entries[i];
 
-				ofs << '\t' << '\t' << '\t' << '\t' << "MxCh " << i << '\n';
-				ofs << '\t' << '\t' << '\t' << '\t' << '\t' << "Address: " << mxchc.address() << '\n';
-				ofs << '\t' << '\t' << '\t' << '\t' << '\t' << "Length: " << mxchc.datasize() << '\n';
-				ofs << '\t' << '\t' << '\t' << '\t' << '\t' << "unk1: " << mxchc.unk1 << '\n';
-				ofs << '\t' << '\t' << '\t' << '\t' << '\t' << "Obj ID: " << mxchc.thingid << '\n';
+				ostr << '\t' << '\t' << '\t' << '\t' << "MxCh " << i << '\n';
+				ostr << '\t' << '\t' << '\t' << '\t' << '\t' << "Address: " << mxchc.address() << '\n';
+				ostr << '\t' << '\t' << '\t' << '\t' << '\t' << "Length: " << mxchc.datasize() << '\n';
+				ostr << '\t' << '\t' << '\t' << '\t' << '\t' << "unk1: " << mxchc.unk1 << '\n';
+				ostr << '\t' << '\t' << '\t' << '\t' << '\t' << "Obj ID: " << mxchc.thingid << '\n';
 			}
 		}
 	}
+
+	std::string text = ostr.str();
+	sink.write_file(filename, text.c_str(), text.size());
 }
 
 
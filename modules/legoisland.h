@@ -32,43 +32,52 @@ public:
 			rip_smackers(true), rip_flcs(true), rip_phonemes(false), 
 			rip_bmaps(true), rip_waves(true),
 			force_wave_loop(false),
-			loopfadelen(5), loopendsilence(1) { };
+			loopfadelen(5), loopendsilence(1),
+			audioformat(RipUtil::PCMData::waveformat),
+			imageformat(RipUtil::BitmapData::bmpformat) { };
+
+	bool check_header(const char* header, int len, int fsize,
+		const RipperFormats::RipperSettings& ripset);
 
 	bool can_rip(RipUtil::MembufStream& stream, const RipperFormats::RipperSettings& ripset,
 		RipperFormats::FileFormatData& fmtdat);
 
-	RipperFormats::RipResults rip(RipUtil::MembufStream& stream, const std::string& fprefix, 
+	RipperFormats::RipResults rip(RipUtil::MembufStream& stream, RipUtil::OutputSink& sink,
+		const std::string& fprefix, 
 		const RipperFormats::RipperSettings& ripset, const RipperFormats::FileFormatData& fmtdat);
+
+	bool list_contents(RipUtil::MembufStream& stream, const RipperFormats::RipperSettings& ripset,
+		const RipperFormats::FileFormatData& fmtdat, std::vector<RipperFormats::ContentsEntry>& contents);
 private:
 	void check_params(const RipperFormats::RipperSettings& ripset);
 
 	void rip_typeid3(
 		RipUtil::MembufStream& stream, int id, std::vector<MxChChunk*>& mxchs, 
-		MxObChunk& header, const std::string& fprefix);
+		MxObChunk& header, RipUtil::OutputSink& sink, const std::string& fprefix);
 
 	void rip_typeid3_smacker(
 		RipUtil::MembufStream& stream, int id, std::vector<MxChChunk*>& mxchs, 
-		MxObChunk& header, const std::string& fprefix);
+		MxObChunk& header, RipUtil::OutputSink& sink, const std::string& fprefix);
 
 	void rip_typeid3_images(
 		RipUtil::MembufStream& stream, int id, std::vector<MxChChunk*>& mxchs, 
-		MxObChunk& header, const std::string& fprefix);
+		MxObChunk& header, RipUtil::OutputSink& sink, const std::string& fprefix);
 
 	void rip_typeid3_flcs(
 		RipUtil::MembufStream& stream, int id, std::vector<MxChChunk*>& mxchs, 
-		MxObChunk& header, const std::string& fprefix);
+		MxObChunk& header, RipUtil::OutputSink& sink, const std::string& fprefix);
 
 	void rip_typeid3_phonemes(
 		RipUtil::MembufStream& stream, int id, std::vector<MxChChunk*>& mxchs, 
-		MxObChunk& header, const std::string& fprefix);
+		MxObChunk& header, RipUtil::OutputSink& sink, const std::string& fprefix);
 
 	void rip_typeid4_wave(
 		RipUtil::MembufStream& stream, int id, std::vector<MxChChunk*>& mxchs, 
-		MxObChunk& header, const std::string& fprefix);
+		MxObChunk& header, RipUtil::OutputSink& sink, const std::string& fprefix);
 
 	void rip_typeid10_image(
 		RipUtil::MembufStream& stream, int id, std::vector<MxChChunk*>& mxchs, 
-		MxObChunk& header, const std::string& fprefix);
+		MxObChunk& header, RipUtil::OutputSink& sink, const std::string& fprefix);
 
 	void decode_lego_rle8(
 		RipUtil::BitmapData& bmp, const char* source, int length);
@@ -87,6 +96,9 @@ private:
 
 	void addMxObs(MxObChunk& mxobc, std::map<int, MxObChunk*>& MxObIDMap);
 
+	// list an MxOb and the MxObs it contains
+	void listMxObs(MxObChunk& mxobc, int depth, std::vector<RipperFormats::ContentsEntry>& contents);
+
 	bool MxChAddressOrder(MxChChunk* mxchc_p1, MxChChunk* mxchc_p2);
 
 	void readRIFFOMNI(RipUtil::MembufStream& stream, RIFFOMNIChunk& dest);
@@ -109,9 +121,9 @@ private:
 
 	void readMxCh(RipUtil::MembufStream& stream, MxChChunk& dest);
 
-	void printMxObInfo(MxObChunk& mxobc, std::ofstream& ofs);
+	void printMxObInfo(MxObChunk& mxobc, std::ostream& ostr);
 
-	void logRIFFOMNI(RIFFOMNIChunk& src, std::string filename);
+	void logRIFFOMNI(RIFFOMNIChunk& src, RipUtil::OutputSink& sink, std::string filename);
 
 	bool logging;
 	bool reporting;
@@ -123,6 +135,8 @@ private:
 	bool force_wave_loop;
 	double loopfadelen;
 	double loopendsilence;
+	RipUtil::PCMData::AudioFormat audioformat;
+	RipUtil::BitmapData::ImageFormat imageformat;
 };
 
 
@@ -9,7 +9,10 @@
 #include "../utils/DefaultException.h"
 #include <iostream>
 #include <iomanip>
+#include <sstream>
+#include <fstream>
 #include <vector>
+#include <cctype>
 
 using namespace RipUtil;
 using namespace RipperFormats;
@@ -18,6 +21,17 @@ namespace Mohawk
 {
 
 
+bool MohawkRip::check_header(const char* header, int len, int fsize,
+	const RipperFormats::RipperSettings& ripset)
+{
+	// MHWK, then RSRC after the file size, XORed if an encoding was given
+	char decoding = (ripset.encoding != RipConsts::not_set) ? ripset.encoding : 0;
+	char hdcheck[12];
+	for (int i = 0; i < 12; i++)
+		hdcheck[i] = header[i] ^ decoding;
+	return (quickcmp(hdcheck, mhwk_id, 4) && quickcmp(hdcheck + 8, mhwk_rsrc_id, 4));
+}
+
 bool MohawkRip::can_rip(RipUtil::MembufStream& stream, const RipperFormats::RipperSettings& ripset,
 	RipperFormats::FileFormatData& fmtdat)
 {
@@ -88,80 +102,44 @@ void MohawkRip::check_params(int argc, char* argv[])
 	}
 }
 
-RipperFormats::RipResults MohawkRip::rip(RipUtil::MembufStream& stream, const std::string& fprefix,
+void MohawkRip::check_selector(const std::string& spec, std::string& seltype, int& selid,
+	int& selindex)
+{
+	AssetSelector sel;
+	parse_selector(spec, sel);
+
+	selindex = get_selector_int(sel, "index");
+	selid = get_selector_int(sel, "id");
+	seltype = sel.count("type") ? sel["type"] : "";
+	for (std::string::size_type i = 0; i < seltype.size(); i++)
+		seltype[i] = std::tolower(seltype[i]);
+
+	bool byindex = (selindex != RipConsts::not_set && sel.size() == 1);
+	bool byid = (selid != RipConsts::not_set && seltype != "" && sel.size() == 2);
+	if (!byindex && !byid)
+		throw(DefaultException("-select for Mohawk files takes type=<type>,id=<ID> "
+			"(e.g. type=tBMP,id=1001) or index=<number>"));
+}
+
+RipperFormats::RipResults MohawkRip::rip(RipUtil::MembufStream& stream, RipUtil::OutputSink& sink,
+	const std::string& fprefix,
 	const RipperFormats::RipperSettings& ripset, const RipperFormats::FileFormatData& fmtdat)
 {
 	check_params(ripset.argc, ripset.argv);
 
+	std::string seltype;
+	int selid = RipConsts::not_set;
+	int selindex = RipConsts::not_set;
+	if (ripset.select != "")
+		check_selector(ripset.select, seltype, selid, selindex);
+
 	RipperFormats::RipResults results;
 
 //	int files_output = 0;
 	bool has_strings = false;
-	std::vector<MHWKHeadChunk> headers;
 	std::vector<MHWKIndexTableEntry> identries;
 	std::vector<MHWKAddrTableEntry> entries;
-	// get address of first header chunk
-	stream.seekg(20);
-	int hdaddress = stream.read_int(4);
-	stream.seekg(hdaddress);
-	int hdlen = stream.read_int(2) + 2;
-	int numhdchunks = stream.read_int(2);
-	// read header chunks
-	char hdcheck[4];
-	for (int i = 0; i < numhdchunks; i++)
-	{
-		stream.read(hdcheck, 4);
-		if (quickcmp(hdcheck, mhwk_cinf_id, 4))
-			mhwk_read_header(stream, cinf, headers);
-		else if (quickcmp(hdcheck, mhwk_conv_id, 4))
-			mhwk_read_header(stream, conv, headers);
-		else if (quickcmp(hdcheck, mhwk_hots_id, 4))
-			mhwk_read_header(stream, hots, headers);
-		else if (quickcmp(hdcheck, mhwk_invo_id, 4))
-			mhwk_read_header(stream, invo, headers);
-		else if (quickcmp(hdcheck, mhwk_qars_id, 4))
-			mhwk_read_header(stream, qars, headers);
-		else if (quickcmp(hdcheck, mhwk_regs_id, 4))
-			mhwk_read_header(stream, regs, headers);
-		else if (quickcmp(hdcheck, mhwk_tbmh_id, 4))
-			mhwk_read_header(stream, tbmh, headers);
-		else if (quickcmp(hdcheck, mhwk_tbmp_id, 4))
-			mhwk_read_header(stream, tbmp, headers);
-		else if (quickcmp(hdcheck, mhwk_tcnt_id, 4))
-			mhwk_read_header(stream, tcnt, headers);
-		else if (quickcmp(hdcheck, mhwk_tpal_id, 4))
-			mhwk_read_header(stream, tpal, headers);
-		else if (quickcmp(hdcheck, mhwk_tscr_id, 4))
-			mhwk_read_header(stream, tscr, headers);
-		else if (quickcmp(hdcheck, mhwk_stri_id, 4))
-		{
-			mhwk_read_header(stream, stri, headers);
-			// this is used to check whether we need to open a file for strings
-			has_strings = true;
-		}
-		else if (quickcmp(hdcheck, mhwk_strl_id, 4))
-			mhwk_read_header(stream, strl, headers);
-		else if (quickcmp(hdcheck, mhwk_scen_id, 4))
-			mhwk_read_header(stream, scen, headers);
-		else if (quickcmp(hdcheck, mhwk_twav_id, 4))
-			mhwk_read_header(stream, twav, headers);
-		// unrecognized header
-		else
-		{
-			mhwk_read_header(stream, mhwk_dattype_none, headers);
-//			throw(DefaultException("unrecognized header chunk"));
-		}
-	}
-	// read index table
-	for (std::vector<MHWKHeadChunk>::size_type i = 0; i < headers.size(); i++)
-	{
-		stream.seekg(hdaddress + headers[i].indstart);
-		mhwk_read_type1_chunk(stream, headers[i].dattype, identries);
-	}
-
-	// read resource table
-	stream.seekg(hdaddress + hdlen);
-	mhwk_read_type2_table(stream, mhwk_dattype_none, entries);
+	mhwk_read_tables(stream, identries, entries, has_strings);
 
 	// sort the entries by index number so we can determine
 	// palettes positionally
@@ -173,16 +151,14 @@ RipperFormats::RipResults MohawkRip::rip(RipUtil::MembufStream& stream, const st
 		for (std::vector<MHWKIndexTableEntry>::size_type i = 0; i < identries.size(); i++)
 		{
 			int indnum = identries[i].index - 1;
+			if (!sink.begin_asset(entries[indnum].address))
+				continue;
 			stream.seekg(entries[indnum].address);
-			char* outbytes = new char[entries[indnum].length];
-			stream.read(outbytes, entries[indnum].length);
-			std::ofstream ofs((fprefix + "-data-" 
+			sink.write_file_from(fprefix + "-data-" 
 				+ mhwk_get_dattype_name(identries[i].dattype)
-				+ "-" + to_string(i)).c_str(),
-				std::ios_base::binary);
-			ofs.write(outbytes, entries[indnum].length);
-			delete[] outbytes;
+				+ "-" + to_string(i), stream, entries[indnum].length);
 		}
+		sink.end_asset();
 		return results;
 	}
 
@@ -206,29 +182,30 @@ RipperFormats::RipResults MohawkRip::rip(RipUtil::MembufStream& stream, const st
 		}
 	}
 
-	// rip strings
-	if (ripset.ripstrings && has_strings)
+	// rip strings (all in one file, so not when selecting a resource)
+	if (ripset.ripstrings && has_strings && ripset.select == "")
 	{
-		std::ofstream ofs((fprefix + "-strings" + ".txt").c_str(), 
-			std::ios_base::binary | std::ios_base::trunc);
+		std::ostringstream strs;
 		int stringnum = 0;
 		for (std::vector<MHWKIndexTableEntry>::size_type i = 0; i < identries.size(); i++)
 		{
 			if (identries[i].dattype == stri || identries[i].dattype == strl)
 			{
-				ofs.width(10);
-				ofs << std::left << stringnum + 1;
+				strs.width(10);
+				strs << std::left << stringnum + 1;
 				int len = entries[identries[i].index - 1].length - 1;
 				stream.seekg(entries[identries[i].index - 1].address);
 				char* outbytes = new char[len];
 				stream.read(outbytes, len);
-				ofs.write(outbytes, len);
-				ofs.put('\n');
+				strs.write(outbytes, len);
+				strs.put('\n');
 				delete[] outbytes;
 				++stringnum;
 				++(results.strings_ripped);
 			}
 		}
+		std::string text = strs.str();
+		sink.write_file(fprefix + "-strings" + ".txt", text.c_str(), text.size());
 	}
 
 	std::vector<BitmapPalette> palettes;
@@ -302,7 +279,15 @@ RipperFormats::RipResults MohawkRip::rip(RipUtil::MembufStream& stream, const st
 	// read data
 	for (std::vector<MHWKIndexTableEntry>::size_type i = 0; i < identries.size(); i++)
 	{
-		if (i >= startentry && i <= endentry)
+		// (entries still current from an incremental rip or not the one
+		// selected are skipped, but still count towards the palette
+		// switches below)
+		bool selected = ripset.select == ""
+			|| (selindex != RipConsts::not_set ? identries[i].index == selindex
+				: identries[i].unknown == selid
+					&& mhwk_get_dattype_name(identries[i].dattype) == seltype);
+		if ((int)i >= startentry && (int)i <= endentry && selected
+			&& sink.begin_asset(entries[identries[i].index - 1].address))
 		{
 			if (identries[i].dattype == twav)
 			{
@@ -312,11 +297,22 @@ RipperFormats::RipResults MohawkRip::rip(RipUtil::MembufStream& stream, const st
 					PCMData wave;
 					mhwk_read_wave(stream, wave, ripset, fmtdat);
 					{
+						int loopstart = wave.get_loopstart();
+						int loopend = wave.get_loopend();
 						if (ripset.normalize)
 							wave.normalize();
-						write_pcmdata_wave(wave, fprefix
-							+ "-wave-"
-							+ to_string(to_string(identries[i].index)) + ".wav");
+						if (wave.get_looping())
+							write_pcmdata_looped(sink, wave, fprefix
+								+ "-wave-"
+								+ to_string(to_string(identries[i].index)),
+								ripset.audioformat, loopstart, loopend, 
+								ripset.numloops - 1, ripset.loopstyle,
+								ripset.loopfadelen, ripset.loopfadesil);
+						else
+							write_pcmdata(sink, wave, fprefix
+								+ "-wave-"
+								+ to_string(to_string(identries[i].index)),
+								ripset.audioformat);
 						++(results.audio_ripped);
 					}
 				}
@@ -336,9 +332,9 @@ RipperFormats::RipResults MohawkRip::rip(RipUtil::MembufStream& stream, const st
 						bitmap.set_palette(palettes[ripset.palettenum]);
 					else
 						bitmap.set_palette_8bit_grayscale();
-					write_bitmapdata_bmp(bitmap, fprefix
+					write_bitmapdata(sink, bitmap, fprefix
 						+ "-tbmp-" 
-						+ to_string(identries[i].index) + ".bmp");
+						+ to_string(identries[i].index), ripset.imageformat);
 					++(results.graphics_ripped);
 				}
 			}
@@ -398,7 +394,7 @@ RipperFormats::RipResults MohawkRip::rip(RipUtil::MembufStream& stream, const st
 						int bytecount = 0;
 						int outputcount = 0;
 
-						std::ofstream ofs("~temporary_shitty_hack", std::ios_base::binary | std::ios_base::trunc);
+						std::ostringstream ofs;
 
 						while (outputcount < decompressedSize)
 						{
@@ -483,7 +479,9 @@ RipperFormats::RipResults MohawkRip::rip(RipUtil::MembufStream& stream, const st
 
 						delete dat;
 
-						MembufStream dumbstream("~temporary_shitty_hack", MembufStream::rb);
+						std::string decompressed = ofs.str();
+						MembufStream dumbstream(decompressed.data(), decompressed.size(),
+							stream.get_fname());
 
 						int fuck = -8;
 
@@ -493,7 +491,7 @@ RipperFormats::RipResults MohawkRip::rip(RipUtil::MembufStream& stream, const st
 							regs_x, regs_y,
 							palettes,
 							palettenum,
-							framenum, fprefix, identries,
+							framenum, sink, fprefix, identries,
 							i,
 							entrynum, fuck, numentries,
 							value1, value2, value3, value4, value5);
@@ -506,7 +504,7 @@ RipperFormats::RipResults MohawkRip::rip(RipUtil::MembufStream& stream, const st
 							regs_x, regs_y,
 							palettes,
 							palettenum,
-							framenum, fprefix, identries,
+							framenum, sink, fprefix, identries,
 							i,
 							entrynum, chunkstart, numentries,
 							value1, value2, value3, value4, value5);
@@ -549,11 +547,10 @@ RipperFormats::RipResults MohawkRip::rip(RipUtil::MembufStream& stream, const st
 
 							if (!ripseq)
 							{
-								write_bitmapdata_bmp(entry.image, fprefix
+								write_bitmapdata(sink, entry.image, fprefix
 									+ "-tbmh-" 
 									+ to_string(identries[i].index) + '-' 
-									+ to_string(framenum + 1)  
-									+ ".bmp");
+									+ to_string(framenum + 1), ripset.imageformat);
 							}
 						}
 						++framenum;
@@ -581,11 +578,10 @@ RipperFormats::RipResults MohawkRip::rip(RipUtil::MembufStream& stream, const st
 								seqsize.centerx + tbmh_entries[j].xoffset,
 								seqsize.centery + tbmh_entries[j].yoffset);
 
-							write_bitmapdata_bmp(bmp, fprefix
+							write_bitmapdata(sink, bmp, fprefix
 								+ "-tbmh-" 
 								+ to_string(identries[i].index) + '-' 
-								+ to_string(j + 1)  
-								+ ".bmp");
+								+ to_string(j + 1), ripset.imageformat);
 						}
 					}
 
@@ -619,13 +615,9 @@ RipperFormats::RipResults MohawkRip::rip(RipUtil::MembufStream& stream, const st
 					case twav: extension = "twav"; break;
 					case strl: extension = "strl"; break;
 					}
-					std::ofstream ofs((fprefix + '_' + extension + '-' + to_string(identries[i].index)).c_str(),
-						std::ios_base::binary);
-					char* outbytes = new char[len];
 					stream.seekg(address);
-					stream.read(outbytes, len);
-					ofs.write(outbytes, len);
-					delete[] outbytes;
+					sink.write_file_from(fprefix + '_' + extension + '-' + to_string(identries[i].index),
+						stream, len);
 					++(results.data_ripped);
 				}
 			}
@@ -638,6 +630,7 @@ RipperFormats::RipResults MohawkRip::rip(RipUtil::MembufStream& stream, const st
 		}
 
 	}
+	sink.end_asset();
 
 	return results;
 }
@@ -648,7 +641,8 @@ void MohawkRip::rip_tbmh_from_stream(RipUtil::MembufStream& stream, RipperFormat
 		REGSEntries& regs_x, REGSEntries& regs_y,
 		std::vector<RipUtil::BitmapPalette>& palettes,
 		int& palettenum,
-		int& framenum, const std::string& fprefix, std::vector<MHWKIndexTableEntry>& identries,
+		int& framenum, RipUtil::OutputSink& sink, const std::string& fprefix,
+		std::vector<MHWKIndexTableEntry>& identries,
 		int i,
 		int& entrynum, int& chunkstart, int& numentries,
 		int& value1, int& value2, int& value3, int& value4, int& value5)
@@ -708,11 +702,10 @@ void MohawkRip::rip_tbmh_from_stream(RipUtil::MembufStream& stream, RipperFormat
 
 			if (!ripseq)
 			{
-				write_bitmapdata_bmp(entry.image, fprefix
+				write_bitmapdata(sink, entry.image, fprefix
 					+ "-tbmh-" 
 					+ to_string(identries[i].index) + '-' 
-					+ to_string(framenum + 1)  
-					+ ".bmp");
+					+ to_string(framenum + 1), ripset.imageformat);
 			}
 		}
 		++framenum;
@@ -740,11 +733,10 @@ void MohawkRip::rip_tbmh_from_stream(RipUtil::MembufStream& stream, RipperFormat
 				seqsize.centerx + tbmh_entries[j].xoffset,
 				seqsize.centery + tbmh_entries[j].yoffset);
 
-			write_bitmapdata_bmp(bmp, fprefix
+			write_bitmapdata(sink, bmp, fprefix
 				+ "-tbmh-" 
 				+ to_string(identries[i].index) + '-' 
-				+ to_string(j + 1)  
-				+ ".bmp");
+				+ to_string(j + 1), ripset.imageformat);
 		}
 	}
 
@@ -761,6 +753,96 @@ bool MohawkRip::IDsByDatType(const MHWKIndexTableEntry& first, const MHWKIndexTa
 	return first.dattype < second.dattype;
 }
 
+bool MohawkRip::list_contents(RipUtil::MembufStream& stream, const RipperFormats::RipperSettings& ripset,
+	const RipperFormats::FileFormatData& fmtdat, std::vector<RipperFormats::ContentsEntry>& contents)
+{
+	std::vector<MHWKIndexTableEntry> identries;
+	std::vector<MHWKAddrTableEntry> entries;
+	bool has_strings = false;
+	mhwk_read_tables(stream, identries, entries, has_strings);
+
+	// resources in the order they're stored
+	std::sort(identries.begin(), identries.end(), IDsByIndexNum);
+	for (std::vector<MHWKIndexTableEntry>::size_type i = 0; i < identries.size(); i++)
+	{
+		int indnum = identries[i].index - 1;
+		if (indnum < 0 || indnum >= (int)entries.size())
+			continue;
+		contents.push_back(ContentsEntry(0, mhwk_get_dattype_name(identries[i].dattype),
+			entries[indnum].address, entries[indnum].length, identries[i].unknown));
+	}
+	return true;
+}
+
+void MohawkRip::mhwk_read_tables(MembufStream& stream,
+	std::vector<MHWKIndexTableEntry>& identries, std::vector<MHWKAddrTableEntry>& entries,
+	bool& has_strings)
+{
+	std::vector<MHWKHeadChunk> headers;
+	// get address of first header chunk
+	stream.seekg(20);
+	int hdaddress = stream.read_int(4);
+	stream.seekg(hdaddress);
+	int hdlen = stream.read_int(2) + 2;
+	int numhdchunks = stream.read_int(2);
+	// read header chunks
+	char hdcheck[4];
+	for (int i = 0; i < numhdchunks; i++)
+	{
+		stream.read(hdcheck, 4);
+		if (quickcmp(hdcheck, mhwk_cinf_id, 4))
+			mhwk_read_header(stream, cinf, headers);
+		else if (quickcmp(hdcheck, mhwk_conv_id, 4))
+			mhwk_read_header(stream, conv, headers);
+		else if (quickcmp(hdcheck, mhwk_hots_id, 4))
+			mhwk_read_header(stream, hots, headers);
+		else if (quickcmp(hdcheck, mhwk_invo_id, 4))
+			mhwk_read_header(stream, invo, headers);
+		else if (quickcmp(hdcheck, mhwk_qars_id, 4))
+			mhwk_read_header(stream, qars, headers);
+		else if (quickcmp(hdcheck, mhwk_regs_id, 4))
+			mhwk_read_header(stream, regs, headers);
+		else if (quickcmp(hdcheck, mhwk_tbmh_id, 4))
+			mhwk_read_header(stream, tbmh, headers);
+		else if (quickcmp(hdcheck, mhwk_tbmp_id, 4))
+			mhwk_read_header(stream, tbmp, headers);
+		else if (quickcmp(hdcheck, mhwk_tcnt_id, 4))
+			mhwk_read_header(stream, tcnt, headers);
+		else if (quickcmp(hdcheck, mhwk_tpal_id, 4))
+			mhwk_read_header(stream, tpal, headers);
+		else if (quickcmp(hdcheck, mhwk_tscr_id, 4))
+			mhwk_read_header(stream, tscr, headers);
+		else if (quickcmp(hdcheck, mhwk_stri_id, 4))
+		{
+			mhwk_read_header(stream, stri, headers);
+			// this is used to check whether we need to open a file for strings
+			has_strings = true;
+		}
+		else if (quickcmp(hdcheck, mhwk_strl_id, 4))
+			mhwk_read_header(stream, strl, headers);
+		else if (quickcmp(hdcheck, mhwk_scen_id, 4))
+			mhwk_read_header(stream, scen, headers);
+		else if (quickcmp(hdcheck, mhwk_twav_id, 4))
+			mhwk_read_header(stream, twav, headers);
+		// unrecognized header
+		else
+		{
+			mhwk_read_header(stream, mhwk_dattype_none, headers);
+//			throw(DefaultException("unrecognized header chunk"));
+		}
+	}
+	// read index table
+	for (std::vector<MHWKHeadChunk>::size_type i = 0; i < headers.size(); i++)
+	{
+		stream.seekg(hdaddress + headers[i].indstart);
+		mhwk_read_type1_chunk(stream, headers[i].dattype, identries);
+	}
+
+	// read resource table
+	stream.seekg(hdaddress + hdlen);
+	mhwk_read_type2_table(stream, mhwk_dattype_none, entries);
+}
+
 void MohawkRip::mhwk_read_header(MembufStream& stream, MHWKDatType dat,
 	std::vector<MHWKHeadChunk>& entries)
 {
@@ -945,10 +1027,12 @@ void MohawkRip::mhwk_read_wave(MembufStream& stream, PCMData& dat,
 				dat.get_waveform()[i] = stream.read_int(1);
 			}
 		}
+		// loops are rendered when the wave is written
 		if (looping)
 		{
-			dat.add_loop(loopstart, loopend, ripset.numloops - 1, ripset.loopstyle,
-				ripset.loopfadelen, ripset.loopfadesil);
+			dat.set_looping(true);
+			dat.set_loopstart(loopstart);
+			dat.set_loopend(loopend);
 		}
 	}
 }
@@ -967,10 +1051,7 @@ void MohawkRip::mhwk_read_tbmp(MembufStream& stream, BitmapData& dat,
 		RawData rawdat;
 		decompress_lz(stream, rawdat);
 
-		std::ofstream ofs("~temporary_shitty_hack_2", std::ios_base::binary | std::ios_base::trunc);
-		ofs.write(rawdat.data, rawdat.size);
-
-		RipUtil::MembufStream dumbstream("~temporary_shitty_hack_2", MembufStream::rb);
+		RipUtil::MembufStream dumbstream(rawdat.data, rawdat.size, stream.get_fname());
 		extract_tbmp(dumbstream, dat,
 			width, height, bytesperrow, format);
 
@@ -23,17 +23,28 @@ public:
 	/*	RipSupport(supported, supported, supported, supported, unnecessary) */ ),
 		ripseq(true) { };
 
+	bool check_header(const char* header, int len, int fsize,
+		const RipperFormats::RipperSettings& ripset);
+
 	bool can_rip(RipUtil::MembufStream& stream, const RipperFormats::RipperSettings& ripset,
 		RipperFormats::FileFormatData& fmtdat);
 
-	RipperFormats::RipResults rip(RipUtil::MembufStream& stream, const std::string& fprefix,
+	RipperFormats::RipResults rip(RipUtil::MembufStream& stream, RipUtil::OutputSink& sink,
+		const std::string& fprefix,
 		const RipperFormats::RipperSettings& ripset, const RipperFormats::FileFormatData& fmtdat);
 
+	bool list_contents(RipUtil::MembufStream& stream, const RipperFormats::RipperSettings& ripset,
+		const RipperFormats::FileFormatData& fmtdat, std::vector<RipperFormats::ContentsEntry>& contents);
+
 private:
 
 	RipperFormats::FileFormatData check_file_format(const std::string& filename, int bufsize);
 
 	void check_params(int argc, char* argv[]);
+	// get the resource named with -select: by type and ID, as listed
+	// with --list, or by its index, as in the output filenames
+	void check_selector(const std::string& spec, std::string& seltype, int& selid,
+		int& selindex);
 
 	bool ripseq;
 
@@ -138,7 +149,8 @@ private:
 		REGSEntries& regs_x, REGSEntries& regs_y,
 		std::vector<RipUtil::BitmapPalette>& palettes,
 		int& palettenum,
-		int& framenum, const std::string& fprefix, std::vector<MHWKIndexTableEntry>& identries,
+		int& framenum, RipUtil::OutputSink& sink, const std::string& fprefix,
+		std::vector<MHWKIndexTableEntry>& identries,
 		int i,
 		int& entrynum, int& chunkstart, int& numentries,
 		int& value1, int& value2, int& value3, int& value4, int& value5);
@@ -229,6 +241,12 @@ private:
 
 	static bool IDsByDatType(const MHWKIndexTableEntry& fir, const MHWKIndexTableEntry& sec);
 
+	// read the Mohawk header chunks and the index and resource tables
+	// they point to; has_strings is set if there are strings
+	void mhwk_read_tables(RipUtil::MembufStream& stream,
+		std::vector<MHWKIndexTableEntry>& identries, std::vector<MHWKAddrTableEntry>& entries,
+		bool& has_strings);
+
 	// read Mohawk header chunk
 	void mhwk_read_header(RipUtil::MembufStream& stream, MHWKDatType dat,
 		std::vector<MHWKHeadChunk>& entries);
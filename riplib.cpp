@@ -0,0 +1,169 @@
+#include "riplib.h"
+#include "launch.h"
+#include "RipModules.h"
+#include "utils/DatManip.h"
+#include "utils/MembufStream.h"
+#include "utils/InputFiles.h"
+#include "utils/OutputSink.h"
+#include "utils/logger.h"
+#include <algorithm>
+
+using namespace Ripper;
+using namespace RipperFormats;
+using namespace RipUtil;
+using namespace Logger;
+
+namespace RipLib
+{
+
+
+// passes output to an AssetHandler: images and audio decoded, anything
+// else as the bytes of the file it would have been
+class HandlerOutputSink : public OutputSink
+{
+public:
+	HandlerOutputSink(AssetHandler& handler)
+		: handler(handler) { };
+
+	bool wants_decoded() const { return true; }
+	void take_bitmap(const std::string& filename, BitmapData& bmp) { handler.bitmap(filename, bmp); }
+	void take_audio(const std::string& filename, PCMData& pcm) { handler.audio(filename, pcm); }
+
+protected:
+	void open_file(const std::string& filename, long long size)
+	{
+		name = filename;
+		data.clear();
+		if (size > 0)
+			data.reserve(size);
+	}
+	void write_bytes(const char* d, int n) { data.insert(data.end(), d, d + n); }
+	void close_file()
+	{
+		handler.file(name, data.empty() ? 0 : &data.front(), data.size());
+		data.clear();
+	}
+
+private:
+	AssetHandler& handler;
+	std::string name;
+	std::vector<char> data;
+};
+
+// settings for ripping name with the given params, as if from the
+// command line; args and argv hold the command line ripset points to
+static void configure_library_settings(const std::string& name,
+	const std::vector<std::string>& params, std::vector<std::string>& args,
+	std::vector<char*>& argv, RipperSettings& ripset)
+{
+	args.push_back("allrip");
+	args.push_back(name);
+	args.insert(args.end(), params.begin(), params.end());
+	for (size_t i = 0; i < args.size(); i++)
+		argv.push_back(const_cast<char*>(args[i].c_str()));
+
+	configure_parameters(argv.size(), &argv.front(), ripset);
+	ripset.argc = argv.size();
+	ripset.argv = &argv.front();
+}
+
+// rip stream with the candidate modules
+static RipResults rip_candidates(RipModules& mods, const std::vector<int>& candidates,
+	MembufStream& stream, const RipperSettings& ripset, AssetHandler& handler,
+	bool* recognized)
+{
+	HandlerOutputSink sink(handler);
+	std::string fprefix = get_short_filename(stream.get_fname());
+	RipResults results;
+	bool ripped = false;
+
+	// modules log to files next to their output
+	bool logging = logger.enabled();
+	logger.disable();
+	try
+	{
+		FileFormatData fmtdat;
+		for (size_t i = 0; i < candidates.size(); i++)
+		{
+			RipModule* mod = mods[candidates[i]];
+			if (mod->can_rip(stream, ripset, fmtdat))
+			{
+				results.add(mod->rip(stream, sink, fprefix, ripset, fmtdat));
+				ripped = true;
+			}
+			stream.rewind();
+		}
+	}
+	catch (...)
+	{
+		if (logging)
+			logger.enable();
+		throw;
+	}
+	if (logging)
+		logger.enable();
+
+	if (recognized)
+		*recognized = ripped;
+	return results;
+}
+
+RipResults rip_file(const std::string& filename, AssetHandler& handler,
+	const std::vector<std::string>& params, bool* recognized)
+{
+	std::vector<std::string> args;
+	std::vector<char*> argv;
+	RipperSettings ripset;
+	configure_library_settings(filename, params, args, argv, ripset);
+
+	// modules keep settings from one rip to the next, so each rip
+	// gets its own
+	RipModules mods;
+	std::vector<int> candidates;
+	mods.detect(filename, ripset, candidates);
+	if (candidates.empty())
+	{
+		if (recognized)
+			*recognized = false;
+		return RipResults();
+	}
+
+	MembufStream* stream = open_input(filename);
+	RipResults results;
+	try
+	{
+		results = rip_candidates(mods, candidates, *stream, ripset, handler, recognized);
+	}
+	catch (...)
+	{
+		delete stream;
+		throw;
+	}
+	delete stream;
+	return results;
+}
+
+RipResults rip_buffer(const char* data, int size, const std::string& name,
+	AssetHandler& handler, const std::vector<std::string>& params, bool* recognized)
+{
+	std::vector<std::string> args;
+	std::vector<char*> argv;
+	RipperSettings ripset;
+	configure_library_settings(name, params, args, argv, ripset);
+
+	RipModules mods;
+	std::vector<int> candidates;
+	mods.detect(data, std::min(size, DetectConsts::header_size), size, ripset, candidates);
+	if (candidates.empty())
+	{
+		if (recognized)
+			*recognized = false;
+		return RipResults();
+	}
+
+	MembufStream stream(data, size, name);
+	return rip_candidates(mods, candidates, stream, ripset, handler, recognized);
+}
+
+
+};	// end namespace RipLib
@@ -0,0 +1,50 @@
+/*	Library interface for embedding the rippers in another program:
+	rip an input file or a buffer already in memory, and receive the
+	ripped assets through callbacks instead of files on disk */
+
+#include "RipperFormats.h"
+#include "utils/BitmapData.h"
+#include "utils/PCMData.h"
+#include <string>
+#include <vector>
+
+namespace RipLib
+{
+
+
+// receives the assets of a rip as they're decoded
+// names are those of the files the command line ripper would have
+// written, extension included
+class AssetHandler
+{
+public:
+	virtual ~AssetHandler() { };
+
+	// an image, with its palette if it's palettized
+	virtual void bitmap(const std::string& name, RipUtil::BitmapData& bmp) { };
+	// audio, with any loops already added
+	virtual void audio(const std::string& name, RipUtil::PCMData& pcm) { };
+	// anything else: raw data, strings, metadata...
+	virtual void file(const std::string& name, const char* data, int size) { };
+};
+
+// rip filename with the modules that recognize it, handing the assets
+// to handler; params are command line params, as given to the command
+// line ripper (e.g. "--ripallraw", or "-e" followed by "105")
+// recognized, if given, is set to whether any module could rip it
+// throws FileOpenException if the file can't be read, and other
+// exceptions for errors while ripping
+RipperFormats::RipResults rip_file(const std::string& filename, AssetHandler& handler,
+	const std::vector<std::string>& params = std::vector<std::string>(),
+	bool* recognized = 0);
+
+// the same for size bytes of data in memory, ripped as if from a
+// file called name
+RipperFormats::RipResults rip_buffer(const char* data, int size, const std::string& name,
+	AssetHandler& handler, const std::vector<std::string>& params = std::vector<std::string>(),
+	bool* recognized = 0);
+
+
+};	// end namespace RipLib
+
+#pragma once
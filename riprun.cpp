@@ -0,0 +1,679 @@
+#include "riprun.h"
+#include "launch.h"
+#include "contentsindex.h"
+#include "utils/DatManip.h"
+#include "utils/MembufStream.h"
+#include "utils/ShardedOutputSink.h"
+#include "utils/IncrementalOutputSink.h"
+#include "utils/JournalOutputSink.h"
+#include "utils/WorkShardOutputSink.h"
+#include "utils/MemoryBudget.h"
+#include "utils/OutputStats.h"
+#include "utils/InputFiles.h"
+#include "utils/IsoImage.h"
+#include "utils/WorkerThreads.h"
+#include "utils/DefaultException.h"
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <map>
+#include <cstdlib>
+
+#ifndef _WIN32
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+using std::cout;
+using std::cerr;
+using namespace Ripper;
+using namespace RipperFormats;
+using namespace RipUtil;
+
+
+// join the write threads and free the sinks; unwritten output is lost
+static void delete_output_sinks(OutputSinks& sinks)
+{
+	delete sinks.writebehind;
+	delete sinks.uringsink;
+	delete sinks.checksumsink;
+	delete sinks.archivesink;
+	sinks.writebehind = 0;
+	sinks.uringsink = 0;
+	sinks.checksumsink = 0;
+	sinks.archivesink = 0;
+	sinks.sink = 0;
+}
+
+OutputSinks::~OutputSinks()
+{
+	// the error that got here is already being passed on
+	if (sink)
+	{
+		try
+		{
+			sink->flush();
+		}
+		catch (...)
+		{
+
+		}
+	}
+	delete_output_sinks(*this);
+}
+
+void open_output_sinks(const RipperSettings& ripset, OutputSinks& sinks)
+{
+	sinks.starttime = std::chrono::steady_clock::now();
+	sinks.sink = &sinks.filesink;
+
+	// time decoding alone: nothing is written, so none of the other
+	// output options apply
+	if (ripset.dryrun)
+	{
+		sinks.sink = &sinks.nullsink;
+		return;
+	}
+	// hash the output instead of writing it
+	else if (ripset.checksum != "")
+	{
+		sinks.checksumsink = new ChecksumOutputSink(ripset.checksum);
+		sinks.sink = sinks.checksumsink;
+		return;
+	}
+	else if (ripset.archive != "")
+	{
+		sinks.archivesink = create_archive_sink(ripset.archive);
+		sinks.sink = sinks.archivesink;
+	}
+	else if (ripset.iouring)
+	{
+		sinks.uringsink = new UringOutputSink;
+		if (!sinks.uringsink->using_uring())
+			cout << "io_uring is not available: writing files normally" << '\n';
+		sinks.sink = sinks.uringsink;
+	}
+
+	// hand finished files to background I/O threads
+	if (ripset.iothreads > 0)
+	{
+		long long maxqueued = (long long)ripset.writequeue * 1024 * 1024;
+		long long queueshare = get_budget_share(MemoryBudgetConsts::queue_share);
+		if (queueshare != MemoryBudgetConsts::unlimited && queueshare < maxqueued)
+		{
+			maxqueued = queueshare;
+			count_budget_fallback("write queue cut to " + to_string(queueshare / 1048576)
+				+ " MB");
+		}
+		// an archive is one sequential stream and io_uring batches on
+		// its own: a single thread feeds either
+		if (sinks.sink != &sinks.filesink)
+			sinks.writebehind = new WriteBehindSink(*sinks.sink, maxqueued);
+		else
+			sinks.writebehind = new WriteBehindSink(ripset.iothreads, maxqueued);
+		sinks.sink = sinks.writebehind;
+	}
+}
+
+void close_output_sinks(const RipperSettings& ripset, OutputSinks& sinks, RipTotals& totals)
+{
+	// wait for all output to be written; if some couldn't be, the
+	// write threads are still joined and the sinks closed before the
+	// error is passed on
+	try
+	{
+		sinks.sink->flush();
+	}
+	catch (...)
+	{
+		delete_output_sinks(sinks);
+		throw;
+	}
+	delete sinks.writebehind;
+	delete sinks.uringsink;
+	sinks.writebehind = 0;
+	sinks.uringsink = 0;
+
+	totals.discardedfiles += sinks.nullsink.get_num_files();
+	totals.discardedbytes += sinks.nullsink.get_total_bytes();
+
+	if (sinks.checksumsink)
+	{
+		cout << "Checksums of " << sinks.checksumsink->get_num_files() << " files written to "
+			<< ripset.checksum << '\n';
+		delete sinks.checksumsink;
+		sinks.checksumsink = 0;
+	}
+
+	// archive throughput, for comparing against plain file output
+	if (sinks.archivesink)
+	{
+		double wallsecs = std::chrono::duration<double>(
+			std::chrono::steady_clock::now() - sinks.starttime).count();
+		if (wallsecs <= 0)
+			wallsecs = 1e-9;
+		cout << "Archive " << ripset.archive << ": "
+			<< sinks.archivesink->get_num_entries() << " files, "
+			<< sinks.archivesink->get_archive_size() << " bytes ("
+			<< sinks.archivesink->get_num_entries() / wallsecs << " files/sec, "
+			<< sinks.archivesink->get_archive_size() / wallsecs / 1000000 << " MB/sec)" << '\n';
+		delete sinks.archivesink;
+		sinks.archivesink = 0;
+	}
+	sinks.sink = 0;
+}
+
+// add the listing of an input's contents to listing
+static void print_contents(std::ostream& listing, const std::string& shortfname,
+	const std::string& module, const std::vector<ContentsEntry>& contents)
+{
+	listing << "Contents of " << shortfname << " (" << module << "): "
+		<< contents.size() << " entries" << '\n';
+	listing << "    offset        size  type" << '\n';
+	for (size_t i = 0; i < contents.size(); i++)
+	{
+		const ContentsEntry& entry = contents[i];
+		listing << "0x" << std::hex << std::setfill('0') << std::setw(8) << entry.offset
+			<< std::dec << std::setfill(' ') << std::setw(12) << entry.size << "  "
+			<< std::string(entry.depth * 2, ' ') << entry.type;
+		if (entry.id != RipConsts::not_set)
+			listing << " " << entry.id;
+		if (entry.name != "")
+			listing << " " << entry.name;
+		listing << '\n';
+	}
+}
+
+// list the contents of the input mod has just recognized into index,
+// and save it at indexpath; false if mod can't list contents
+static bool index_input(RipModule* mod, MembufStream& stream, const RipperSettings& ripset,
+	const FileFormatData& fmtdat, const std::string& indexpath, ContentsIndex& index)
+{
+	index.module = mod->module_name;
+	index.encoding = stream.get_decoding_byte();
+	index.contents.clear();
+	if (!mod->list_contents(stream, ripset, fmtdat, index.contents))
+		return false;
+	stream.clear();
+
+	if (indexpath != "" && !save_contents_index(indexpath, stream.get_fname(), index))
+		cout << "Could not write index " << indexpath << '\n';
+	return true;
+}
+
+// print the contents of stream as listed by the candidate modules,
+// saving them at indexpath if it's set; false if none could list it
+static bool list_input(RipModules& mods, const std::vector<int>& candidates,
+	MembufStream& stream, const RipperSettings& ripset, const std::string& indexpath)
+{
+	std::string shortfname = get_short_filename(stream.get_fname());
+	// printed all at once, so listings from batch workers don't mix
+	std::ostringstream listing;
+	bool listed = false;
+	FileFormatData fmtdat;
+	for (size_t i = 0; i < candidates.size(); i++)
+	{
+		RipModule* mod = mods[candidates[i]];
+		ContentsIndex index;
+		// only the first listing is indexed
+		if (mod->can_rip(stream, ripset, fmtdat)
+			&& index_input(mod, stream, ripset, fmtdat, listed ? "" : indexpath, index))
+		{
+			print_contents(listing, shortfname, mod->module_name, index.contents);
+			listed = true;
+		}
+		stream.rewind();
+	}
+
+	if (!listed)
+		listing << "No module could list the contents of " << shortfname << '\n';
+	cout << listing.str();
+	cout.flush();
+	return listed;
+}
+
+bool rip_input(RipModules& mods, const std::string& filename,
+	const std::string& fprefix, const RipperSettings& ripset,
+	int bufsize, OutputSink& output, RipResults& results)
+{
+	std::string shortfname = get_short_filename(filename);
+
+	// an index saved by an earlier run names the module for the input,
+	// and lists its contents without loading it
+	std::string indexpath = get_index_path(filename, ripset);
+	ContentsIndex index;
+	bool indexed = (indexpath != "" && load_contents_index(indexpath, filename, index));
+	std::vector<int> candidates;
+	if (indexed)
+	{
+		for (int i = 0; i < mods.num_mods(); i++)
+			if (mods[i]->module_name == index.module)
+				candidates.push_back(i);
+		// made by a build with other modules
+		indexed = !candidates.empty();
+	}
+	if (indexed && ripset.listcontents)
+	{
+		std::ostringstream listing;
+		print_contents(listing, shortfname, index.module, index.contents);
+		cout << listing.str();
+		cout.flush();
+		return true;
+	}
+
+	// only load the file if its header matches some module
+	if (!indexed)
+		mods.detect(filename, ripset, candidates);
+	if (candidates.empty())
+	{
+		cout << "No module could recognize " << shortfname << ": no output" << '\n';
+		return false;
+	}
+
+	// an input bigger than its share of the memory budget is read
+	// through a window, refilled as the module moves around it; one in
+	// a disc image is only paged in from the image as it's read
+	long long inputshare = get_budget_share(MemoryBudgetConsts::input_share);
+	IsoImage* image;
+	const IsoEntry* entry;
+	if (inputshare != MemoryBudgetConsts::unlimited && !find_image_file(filename, image, entry))
+	{
+		long long window = std::max(inputshare, (long long)MemoryBudgetConsts::min_input_window);
+		if (bufsize == MembufStream::def_bufsize || bufsize > window)
+		{
+			if (get_input_size(filename) > window)
+			{
+				bufsize = window;
+				count_budget_fallback("input read through a " + to_string(window / 1048576)
+					+ " MB window");
+			}
+		}
+	}
+	MembufStream* input = open_input(filename, bufsize);
+	MembufStream& stream = *input;
+	if (ripset.listcontents)
+	{
+		bool listed;
+		try
+		{
+			listed = list_input(mods, candidates, stream, ripset, indexpath);
+		}
+		catch (...)
+		{
+			delete input;
+			throw;
+		}
+		delete input;
+		return listed;
+	}
+
+	OutputSink* sink = &output;
+	// incremental and resumed rips need the output on disk
+	bool ondisk = (!ripset.dryrun && ripset.checksum == "" && ripset.archive == "");
+
+	// skip assets whose output is unchanged since the last run
+	IncrementalOutputSink* incrementalsink = 0;
+	if (ripset.incremental && ondisk)
+	{
+		incrementalsink = new IncrementalOutputSink(*sink, fprefix + "-manifest.txt",
+			filename, get_output_settings(ripset.argc, ripset.argv));
+		sink = incrementalsink;
+	}
+	// journal finished units, to pick up from there if interrupted
+	JournalOutputSink* journalsink = 0;
+	if (ripset.resume && ondisk)
+	{
+		journalsink = new JournalOutputSink(*sink, fprefix + "-journal.txt",
+			filename, get_output_settings(ripset.argc, ripset.argv));
+		sink = journalsink;
+	}
+	// spread output over subdirectories
+	ShardedOutputSink* shardsink = 0;
+	if (ripset.shardlayout != ShardedOutputSink::flatlayout
+		&& !ripset.dryrun && ripset.checksum == "")
+	{
+		shardsink = new ShardedOutputSink(*sink, ripset.shardlayout,
+			ripset.shardfanout, ripset.archive == "");
+		sink = shardsink;
+	}
+	// keep only this process's share of the work
+	WorkShardOutputSink* worksink = 0;
+	if (ripset.workshards > 1)
+	{
+		worksink = new WorkShardOutputSink(*sink, ripset.workshard, ripset.workshards,
+			shortfname);
+		sink = worksink;
+	}
+
+	FileFormatData fmtdat;
+	bool ripped = false;
+	try
+	{
+		for (size_t i = 0; i < candidates.size(); i++)
+		{
+			RipModule* mod = mods[candidates[i]];
+			if (mod->can_rip(stream, ripset, fmtdat))
+			{
+				cout << "Input file: " << shortfname << '\n';
+				if (incrementalsink)
+					incrementalsink->set_module(mod->module_name);
+				if (journalsink)
+					journalsink->set_module(mod->module_name);
+				// index the input the first time it's ripped
+				if (indexpath != "" && !indexed)
+					indexed = index_input(mod, stream, ripset, fmtdat, indexpath, index);
+				if (indexed && index.module == mod->module_name)
+					mod->set_indexed_contents(&index.contents);
+				results.add(mod->rip(stream, *sink, fprefix, ripset, fmtdat));
+				mod->set_indexed_contents(0);
+				ripped = true;
+			}
+			stream.rewind();
+		}
+
+		// this input's manifest and journal are written now; the shared
+		// sinks are flushed after the last input
+		if (journalsink)
+			journalsink->flush();
+		else if (incrementalsink)
+			incrementalsink->flush();
+	}
+	catch (...)
+	{
+		for (size_t i = 0; i < candidates.size(); i++)
+			mods[candidates[i]]->set_indexed_contents(0);
+		delete worksink;
+		delete shardsink;
+		delete journalsink;
+		delete incrementalsink;
+		delete input;
+		throw;
+	}
+	delete input;
+
+	if (worksink)
+	{
+		cout << "Shard " << ripset.workshard + 1 << "/" << ripset.workshards << ": skipped "
+			<< worksink->get_num_skipped() << " units left to other shards" << '\n';
+		delete worksink;
+	}
+	delete shardsink;
+	// the rip is complete, so there's nothing left to resume
+	if (journalsink)
+	{
+		if (journalsink->get_num_skipped())
+			cout << "Resumed: skipped " << journalsink->get_num_skipped()
+				<< " units finished by an earlier run" << '\n';
+		journalsink->remove_journal();
+		delete journalsink;
+	}
+	if (incrementalsink)
+	{
+		cout << "Incremental: " << incrementalsink->get_num_skipped() << " of "
+			<< incrementalsink->get_num_assets() << " assets up to date" << '\n';
+		delete incrementalsink;
+	}
+
+	if (!ripped)
+	{
+		cout << "No module could recognize " << shortfname << ": no output" << '\n';
+	}
+	return ripped;
+}
+
+// rip one input of a batch, counting the outcome in totals rather
+// than stopping the batch on an error
+static void rip_batch_input(RipModules& mods, const std::string& filename,
+	const std::string& fprefix, const RipperSettings& ripset, int bufsize,
+	OutputSink& output, RipTotals& totals)
+{
+	try
+	{
+		if (rip_input(mods, filename, fprefix, ripset, bufsize, output, totals.results))
+			++totals.ripped;
+		else
+			++totals.unrecognized;
+	}
+	catch (FileOpenException& e)
+	{
+		cerr << "Error opening file " << e.fname << " for reading " << '\n';
+		++totals.failed;
+	}
+	catch (std::exception& e)
+	{
+		cerr << "Error ripping " << filename << ": " << e.what() << '\n';
+		++totals.failed;
+	}
+}
+
+#ifndef _WIN32
+
+// pass totals from a worker process back to the batch
+static void save_totals(std::ostream& ostr, const RipTotals& totals)
+{
+	const RipResults& r = totals.results;
+	ostr << "totals " << totals.ripped << ' ' << totals.unrecognized << ' '
+		<< totals.failed << ' ' << totals.discardedfiles << ' '
+		<< totals.discardedbytes << ' ' << r.graphics_ripped << ' '
+		<< r.animations_ripped << ' ' << r.animation_frames_ripped << ' '
+		<< r.audio_ripped << ' ' << r.strings_ripped << ' '
+		<< r.palettes_ripped << ' ' << r.data_ripped << '\n';
+}
+
+// add totals saved by a worker; false if there were none
+static bool load_totals(std::istream& istr, RipTotals& totals)
+{
+	std::string tag;
+	RipTotals t;
+	RipResults& r = t.results;
+	istr >> tag >> t.ripped >> t.unrecognized >> t.failed >> t.discardedfiles
+		>> t.discardedbytes >> r.graphics_ripped >> r.animations_ripped
+		>> r.animation_frames_ripped >> r.audio_ripped >> r.strings_ripped
+		>> r.palettes_ripped >> r.data_ripped;
+	if (!istr || tag != "totals")
+		return false;
+
+	totals.ripped += t.ripped;
+	totals.unrecognized += t.unrecognized;
+	totals.failed += t.failed;
+	totals.discardedfiles += t.discardedfiles;
+	totals.discardedbytes += t.discardedbytes;
+	totals.results.add(r);
+	return true;
+}
+
+// rip one input in a forked worker process and send the totals down fd
+static void run_worker(RipModules& mods, const std::string& filename,
+	const std::string& fprefix, const RipperSettings& ripset, int fd)
+{
+	RipTotals totals;
+	try
+	{
+		OutputSinks sinks;
+		open_output_sinks(ripset, sinks);
+		rip_batch_input(mods, filename, fprefix, ripset, -1, *sinks.sink, totals);
+		close_output_sinks(ripset, sinks, totals);
+	}
+	catch (std::exception& e)
+	{
+		cerr << "Error ripping " << filename << ": " << e.what() << '\n';
+		totals.failed = 1;
+	}
+
+	std::ostringstream msg;
+	save_totals(msg, totals);
+	save_budget_fallbacks(msg);
+	save_output_stats(msg);
+	std::string text = msg.str();
+	for (size_t pos = 0; pos < text.size(); )
+	{
+		int n = write(fd, text.c_str() + pos, text.size() - pos);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			break;
+		pos += n;
+	}
+	close(fd);
+}
+
+int start_worker(RipModules& mods, const std::string& filename,
+	const std::string& fprefix, const RipperSettings& ripset, int threads,
+	long long membudget, int& fd, const std::vector<int>& closefds)
+{
+	int fds[2];
+	if (pipe(fds) != 0)
+		throw(DefaultException("could not create pipe for worker process"));
+	// don't let the worker inherit unwritten output
+	cout.flush();
+	cerr.flush();
+	int pid = fork();
+	if (pid < 0)
+	{
+		close(fds[0]);
+		close(fds[1]);
+		throw(DefaultException("could not start worker process"));
+	}
+	if (pid == 0)
+	{
+		close(fds[0]);
+		for (size_t i = 0; i < closefds.size(); i++)
+			close(closefds[i]);
+		set_worker_threads(threads);
+		set_memory_budget(membudget);
+		run_worker(mods, filename, fprefix, ripset, fds[1]);
+		cout.flush();
+		cerr.flush();
+		std::exit(0);
+	}
+	close(fds[1]);
+	fd = fds[0];
+	return pid;
+}
+
+bool finish_worker(int fd, RipTotals& totals)
+{
+	// read everything the worker sent
+	std::string text;
+	char buf[4096];
+	while (true)
+	{
+		int n = read(fd, buf, sizeof(buf));
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			break;
+		text.append(buf, n);
+	}
+	close(fd);
+
+	std::istringstream msg(text);
+	if (!load_totals(msg, totals))
+		return false;
+	load_budget_fallbacks(msg);
+	load_output_stats(msg);
+	return true;
+}
+
+// rip the inputs in forked worker processes, one per input and at most
+// ripset.jobs at once, so modules' per-process state is never shared
+// workers hold their whole input in memory, so one is only started
+// if the inputs being ripped fit within ripset.batchmemory
+static void rip_batch_forked(RipModules& mods, const std::vector<std::string>& inputs,
+	const std::vector<std::string>& prefixes, const RipperSettings& ripset,
+	RipTotals& totals)
+{
+	long long budget = (long long)ripset.batchmemory * 1024 * 1024;
+	long long inflight = 0;
+	// under a memory budget, each worker keeps to its share of it
+	// (reading its input through a window if need be)
+	long long workerbudget = MemoryBudgetConsts::unlimited;
+	if (get_memory_budget() != MemoryBudgetConsts::unlimited)
+	{
+		workerbudget = get_memory_budget() / ripset.jobs;
+		budget = std::min(budget, get_memory_budget());
+	}
+
+	// each worker gets its share of the encoder threads
+	int workerthreads = std::max(1, get_worker_threads() / ripset.jobs);
+
+	std::map<int, int> workerinput;			// pid -> input
+	std::map<int, int> workerfd;			// pid -> read end of its pipe
+	std::map<int, long long> workerbytes;	// pid -> size of its input
+	int next = 0;
+	while (next < (int)inputs.size() || !workerinput.empty())
+	{
+		while (next < (int)inputs.size() && (int)workerinput.size() < ripset.jobs)
+		{
+			// an input bigger than the budget still gets ripped, alone
+			long long size = get_input_size(inputs[next]);
+			if (workerbudget != MemoryBudgetConsts::unlimited)
+				size = std::min(size, workerbudget);
+			if (!workerinput.empty() && inflight + size > budget)
+				break;
+
+			int fd;
+			int pid = start_worker(mods, inputs[next], prefixes[next], ripset,
+				ripset.threads ? ripset.threads : workerthreads, workerbudget, fd);
+			workerinput[pid] = next;
+			workerfd[pid] = fd;
+			workerbytes[pid] = size;
+			inflight += size;
+			++next;
+		}
+
+		int status;
+		int pid = waitpid(-1, &status, 0);
+		if (pid < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			throw(DefaultException("lost track of worker processes"));
+		}
+		if (!workerinput.count(pid))
+			continue;
+
+		if (!finish_worker(workerfd[pid], totals))
+		{
+			cerr << "Error ripping " << inputs[workerinput[pid]]
+				<< ": worker process died" << '\n';
+			++totals.failed;
+		}
+		inflight -= workerbytes[pid];
+		workerinput.erase(pid);
+		workerfd.erase(pid);
+		workerbytes.erase(pid);
+	}
+}
+
+#endif
+
+void rip_batch(RipModules& mods, const std::vector<std::string>& inputs,
+	const std::vector<std::string>& prefixes, const RipperSettings& ripset,
+	RipTotals& totals)
+{
+#ifndef _WIN32
+	// an archive or checksum manifest collects the output of every input,
+	// so those are written from this process
+	if (ripset.jobs > 1 && ripset.archive == "" && ripset.checksum == "")
+	{
+		rip_batch_forked(mods, inputs, prefixes, ripset, totals);
+		return;
+	}
+#endif
+
+	OutputSinks sinks;
+	open_output_sinks(ripset, sinks);
+	for (size_t i = 0; i < inputs.size(); i++)
+	{
+		// modules keep settings from one rip to the next (a selection,
+		// the asset types to rip...), so each input gets fresh ones, as
+		// each forked worker does
+		RipModules inputmods;
+		rip_batch_input(inputmods, inputs[i], prefixes[i], ripset, -1, *sinks.sink, totals);
+	}
+	close_output_sinks(ripset, sinks, totals);
+}
@@ -0,0 +1,95 @@
+/*	Running rips: setting up output sinks, ripping one input file with
+	whichever module recognizes it, and ripping batches of inputs on a
+	pool of worker processes */
+
+#include "RipperFormats.h"
+#include "RipModules.h"
+#include "utils/OutputSink.h"
+#include "utils/ArchiveOutputSink.h"
+#include "utils/ChecksumOutputSink.h"
+#include "utils/UringOutputSink.h"
+#include "utils/WriteBehindSink.h"
+#include <chrono>
+#include <string>
+#include <vector>
+
+
+
+// output sinks shared by every input ripped in one process; ones still
+// open when it goes (a rip threw) are flushed and freed, so queued output
+// is written and an archive is finished
+struct OutputSinks
+{
+	OutputSinks()
+		: checksumsink(0), archivesink(0), uringsink(0), writebehind(0), sink(0) { };
+	~OutputSinks();
+
+	RipUtil::FileOutputSink filesink;
+	RipUtil::NullOutputSink nullsink;
+	RipUtil::ChecksumOutputSink* checksumsink;
+	RipUtil::ArchiveOutputSink* archivesink;
+	RipUtil::UringOutputSink* uringsink;
+	RipUtil::WriteBehindSink* writebehind;
+	RipUtil::OutputSink* sink;		// where output goes
+	std::chrono::steady_clock::time_point starttime;
+
+private:
+	OutputSinks(const OutputSinks&);
+	OutputSinks& operator=(const OutputSinks&);
+};
+
+// totals over all inputs ripped
+struct RipTotals
+{
+	RipTotals()
+		: ripped(0), unrecognized(0), failed(0),
+		discardedfiles(0), discardedbytes(0) { };
+
+	RipperFormats::RipResults results;
+	int ripped;					// inputs some module could rip
+	int unrecognized;			// inputs no module could rip
+	int failed;					// inputs that stopped with an error
+	int discardedfiles;			// output dropped by a dry run
+	long long discardedbytes;
+};
+
+// set up the output sinks asked for by ripset
+void open_output_sinks(const RipperFormats::RipperSettings& ripset, OutputSinks& sinks);
+
+// write everything still pending, report on the sinks and free them
+void close_output_sinks(const RipperFormats::RipperSettings& ripset, OutputSinks& sinks,
+	RipTotals& totals);
+
+// rip filename with the first module that recognizes it, writing to output
+// with the given prefix; bufsize limits the input buffer (-1 = whole file)
+// returns false if no module could rip it
+bool rip_input(Ripper::RipModules& mods, const std::string& filename,
+	const std::string& fprefix, const RipperFormats::RipperSettings& ripset,
+	int bufsize, RipUtil::OutputSink& output, RipperFormats::RipResults& results);
+
+#ifndef _WIN32
+
+// rip filename in a forked worker process using threads encoder threads,
+// within membudget bytes (see MemoryBudget.h); returns its pid, with fd
+// set to the pipe its totals come back through; the worker closes
+// closefds, descriptors of the parent's it has no use for
+int start_worker(Ripper::RipModules& mods, const std::string& filename,
+	const std::string& fprefix, const RipperFormats::RipperSettings& ripset,
+	int threads, long long membudget, int& fd,
+	const std::vector<int>& closefds = std::vector<int>());
+
+// read the totals sent by a worker, once it's done, and add them to totals;
+// false if it ended without sending any
+bool finish_worker(int fd, RipTotals& totals);
+
+#endif
+
+// rip every input, each into its own prefix and with modules of its
+// own, ripset.jobs at a time
+void rip_batch(Ripper::RipModules& mods, const std::vector<std::string>& inputs,
+	const std::vector<std::string>& prefixes, const RipperFormats::RipperSettings& ripset,
+	RipTotals& totals);
+
+
+
+#pragma once
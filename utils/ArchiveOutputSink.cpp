@@ -0,0 +1,367 @@
+#include "ArchiveOutputSink.h"
+#include "Checksums.h"
+#include "DefaultException.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <ctime>
+
+namespace RipUtil
+{
+
+
+// store the low n bytes of val little-endian (zip byte order)
+static char* put_le(char* out, long long val, int n)
+{
+	for (int i = 0; i < n; i++)
+		out[i] = (char)((val >> (8 * i)) & 0xFF);
+	return out;
+}
+
+// store val as a NUL-terminated, zero-padded octal field (tar number format)
+static void put_octal(char* out, long long val, int n)
+{
+	out[n - 1] = 0;
+	for (int i = n - 2; i >= 0; i--)
+	{
+		out[i] = '0' + (char)(val & 7);
+		val >>= 3;
+	}
+}
+
+
+ArchiveOutputSink::ArchiveOutputSink(const std::string& filename)
+	: archivename(filename), numentries(0), archivesize(0),
+	entryopen(false), mtime(std::time(0)), finished(false)
+{
+	ofs.open(filename.c_str(), std::ios_base::binary | std::ios_base::trunc);
+	if (!ofs) throw(DefaultException("error writing to file " + filename));
+}
+
+void ArchiveOutputSink::flush()
+{
+	if (finished)
+		return;
+	finish_archive();
+	ofs.close();
+	finished = true;
+	if (!ofs) throw(DefaultException("error writing to file " + archivename));
+}
+
+void ArchiveOutputSink::write_archive(const char* data, int n)
+{
+	ofs.write(data, n);
+	archivesize += n;
+}
+
+void ArchiveOutputSink::write_archive_zeroes(int n)
+{
+	static const char zeroes[ArchiveConsts::tar_block_size] = { 0 };
+	while (n > 0)
+	{
+		int chunk = std::min(n, ArchiveConsts::tar_block_size);
+		write_archive(zeroes, chunk);
+		n -= chunk;
+	}
+}
+
+std::string ArchiveOutputSink::get_entry_name(const std::string& filename)
+{
+	std::string name = filename;
+	std::replace(name.begin(), name.end(), '\\', '/');
+
+	// drop drive letters, leading slashes and ./ or ../ components
+	if (name.length() >= 2 && name[1] == ':')
+		name = name.substr(2);
+	std::string::size_type start = 0;
+	while (start < name.length())
+	{
+		if (name[start] == '/')
+			++start;
+		else if (name.compare(start, 2, "./") == 0)
+			start += 2;
+		else if (name.compare(start, 3, "../") == 0)
+			start += 3;
+		else
+			break;
+	}
+	name = name.substr(start);
+
+	// collapse inner ./ components
+	std::string::size_type pos;
+	while ((pos = name.find("/./")) != std::string::npos)
+		name.erase(pos, 2);
+	return name;
+}
+
+
+// tar
+
+void TarOutputSink::write_header(const std::string& name, long long size, char type)
+{
+	// names that don't fit the header go in a preceding GNU longname entry
+	if ((int)name.length() > ArchiveConsts::tar_name_size)
+	{
+		write_header(ArchiveConsts::tar_longname_entry, name.length() + 1, 'L');
+		write_archive(name.c_str(), name.length() + 1);
+		write_archive_zeroes((ArchiveConsts::tar_block_size
+			- (name.length() + 1) % ArchiveConsts::tar_block_size)
+			% ArchiveConsts::tar_block_size);
+	}
+
+	char header[ArchiveConsts::tar_block_size];
+	std::memset(header, 0, ArchiveConsts::tar_block_size);
+	std::memcpy(header, name.c_str(),
+		std::min((int)name.length(), ArchiveConsts::tar_name_size));
+	put_octal(header + 100, 0644, 8);		// mode
+	put_octal(header + 108, 0, 8);			// uid
+	put_octal(header + 116, 0, 8);			// gid
+	put_octal(header + 124, size, 12);		// size
+	put_octal(header + 136, mtime, 12);		// mtime
+	header[156] = type;
+	std::memcpy(header + 257, "ustar", 6);	// magic
+	std::memcpy(header + 263, "00", 2);		// version
+
+	// checksum is computed with its own field set to spaces
+	std::memset(header + 148, ' ', 8);
+	int checksum = 0;
+	for (int i = 0; i < ArchiveConsts::tar_block_size; i++)
+		checksum += (unsigned char)header[i];
+	put_octal(header + 148, checksum, 7);
+
+	write_archive(header, ArchiveConsts::tar_block_size);
+}
+
+void TarOutputSink::open_file(const std::string& filename, long long size)
+{
+	// a writer may have thrown before closing its last file
+	if (entryopen)
+		end_entry();
+
+	entryname = get_entry_name(filename);
+	entrysize = size;
+	entrywritten = 0;
+	buffered = (size == OutputSinkConsts::unknown_size);
+	if (buffered)
+		buffer.clear();
+	else
+		write_header(entryname, entrysize, '0');
+	entryopen = true;
+}
+
+void TarOutputSink::write_bytes(const char* data, int n)
+{
+	if (buffered)
+		buffer.insert(buffer.end(), data, data + n);
+	else
+	{
+		if (entrywritten + n > entrysize)
+			throw(DefaultException("output file " + entryname
+				+ " is larger than its announced size"));
+		write_archive(data, n);
+	}
+	entrywritten += n;
+}
+
+void TarOutputSink::close_file()
+{
+	bool complete = (buffered || entrywritten == entrysize);
+	end_entry();
+	if (!complete)
+		throw(DefaultException("output file " + entryname
+			+ " is smaller than its announced size"));
+}
+
+void TarOutputSink::end_entry()
+{
+	if (buffered)
+	{
+		entrysize = buffer.size();
+		write_header(entryname, entrysize, '0');
+		if (!buffer.empty())
+			write_archive(&buffer.front(), buffer.size());
+		buffer.clear();
+	}
+	// pad a truncated entry out to the size given in its header
+	else if (entrywritten < entrysize)
+		write_archive_zeroes(entrysize - entrywritten);
+
+	write_archive_zeroes((ArchiveConsts::tar_block_size
+		- entrysize % ArchiveConsts::tar_block_size)
+		% ArchiveConsts::tar_block_size);
+	++numentries;
+	entryopen = false;
+}
+
+void TarOutputSink::finish_archive()
+{
+	if (entryopen)
+		end_entry();
+	// end of archive: two zero blocks
+	write_archive_zeroes(ArchiveConsts::tar_block_size * 2);
+}
+
+
+// zip
+
+ZipOutputSink::ZipOutputSink(const std::string& filename)
+	: ArchiveOutputSink(filename)
+{
+	std::time_t t = mtime;
+	std::tm* tm = std::localtime(&t);
+	dostime = (tm->tm_hour << 11) | (tm->tm_min << 5) | (tm->tm_sec / 2);
+	dosdate = ((std::max(tm->tm_year - 80, 0)) << 9)
+		| ((tm->tm_mon + 1) << 5) | tm->tm_mday;
+}
+
+void ZipOutputSink::open_file(const std::string& filename, long long size)
+{
+	// a writer may have thrown before closing its last file
+	if (entryopen)
+		end_entry();
+
+	current = ZipEntry();
+	current.name = get_entry_name(filename);
+	current.offset = archivesize;
+
+	// crc and sizes are left 0 here and given in the data descriptor
+	char header[ArchiveConsts::zip_local_header_size];
+	std::memset(header, 0, ArchiveConsts::zip_local_header_size);
+	put_le(header, ArchiveConsts::zip_local_header_sig, 4);
+	put_le(header + 4, ArchiveConsts::zip_version, 2);
+	put_le(header + 6, ArchiveConsts::zip_flag_data_descriptor, 2);
+	put_le(header + 8, 0, 2);				// method: stored
+	put_le(header + 10, dostime, 2);
+	put_le(header + 12, dosdate, 2);
+	put_le(header + 26, current.name.length(), 2);
+	write_archive(header, ArchiveConsts::zip_local_header_size);
+	write_archive(current.name.c_str(), current.name.length());
+	entryopen = true;
+}
+
+void ZipOutputSink::write_bytes(const char* data, int n)
+{
+	current.crc = crc32(current.crc, data, n);
+	current.size += n;
+	write_archive(data, n);
+}
+
+void ZipOutputSink::close_file()
+{
+	end_entry();
+}
+
+void ZipOutputSink::end_entry()
+{
+	char descriptor[ArchiveConsts::zip_data_descriptor_size];
+	put_le(descriptor, ArchiveConsts::zip_data_descriptor_sig, 4);
+	put_le(descriptor + 4, current.crc, 4);
+	put_le(descriptor + 8, current.size, 4);	// compressed size
+	put_le(descriptor + 12, current.size, 4);	// uncompressed size
+	write_archive(descriptor, ArchiveConsts::zip_data_descriptor_size);
+
+	entries.push_back(current);
+	++numentries;
+	entryopen = false;
+}
+
+void ZipOutputSink::finish_archive()
+{
+	if (entryopen)
+		end_entry();
+
+	// central directory
+	long long cdstart = archivesize;
+	for (std::vector<ZipEntry>::const_iterator it = entries.begin();
+		it != entries.end(); ++it)
+	{
+		// entries past 4 GB record their offset in a zip64 extra field
+		bool zip64 = (it->offset >= ArchiveConsts::zip_max_offset);
+
+		char header[ArchiveConsts::zip_central_header_size];
+		std::memset(header, 0, ArchiveConsts::zip_central_header_size);
+		put_le(header, ArchiveConsts::zip_central_header_sig, 4);
+		put_le(header + 4, zip64 ? ArchiveConsts::zip64_version
+			: ArchiveConsts::zip_version, 2);		// version made by
+		put_le(header + 6, zip64 ? ArchiveConsts::zip64_version
+			: ArchiveConsts::zip_version, 2);		// version needed
+		put_le(header + 8, ArchiveConsts::zip_flag_data_descriptor, 2);
+		put_le(header + 10, 0, 2);				// method: stored
+		put_le(header + 12, dostime, 2);
+		put_le(header + 14, dosdate, 2);
+		put_le(header + 16, it->crc, 4);
+		put_le(header + 20, it->size, 4);
+		put_le(header + 24, it->size, 4);
+		put_le(header + 28, it->name.length(), 2);
+		put_le(header + 30, zip64 ? 12 : 0, 2);	// extra field length
+		put_le(header + 42, zip64 ? ArchiveConsts::zip_max_offset : it->offset, 4);
+		write_archive(header, ArchiveConsts::zip_central_header_size);
+		write_archive(it->name.c_str(), it->name.length());
+
+		if (zip64)
+		{
+			char extra[12];
+			put_le(extra, ArchiveConsts::zip64_extra_id, 2);
+			put_le(extra + 2, 8, 2);
+			put_le(extra + 4, it->offset, 8);
+			write_archive(extra, 12);
+		}
+	}
+	long long cdsize = archivesize - cdstart;
+
+	// counts or offsets too large for the end record go in zip64 records
+	if (entries.size() >= ArchiveConsts::zip_max_entries
+		|| cdstart >= ArchiveConsts::zip_max_offset
+		|| cdsize >= ArchiveConsts::zip_max_offset)
+	{
+		long long zip64start = archivesize;
+
+		char end64[ArchiveConsts::zip64_end_size];
+		std::memset(end64, 0, ArchiveConsts::zip64_end_size);
+		put_le(end64, ArchiveConsts::zip64_end_sig, 4);
+		put_le(end64 + 4, ArchiveConsts::zip64_end_size - 12, 8);
+		put_le(end64 + 12, ArchiveConsts::zip64_version, 2);
+		put_le(end64 + 14, ArchiveConsts::zip64_version, 2);
+		put_le(end64 + 24, entries.size(), 8);
+		put_le(end64 + 32, entries.size(), 8);
+		put_le(end64 + 40, cdsize, 8);
+		put_le(end64 + 48, cdstart, 8);
+		write_archive(end64, ArchiveConsts::zip64_end_size);
+
+		char locator[ArchiveConsts::zip64_end_locator_size];
+		std::memset(locator, 0, ArchiveConsts::zip64_end_locator_size);
+		put_le(locator, ArchiveConsts::zip64_end_locator_sig, 4);
+		put_le(locator + 8, zip64start, 8);
+		put_le(locator + 16, 1, 4);				// total number of disks
+		write_archive(locator, ArchiveConsts::zip64_end_locator_size);
+	}
+
+	char end[ArchiveConsts::zip_end_size];
+	std::memset(end, 0, ArchiveConsts::zip_end_size);
+	put_le(end, ArchiveConsts::zip_end_sig, 4);
+	put_le(end + 8, std::min((long long)entries.size(), ArchiveConsts::zip_max_entries), 2);
+	put_le(end + 10, std::min((long long)entries.size(), ArchiveConsts::zip_max_entries), 2);
+	put_le(end + 12, std::min(cdsize, ArchiveConsts::zip_max_offset), 4);
+	put_le(end + 16, std::min(cdstart, ArchiveConsts::zip_max_offset), 4);
+	write_archive(end, ArchiveConsts::zip_end_size);
+}
+
+
+ArchiveOutputSink* create_archive_sink(const std::string& filename)
+{
+	std::string ext;
+	std::string::size_type dot = filename.find_last_of('.');
+	if (dot != std::string::npos)
+		ext = filename.substr(dot + 1);
+	std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+
+	if (ext == "tar")
+		return new TarOutputSink(filename);
+	else if (ext == "zip")
+		return new ZipOutputSink(filename);
+	throw(DefaultException("unknown archive type for " + filename
+		+ " (expected .tar or .zip)"));
+}
+
+
+};	// end namespace RipUtil
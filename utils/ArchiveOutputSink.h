@@ -0,0 +1,159 @@
+/* Output sinks that pack every output file of a run into a single
+   archive, written front to back in one sequential pass:
+   a ustar tar, or a store-only (uncompressed) zip whose central
+   directory indexes all entries at the end of the archive */
+
+#include "OutputSink.h"
+#include <string>
+#include <vector>
+#include <fstream>
+
+namespace RipUtil
+{
+
+
+namespace ArchiveConsts
+{
+	// tar
+	const static int tar_block_size = 512;
+	const static int tar_name_size = 100;
+	// name of the GNU pseudo-entry holding a name too long for the header
+	const static char tar_longname_entry[] = "././@LongLink";
+
+	// zip record signatures
+	const static int zip_local_header_sig = 0x04034B50;
+	const static int zip_data_descriptor_sig = 0x08074B50;
+	const static int zip_central_header_sig = 0x02014B50;
+	const static int zip_end_sig = 0x06054B50;
+	const static int zip64_end_sig = 0x06064B50;
+	const static int zip64_end_locator_sig = 0x07064B50;
+	// zip record sizes (excluding variable-length fields)
+	const static int zip_local_header_size = 30;
+	const static int zip_data_descriptor_size = 16;
+	const static int zip_central_header_size = 46;
+	const static int zip_end_size = 22;
+	const static int zip64_end_size = 56;
+	const static int zip64_end_locator_size = 20;
+	// version needed to extract: 2.0 (data descriptors), 4.5 (zip64)
+	const static int zip_version = 20;
+	const static int zip64_version = 45;
+	// general purpose flag: crc and sizes follow the data
+	const static int zip_flag_data_descriptor = 0x0008;
+	// zip64 extended information extra field id
+	const static int zip64_extra_id = 0x0001;
+	// largest value that fits the 16- and 32-bit zip fields
+	const static long long zip_max_entries = 0xFFFF;
+	const static long long zip_max_offset = 0xFFFFFFFFLL;
+};
+
+// common base: owns the archive file and maps output filenames
+// to entry names
+class ArchiveOutputSink : public OutputSink
+{
+public:
+	ArchiveOutputSink(const std::string& filename);
+
+	// write the archive index/trailer and close the archive
+	void flush();
+
+	// number of entries and total bytes written to the archive so far
+	int get_num_entries() const { return numentries; }
+	long long get_archive_size() const { return archivesize; }
+
+protected:
+	// write the archive trailer; called once by flush()
+	virtual void finish_archive() = 0;
+
+	// append raw bytes to the archive
+	void write_archive(const char* data, int n);
+	// append n zero bytes to the archive
+	void write_archive_zeroes(int n);
+
+	// relative, '/'-separated entry name for an output filename
+	static std::string get_entry_name(const std::string& filename);
+
+	std::string archivename;
+	int numentries;
+	long long archivesize;
+	// an entry has been opened but not yet closed
+	bool entryopen;
+	// time the run began, used as the modification time of all entries
+	long long mtime;
+
+private:
+	std::ofstream ofs;
+	bool finished;
+};
+
+// streaming ustar archive
+// files whose size is announced at open() are streamed straight through;
+// others are buffered until close(), since the header needs the size
+class TarOutputSink : public ArchiveOutputSink
+{
+public:
+	TarOutputSink(const std::string& filename)
+		: ArchiveOutputSink(filename), entrysize(0), entrywritten(0),
+		buffered(false) { };
+
+protected:
+	void open_file(const std::string& filename, long long size);
+	void write_bytes(const char* data, int n);
+	void close_file();
+	void finish_archive();
+
+private:
+	void write_header(const std::string& name, long long size, char type);
+	// pad and finish the open entry
+	void end_entry();
+
+	std::string entryname;
+	long long entrysize;
+	long long entrywritten;
+	bool buffered;
+	std::vector<char> buffer;
+};
+
+// streaming store-only zip archive
+// crc and sizes go in a data descriptor after each entry, so nothing
+// is buffered; the central directory is written by flush()
+class ZipOutputSink : public ArchiveOutputSink
+{
+public:
+	ZipOutputSink(const std::string& filename);
+
+protected:
+	void open_file(const std::string& filename, long long size);
+	void write_bytes(const char* data, int n);
+	void close_file();
+	void finish_archive();
+
+private:
+	// write the data descriptor of the open entry and record it
+	void end_entry();
+
+	// central directory record for one entry
+	struct ZipEntry
+	{
+		ZipEntry()
+			: crc(0), size(0), offset(0) { };
+
+		std::string name;
+		unsigned int crc;
+		long long size;
+		long long offset;
+	};
+
+	std::vector<ZipEntry> entries;
+	ZipEntry current;
+	int dostime;
+	int dosdate;
+};
+
+// create a tar or zip sink according to the extension of filename
+// (.tar or .zip); throws if the extension is not recognized
+ArchiveOutputSink* create_archive_sink(const std::string& filename);
+
+
+};	// end namespace RipUtil
+
+#pragma once
@@ -2,9 +2,14 @@
 
 #include "DatManip.h"
 #include "DefaultException.h"
+#include "Checksums.h"
+#include "Deflate.h"
+#include "OutputStats.h"
 #include <cstring>
-#include <fstream>
 #include <cmath>
+#include <cstdlib>
+#include <algorithm>
+#include <vector>
 
 namespace RipUtil
 {
@@ -286,37 +291,85 @@ void BitmapData::blit_bitmapdata(BitmapData& bmpdat, int xpos, int ypos,
 	}
 }
 
-void write_bmp_header(std::ofstream& ofs, const BMPHeader& bmphd)
+void write_bmp_header(OutputSink& sink, const BMPHeader& bmphd)
 {
 	// file header
-	ofs.write(bmphd.bmp_filehd_type, 2);
-	ofs.write(bmphd.bmp_filehd_size, 4);
-	ofs.write(bmphd.bmp_filehd_reserved1, 2);
-	ofs.write(bmphd.bmp_filehd_reserved2, 2);
-	ofs.write(bmphd.bmp_filehd_offbits, 4);
+	sink.write(bmphd.bmp_filehd_type, 2);
+	sink.write(bmphd.bmp_filehd_size, 4);
+	sink.write(bmphd.bmp_filehd_reserved1, 2);
+	sink.write(bmphd.bmp_filehd_reserved2, 2);
+	sink.write(bmphd.bmp_filehd_offbits, 4);
 
 	// info header
-	ofs.write(bmphd.bmp_infohd_size, 4);
-	ofs.write(bmphd.bmp_infohd_width, 4);
-	ofs.write(bmphd.bmp_infohd_height, 4);
-	ofs.write(bmphd.bmp_infohd_planes, 2);
-	ofs.write(bmphd.bmp_infohd_bitcount, 2);
-	ofs.write(bmphd.bmp_infohd_compression, 4);
-	ofs.write(bmphd.bmp_infohd_sizeimage, 4);
-	ofs.write(bmphd.bmp_infohd_xpelsm, 4);
-	ofs.write(bmphd.bmp_infohd_ypelsm, 4);
-	ofs.write(bmphd.bmp_infohd_clrused, 4);
-	ofs.write(bmphd.bmp_infohd_clrimp, 4);
+	sink.write(bmphd.bmp_infohd_size, 4);
+	sink.write(bmphd.bmp_infohd_width, 4);
+	sink.write(bmphd.bmp_infohd_height, 4);
+	sink.write(bmphd.bmp_infohd_planes, 2);
+	sink.write(bmphd.bmp_infohd_bitcount, 2);
+	sink.write(bmphd.bmp_infohd_compression, 4);
+	sink.write(bmphd.bmp_infohd_sizeimage, 4);
+	sink.write(bmphd.bmp_infohd_xpelsm, 4);
+	sink.write(bmphd.bmp_infohd_ypelsm, 4);
+	sink.write(bmphd.bmp_infohd_clrused, 4);
+	sink.write(bmphd.bmp_infohd_clrimp, 4);
 }
 
-void write_bitmapdata_bmp(BitmapData& bmpdat, const std::string& filename)
+// convert a pixel to a 24-bit color (red in the low byte)
+static int bitmapdata_pixel_color(BitmapData& bmpdat, unsigned int pixel)
 {
+	int r = 0;
+	int g = 0;
+	int b = 0;
+	if (bmpdat.get_palettized())
+	{
+		unsigned int color = bmpdat.get_palette()[pixel];
+		r = (color & 0xFF);
+		g = (color & 0xFF00) >> 8;
+		b = (color & 0xFF0000) >> 16;
+	}
+	else
+	{
+		unsigned int color = pixel;
+		switch(bmpdat.get_bpp())
+		{
+		case 8:
+			r = color & 3;
+			g = color & (3 << 2);
+			b = color & (3 << 4);
+			break;
+		case 16:
+			r = (color & 0xF);
+			g = (color & 0xF0) >> 4;
+			b = (color & 0xF00) >> 8;
+			break;
+		case 24: case 32:
+			r = (color & 0xFF);
+			g = (color & 0xFF00) >> 8;
+			b = (color & 0xFF0000) >> 16;
+			break;
+		default:
+			throw(DefaultException("tried to save image with invalid bpp"));
+		}
+	}
+	return r | (g << 8) | (b << 16);
+}
+
+void write_bitmapdata_bmp(OutputSink& sink, BitmapData& bmpdat, const std::string& filename)
+{
+	if (sink.wants_decoded())
+	{
+		sink.take_bitmap(filename, bmpdat);
+		return;
+	}
+
 	BMPHeader bmphd;
 	
 	int infohd_size = 40;
 	int offbits = 14 + infohd_size;
 	int bitcount = 24;
-	int sizeimage = bmpdat.get_width() * bmpdat.get_height();
+	// rows are padded to a 4-byte boundary
+	int rowbytes = (bmpdat.get_width() * 3 + 3) & ~3;
+	int sizeimage = rowbytes * bmpdat.get_height();
 	int fsize = offbits + sizeimage;
 	int xpels = 0;
 	int ypels = 0;
@@ -332,76 +385,46 @@ void write_bitmapdata_bmp(BitmapData& bmpdat, const std::string& filename)
 	to_bytes(ypels, bmphd.bmp_infohd_ypelsm, 4, DatManip::le);
 
 	// file header
-	std::ofstream ofs(filename.c_str(), std::ios_base::binary);
-	write_bmp_header(ofs, bmphd);
+	sink.open(filename, fsize);
+	write_bmp_header(sink, bmphd);
 
-	// pixel data
+	// pixel data, bottom row first, filled in place
+	char* out = sink.reserve_write(sizeimage);
 	for (int i = bmpdat.get_height() - 1; i >= 0; i--)
 	{
 		int* rowstart = bmpdat.get_pixels() + i * bmpdat.get_width();
+		char* outrow = out + (bmpdat.get_height() - 1 - i) * rowbytes;
 		for (int j = 0; j < bmpdat.get_width(); j++)
 		{
-			int r = 0;
-			int g = 0;
-			int b = 0;
-			int output = 0;
-			if (bmpdat.get_palettized())
-			{
-				unsigned int palettecolor = *(rowstart + j);
-				unsigned int color = bmpdat.get_palette()[palettecolor];
-				r = (color & 0xFF);
-				g = (color & 0xFF00) >> 8;
-				b = (color & 0xFF0000) >> 16;
-			}
-			else
-			{
-				unsigned int color = *(rowstart + j);
-				switch(bmpdat.get_bpp())
-				{
-				case 8:
-					r = color & 3;
-					g = color & (3 << 2);
-					b = color & (3 << 4);
-					break;
-				case 16:
-					r = (color & 0xF);
-					g = (color & 0xF0) >> 4;
-					b = (color & 0xF00) >> 8;
-					break;
-				case 24: case 32:
-					r = (color & 0xFF);
-					g = (color & 0xFF00) >> 8;
-					b = (color & 0xFF0000) >> 16;
-					break;
-				default:
-					throw(DefaultException("tried to save image with invalid bpp"));
-				}
-			}
-			output |= r;
-			output |= (g << 8);
-			output |= (b << 16);
-			char outbytes[3];
-			to_bytes(output, outbytes, 3);
-			ofs.write(outbytes, 3);
+			int output = bitmapdata_pixel_color(bmpdat, *(rowstart + j));
+			to_bytes(output, outrow + j * 3, 3);
 		}
 		// pad line to 4-byte boundary
-		int padbytes = bmpdat.get_width() % 4;
-		for (int j = 0; j < padbytes; j++)
-		{
-			ofs.put(0);
-		}
+		std::memset(outrow + bmpdat.get_width() * 3, 0,
+			rowbytes - bmpdat.get_width() * 3);
 	}
+	sink.commit_write();
+	count_output_bytes("bmp", sink.get_file_size());
+	sink.close();
 }
 
-void write_bitmapdata_8bitpalettized_bmp(BitmapData& bmpdat, const std::string& filename)
+void write_bitmapdata_8bitpalettized_bmp(OutputSink& sink, BitmapData& bmpdat, const std::string& filename)
 {
+	if (sink.wants_decoded())
+	{
+		sink.take_bitmap(filename, bmpdat);
+		return;
+	}
+
 	BMPHeader bmphd;
 	char colortable[1024];
 	
 	int infohd_size = 40;
 	int offbits = 14 + infohd_size + 1024;
 	int bitcount = 8;
-	int sizeimage = bmpdat.get_width() * bmpdat.get_height();
+	// rows are padded to a 4-byte boundary
+	int rowbytes = (bmpdat.get_width() + 3) & ~3;
+	int sizeimage = rowbytes * bmpdat.get_height();
 	int fsize = offbits + sizeimage;
 	int xpels = 0;
 	int ypels = 0;
@@ -430,37 +453,242 @@ void write_bitmapdata_8bitpalettized_bmp(BitmapData& bmpdat, const std::string&
 	to_bytes(clrused, bmphd.bmp_infohd_clrused, 4, DatManip::le);
 	to_bytes(clrimp, bmphd.bmp_infohd_clrimp, 4, DatManip::le);
 
-	std::ofstream ofs(filename.c_str(), std::ios_base::binary);
+	sink.open(filename, fsize);
 
-	write_bmp_header(ofs, bmphd);
-	ofs.write(colortable, BMPWriterConsts::max_8bit_colors * 4);
+	write_bmp_header(sink, bmphd);
+	sink.write(colortable, BMPWriterConsts::max_8bit_colors * 4);
 
-	// pixel data
+	// pixel data, bottom row first, filled in place
+	char* out = sink.reserve_write(sizeimage);
 	for (int i = bmpdat.get_height() - 1; i >= 0; i--)
 	{
 		int* rowstart = bmpdat.get_pixels() + i * bmpdat.get_width();
+		char* outrow = out + (bmpdat.get_height() - 1 - i) * rowbytes;
 		for (int j = 0; j < bmpdat.get_width(); j++)
+			outrow[j] = *(rowstart + j);
+		// pad line to 4-byte boundary
+		std::memset(outrow + bmpdat.get_width(), 0, rowbytes - bmpdat.get_width());
+	}
+	sink.commit_write();
+	count_output_bytes("bmp", sink.get_file_size());
+	sink.close();
+}
+
+// write a PNG chunk with its length and CRC
+static void write_png_chunk(OutputSink& sink, const char* id, const char* data, int len)
+{
+	char bytes[4];
+	to_bytes(len, bytes, 4, DatManip::be);
+	sink.write(bytes, 4);
+	sink.write(id, 4);
+	if (len)
+		sink.write(data, len);
+	unsigned int crc = crc32(0, id, 4);
+	crc = crc32(crc, data, len);
+	to_bytes(crc, bytes, 4, DatManip::be);
+	sink.write(bytes, 4);
+}
+
+// write the PNG signature and IHDR chunk (8 bits per sample)
+static void write_png_header(OutputSink& sink, int width, int height, int colortype)
+{
+	sink.write(PNGWriterConsts::png_signature, 8);
+	char ihdr[13];
+	to_bytes(width, ihdr, 4, DatManip::be);
+	to_bytes(height, ihdr + 4, 4, DatManip::be);
+	ihdr[8] = 8;			// bit depth
+	ihdr[9] = colortype;
+	ihdr[10] = 0;			// compression: deflate
+	ihdr[11] = 0;			// filter method: adaptive
+	ihdr[12] = 0;			// no interlace
+	write_png_chunk(sink, PNGWriterConsts::png_ihdr_id, ihdr, 13);
+}
+
+// compress filtered scanlines and write them with the closing chunks
+static void write_png_image_data(OutputSink& sink, const std::vector<char>& scanlines,
+	int linebytes)
+{
+	// bands of whole scanlines, so output does not depend on thread count
+	int bandlines = std::max(1, PNGWriterConsts::band_bytes / linebytes);
+	std::vector<char> idat;
+	zlib_compress(&scanlines[0], scanlines.size(), idat, bandlines * linebytes);
+	write_png_chunk(sink, PNGWriterConsts::png_idat_id, &idat[0], idat.size());
+	write_png_chunk(sink, PNGWriterConsts::png_iend_id, 0, 0);
+}
+
+static int paeth_predictor(int a, int b, int c)
+{
+	int p = a + b - c;
+	int pa = std::abs(p - a);
+	int pb = std::abs(p - b);
+	int pc = std::abs(p - c);
+	if (pa <= pb && pa <= pc)
+		return a;
+	else if (pb <= pc)
+		return b;
+	return c;
+}
+
+// filter a scanline of rowbytes bytes with whichever of the five PNG
+// filters gives the smallest sum of absolute differences
+// (prev is 0 for the first line)
+static void png_filter_line(const unsigned char* line, const unsigned char* prev,
+	int rowbytes, int bytespp, char* out)
+{
+	std::vector<char> trial(rowbytes);
+	long long bestsum = -1;
+	for (int filter = 0; filter < 5; filter++)
+	{
+		long long sum = 0;
+		for (int i = 0; i < rowbytes; i++)
+		{
+			int a = (i >= bytespp) ? line[i - bytespp] : 0;
+			int b = prev ? prev[i] : 0;
+			int c = (prev && i >= bytespp) ? prev[i - bytespp] : 0;
+			int pred = 0;
+			switch (filter)
+			{
+			case 1: pred = a; break;
+			case 2: pred = b; break;
+			case 3: pred = (a + b) / 2; break;
+			case 4: pred = paeth_predictor(a, b, c); break;
+			}
+			trial[i] = static_cast<char>(line[i] - pred);
+			sum += std::abs(static_cast<int>(static_cast<signed char>(trial[i])));
+		}
+		if (bestsum < 0 || sum < bestsum)
 		{
-			
-			char color = *(rowstart + j);
-			ofs.put(color);
+			bestsum = sum;
+			out[0] = filter;
+			if (rowbytes)
+				std::memcpy(out + 1, &trial[0], rowbytes);
 		}
-		// pad line to 4-byte boundary
-		int padbytes = bmpdat.get_width() % 4;
-		if (padbytes != 0)
-			for (int j = 0; j < 4 - padbytes; j++)
-				ofs.put(0);
 	}
 }
 
-void BitmapData::write(const std::string& filename) {
+void write_bitmapdata_png(OutputSink& sink, BitmapData& bmpdat, const std::string& filename)
+{
+	if (sink.wants_decoded())
+	{
+		sink.take_bitmap(filename, bmpdat);
+		return;
+	}
+
+	int width = bmpdat.get_width();
+	int height = bmpdat.get_height();
+	int rowbytes = width * 3;
+	int linebytes = rowbytes + 1;
+
+	std::vector<unsigned char> rgb(rowbytes * 2);
+	std::vector<char> scanlines(linebytes * height);
+	unsigned char* line = &rgb[0];
+	unsigned char* prev = &rgb[rowbytes];
+	for (int i = 0; i < height; i++)
+	{
+		int* rowstart = bmpdat.get_pixels() + i * width;
+		for (int j = 0; j < width; j++)
+		{
+			int color = bitmapdata_pixel_color(bmpdat, *(rowstart + j));
+			line[j * 3] = color & 0xFF;
+			line[j * 3 + 1] = (color & 0xFF00) >> 8;
+			line[j * 3 + 2] = (color & 0xFF0000) >> 16;
+		}
+		png_filter_line(line, i ? prev : 0, rowbytes, 3, &scanlines[i * linebytes]);
+		std::swap(line, prev);
+	}
+
+	sink.open(filename);
+	write_png_header(sink, width, height, PNGWriterConsts::png_color_rgb);
+	write_png_image_data(sink, scanlines, linebytes);
+	count_output_bytes("png", sink.get_file_size());
+	sink.close();
+}
+
+void write_bitmapdata_8bitpalettized_png(OutputSink& sink, BitmapData& bmpdat, const std::string& filename)
+{
+	if (sink.wants_decoded())
+	{
+		sink.take_bitmap(filename, bmpdat);
+		return;
+	}
+
+	int width = bmpdat.get_width();
+	int height = bmpdat.get_height();
+	int linebytes = width + 1;
+
+	// indexed images compress best unfiltered
+	std::vector<char> scanlines(linebytes * height);
+	int maxindex = 0;
+	for (int i = 0; i < height; i++)
+	{
+		int* rowstart = bmpdat.get_pixels() + i * width;
+		char* out = &scanlines[i * linebytes];
+		out[0] = 0;
+		for (int j = 0; j < width; j++)
+		{
+			int index = *(rowstart + j) & 0xFF;
+			out[j + 1] = index;
+			maxindex = std::max(maxindex, index);
+		}
+	}
+
+	// palette only needs to cover the indices actually used
+	char plte[BMPWriterConsts::max_8bit_colors * 3];
+	BitmapPalette& palette = bmpdat.get_palette();
+	for (int i = 0; i <= maxindex; i++)
+	{
+		BitmapPalette::const_iterator it = palette.find(i);
+		int color = (it == palette.end()) ? 0 : it->second;
+		plte[i * 3] = color & 0xFF;
+		plte[i * 3 + 1] = (color & 0xFF00) >> 8;
+		plte[i * 3 + 2] = (color & 0xFF0000) >> 16;
+	}
+
+	sink.open(filename);
+	write_png_header(sink, width, height, PNGWriterConsts::png_color_indexed);
+	write_png_chunk(sink, PNGWriterConsts::png_plte_id, plte, (maxindex + 1) * 3);
+	write_png_image_data(sink, scanlines, linebytes);
+	count_output_bytes("png", sink.get_file_size());
+	sink.close();
+}
+
+void write_bitmapdata(OutputSink& sink, BitmapData& bmpdat, const std::string& filename,
+	BitmapData::ImageFormat format)
+{
+	// PNG can't represent an empty image
+	if (format == BitmapData::pngformat
+		&& bmpdat.get_width() > 0 && bmpdat.get_height() > 0)
+		write_bitmapdata_png(sink, bmpdat, filename + ".png");
+	else
+		write_bitmapdata_bmp(sink, bmpdat, filename + ".bmp");
+}
+
+void write_bitmapdata_8bitpalettized(OutputSink& sink, BitmapData& bmpdat, const std::string& filename,
+	BitmapData::ImageFormat format)
+{
+	if (format == BitmapData::pngformat
+		&& bmpdat.get_width() > 0 && bmpdat.get_height() > 0)
+		write_bitmapdata_8bitpalettized_png(sink, bmpdat, filename + ".png");
+	else
+		write_bitmapdata_8bitpalettized_bmp(sink, bmpdat, filename + ".bmp");
+}
+
+void BitmapData::write(OutputSink& sink, const std::string& filename) {
 	if (palettized && bpp == 8) {
-		write_bitmapdata_8bitpalettized_bmp(*this, filename);
+		write_bitmapdata_8bitpalettized_bmp(sink, *this, filename);
 	}
 	else {
-		write_bitmapdata_bmp(*this, filename);
+		write_bitmapdata_bmp(sink, *this, filename);
 	}
 }
 
+void BitmapData::write(OutputSink& sink, const std::string& filename, ImageFormat format)
+{
+	if (palettized && bpp == 8)
+		write_bitmapdata_8bitpalettized(sink, *this, filename, format);
+	else
+		write_bitmapdata(sink, *this, filename, format);
+}
+
 
 };	// end namespace RipUtil
@@ -3,6 +3,7 @@
 #include <string>
 #include <map>
 #include <cstring>
+#include "OutputSink.h"
 
 namespace RipUtil
 {
@@ -21,6 +22,13 @@ struct DrawPos
 class BitmapData
 {
 public:
+	// output image file formats
+	enum ImageFormat
+	{
+		bmpformat,
+		pngformat
+	};
+
 	BitmapData()
 		: pixels(0), width(0), height(0), bpp(0),
 		allocation_size(0), palettized(0) { };
@@ -91,7 +99,9 @@ public:
 	void blit_bitmapdata(BitmapData& bmpdat, int xpos, int ypos,
 		int transcolor);
 	
-	void write(const std::string& filename);
+	void write(OutputSink& sink, const std::string& filename);
+	// write in the given format; the extension is appended to filename
+	void write(OutputSink& sink, const std::string& filename, ImageFormat format);
 
 private:
 	int* pixels;
@@ -111,6 +121,26 @@ namespace BMPWriterConsts
 	const static int max_8bit_colors = 256;
 };
 
+namespace PNGWriterConsts
+{
+	const static char png_signature[8]
+	= { (char)0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+	// chunk types
+	const static char png_ihdr_id[4] = { 'I', 'H', 'D', 'R' };
+	const static char png_plte_id[4] = { 'P', 'L', 'T', 'E' };
+	const static char png_idat_id[4] = { 'I', 'D', 'A', 'T' };
+	const static char png_iend_id[4] = { 'I', 'E', 'N', 'D' };
+
+	// IHDR color types
+	const static int png_color_rgb = 2;
+	const static int png_color_indexed = 3;
+
+	// approximate number of image bytes per independently
+	// compressed band
+	const static int band_bytes = 262144;
+};
+
 // this is what we should be using instead of BMPHeader
 struct BMPDataHeader
 {
@@ -179,11 +209,27 @@ struct BMPHeader
 };
 
 
-void write_bmp_header(std::ofstream& ofs, const BMPHeader& bmphd);
+void write_bmp_header(OutputSink& sink, const BMPHeader& bmphd);
+
+void write_bitmapdata_bmp(OutputSink& sink, BitmapData& bmpdat, const std::string& filename);
+
+void write_bitmapdata_8bitpalettized_bmp(OutputSink& sink, BitmapData& bmpdat, const std::string& filename);
+
+// write as a 24-bit RGB PNG
+void write_bitmapdata_png(OutputSink& sink, BitmapData& bmpdat, const std::string& filename);
+
+// write as an 8-bit indexed PNG using the bitmap's palette
+void write_bitmapdata_8bitpalettized_png(OutputSink& sink, BitmapData& bmpdat, const std::string& filename);
 
-void write_bitmapdata_bmp(BitmapData& bmpdat, const std::string& filename);
+// write as 24-bit color in the given format
+// the extension for the format is appended to filename
+void write_bitmapdata(OutputSink& sink, BitmapData& bmpdat, const std::string& filename,
+	BitmapData::ImageFormat format);
 
-void write_bitmapdata_8bitpalettized_bmp(BitmapData& bmpdat, const std::string& filename);
+// write as 8-bit palettized in the given format
+// the extension for the format is appended to filename
+void write_bitmapdata_8bitpalettized(OutputSink& sink, BitmapData& bmpdat, const std::string& filename,
+	BitmapData::ImageFormat format);
 
 
 };	// end namespace RipUtil
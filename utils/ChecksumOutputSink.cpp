@@ -0,0 +1,49 @@
+#include "ChecksumOutputSink.h"
+#include "DefaultException.h"
+#include <cstdio>
+
+namespace RipUtil
+{
+
+
+ChecksumOutputSink::ChecksumOutputSink(const std::string& manifestname)
+	: manifestname(manifestname)
+{
+
+}
+
+void ChecksumOutputSink::open_file(const std::string& filename, long long size)
+{
+	this->filename = filename;
+	hash = XXHash64();
+}
+
+void ChecksumOutputSink::close_file()
+{
+	ManifestEntry& entry = entries[filename];
+	entry.hash = hash.digest();
+	entry.size = get_file_size();
+}
+
+void ChecksumOutputSink::flush()
+{
+	std::FILE* fp = std::fopen(manifestname.c_str(), "wb");
+	if (!fp)
+		throw(DefaultException("could not open manifest " + manifestname));
+
+	for (std::map<std::string, ManifestEntry>::const_iterator it = entries.begin();
+		it != entries.end(); ++it)
+	{
+		std::fprintf(fp, "%016llx %lld %s\n", it->second.hash,
+			it->second.size, it->first.c_str());
+	}
+
+	bool failed = (std::ferror(fp) != 0);
+	if (std::fclose(fp) != 0)
+		failed = true;
+	if (failed)
+		throw(DefaultException("error writing to manifest " + manifestname));
+}
+
+
+};	// end namespace RipUtil
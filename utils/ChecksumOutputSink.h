@@ -0,0 +1,50 @@
+/* Output sink that hashes output files instead of writing them.
+   Each file's bytes are run through XXH64, and flush() writes a
+   manifest with one line per file, sorted by name:
+     <16 hex digit hash> <size> <name>
+   so the output of two builds can be compared by diffing manifests,
+   without writing the output itself anywhere */
+
+#include "OutputSink.h"
+#include "Checksums.h"
+#include <string>
+#include <map>
+
+namespace RipUtil
+{
+
+
+class ChecksumOutputSink : public OutputSink
+{
+public:
+	// the manifest is written to manifestname on flush()
+	ChecksumOutputSink(const std::string& manifestname);
+
+	void flush();
+
+	int get_num_files() const { return entries.size(); }
+
+protected:
+	void open_file(const std::string& filename, long long size);
+	void write_bytes(const char* data, int n) { hash.update(data, n); }
+	void close_file();
+
+private:
+	struct ManifestEntry
+	{
+		unsigned long long hash;
+		long long size;
+	};
+
+	std::string manifestname;
+	// a file written more than once keeps its last contents
+	std::map<std::string, ManifestEntry> entries;
+
+	std::string filename;	// file being hashed
+	XXHash64 hash;
+};
+
+
+};	// end namespace RipUtil
+
+#pragma once
@@ -0,0 +1,221 @@
+#include "Checksums.h"
+#include "DefaultException.h"
+#include "IsoImage.h"
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+namespace RipUtil
+{
+
+
+// CRC-32 lookup table
+struct CRC32Table
+{
+	CRC32Table()
+	{
+		for (unsigned int i = 0; i < 256; i++)
+		{
+			unsigned int c = i;
+			for (int j = 0; j < 8; j++)
+				c = (c & 1) ? (0xEDB88320 ^ (c >> 1)) : (c >> 1);
+			table[i] = c;
+		}
+	}
+
+	unsigned int table[256];
+};
+
+static const CRC32Table crc32_table;
+
+unsigned int crc32(unsigned int crc, const char* s, int n)
+{
+	crc = ~crc;
+	for (int i = 0; i < n; i++)
+		crc = crc32_table.table[(crc ^ static_cast<unsigned char>(s[i])) & 0xFF] ^ (crc >> 8);
+	return ~crc;
+}
+
+unsigned int adler32(unsigned int adler, const char* s, int n)
+{
+	unsigned int a = adler & 0xFFFF;
+	unsigned int b = adler >> 16;
+	while (n > 0)
+	{
+		// largest run that can't overflow before the modulo
+		int run = (n < 5552) ? n : 5552;
+		n -= run;
+		for (int i = 0; i < run; i++)
+		{
+			a += static_cast<unsigned char>(*s++);
+			b += a;
+		}
+		a %= 65521;
+		b %= 65521;
+	}
+	return (b << 16) | a;
+}
+
+// XXH64 primes
+static const unsigned long long xxh_prime1 = 11400714785074694791ULL;
+static const unsigned long long xxh_prime2 = 14029467366897019727ULL;
+static const unsigned long long xxh_prime3 = 1609587929392839161ULL;
+static const unsigned long long xxh_prime4 = 9650029242287828579ULL;
+static const unsigned long long xxh_prime5 = 2870177450012600261ULL;
+
+static inline unsigned long long xxh_rotl(unsigned long long x, int r)
+{
+	return (x << r) | (x >> (64 - r));
+}
+
+static inline unsigned long long xxh_round(unsigned long long acc, unsigned long long input)
+{
+	acc += input * xxh_prime2;
+	acc = xxh_rotl(acc, 31);
+	return acc * xxh_prime1;
+}
+
+static inline unsigned long long xxh_merge(unsigned long long acc, unsigned long long val)
+{
+	acc ^= xxh_round(0, val);
+	return acc * xxh_prime1 + xxh_prime4;
+}
+
+static inline unsigned long long xxh_read64(const unsigned char* p)
+{
+	unsigned long long x = 0;
+	for (int i = 7; i >= 0; i--)
+		x = (x << 8) | p[i];
+	return x;
+}
+
+static inline unsigned long long xxh_read32(const unsigned char* p)
+{
+	return (unsigned long long)p[0] | ((unsigned long long)p[1] << 8)
+		| ((unsigned long long)p[2] << 16) | ((unsigned long long)p[3] << 24);
+}
+
+XXHash64::XXHash64(unsigned long long seed)
+	: total(0), seed(seed), stripelen(0)
+{
+	acc[0] = seed + xxh_prime1 + xxh_prime2;
+	acc[1] = seed + xxh_prime2;
+	acc[2] = seed;
+	acc[3] = seed - xxh_prime1;
+}
+
+void XXHash64::update(const char* s, int n)
+{
+	const unsigned char* p = (const unsigned char*)s;
+	total += n;
+
+	// complete a stripe left over from the last update
+	if (stripelen)
+	{
+		int fill = (n < 32 - stripelen) ? n : 32 - stripelen;
+		for (int i = 0; i < fill; i++)
+			stripe[stripelen + i] = p[i];
+		stripelen += fill;
+		p += fill;
+		n -= fill;
+		if (stripelen < 32)
+			return;
+		for (int i = 0; i < 4; i++)
+			acc[i] = xxh_round(acc[i], xxh_read64(stripe + i * 8));
+		stripelen = 0;
+	}
+
+	while (n >= 32)
+	{
+		for (int i = 0; i < 4; i++)
+			acc[i] = xxh_round(acc[i], xxh_read64(p + i * 8));
+		p += 32;
+		n -= 32;
+	}
+
+	for (int i = 0; i < n; i++)
+		stripe[i] = p[i];
+	stripelen = n;
+}
+
+unsigned long long XXHash64::digest() const
+{
+	unsigned long long h;
+	if (total >= 32)
+	{
+		h = xxh_rotl(acc[0], 1) + xxh_rotl(acc[1], 7)
+			+ xxh_rotl(acc[2], 12) + xxh_rotl(acc[3], 18);
+		for (int i = 0; i < 4; i++)
+			h = xxh_merge(h, acc[i]);
+	}
+	else
+		h = seed + xxh_prime5;
+	h += total;
+
+	// the remaining partial stripe
+	const unsigned char* p = stripe;
+	int n = stripelen;
+	for (; n >= 8; p += 8, n -= 8)
+	{
+		h ^= xxh_round(0, xxh_read64(p));
+		h = xxh_rotl(h, 27) * xxh_prime1 + xxh_prime4;
+	}
+	if (n >= 4)
+	{
+		h ^= xxh_read32(p) * xxh_prime1;
+		h = xxh_rotl(h, 23) * xxh_prime2 + xxh_prime3;
+		p += 4;
+		n -= 4;
+	}
+	for (; n > 0; p++, n--)
+	{
+		h ^= *p * xxh_prime5;
+		h = xxh_rotl(h, 11) * xxh_prime1;
+	}
+
+	// avalanche
+	h ^= h >> 33;
+	h *= xxh_prime2;
+	h ^= h >> 29;
+	h *= xxh_prime3;
+	h ^= h >> 32;
+	return h;
+}
+
+unsigned long long xxhash64_file(const std::string& filename)
+{
+	IsoImage* image;
+	const IsoEntry* entry;
+	if (find_image_file(filename, image, entry))
+	{
+		XXHash64 hash;
+		if (image->in_one_piece(*entry))
+			hash.update(image->get_data(*entry), entry->size);
+		else
+		{
+			std::vector<char> buf(65536);
+			for (int pos = 0; pos < entry->size; pos += buf.size())
+			{
+				int n = std::min((int)buf.size(), entry->size - pos);
+				image->copy_data(*entry, pos, n, &buf.front());
+				hash.update(&buf.front(), n);
+			}
+		}
+		return hash.digest();
+	}
+
+	std::FILE* fp = std::fopen(filename.c_str(), "rb");
+	if (!fp)
+		throw(DefaultException("could not open " + filename));
+
+	XXHash64 hash;
+	std::vector<char> buf(65536);
+	int n;
+	while ((n = std::fread(&buf.front(), 1, buf.size(), fp)) > 0)
+		hash.update(&buf.front(), n);
+	std::fclose(fp);
+	return hash.digest();
+}
+
+
+};	// end namespace RipUtil
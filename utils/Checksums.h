@@ -0,0 +1,44 @@
+/* Checksums used by output file formats */
+
+#include <string>
+
+namespace RipUtil
+{
+
+
+// update a running CRC-32 (as used by PNG and zip) with n bytes of s
+// start with crc = 0
+unsigned int crc32(unsigned int crc, const char* s, int n);
+
+// update a running Adler-32 (as used by zlib) with n bytes of s
+// start with adler = 1
+unsigned int adler32(unsigned int adler, const char* s, int n);
+
+// running 64-bit xxHash (XXH64) of a byte stream: a fast
+// non-cryptographic hash for telling files apart
+class XXHash64
+{
+public:
+	XXHash64(unsigned long long seed = 0);
+
+	// add n bytes of s
+	void update(const char* s, int n);
+	// hash of all bytes added so far
+	unsigned long long digest() const;
+
+private:
+	unsigned long long acc[4];
+	unsigned long long total;
+	unsigned long long seed;
+	// bytes waiting for a complete 32-byte stripe
+	unsigned char stripe[32];
+	int stripelen;
+};
+
+// XXH64 of the whole contents of a file
+unsigned long long xxhash64_file(const std::string& filename);
+
+
+};	// end namespace RipUtil
+
+#pragma once
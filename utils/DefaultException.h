@@ -12,7 +12,7 @@ public:
   
 	~DefaultException() throw() { };
 
-	const char* what()
+	const char* what() const throw()
 	{
 		return errmess.c_str();
 	}
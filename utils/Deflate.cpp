@@ -0,0 +1,585 @@
+#include "Deflate.h"
+#include "Checksums.h"
+#include "WorkerThreads.h"
+#include <algorithm>
+#include <cstring>
+
+namespace RipUtil
+{
+
+
+// length codes 257-285: base lengths and extra bits
+static const int deflate_len_base[29] = {
+	3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+	35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const int deflate_len_extra[29] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+	3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+// distance codes 0-29: base distances and extra bits
+static const int deflate_dist_base[30] = {
+	1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+	257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+	8193, 12289, 16385, 24577 };
+static const int deflate_dist_extra[30] = {
+	0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+	7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+// order in which code length code lengths are sent
+static const int deflate_codelen_order[19] = {
+	16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+const static int deflate_num_litlen = 286;
+const static int deflate_num_dist = 30;
+const static int deflate_num_codelen = 19;
+const static int deflate_end_of_block = 256;
+
+// lookup from match length/distance to code
+struct DeflateTables
+{
+	DeflateTables()
+	{
+		for (int i = 0; i < 29; i++)
+			for (int j = 0; j < (1 << deflate_len_extra[i]); j++)
+				if (deflate_len_base[i] + j <= DeflateConsts::max_match)
+					lencode[deflate_len_base[i] + j] = i;
+		for (int i = 0; i < 30; i++)
+			for (int j = 0; j < (1 << deflate_dist_extra[i]); j++)
+				distcode[deflate_dist_base[i] + j] = i;
+	}
+
+	int lencode[DeflateConsts::max_match + 1];
+	int distcode[DeflateConsts::window_size + 1];
+};
+
+static const DeflateTables deflate_tables;
+
+// one LZ77 symbol: a literal byte (dist == 0) or a match
+struct DeflateSymbol
+{
+	unsigned short litlen;
+	unsigned short dist;
+};
+
+// LSB-first bit writer
+class DeflateBitWriter
+{
+public:
+	DeflateBitWriter(std::vector<char>& o)
+		: out(o), acc(0), nbits(0) { };
+
+	void put(unsigned int val, int n)
+	{
+		acc |= static_cast<unsigned long long>(val) << nbits;
+		nbits += n;
+		while (nbits >= 8)
+		{
+			out.push_back(static_cast<char>(acc & 0xFF));
+			acc >>= 8;
+			nbits -= 8;
+		}
+	}
+
+	void align()
+	{
+		if (nbits)
+			put(0, 8 - nbits);
+	}
+
+private:
+	std::vector<char>& out;
+	unsigned long long acc;
+	int nbits;
+};
+
+// compute huffman code lengths no longer than maxbits for the
+// given symbol frequencies
+static void deflate_code_lengths(const int* freqs, int n, int maxbits, int* lengths)
+{
+	std::vector<int> f(freqs, freqs + n);
+	while (true)
+	{
+		std::fill(lengths, lengths + n, 0);
+		std::vector<std::pair<int, int> > leaves;
+		for (int i = 0; i < n; i++)
+			if (f[i] > 0)
+				leaves.push_back(std::make_pair(f[i], i));
+		if (leaves.size() == 0)
+			return;
+		if (leaves.size() == 1)
+		{
+			lengths[leaves[0].second] = 1;
+			return;
+		}
+		std::sort(leaves.begin(), leaves.end());
+
+		// two-queue construction: leaves, then internal nodes
+		int m = leaves.size();
+		std::vector<long long> weight(m * 2);
+		std::vector<int> parent(m * 2, -1);
+		for (int i = 0; i < m; i++)
+			weight[i] = leaves[i].first;
+		int leafpos = 0;
+		int nodepos = m;
+		int nextnode = m;
+		for (int k = 0; k < m - 1; k++)
+		{
+			int pick[2];
+			for (int j = 0; j < 2; j++)
+			{
+				if (leafpos < m && (nodepos >= nextnode
+					|| weight[leafpos] <= weight[nodepos]))
+					pick[j] = leafpos++;
+				else
+					pick[j] = nodepos++;
+			}
+			weight[nextnode] = weight[pick[0]] + weight[pick[1]];
+			parent[pick[0]] = nextnode;
+			parent[pick[1]] = nextnode;
+			++nextnode;
+		}
+
+		// parents always come after their children
+		std::vector<int> depth(nextnode, 0);
+		int maxlen = 0;
+		for (int i = nextnode - 2; i >= 0; i--)
+		{
+			depth[i] = depth[parent[i]] + 1;
+			if (i < m)
+				maxlen = std::max(maxlen, depth[i]);
+		}
+		if (maxlen <= maxbits)
+		{
+			for (int i = 0; i < m; i++)
+				lengths[leaves[i].second] = depth[i];
+			return;
+		}
+
+		// too long: flatten the distribution and try again
+		for (int i = 0; i < n; i++)
+			if (f[i] > 0)
+				f[i] = (f[i] + 1) / 2;
+	}
+}
+
+// assign canonical codes (bit-reversed for LSB-first output)
+static void deflate_canonical_codes(const int* lengths, int n, unsigned int* codes)
+{
+	int blcount[16] = { 0 };
+	for (int i = 0; i < n; i++)
+		if (lengths[i])
+			++blcount[lengths[i]];
+	unsigned int nextcode[16];
+	unsigned int code = 0;
+	for (int bits = 1; bits < 16; bits++)
+	{
+		code = (code + blcount[bits - 1]) << 1;
+		nextcode[bits] = code;
+	}
+	for (int i = 0; i < n; i++)
+	{
+		codes[i] = 0;
+		if (!lengths[i])
+			continue;
+		unsigned int c = nextcode[lengths[i]]++;
+		unsigned int rev = 0;
+		for (int j = 0; j < lengths[i]; j++)
+		{
+			rev = (rev << 1) | (c & 1);
+			c >>= 1;
+		}
+		codes[i] = rev;
+	}
+}
+
+// find the longest match for pos among earlier positions in the window
+static int deflate_find_match(const unsigned char* data, int len, int pos,
+	const std::vector<int>& head, const std::vector<int>& prev, int hash, int& bestdist)
+{
+	int maxlen = std::min(DeflateConsts::max_match, len - pos);
+	int bestlen = 0;
+	int chain = DeflateConsts::max_chain;
+	int cand = head[hash];
+	while (cand >= 0 && pos - cand <= DeflateConsts::window_size && chain--)
+	{
+		if (data[cand + bestlen] == data[pos + bestlen])
+		{
+			int l = 0;
+			while (l < maxlen && data[cand + l] == data[pos + l])
+				++l;
+			if (l > bestlen)
+			{
+				bestlen = l;
+				bestdist = pos - cand;
+				if (l >= DeflateConsts::nice_match || l == maxlen)
+					break;
+			}
+		}
+		int next = prev[cand & (DeflateConsts::window_size - 1)];
+		// slot was reused by a newer position
+		if (next >= cand)
+			break;
+		cand = next;
+	}
+	return bestlen;
+}
+
+// LZ77-parse a band, with one step of lazy matching
+static void deflate_lz77(const unsigned char* data, int len, std::vector<DeflateSymbol>& syms)
+{
+	const int hashsize = 1 << 15;
+	std::vector<int> head(hashsize, -1);
+	std::vector<int> prev(DeflateConsts::window_size, -1);
+
+	int pos = 0;
+	while (pos < len)
+	{
+		int matchlen = 0;
+		int matchdist = 0;
+		int hash = 0;
+		if (pos + DeflateConsts::min_match <= len)
+		{
+			hash = ((data[pos] << 10) ^ (data[pos + 1] << 5) ^ data[pos + 2]) & (hashsize - 1);
+			matchlen = deflate_find_match(data, len, pos, head, prev, hash, matchdist);
+			prev[pos & (DeflateConsts::window_size - 1)] = head[hash];
+			head[hash] = pos;
+		}
+
+		// take a literal if the next position has a longer match
+		if (matchlen >= DeflateConsts::min_match && matchlen < DeflateConsts::nice_match
+			&& pos + 1 + DeflateConsts::min_match <= len)
+		{
+			int nexthash = ((data[pos + 1] << 10) ^ (data[pos + 2] << 5) ^ data[pos + 3])
+				& (hashsize - 1);
+			int nextdist;
+			if (deflate_find_match(data, len, pos + 1, head, prev, nexthash, nextdist) > matchlen)
+				matchlen = 0;
+		}
+
+		DeflateSymbol sym;
+		if (matchlen >= DeflateConsts::min_match)
+		{
+			sym.litlen = matchlen;
+			sym.dist = matchdist;
+			syms.push_back(sym);
+			for (int i = 1; i < matchlen; i++)
+			{
+				int p = pos + i;
+				if (p + DeflateConsts::min_match > len)
+					break;
+				int h = ((data[p] << 10) ^ (data[p + 1] << 5) ^ data[p + 2]) & (hashsize - 1);
+				prev[p & (DeflateConsts::window_size - 1)] = head[h];
+				head[h] = p;
+			}
+			pos += matchlen;
+		}
+		else
+		{
+			sym.litlen = data[pos];
+			sym.dist = 0;
+			syms.push_back(sym);
+			++pos;
+		}
+	}
+}
+
+// huffman codes for one block
+struct DeflateCodes
+{
+	int litlens[288];
+	unsigned int litcodes[288];
+	int distlens[32];
+	unsigned int distcodes[32];
+};
+
+// bits needed for the symbols of a block under the given codes
+static long long deflate_symbol_bits(const int* litfreq, const int* distfreq,
+	const DeflateCodes& codes)
+{
+	long long bits = 0;
+	for (int i = 0; i < deflate_num_litlen; i++)
+	{
+		bits += (long long)litfreq[i] * codes.litlens[i];
+		if (i > deflate_end_of_block)
+			bits += (long long)litfreq[i] * deflate_len_extra[i - 257];
+	}
+	for (int i = 0; i < deflate_num_dist; i++)
+		bits += (long long)distfreq[i] * (codes.distlens[i] + deflate_dist_extra[i]);
+	return bits;
+}
+
+static void deflate_write_symbols(DeflateBitWriter& bw, const DeflateSymbol* syms,
+	int nsyms, const DeflateCodes& codes)
+{
+	for (int i = 0; i < nsyms; i++)
+	{
+		if (!syms[i].dist)
+		{
+			bw.put(codes.litcodes[syms[i].litlen], codes.litlens[syms[i].litlen]);
+			continue;
+		}
+		int lc = deflate_tables.lencode[syms[i].litlen];
+		bw.put(codes.litcodes[257 + lc], codes.litlens[257 + lc]);
+		bw.put(syms[i].litlen - deflate_len_base[lc], deflate_len_extra[lc]);
+		int dc = deflate_tables.distcode[syms[i].dist];
+		bw.put(codes.distcodes[dc], codes.distlens[dc]);
+		bw.put(syms[i].dist - deflate_dist_base[dc], deflate_dist_extra[dc]);
+	}
+	bw.put(codes.litcodes[deflate_end_of_block], codes.litlens[deflate_end_of_block]);
+}
+
+// write one block as whichever of stored, fixed or dynamic
+// huffman is smallest
+static void deflate_write_block(DeflateBitWriter& bw, const DeflateSymbol* syms, int nsyms,
+	const char* raw, int rawlen, bool final)
+{
+	int litfreq[deflate_num_litlen] = { 0 };
+	int distfreq[deflate_num_dist] = { 0 };
+	for (int i = 0; i < nsyms; i++)
+	{
+		if (syms[i].dist)
+		{
+			++litfreq[257 + deflate_tables.lencode[syms[i].litlen]];
+			++distfreq[deflate_tables.distcode[syms[i].dist]];
+		}
+		else
+			++litfreq[syms[i].litlen];
+	}
+	litfreq[deflate_end_of_block] = 1;
+
+	// fixed codes
+	DeflateCodes fixedcodes;
+	for (int i = 0; i < 288; i++)
+		fixedcodes.litlens[i] = (i < 144) ? 8 : (i < 256) ? 9 : (i < 280) ? 7 : 8;
+	for (int i = 0; i < 32; i++)
+		fixedcodes.distlens[i] = 5;
+	deflate_canonical_codes(fixedcodes.litlens, 288, fixedcodes.litcodes);
+	deflate_canonical_codes(fixedcodes.distlens, 32, fixedcodes.distcodes);
+	long long fixedbits = 3 + deflate_symbol_bits(litfreq, distfreq, fixedcodes);
+
+	// dynamic codes
+	DeflateCodes dyncodes;
+	std::fill(dyncodes.litlens, dyncodes.litlens + 288, 0);
+	std::fill(dyncodes.distlens, dyncodes.distlens + 32, 0);
+	deflate_code_lengths(litfreq, deflate_num_litlen, 15, dyncodes.litlens);
+	// always send at least two distance codes, for the benefit of
+	// older decoders
+	int distused[deflate_num_dist];
+	std::memcpy(distused, distfreq, sizeof(distused));
+	int numused = 0;
+	for (int i = 0; i < deflate_num_dist; i++)
+		if (distused[i])
+			++numused;
+	for (int i = 0; i < deflate_num_dist && numused < 2; i++)
+		if (!distused[i])
+		{
+			distused[i] = 1;
+			++numused;
+		}
+	deflate_code_lengths(distused, deflate_num_dist, 15, dyncodes.distlens);
+	deflate_canonical_codes(dyncodes.litlens, 288, dyncodes.litcodes);
+	deflate_canonical_codes(dyncodes.distlens, 32, dyncodes.distcodes);
+
+	int hlit = deflate_num_litlen;
+	while (hlit > 257 && !dyncodes.litlens[hlit - 1])
+		--hlit;
+	int hdist = deflate_num_dist;
+	while (hdist > 1 && !dyncodes.distlens[hdist - 1])
+		--hdist;
+
+	// run-length code the code lengths
+	std::vector<int> lens(hlit + hdist);
+	for (int i = 0; i < hlit; i++)
+		lens[i] = dyncodes.litlens[i];
+	for (int i = 0; i < hdist; i++)
+		lens[hlit + i] = dyncodes.distlens[i];
+	std::vector<std::pair<int, int> > rle;		// (symbol, extra bits value)
+	for (size_t i = 0; i < lens.size(); )
+	{
+		int cur = lens[i];
+		int run = 1;
+		while (i + run < lens.size() && lens[i + run] == cur)
+			++run;
+		i += run;
+		if (cur == 0)
+		{
+			while (run >= 11)
+			{
+				int r = std::min(run, 138);
+				rle.push_back(std::make_pair(18, r - 11));
+				run -= r;
+			}
+			if (run >= 3)
+			{
+				rle.push_back(std::make_pair(17, run - 3));
+				run = 0;
+			}
+		}
+		else
+		{
+			rle.push_back(std::make_pair(cur, 0));
+			--run;
+			while (run >= 3)
+			{
+				int r = std::min(run, 6);
+				rle.push_back(std::make_pair(16, r - 3));
+				run -= r;
+			}
+		}
+		while (run-- > 0)
+			rle.push_back(std::make_pair(cur, 0));
+	}
+
+	int clfreq[deflate_num_codelen] = { 0 };
+	for (size_t i = 0; i < rle.size(); i++)
+		++clfreq[rle[i].first];
+	int cllens[deflate_num_codelen];
+	unsigned int clcodes[deflate_num_codelen];
+	deflate_code_lengths(clfreq, deflate_num_codelen, 7, cllens);
+	deflate_canonical_codes(cllens, deflate_num_codelen, clcodes);
+	int hclen = deflate_num_codelen;
+	while (hclen > 4 && !cllens[deflate_codelen_order[hclen - 1]])
+		--hclen;
+
+	long long dynbits = 3 + 5 + 5 + 4 + 3 * hclen
+		+ deflate_symbol_bits(litfreq, distfreq, dyncodes);
+	for (size_t i = 0; i < rle.size(); i++)
+	{
+		dynbits += cllens[rle[i].first];
+		if (rle[i].first == 16)
+			dynbits += 2;
+		else if (rle[i].first == 17)
+			dynbits += 3;
+		else if (rle[i].first == 18)
+			dynbits += 7;
+	}
+
+	long long storedbits = (long long)(rawlen / 65535 + 1) * (3 + 7 + 32) + 8LL * rawlen;
+
+	if (storedbits < fixedbits && storedbits < dynbits)
+	{
+		int pos = 0;
+		do
+		{
+			int chunk = std::min(rawlen - pos, 65535);
+			bool last = (pos + chunk >= rawlen);
+			bw.put((final && last) ? 1 : 0, 1);
+			bw.put(0, 2);
+			bw.align();
+			bw.put(chunk, 16);
+			bw.put(~chunk & 0xFFFF, 16);
+			for (int i = 0; i < chunk; i++)
+				bw.put(static_cast<unsigned char>(raw[pos + i]), 8);
+			pos += chunk;
+		} while (pos < rawlen);
+	}
+	else if (fixedbits <= dynbits)
+	{
+		bw.put(final ? 1 : 0, 1);
+		bw.put(1, 2);
+		deflate_write_symbols(bw, syms, nsyms, fixedcodes);
+	}
+	else
+	{
+		bw.put(final ? 1 : 0, 1);
+		bw.put(2, 2);
+		bw.put(hlit - 257, 5);
+		bw.put(hdist - 1, 5);
+		bw.put(hclen - 4, 4);
+		for (int i = 0; i < hclen; i++)
+			bw.put(cllens[deflate_codelen_order[i]], 3);
+		for (size_t i = 0; i < rle.size(); i++)
+		{
+			bw.put(clcodes[rle[i].first], cllens[rle[i].first]);
+			if (rle[i].first == 16)
+				bw.put(rle[i].second, 2);
+			else if (rle[i].first == 17)
+				bw.put(rle[i].second, 3);
+			else if (rle[i].first == 18)
+				bw.put(rle[i].second, 7);
+		}
+		deflate_write_symbols(bw, syms, nsyms, dyncodes);
+	}
+}
+
+// shared state for compressing bands in parallel
+struct DeflateJob
+{
+	const char* data;
+	int len;
+	int bandsize;
+	std::vector<std::vector<char> > bands;
+};
+
+// compress one band (run_parallel callback)
+static void deflate_band(void* context, int band)
+{
+	DeflateJob& job = *static_cast<DeflateJob*>(context);
+	int start = band * job.bandsize;
+	int len = std::min(job.bandsize, job.len - start);
+	bool lastband = (band == (int)job.bands.size() - 1);
+	const char* raw = job.data + start;
+
+	std::vector<DeflateSymbol> syms;
+	deflate_lz77(reinterpret_cast<const unsigned char*>(raw), len, syms);
+
+	std::vector<char>& out = job.bands[band];
+	DeflateBitWriter bw(out);
+	int rawpos = 0;
+	for (int i = 0; i < (int)syms.size(); i += DeflateConsts::max_block_symbols)
+	{
+		int nsyms = std::min(DeflateConsts::max_block_symbols, (int)syms.size() - i);
+		int rawlen = 0;
+		for (int j = 0; j < nsyms; j++)
+			rawlen += syms[i + j].dist ? syms[i + j].litlen : 1;
+		bool final = lastband && (i + nsyms >= (int)syms.size());
+		deflate_write_block(bw, &syms[i], nsyms, raw + rawpos, rawlen, final);
+		rawpos += rawlen;
+	}
+
+	if (lastband)
+	{
+		// an empty stream still needs one final block
+		if (!syms.size())
+		{
+			bw.put(1, 1);
+			bw.put(1, 2);
+			bw.put(0, 7);
+		}
+	}
+	else
+	{
+		// empty stored block to end on a byte boundary
+		bw.put(0, 1);
+		bw.put(0, 2);
+		bw.align();
+		bw.put(0, 16);
+		bw.put(0xFFFF, 16);
+	}
+	bw.align();
+}
+
+void zlib_compress(const char* data, int len, std::vector<char>& out,
+	int bandsize)
+{
+	DeflateJob job;
+	job.data = data;
+	job.len = std::max(0, len);
+	job.bandsize = std::max(1, bandsize);
+	job.bands.resize(std::max(1, (job.len + job.bandsize - 1) / job.bandsize));
+
+	run_parallel(deflate_band, &job, job.bands.size());
+
+	// zlib header: deflate, 32k window, default compression
+	out.push_back(0x78);
+	out.push_back(static_cast<char>(0x9C));
+	for (size_t i = 0; i < job.bands.size(); i++)
+	{
+		out.insert(out.end(), job.bands[i].begin(), job.bands[i].end());
+		std::vector<char>().swap(job.bands[i]);
+	}
+	unsigned int adler = adler32(1, data, job.len);
+	for (int i = 3; i >= 0; i--)
+		out.push_back(static_cast<char>((adler >> (8 * i)) & 0xFF));
+}
+
+
+};	// end namespace RipUtil
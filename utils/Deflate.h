@@ -0,0 +1,39 @@
+/* Self-contained deflate (RFC 1951) compressor producing zlib
+   (RFC 1950) streams. Input is split into bands which are compressed
+   independently (no matches across band boundaries) on worker threads
+   and joined with empty stored blocks, so the result is one ordinary
+   stream whatever the number of threads */
+
+#include <vector>
+
+namespace RipUtil
+{
+
+
+namespace DeflateConsts
+{
+	// size of the LZ77 sliding window
+	const static int window_size = 32768;
+	// shortest and longest matches
+	const static int min_match = 3;
+	const static int max_match = 258;
+	// number of hash chain entries searched for a match
+	const static int max_chain = 128;
+	// stop searching once a match this long is found
+	const static int nice_match = 128;
+	// maximum number of symbols in one block
+	const static int max_block_symbols = 32768;
+	// default number of input bytes per independently compressed band
+	const static int default_band_size = 262144;
+};
+
+// compress len bytes of data as a zlib stream, appending it to out
+// bandsize gives the number of input bytes per independently
+// compressed band
+void zlib_compress(const char* data, int len, std::vector<char>& out,
+	int bandsize = DeflateConsts::default_band_size);
+
+
+};	// end namespace RipUtil
+
+#pragma once
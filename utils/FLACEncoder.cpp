@@ -0,0 +1,938 @@
+#include "FLACEncoder.h"
+#include "WorkerThreads.h"
+#include "DatManip.h"
+#include "DefaultException.h"
+#include "OutputStats.h"
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+namespace RipUtil
+{
+
+
+const static double flac_pi = 3.14159265358979323846;
+
+// MSB-first bit writer for FLAC frames
+class FLACBitWriter
+{
+public:
+	FLACBitWriter(std::vector<unsigned char>& o)
+		: out(o), acc(0), nbits(0) { };
+
+	// write the low n bits of val (n <= 32)
+	void put(unsigned int val, int n)
+	{
+		if (n <= 0)
+			return;
+		if (n < 32)
+			val &= (1u << n) - 1;
+		acc = (acc << n) | val;
+		nbits += n;
+		while (nbits >= 8)
+		{
+			nbits -= 8;
+			out.push_back(static_cast<unsigned char>(acc >> nbits));
+		}
+		acc &= (1u << nbits) - 1;
+	}
+
+	// write a two's complement value in n bits
+	void put_signed(int val, int n)
+	{
+		put(static_cast<unsigned int>(val), n);
+	}
+
+	// write q in unary (q zeros followed by a one)
+	void put_unary(unsigned int q)
+	{
+		while (q >= 31)
+		{
+			put(0, 31);
+			q -= 31;
+		}
+		put(1, q + 1);
+	}
+
+	// pad with zeros to the next byte boundary
+	void align()
+	{
+		if (nbits)
+			put(0, 8 - nbits);
+	}
+
+private:
+	std::vector<unsigned char>& out;
+	unsigned long long acc;
+	int nbits;
+};
+
+// CRC-8 (frame header) and CRC-16 (frame) lookup tables
+struct FLACCRCTables
+{
+	FLACCRCTables()
+	{
+		for (int i = 0; i < 256; i++)
+		{
+			int crc = i;
+			for (int j = 0; j < 8; j++)
+				crc = (crc & 0x80) ? ((crc << 1) ^ 0x07) : (crc << 1);
+			crc8[i] = crc & 0xFF;
+
+			crc = i << 8;
+			for (int j = 0; j < 8; j++)
+				crc = (crc & 0x8000) ? ((crc << 1) ^ 0x8005) : (crc << 1);
+			crc16[i] = crc & 0xFFFF;
+		}
+	}
+
+	int get_crc8(const unsigned char* s, int n) const
+	{
+		int crc = 0;
+		for (int i = 0; i < n; i++)
+			crc = crc8[crc ^ s[i]];
+		return crc;
+	}
+
+	int get_crc16(const unsigned char* s, int n) const
+	{
+		int crc = 0;
+		for (int i = 0; i < n; i++)
+			crc = ((crc << 8) ^ crc16[(crc >> 8) ^ s[i]]) & 0xFFFF;
+		return crc;
+	}
+
+	int crc8[256];
+	int crc16[256];
+};
+
+static const FLACCRCTables flac_crc;
+
+// MD5 of the unencoded samples, stored in STREAMINFO
+class FLACMD5
+{
+public:
+	FLACMD5()
+		: buflen(0), totallen(0)
+	{
+		state[0] = 0x67452301;
+		state[1] = 0xefcdab89;
+		state[2] = 0x98badcfe;
+		state[3] = 0x10325476;
+	}
+
+	void update(const unsigned char* s, int n)
+	{
+		totallen += n;
+		while (n > 0)
+		{
+			int count = std::min(n, 64 - buflen);
+			std::memcpy(buf + buflen, s, count);
+			buflen += count;
+			s += count;
+			n -= count;
+			if (buflen == 64)
+			{
+				transform(buf);
+				buflen = 0;
+			}
+		}
+	}
+
+	void final(unsigned char* digest)
+	{
+		unsigned long long bitlen = totallen * 8;
+		unsigned char pad = 0x80;
+		update(&pad, 1);
+		pad = 0;
+		while (buflen != 56)
+			update(&pad, 1);
+		unsigned char lenbytes[8];
+		for (int i = 0; i < 8; i++)
+			lenbytes[i] = static_cast<unsigned char>(bitlen >> (8 * i));
+		update(lenbytes, 8);
+		for (int i = 0; i < 4; i++)
+			for (int j = 0; j < 4; j++)
+				digest[i * 4 + j] = static_cast<unsigned char>(state[i] >> (8 * j));
+	}
+
+private:
+	static unsigned int rotl(unsigned int x, int c)
+	{
+		return (x << c) | (x >> (32 - c));
+	}
+
+	void transform(const unsigned char* block)
+	{
+		static const unsigned int k[64] = {
+			0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a,
+			0xa8304613, 0xfd469501, 0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be,
+			0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821, 0xf61e2562, 0xc040b340,
+			0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+			0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8,
+			0x676f02d9, 0x8d2a4c8a, 0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c,
+			0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70, 0x289b7ec6, 0xeaa127fa,
+			0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+			0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92,
+			0xffeff47d, 0x85845dd1, 0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1,
+			0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391 };
+		static const int r[64] = {
+			7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+			5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20,
+			4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+			6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21 };
+
+		unsigned int w[16];
+		for (int i = 0; i < 16; i++)
+			w[i] = block[i * 4] | (block[i * 4 + 1] << 8)
+				| (block[i * 4 + 2] << 16) | ((unsigned int)block[i * 4 + 3] << 24);
+
+		unsigned int a = state[0], b = state[1], c = state[2], d = state[3];
+		for (int i = 0; i < 64; i++)
+		{
+			unsigned int f;
+			int g;
+			if (i < 16)
+			{
+				f = (b & c) | (~b & d);
+				g = i;
+			}
+			else if (i < 32)
+			{
+				f = (d & b) | (~d & c);
+				g = (5 * i + 1) % 16;
+			}
+			else if (i < 48)
+			{
+				f = b ^ c ^ d;
+				g = (3 * i + 5) % 16;
+			}
+			else
+			{
+				f = c ^ (b | ~d);
+				g = (7 * i) % 16;
+			}
+			unsigned int temp = d;
+			d = c;
+			c = b;
+			b = b + rotl(a + f + k[i] + w[g], r[i]);
+			a = temp;
+		}
+		state[0] += a;
+		state[1] += b;
+		state[2] += c;
+		state[3] += d;
+	}
+
+	unsigned int state[4];
+	unsigned char buf[64];
+	int buflen;
+	unsigned long long totallen;
+};
+
+// subframe encoding chosen for one channel of a frame
+struct FLACSubframe
+{
+	enum SubframeType
+	{
+		constant, verbatim, fixed, lpc
+	};
+
+	FLACSubframe()
+		: type(verbatim), order(0), precision(0), shift(0),
+		partorder(0), ricemethod(0), bits(0) { };
+
+	SubframeType type;
+	int order;
+	int precision;
+	int shift;
+	int coefs[FLACEncoderConsts::max_lpc_order];
+	std::vector<int> residual;
+	int partorder;
+	int ricemethod;
+	std::vector<int> riceparams;
+	long long bits;		// encoded size in bits
+};
+
+// shared state for encoding frames in parallel
+struct FLACEncodeJob
+{
+	const unsigned char* data;
+	int channels;
+	int bytespersamp;
+	bool bigend;
+	bool is_unsigned;
+	int totalsamps;
+	int samprate;
+	int firstframe;		// number of the frame data starts at
+	std::vector<std::vector<unsigned char> > frames;
+};
+
+// read one sample as a signed value
+static int read_flac_sample(const unsigned char* p, int bytespersamp,
+	bool bigend, bool is_unsigned)
+{
+	unsigned int val = 0;
+	for (int i = 0; i < bytespersamp; i++)
+		val |= static_cast<unsigned int>(p[bigend ? bytespersamp - 1 - i : i]) << (8 * i);
+	if (is_unsigned)
+		return static_cast<int>(val) - (1 << (8 * bytespersamp - 1));
+	int shift = 32 - 8 * bytespersamp;
+	return static_cast<int>(val << shift) >> shift;
+}
+
+// map a signed residual to an unsigned rice value
+static unsigned int flac_zigzag(int val)
+{
+	return (static_cast<unsigned int>(val) << 1) ^ static_cast<unsigned int>(val >> 31);
+}
+
+// estimated bits for a rice partition with the given sum of values,
+// setting param to the best rice parameter
+static long long flac_rice_cost(unsigned long long sum, int len, int& param)
+{
+	param = 0;
+	if (len <= 0)
+		return 0;
+	int guess = 0;
+	while (guess < 30 && (static_cast<unsigned long long>(len) << (guess + 1)) <= sum)
+		++guess;
+	long long best = -1;
+	for (int k = std::max(0, guess - 1); k <= std::min(30, guess + 1); k++)
+	{
+		long long cost = static_cast<long long>(len) * (k + 1) + (sum >> k);
+		if (best < 0 || cost < best)
+		{
+			best = cost;
+			param = k;
+		}
+	}
+	return best;
+}
+
+// choose partition order and rice parameters for the residual of a
+// subframe, returning the encoded residual size in bits
+static long long flac_choose_rice(FLACSubframe& sub, int n)
+{
+	const std::vector<int>& res = sub.residual;
+	int order = sub.order;
+
+	// highest usable partition order
+	int maxorder = 0;
+	while (maxorder < FLACEncoderConsts::max_partition_order
+		&& !(n % (1 << (maxorder + 1)))
+		&& (n >> (maxorder + 1)) > order)
+		++maxorder;
+
+	// partition sums at the highest order, merged for lower orders
+	int numparts = 1 << maxorder;
+	std::vector<unsigned long long> sums(numparts, 0);
+	int partlen = n >> maxorder;
+	for (size_t i = 0; i < res.size(); i++)
+		sums[(i + order) / partlen] += flac_zigzag(res[i]);
+
+	long long best = -1;
+	for (int p = maxorder; p >= 0; p--)
+	{
+		int parts = 1 << p;
+		int len = n >> p;
+		long long cost = 6;
+		std::vector<int> params(parts);
+		int highparam = 0;
+		for (int i = 0; i < parts; i++)
+		{
+			cost += flac_rice_cost(sums[i], len - (i ? 0 : order), params[i]);
+			highparam = std::max(highparam, params[i]);
+		}
+		int method = (highparam > 14) ? 1 : 0;
+		cost += parts * (method ? 5 : 4);
+		if (best < 0 || cost < best)
+		{
+			best = cost;
+			sub.partorder = p;
+			sub.ricemethod = method;
+			sub.riceparams = params;
+		}
+		// merge pairs of partitions for the next order down
+		for (int i = 0; i < parts/2; i++)
+			sums[i] = sums[i * 2] + sums[i * 2 + 1];
+	}
+	return best;
+}
+
+// compute the residual of a fixed predictor
+// return false if it doesn't fit in 32 bits
+static bool flac_fixed_residual(const int* s, int n, int order, std::vector<int>& res)
+{
+	res.resize(n - order);
+	for (int i = order; i < n; i++)
+	{
+		long long r;
+		switch (order)
+		{
+		case 0:
+			r = s[i];
+			break;
+		case 1:
+			r = (long long)s[i] - s[i - 1];
+			break;
+		case 2:
+			r = (long long)s[i] - 2LL * s[i - 1] + s[i - 2];
+			break;
+		case 3:
+			r = (long long)s[i] - 3LL * s[i - 1] + 3LL * s[i - 2] - s[i - 3];
+			break;
+		default:
+			r = (long long)s[i] - 4LL * s[i - 1] + 6LL * s[i - 2]
+				- 4LL * s[i - 3] + s[i - 4];
+			break;
+		}
+		if (r > 0x3FFFFFFF || r < -0x40000000)
+			return false;
+		res[i - order] = static_cast<int>(r);
+	}
+	return true;
+}
+
+// quantize LPC coefficients to the given precision
+// return false if they can't be represented
+static bool flac_quantize_lpc(const double* lp, int order, int precision,
+	int* qlp, int& shift)
+{
+	double cmax = 0;
+	for (int i = 0; i < order; i++)
+		cmax = std::max(cmax, std::fabs(lp[i]));
+	if (cmax <= 0)
+		return false;
+	int log2cmax;
+	std::frexp(cmax, &log2cmax);
+	--log2cmax;
+	shift = precision - 2 - log2cmax;
+	if (shift > 15)
+		shift = 15;
+	else if (shift < 0)
+		return false;
+
+	int qmax = (1 << (precision - 1)) - 1;
+	int qmin = -(1 << (precision - 1));
+	double error = 0;
+	for (int i = 0; i < order; i++)
+	{
+		error += lp[i] * (1 << shift);
+		int q = static_cast<int>(std::floor(error + 0.5));
+		q = std::min(qmax, std::max(qmin, q));
+		error -= q;
+		qlp[i] = q;
+	}
+	return true;
+}
+
+// compute the residual of a quantized LPC predictor
+// return false if it doesn't fit in 32 bits
+static bool flac_lpc_residual(const int* s, int n, int order, const int* qlp, int shift,
+	std::vector<int>& res)
+{
+	res.resize(n - order);
+	for (int i = order; i < n; i++)
+	{
+		long long sum = 0;
+		for (int j = 0; j < order; j++)
+			sum += (long long)qlp[j] * s[i - j - 1];
+		long long r = s[i] - (sum >> shift);
+		if (r > 0x3FFFFFFF || r < -0x40000000)
+			return false;
+		res[i - order] = static_cast<int>(r);
+	}
+	return true;
+}
+
+// pick the smallest encoding for one channel of a frame
+static void flac_analyze_subframe(const int* s, int n, int bps, FLACSubframe& best)
+{
+	// verbatim is always possible
+	best.type = FLACSubframe::verbatim;
+	best.order = 0;
+	best.bits = 8 + (long long)n * bps;
+
+	bool is_constant = true;
+	for (int i = 1; i < n && is_constant; i++)
+		if (s[i] != s[0])
+			is_constant = false;
+	if (is_constant)
+	{
+		best.type = FLACSubframe::constant;
+		best.bits = 8 + bps;
+		return;
+	}
+
+	FLACSubframe cand;
+
+	// fixed predictors
+	for (int order = 0; order <= FLACEncoderConsts::max_fixed_order && order < n; order++)
+	{
+		cand.type = FLACSubframe::fixed;
+		cand.order = order;
+		if (!flac_fixed_residual(s, n, order, cand.residual))
+			continue;
+		cand.bits = 8 + (long long)order * bps + flac_choose_rice(cand, n);
+		if (cand.bits < best.bits)
+			std::swap(best, cand);
+	}
+
+	// LPC predictors from the windowed autocorrelation
+	int maxorder = std::min(FLACEncoderConsts::max_lpc_order, n - 1);
+	if (maxorder < 1)
+		return;
+
+	// tukey(0.5) window
+	std::vector<double> x(n);
+	int np = n/4 - 1;
+	for (int i = 0; i < n; i++)
+	{
+		double w = 1.0;
+		if (np > 0 && i <= np)
+			w = 0.5 - 0.5 * std::cos(flac_pi * i / np);
+		else if (np > 0 && i >= n - np - 1)
+			w = 0.5 - 0.5 * std::cos(flac_pi * (n - 1 - i) / np);
+		x[i] = s[i] * w;
+	}
+	double autoc[FLACEncoderConsts::max_lpc_order + 1];
+	for (int lag = 0; lag <= maxorder; lag++)
+	{
+		double sum = 0;
+		for (int i = lag; i < n; i++)
+			sum += x[i] * x[i - lag];
+		autoc[lag] = sum;
+	}
+	if (autoc[0] <= 0)
+		return;
+
+	// levinson-durbin recursion, trying each order as it is found
+	double a[FLACEncoderConsts::max_lpc_order];
+	double prev[FLACEncoderConsts::max_lpc_order];
+	double err = autoc[0];
+	int precision = std::min(FLACEncoderConsts::lpc_precision, bps + 5);
+	for (int m = 0; m < maxorder; m++)
+	{
+		double k = autoc[m + 1];
+		for (int j = 0; j < m; j++)
+			k -= a[j] * autoc[m - j];
+		k /= err;
+		std::memcpy(prev, a, sizeof(double) * m);
+		a[m] = k;
+		for (int j = 0; j < m; j++)
+			a[j] = prev[j] - k * prev[m - 1 - j];
+		err *= (1 - k * k);
+
+		cand.type = FLACSubframe::lpc;
+		cand.order = m + 1;
+		cand.precision = precision;
+		if (flac_quantize_lpc(a, cand.order, precision, cand.coefs, cand.shift)
+			&& flac_lpc_residual(s, n, cand.order, cand.coefs, cand.shift, cand.residual))
+		{
+			cand.bits = 8 + (long long)cand.order * bps + 9
+				+ (long long)cand.order * precision + flac_choose_rice(cand, n);
+			if (cand.bits < best.bits)
+				std::swap(best, cand);
+		}
+		if (err <= 0)
+			break;
+	}
+}
+
+// write a subframe chosen by flac_analyze_subframe
+static void flac_write_subframe(FLACBitWriter& bw, const int* s, int n, int bps,
+	const FLACSubframe& sub)
+{
+	switch (sub.type)
+	{
+	case FLACSubframe::constant:
+		bw.put(0x00, 8);
+		bw.put_signed(s[0], bps);
+		return;
+	case FLACSubframe::verbatim:
+		bw.put(0x01 << 1, 8);
+		for (int i = 0; i < n; i++)
+			bw.put_signed(s[i], bps);
+		return;
+	case FLACSubframe::fixed:
+		bw.put((0x08 | sub.order) << 1, 8);
+		for (int i = 0; i < sub.order; i++)
+			bw.put_signed(s[i], bps);
+		break;
+	case FLACSubframe::lpc:
+		bw.put((0x20 | (sub.order - 1)) << 1, 8);
+		for (int i = 0; i < sub.order; i++)
+			bw.put_signed(s[i], bps);
+		bw.put(sub.precision - 1, 4);
+		bw.put_signed(sub.shift, 5);
+		for (int i = 0; i < sub.order; i++)
+			bw.put_signed(sub.coefs[i], sub.precision);
+		break;
+	}
+
+	// rice-coded residual
+	bw.put(sub.ricemethod, 2);
+	bw.put(sub.partorder, 4);
+	int parambits = sub.ricemethod ? 5 : 4;
+	int pos = 0;
+	for (int i = 0; i < (1 << sub.partorder); i++)
+	{
+		int k = sub.riceparams[i];
+		int len = (n >> sub.partorder) - (i ? 0 : sub.order);
+		bw.put(k, parambits);
+		for (int j = 0; j < len; j++)
+		{
+			unsigned int u = flac_zigzag(sub.residual[pos++]);
+			bw.put_unary(u >> k);
+			bw.put(u, k);
+		}
+	}
+}
+
+// frame header code for a sample rate (0 = get from STREAMINFO)
+static int flac_samprate_code(int samprate)
+{
+	switch (samprate)
+	{
+	case 88200: return 1;
+	case 176400: return 2;
+	case 192000: return 3;
+	case 8000: return 4;
+	case 16000: return 5;
+	case 22050: return 6;
+	case 24000: return 7;
+	case 32000: return 8;
+	case 44100: return 9;
+	case 48000: return 10;
+	case 96000: return 11;
+	default: return 0;
+	}
+}
+
+// frame header code for a sample width
+static int flac_sampwidth_code(int bps)
+{
+	switch (bps)
+	{
+	case 8: return 1;
+	case 16: return 4;
+	case 24: return 6;
+	default: return 0;
+	}
+}
+
+// encode one frame of the job (run_parallel callback)
+static void flac_encode_frame(void* context, int framenum)
+{
+	FLACEncodeJob& job = *static_cast<FLACEncodeJob*>(context);
+	int bps = job.bytespersamp * 8;
+	int start = framenum * FLACEncoderConsts::blocksize;
+	std::vector<unsigned char>& out = job.frames[framenum];
+	// numbered within the whole stream
+	framenum += job.firstframe;
+	int n = std::min(FLACEncoderConsts::blocksize,
+		job.totalsamps - framenum * FLACEncoderConsts::blocksize);
+
+	// deinterleave samples
+	std::vector<std::vector<int> > chans(job.channels, std::vector<int>(n));
+	const unsigned char* p = job.data + (long long)start * job.channels * job.bytespersamp;
+	for (int i = 0; i < n; i++)
+		for (int c = 0; c < job.channels; c++)
+		{
+			chans[c][i] = read_flac_sample(p, job.bytespersamp, job.bigend, job.is_unsigned);
+			p += job.bytespersamp;
+		}
+
+	std::vector<FLACSubframe> subs(job.channels);
+	for (int c = 0; c < job.channels; c++)
+		flac_analyze_subframe(&chans[c][0], n, bps, subs[c]);
+
+	// channel assignment: independent unless a stereo
+	// decorrelation comes out smaller
+	int assignment = job.channels - 1;
+	const int* outchans[8];
+	int outbps[8];
+	for (int c = 0; c < job.channels; c++)
+	{
+		outchans[c] = &chans[c][0];
+		outbps[c] = bps;
+	}
+	std::vector<int> mid, side;
+	FLACSubframe midsub, sidesub;
+	if (job.channels == 2)
+	{
+		mid.resize(n);
+		side.resize(n);
+		for (int i = 0; i < n; i++)
+		{
+			mid[i] = (chans[0][i] + chans[1][i]) >> 1;
+			side[i] = chans[0][i] - chans[1][i];
+		}
+		flac_analyze_subframe(&mid[0], n, bps, midsub);
+		flac_analyze_subframe(&side[0], n, bps + 1, sidesub);
+
+		long long indep = subs[0].bits + subs[1].bits;
+		long long leftside = subs[0].bits + sidesub.bits;
+		long long rightside = sidesub.bits + subs[1].bits;
+		long long midside = midsub.bits + sidesub.bits;
+		long long best = std::min(std::min(indep, leftside), std::min(rightside, midside));
+		if (best == midside)
+		{
+			assignment = 10;
+			outchans[0] = &mid[0];
+			outchans[1] = &side[0];
+			outbps[1] = bps + 1;
+			std::swap(subs[0], midsub);
+			std::swap(subs[1], sidesub);
+		}
+		else if (best == leftside)
+		{
+			assignment = 8;
+			outchans[1] = &side[0];
+			outbps[1] = bps + 1;
+			std::swap(subs[1], sidesub);
+		}
+		else if (best == rightside)
+		{
+			assignment = 9;
+			outchans[0] = &side[0];
+			outbps[0] = bps + 1;
+			std::swap(subs[0], sidesub);
+		}
+	}
+
+	FLACBitWriter bw(out);
+
+	// frame header
+	int blockcode;
+	if (n == FLACEncoderConsts::blocksize)
+		blockcode = 12;
+	else if (n <= 256)
+		blockcode = 6;
+	else
+		blockcode = 7;
+	bw.put(0xFFF8, 16);
+	bw.put(blockcode, 4);
+	bw.put(flac_samprate_code(job.samprate), 4);
+	bw.put(assignment, 4);
+	bw.put(flac_sampwidth_code(bps), 3);
+	bw.put(0, 1);
+	// frame number, utf-8 style
+	if (framenum < 0x80)
+		bw.put(framenum, 8);
+	else
+	{
+		int extra = 1;
+		while (extra < 5 && framenum >= (1 << (5 * extra + 6)))
+			++extra;
+		bw.put((0xFF00 >> (extra + 1)) | (framenum >> (6 * extra)), 8);
+		for (int i = extra - 1; i >= 0; i--)
+			bw.put(0x80 | ((framenum >> (6 * i)) & 0x3F), 8);
+	}
+	if (blockcode == 6)
+		bw.put(n - 1, 8);
+	else if (blockcode == 7)
+		bw.put(n - 1, 16);
+	bw.put(flac_crc.get_crc8(&out[0], out.size()), 8);
+
+	for (int c = 0; c < job.channels; c++)
+		flac_write_subframe(bw, outchans[c], n, outbps[c], subs[c]);
+
+	bw.align();
+	bw.put(flac_crc.get_crc16(&out[0], out.size()), 16);
+}
+
+// add the first count sample values of job.data to md5, as signed
+// little-endian (the form STREAMINFO's md5 is of)
+static void flac_md5_samples(FLACMD5& md5, const FLACEncodeJob& job, int count)
+{
+	std::vector<unsigned char> md5buf(FLACEncoderConsts::blocksize * job.bytespersamp);
+	for (int i = 0; i < count; i += FLACEncoderConsts::blocksize)
+	{
+		int n = std::min(FLACEncoderConsts::blocksize, count - i);
+		for (int j = 0; j < n; j++)
+		{
+			int val = read_flac_sample(job.data + (long long)(i + j) * job.bytespersamp,
+				job.bytespersamp, job.bigend, job.is_unsigned);
+			for (int b = 0; b < job.bytespersamp; b++)
+				md5buf[j * job.bytespersamp + b] = static_cast<unsigned char>(val >> (8 * b));
+		}
+		md5.update(&md5buf[0], n * job.bytespersamp);
+	}
+}
+
+// widen minframe..maxframe to take in a frame of framesize bytes
+static void flac_frame_size_range(int framesize, bool firstframe, int& minframe, int& maxframe)
+{
+	if (firstframe || framesize < minframe)
+		minframe = framesize;
+	maxframe = std::max(maxframe, framesize);
+}
+
+// the stream marker and STREAMINFO block for job's frames
+static void flac_stream_header(std::vector<unsigned char>& header, const FLACEncodeJob& job,
+	int numframes, int minframe, int maxframe, const unsigned char* digest)
+{
+	int blocksize = FLACEncoderConsts::blocksize;
+	if (numframes <= 1)
+		blocksize = std::max(16, job.totalsamps);
+
+	FLACBitWriter bw(header);
+	for (int i = 0; i < 4; i++)
+		bw.put(FLACEncoderConsts::flac_stream_id[i], 8);
+	bw.put(1, 1);		// last metadata block
+	bw.put(0, 7);		// STREAMINFO
+	bw.put(34, 24);
+	bw.put(blocksize, 16);
+	bw.put(blocksize, 16);
+	bw.put(minframe, 24);
+	bw.put(maxframe, 24);
+	bw.put(job.samprate, 20);
+	bw.put(job.channels - 1, 3);
+	bw.put(job.bytespersamp * 8 - 1, 5);
+	bw.put(0, 4);		// high bits of 36-bit sample count
+	bw.put(job.totalsamps, 32);
+	for (int i = 0; i < 16; i++)
+		bw.put(digest[i], 8);
+}
+
+bool flac_can_encode(PCMData& dat)
+{
+	int sw = dat.get_sampwidth();
+	return (sw == 8 || sw == 16 || sw == 24)
+		&& dat.get_channels() >= 1 && dat.get_channels() <= 8
+		&& dat.get_samprate() > 0 && dat.get_samprate() < (1 << 20);
+}
+
+void encode_pcmdata_flac(PCMData& dat, std::vector<char>& out,
+	int ignorebytes, int ignoreend)
+{
+	if (!flac_can_encode(dat))
+		throw(DefaultException("audio format can't be encoded as FLAC"));
+
+	// disallow negative ignore values
+	ignorebytes = std::max(0, ignorebytes);
+	ignoreend = std::max(0, ignoreend);
+	int size = std::max(0, dat.get_wavesize() - ignorebytes - ignoreend);
+
+	FLACEncodeJob job;
+	job.data = reinterpret_cast<const unsigned char*>(dat.get_waveform() + ignorebytes);
+	job.channels = dat.get_channels();
+	job.bytespersamp = dat.get_sampwidth()/8;
+	job.bigend = (dat.get_end() == DatManip::be);
+	job.is_unsigned = (dat.get_signed() == DatManip::has_nosign);
+	job.totalsamps = size / (job.channels * job.bytespersamp);
+	job.samprate = dat.get_samprate();
+	job.firstframe = 0;
+	int numframes = (job.totalsamps + FLACEncoderConsts::blocksize - 1)
+		/ FLACEncoderConsts::blocksize;
+	job.frames.resize(numframes);
+
+	run_parallel(flac_encode_frame, &job, numframes);
+
+	FLACMD5 md5;
+	flac_md5_samples(md5, job, job.totalsamps * job.channels);
+	unsigned char digest[16];
+	md5.final(digest);
+
+	int minframe = 0;
+	int maxframe = 0;
+	for (int i = 0; i < numframes; i++)
+		flac_frame_size_range(job.frames[i].size(), i == 0, minframe, maxframe);
+
+	std::vector<unsigned char> header;
+	flac_stream_header(header, job, numframes, minframe, maxframe, digest);
+
+	out.insert(out.end(), header.begin(), header.end());
+	for (int i = 0; i < numframes; i++)
+	{
+		out.insert(out.end(), job.frames[i].begin(), job.frames[i].end());
+		std::vector<unsigned char>().swap(job.frames[i]);
+	}
+}
+
+void write_pcmdata_flac(OutputSink& sink, PCMData& dat, const std::string& outfile,
+	int ignorebytes, int ignoreend)
+{
+	if (sink.wants_decoded())
+	{
+		take_pcmdata(sink, dat, outfile, ignorebytes, ignoreend);
+		return;
+	}
+
+	std::vector<char> encoded;
+	encode_pcmdata_flac(dat, encoded, ignorebytes, ignoreend);
+
+	sink.write_file(outfile, encoded.size() ? &encoded[0] : 0, encoded.size());
+	count_output_bytes("flac", encoded.size());
+}
+
+void write_flac_streamed(OutputSink& sink, PCMData& dat, const std::string& outfile,
+	int totalsamps, FLACSampleSource source, void* context)
+{
+	if (!flac_can_encode(dat))
+		throw(DefaultException("audio format can't be encoded as FLAC"));
+
+	FLACEncodeJob job;
+	job.channels = dat.get_channels();
+	job.bytespersamp = dat.get_sampwidth()/8;
+	job.bigend = (dat.get_end() == DatManip::be);
+	job.is_unsigned = (dat.get_signed() == DatManip::has_nosign);
+	job.totalsamps = std::max(0, totalsamps);
+	job.samprate = dat.get_samprate();
+	int numframes = (job.totalsamps + FLACEncoderConsts::blocksize - 1)
+		/ FLACEncoderConsts::blocksize;
+	std::vector<char> buf(std::max(1, FLACEncoderConsts::stream_frames
+		* FLACEncoderConsts::blocksize * job.channels * job.bytespersamp));
+	job.data = reinterpret_cast<const unsigned char*>(&buf[0]);
+
+	// the STREAMINFO block before the frames needs their sizes and md5,
+	// so they're encoded once for those, then again to be written
+	FLACMD5 md5;
+	int minframe = 0;
+	int maxframe = 0;
+	long long encodedsize = 0;
+	for (int pass = 0; pass < 2; pass++)
+	{
+		for (int first = 0; first < numframes; first += FLACEncoderConsts::stream_frames)
+		{
+			int batch = std::min(FLACEncoderConsts::stream_frames, numframes - first);
+			int start = first * FLACEncoderConsts::blocksize;
+			int count = std::min(batch * FLACEncoderConsts::blocksize, job.totalsamps - start);
+			source(context, start, count, &buf[0]);
+			job.firstframe = first;
+			job.frames.assign(batch, std::vector<unsigned char>());
+			run_parallel(flac_encode_frame, &job, batch);
+
+			for (int i = 0; i < batch; i++)
+			{
+				const std::vector<unsigned char>& frame = job.frames[i];
+				if (pass == 0)
+				{
+					flac_frame_size_range(frame.size(), first + i == 0, minframe, maxframe);
+					encodedsize += frame.size();
+				}
+				else
+					sink.write(reinterpret_cast<const char*>(&frame[0]), frame.size());
+			}
+			if (pass == 0)
+				flac_md5_samples(md5, job, count * job.channels);
+		}
+
+		if (pass == 0)
+		{
+			unsigned char digest[16];
+			md5.final(digest);
+			std::vector<unsigned char> header;
+			flac_stream_header(header, job, numframes, minframe, maxframe, digest);
+			sink.open(outfile, header.size() + encodedsize);
+			sink.write(reinterpret_cast<const char*>(&header[0]), header.size());
+		}
+	}
+	count_output_bytes("flac", sink.get_file_size());
+	sink.close();
+}
+
+
+};	// end namespace RipUtil
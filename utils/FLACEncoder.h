@@ -0,0 +1,58 @@
+/* Self-contained FLAC encoder for PCMData: frames use constant, verbatim,
+   fixed or LPC subframes (whichever is smallest) with Rice-coded
+   residuals, and are encoded in parallel */
+
+#include <string>
+#include <vector>
+
+#include "PCMData.h"
+
+namespace RipUtil
+{
+
+
+namespace FLACEncoderConsts
+{
+	const static char flac_stream_id[4]
+		= { 'f', 'L', 'a', 'C' };
+	// samples per channel per frame
+	const static int blocksize = 4096;
+	// highest fixed predictor order
+	const static int max_fixed_order = 4;
+	// highest LPC predictor order
+	const static int max_lpc_order = 8;
+	// precision of quantized LPC coefficients
+	const static int lpc_precision = 13;
+	// highest rice partition order
+	const static int max_partition_order = 8;
+	// frames encoded at once by write_flac_streamed()
+	const static int stream_frames = 64;
+};
+
+// fills buf with count samples per channel, from sample start on,
+// in the sample format of the stream being encoded
+typedef void (*FLACSampleSource)(void* context, int start, int count, char* buf);
+
+// return true if the format of dat can be stored as FLAC
+// (8, 16 or 24 bits per sample, 1 to 8 channels)
+bool flac_can_encode(PCMData& dat);
+
+// encode PCMData as a FLAC stream, appending it to out
+void encode_pcmdata_flac(PCMData& dat, std::vector<char>& out,
+	int ignorebytes = 0, int ignoreend = 0);
+
+// write out PCMData as a FLAC file
+void write_pcmdata_flac(OutputSink& sink, PCMData& dat, const std::string& outfile,
+	int ignorebytes = 0, int ignoreend = 0);
+
+// write a FLAC file of totalsamps samples per channel in the format of
+// dat, taken from source a few frames at a time instead of held whole.
+// The samples are read twice (for STREAMINFO, then for the frames), so
+// the file is the same as write_pcmdata_flac() makes of them
+void write_flac_streamed(OutputSink& sink, PCMData& dat, const std::string& outfile,
+	int totalsamps, FLACSampleSource source, void* context);
+
+
+};	// end namespace RipUtil
+
+#pragma once
@@ -0,0 +1,180 @@
+#include "IncrementalOutputSink.h"
+#include "Checksums.h"
+#include "DatManip.h"
+#include "DefaultException.h"
+#include <cstdio>
+#include <fstream>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+namespace RipUtil
+{
+
+
+// 16 hex digit form of a hash
+static std::string hash_string(unsigned long long hash)
+{
+	char buf[17];
+	std::sprintf(buf, "%016llx", hash);
+	return buf;
+}
+
+IncrementalOutputSink::IncrementalOutputSink(OutputSink& target,
+	const std::string& manifestname, const std::string& inputname,
+	const std::string& settings)
+	: target(target), manifestname(manifestname), numskipped(0), inasset(false)
+{
+	inputhash = hash_string(xxhash64_file(inputname));
+	XXHash64 hash;
+	hash.update(settings.c_str(), settings.size());
+	settingshash = hash_string(hash.digest());
+
+	read_manifest();
+}
+
+void IncrementalOutputSink::read_manifest()
+{
+	std::ifstream ifs(manifestname.c_str());
+	std::string line;
+	while (std::getline(ifs, line))
+	{
+		// <input hash> <settings hash> <offset> <number of files> <module>
+		std::string::size_type pos[4];
+		pos[0] = line.find(' ');
+		for (int i = 1; i < 4 && pos[i - 1] != std::string::npos; i++)
+			pos[i] = line.find(' ', pos[i - 1] + 1);
+		if (pos[0] == std::string::npos || pos[1] == std::string::npos
+			|| pos[2] == std::string::npos || pos[3] == std::string::npos)
+			break;
+
+		bool match = (line.substr(0, pos[0]) == inputhash
+			&& line.substr(pos[0] + 1, pos[1] - pos[0] - 1) == settingshash);
+		std::string key = line.substr(pos[3] + 1) + " "
+			+ line.substr(pos[1] + 1, pos[2] - pos[1] - 1);
+		int numfiles = from_string<int>(line.substr(pos[2] + 1, pos[3] - pos[2] - 1));
+
+		AssetFiles files;
+		for (int i = 0; i < numfiles && std::getline(ifs, line); i++)
+		{
+			// <size> <filename>
+			std::string::size_type space = line.find(' ');
+			if (space == std::string::npos)
+				continue;
+			files.sizes.push_back(from_string<long long>(line.substr(0, space)));
+			files.names.push_back(line.substr(space + 1));
+		}
+		// anything from a different input or different settings is stale
+		if (match)
+			oldassets[key] = files;
+	}
+}
+
+std::string IncrementalOutputSink::get_asset_key(int offset)
+{
+	// an offset seen again (e.g. a chunk with no address of its own)
+	// is told apart by how many times it has come up
+	std::string key = module + " " + to_string(offset);
+	int count = keycounts[key]++;
+	if (count)
+		key += "." + to_string(count);
+	return key;
+}
+
+bool IncrementalOutputSink::files_current(const AssetFiles& files)
+{
+	for (size_t i = 0; i < files.names.size(); i++)
+	{
+#ifdef _WIN32
+		struct _stati64 st;
+		if (_stati64(files.names[i].c_str(), &st) != 0)
+#else
+		struct stat st;
+		if (stat(files.names[i].c_str(), &st) != 0)
+#endif
+			return false;
+		if (st.st_size != files.sizes[i])
+			return false;
+	}
+	return true;
+}
+
+bool IncrementalOutputSink::begin_asset(int offset)
+{
+	end_asset();
+
+	std::string key = get_asset_key(offset);
+	std::map<std::string, AssetFiles>::const_iterator it = oldassets.find(key);
+	if (it != oldassets.end() && files_current(it->second))
+	{
+		assets[key] = it->second;
+		++numskipped;
+		return false;
+	}
+
+	inasset = true;
+	assetkey = key;
+	assets[key] = AssetFiles();
+	return true;
+}
+
+void IncrementalOutputSink::end_asset()
+{
+	inasset = false;
+}
+
+void IncrementalOutputSink::open_file(const std::string& filename, long long size)
+{
+	this->filename = filename;
+	target.open(filename, size);
+}
+
+void IncrementalOutputSink::close_file()
+{
+	target.close();
+	if (inasset)
+	{
+		AssetFiles& files = assets[assetkey];
+		files.names.push_back(filename);
+		files.sizes.push_back(get_file_size());
+	}
+}
+
+int IncrementalOutputSink::copy_from_stream(MembufStream& stream, int n)
+{
+	long long before = target.get_file_size();
+	target.write_from(stream, n);
+	return target.get_file_size() - before;
+}
+
+void IncrementalOutputSink::flush()
+{
+	end_asset();
+	// the files have to be on disk before the manifest says so
+	target.flush();
+
+	std::FILE* fp = std::fopen(manifestname.c_str(), "wb");
+	if (!fp)
+		throw(DefaultException("could not open manifest " + manifestname));
+
+	for (std::map<std::string, AssetFiles>::const_iterator it = assets.begin();
+		it != assets.end(); ++it)
+	{
+		// key is "<module> <offset>"
+		std::string::size_type space = it->first.find_last_of(' ');
+		const AssetFiles& files = it->second;
+		std::fprintf(fp, "%s %s %s %d %s\n", inputhash.c_str(), settingshash.c_str(),
+			it->first.substr(space + 1).c_str(), (int)files.names.size(),
+			it->first.substr(0, space).c_str());
+		for (size_t i = 0; i < files.names.size(); i++)
+			std::fprintf(fp, "%lld %s\n", files.sizes[i], files.names[i].c_str());
+	}
+
+	bool failed = (std::ferror(fp) != 0);
+	if (std::fclose(fp) != 0)
+		failed = true;
+	if (failed)
+		throw(DefaultException("error writing to manifest " + manifestname));
+}
+
+
+};	// end namespace RipUtil
@@ -0,0 +1,88 @@
+/* Output sink for incremental rips: it records which files each
+   asset of the input produced, and on the next run over the same
+   input with the same settings, tells the ripper to skip assets whose
+   files are all still on disk with the recorded sizes.
+   Assets are identified by ripping module and offset in the input
+   (plus a count, for an offset used more than once);
+   the manifest holding them is plain text:
+     <input hash> <settings hash> <offset> <number of files> <module>
+     <size> <filename>
+     ...
+   with one such block per asset */
+
+#include "OutputSink.h"
+#include <string>
+#include <vector>
+#include <map>
+
+namespace RipUtil
+{
+
+
+class IncrementalOutputSink : public OutputSink
+{
+public:
+	// manifestname: manifest of the last run, if any, replaced by
+	// flush(); inputname is hashed to tell when the input has
+	// changed, and settings is anything else the output depends on
+	IncrementalOutputSink(OutputSink& target, const std::string& manifestname,
+		const std::string& inputname, const std::string& settings);
+
+	// name of the module whose assets follow
+	void set_module(const std::string& module) { this->module = module; }
+
+	bool begin_asset(int offset);
+	void end_asset();
+	// write the new manifest, then flush the target
+	void flush();
+	// the manifest is only written by flush(), once per input
+	void sync() { target.sync(); }
+
+	int get_num_assets() const { return assets.size(); }
+	int get_num_skipped() const { return numskipped; }
+
+protected:
+	void open_file(const std::string& filename, long long size);
+	void write_bytes(const char* data, int n) { target.write(data, n); }
+	void close_file();
+	int copy_from_stream(MembufStream& stream, int n);
+	char* reserve_bytes(int n) { return target.reserve_write(n); }
+	void commit_bytes(int n) { target.commit_write(); }
+
+private:
+	// files written for one asset
+	struct AssetFiles
+	{
+		std::vector<std::string> names;
+		std::vector<long long> sizes;
+	};
+
+	void read_manifest();
+	// key of the asset at offset, for the current module
+	std::string get_asset_key(int offset);
+	// are all of the asset's files still on disk?
+	static bool files_current(const AssetFiles& files);
+
+	OutputSink& target;
+	std::string manifestname;
+	std::string inputhash;
+	std::string settingshash;
+	std::string module;
+
+	// assets from the last run with the same input and settings
+	std::map<std::string, AssetFiles> oldassets;
+	// assets of this run, ripped or carried over
+	std::map<std::string, AssetFiles> assets;
+	std::map<std::string, int> keycounts;
+	int numskipped;
+
+	// asset being ripped, if any
+	bool inasset;
+	std::string assetkey;
+	std::string filename;	// file being written
+};
+
+
+};	// end namespace RipUtil
+
+#pragma once
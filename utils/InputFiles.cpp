@@ -0,0 +1,186 @@
+#include "InputFiles.h"
+#include "IsoImage.h"
+#include "DefaultException.h"
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <set>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif
+
+namespace RipUtil
+{
+
+
+bool is_directory(const std::string& path)
+{
+#ifdef _WIN32
+	struct _stati64 st;
+	return _stati64(path.c_str(), &st) == 0 && (st.st_mode & _S_IFDIR);
+#else
+	struct stat st;
+	return stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+#endif
+}
+
+long long get_input_size(const std::string& path)
+{
+	IsoImage* image;
+	const IsoEntry* entry;
+	if (find_image_file(path, image, entry))
+		return entry->size;
+#ifdef _WIN32
+	struct _stati64 st;
+	if (_stati64(path.c_str(), &st) != 0)
+#else
+	struct stat st;
+	if (stat(path.c_str(), &st) != 0)
+#endif
+		return 0;
+	return st.st_size;
+}
+
+MembufStream* open_input(const std::string& path, int bufsize)
+{
+	IsoImage* image;
+	const IsoEntry* entry;
+	if (find_image_file(path, image, entry))
+	{
+		if (image->in_one_piece(*entry))
+			return new MembufStream(image->get_data(*entry), entry->size, path, MembufStream::view);
+		// a file in pieces is read from a copy of them, put together
+		std::vector<char> data(entry->size);
+		if (entry->size > 0)
+			image->copy_data(*entry, 0, entry->size, &data.front());
+		return new MembufStream(entry->size ? &data.front() : 0, entry->size, path);
+	}
+	return new MembufStream(path, MembufStream::rb, 0, bufsize);
+}
+
+// names of the entries of a directory, other than . and ..
+static void list_directory(const std::string& dir, std::vector<std::string>& names)
+{
+#ifdef _WIN32
+	WIN32_FIND_DATAA fd;
+	HANDLE h = FindFirstFileA((dir + "\\*").c_str(), &fd);
+	if (h == INVALID_HANDLE_VALUE)
+		throw(DefaultException("could not read directory " + dir));
+	do
+	{
+		std::string name = fd.cFileName;
+		if (name != "." && name != "..")
+			names.push_back(name);
+	} while (FindNextFileA(h, &fd));
+	FindClose(h);
+#else
+	DIR* d = opendir(dir.c_str());
+	if (!d)
+		throw(DefaultException("could not read directory " + dir));
+	while (dirent* ent = readdir(d))
+	{
+		std::string name = ent->d_name;
+		if (name != "." && name != "..")
+			names.push_back(name);
+	}
+	closedir(d);
+#endif
+}
+
+// what tells a file or directory apart, however it's reached (through
+// symlinks, other relative paths...): its device and inode, where there
+// are any
+static std::string get_file_id(const std::string& path)
+{
+#ifdef _WIN32
+	return path;
+#else
+	struct stat st;
+	if (stat(path.c_str(), &st) != 0)
+		return path;
+	return to_string((long long)st.st_dev) + ":" + to_string((long long)st.st_ino);
+#endif
+}
+
+// collect_input_files(), with the ids of the directories and lists
+// being expanded in expanding, to stop at one that contains itself
+static void collect_files(const std::string& arg, std::vector<std::string>& files,
+	std::set<std::string>& expanding)
+{
+	bool islist = (arg.size() > 1 && arg[0] == '@');
+	bool isdir = !islist && is_directory(arg);
+	std::string id;
+	if (islist || isdir)
+	{
+		id = get_file_id(islist ? arg.substr(1) : arg);
+		if (!expanding.insert(id).second)
+		{
+			std::cout << "Skipping " << arg << ": it's inside itself" << '\n';
+			return;
+		}
+	}
+
+	if (islist)
+	{
+		std::string listname = arg.substr(1);
+		std::ifstream ifs(listname.c_str());
+		if (!ifs.good())
+			throw(DefaultException("could not open input list " + listname));
+		std::string line;
+		while (std::getline(ifs, line))
+		{
+			// lists written on DOS keep their CRs
+			if (!line.empty() && line[line.size() - 1] == '\r')
+				line.erase(line.size() - 1);
+			if (!line.empty())
+				collect_files(line, files, expanding);
+		}
+	}
+	else if (isdir)
+	{
+		std::vector<std::string> names;
+		list_directory(arg, names);
+		std::sort(names.begin(), names.end());
+		std::string dir = arg;
+		if (dir[dir.size() - 1] != '/' && dir[dir.size() - 1] != '\\')
+			dir += '/';
+		for (size_t i = 0; i < names.size(); i++)
+		{
+			// skip the indexes saved next to inputs
+			const std::string& name = names[i];
+			size_t extlen = sizeof(index_extension) - 1;
+			if (name.size() > extlen && name.compare(name.size() - extlen, extlen, index_extension) == 0)
+				continue;
+			collect_files(dir + name, files, expanding);
+		}
+	}
+	else if (is_iso_image(arg))
+	{
+		IsoImage& image = get_iso_image(arg);
+		const std::vector<std::string>& skipped = image.get_skipped();
+		for (size_t i = 0; i < skipped.size(); i++)
+			std::cout << "Skipping " << arg << "/" << skipped[i] << '\n';
+		const std::vector<IsoEntry>& entries = image.get_entries();
+		for (size_t i = 0; i < entries.size(); i++)
+			files.push_back(arg + "/" + entries[i].path);
+	}
+	else
+		files.push_back(arg);
+
+	if (!id.empty())
+		expanding.erase(id);
+}
+
+void collect_input_files(const std::string& arg, std::vector<std::string>& files)
+{
+	std::set<std::string> expanding;
+	collect_files(arg, files, expanding);
+}
+
+
+};	// end namespace RipUtil
@@ -0,0 +1,37 @@
+/* Expanding input arguments into the list of files to rip:
+   a plain file, a directory (searched recursively), a disc image
+   (every file in it, see IsoImage.h) or @listfile (a text file naming
+   one input per line) */
+
+#include "MembufStream.h"
+#include <string>
+#include <vector>
+
+namespace RipUtil
+{
+
+
+// extension of the contents indexes saved next to inputs, which
+// aren't inputs themselves
+const static char index_extension[] = ".allrip-index";
+
+// is path an existing directory?
+bool is_directory(const std::string& path);
+
+// size of a file in bytes, or 0 if it can't be read
+long long get_input_size(const std::string& path);
+
+// open the input at path for reading; a file in a disc image is read
+// in place from the image, ignoring bufsize. The caller deletes the stream
+MembufStream* open_input(const std::string& path,
+	int bufsize = MembufStream::def_bufsize);
+
+// add the files named by arg to files; directories, disc images and
+// list files are expanded in name order. A directory or list inside
+// itself (through a symlink, or a list naming itself) is skipped there
+void collect_input_files(const std::string& arg, std::vector<std::string>& files);
+
+
+};	// end namespace RipUtil
+
+#pragma once
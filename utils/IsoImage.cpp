@@ -0,0 +1,392 @@
+#include "IsoImage.h"
+#include "DefaultException.h"
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <cstring>
+#include <mutex>
+#include <set>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace RipUtil
+{
+
+
+static std::string to_lower(std::string s)
+{
+	for (std::string::size_type i = 0; i < s.size(); i++)
+		s[i] = std::tolower((unsigned char)s[i]);
+	return s;
+}
+
+static long long get_le32(const char* p)
+{
+	const unsigned char* b = (const unsigned char*)p;
+	return (long long)b[0] | ((long long)b[1] << 8) | ((long long)b[2] << 16)
+		| ((long long)b[3] << 24);
+}
+
+// a Joliet name (UCS-2, big endian) in UTF-8
+static std::string from_ucs2(const char* p, int len)
+{
+	const unsigned char* b = (const unsigned char*)p;
+	std::string s;
+	for (int i = 0; i + 1 < len; i += 2)
+	{
+		int c = (b[i] << 8) | b[i + 1];
+		if (c < 0x80)
+			s += (char)c;
+		else if (c < 0x800)
+		{
+			s += (char)(0xC0 | (c >> 6));
+			s += (char)(0x80 | (c & 0x3F));
+		}
+		else
+		{
+			s += (char)(0xE0 | (c >> 12));
+			s += (char)(0x80 | ((c >> 6) & 0x3F));
+			s += (char)(0x80 | (c & 0x3F));
+		}
+	}
+	return s;
+}
+
+static bool entry_less(const IsoEntry& a, const IsoEntry& b)
+{
+	return a.path < b.path;
+}
+
+IsoImage::IsoImage(const std::string& filename)
+	: filename(filename), data(0), size(0), mtime(0)
+{
+#ifdef _WIN32
+	struct _stati64 st;
+	if (_stati64(filename.c_str(), &st) != 0)
+		throw(DefaultException("could not open image " + filename));
+	size = st.st_size;
+	mtime = st.st_mtime;
+	filehandle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, 0,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+	if (filehandle == INVALID_HANDLE_VALUE)
+		throw(DefaultException("could not open image " + filename));
+	maphandle = size ? CreateFileMappingA(filehandle, 0, PAGE_READONLY, 0, 0, 0) : 0;
+	if (maphandle)
+		data = (const char*)MapViewOfFile(maphandle, FILE_MAP_READ, 0, 0, 0);
+	if (!data)
+	{
+		if (maphandle)
+			CloseHandle(maphandle);
+		CloseHandle(filehandle);
+		throw(DefaultException("could not map image " + filename));
+	}
+#else
+	int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+	struct stat st;
+	if (fd < 0 || fstat(fd, &st) != 0)
+	{
+		if (fd >= 0)
+			::close(fd);
+		throw(DefaultException("could not open image " + filename));
+	}
+	size = st.st_size;
+	mtime = st.st_mtime;
+	void* map = size ? mmap(0, size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+	// the mapping holds the file open
+	::close(fd);
+	if (map == MAP_FAILED)
+		throw(DefaultException("could not map image " + filename));
+	data = (const char*)map;
+#endif
+
+	// find the root directory in the volume descriptors, preferring
+	// the Joliet one for its long names
+	const char* root = 0;
+	bool joliet = false;
+	for (int i = 0; i < IsoConsts::max_descriptors; i++)
+	{
+		long long pos = (long long)(IsoConsts::first_descriptor + i) * IsoConsts::sector_size;
+		if (pos + IsoConsts::sector_size > size)
+			break;
+		const char* desc = data + pos;
+		if (std::memcmp(desc + 1, "CD001", 5) != 0)
+			break;
+		unsigned char type = desc[0];
+		if (type == 255)
+			break;
+		if (type == 1 && !root)
+			root = desc + 156;
+		else if (type == 2 && desc[88] == '%' && desc[89] == '/'
+			&& (desc[90] == '@' || desc[90] == 'C' || desc[90] == 'E'))
+		{
+			root = desc + 156;
+			joliet = true;
+		}
+	}
+	if (!root)
+	{
+		unmap();
+		throw(DefaultException(filename + " is not an ISO9660 image"));
+	}
+
+	std::set<long long> dirsread;
+	read_directory(get_le32(root + 2), get_le32(root + 10), "", joliet, 0, dirsread);
+	std::sort(entries.begin(), entries.end(), entry_less);
+	for (size_t i = 0; i < entries.size(); i++)
+		lookup[to_lower(entries[i].path)] = i;
+}
+
+IsoImage::~IsoImage()
+{
+	unmap();
+}
+
+void IsoImage::unmap()
+{
+	if (!data)
+		return;
+#ifdef _WIN32
+	UnmapViewOfFile(data);
+	CloseHandle(maphandle);
+	CloseHandle(filehandle);
+#else
+	munmap((void*)data, size);
+#endif
+	data = 0;
+}
+
+void IsoImage::read_directory(long long extent, long long dirsize, const std::string& prefix,
+	bool joliet, int depth, std::set<long long>& dirsread)
+{
+	long long start = extent * IsoConsts::sector_size;
+	// a damaged image can list a directory more than once
+	if (depth > IsoConsts::max_depth || start >= size || !dirsread.insert(extent).second)
+		return;
+	dirsize = std::min(dirsize, size - start);
+
+	// a file in several extents has a record for each, in order, all but
+	// the last flagged; the parts read so far of the one being listed
+	std::string partpath;
+	std::vector<IsoExtent> parts;
+	bool interleaved = false;
+
+	long long pos = 0;
+	while (pos < dirsize)
+	{
+		const char* rec = data + start + pos;
+		int reclen = (unsigned char)rec[0];
+		// records don't cross sectors; the rest of one is zeroes
+		if (reclen == 0)
+		{
+			pos = (pos / IsoConsts::sector_size + 1) * IsoConsts::sector_size;
+			continue;
+		}
+		int namelen = (unsigned char)rec[32];
+		if (reclen < 34 || pos + reclen > dirsize || 33 + namelen > reclen)
+			break;
+		pos += reclen;
+
+		// skip . and ..
+		if (namelen == 1 && (rec[33] == 0 || rec[33] == 1))
+			continue;
+		std::string name = joliet ? from_ucs2(rec + 33, namelen)
+			: std::string(rec + 33, namelen);
+		// drop the version and the dot of names without an extension
+		std::string::size_type version = name.find(';');
+		if (version != std::string::npos)
+			name.erase(version);
+		if (!name.empty() && name[name.size() - 1] == '.')
+			name.erase(name.size() - 1);
+		if (name.empty())
+			continue;
+
+		long long fileextent = get_le32(rec + 2);
+		long long filesize = get_le32(rec + 10);
+		int flags = (unsigned char)rec[25];
+		std::string path = prefix + name;
+		// parts of a file whose last extent never came
+		if (!partpath.empty() && (path != partpath || (flags & 0x02)))
+		{
+			skipped.push_back(partpath + ": its last extent is missing");
+			partpath.clear();
+		}
+		if (flags & 0x02)
+		{
+			read_directory(fileextent, filesize, prefix + name + "/", joliet, depth + 1,
+				dirsread);
+			continue;
+		}
+		if (partpath.empty())
+		{
+			parts.clear();
+			interleaved = false;
+		}
+		IsoExtent part;
+		part.offset = fileextent * IsoConsts::sector_size;
+		part.size = filesize;
+		parts.push_back(part);
+		if (rec[26] != 0)
+			interleaved = true;
+		if (flags & 0x80)
+		{
+			partpath = path;
+			continue;
+		}
+		partpath.clear();
+		add_entry(path, parts, interleaved);
+	}
+	if (!partpath.empty())
+		skipped.push_back(partpath + ": its last extent is missing");
+}
+
+void IsoImage::add_entry(const std::string& path, const std::vector<IsoExtent>& parts,
+	bool interleaved)
+{
+	if (interleaved)
+	{
+		skipped.push_back(path + ": interleaved files aren't supported");
+		return;
+	}
+	// join extents that follow each other in the image
+	std::vector<IsoExtent> pieces;
+	long long filesize = 0;
+	for (size_t i = 0; i < parts.size(); i++)
+	{
+		if (parts[i].offset + parts[i].size > size)
+		{
+			skipped.push_back(path + ": it's past the end of the image");
+			return;
+		}
+		filesize += parts[i].size;
+		if (!pieces.empty() && pieces.back().offset + pieces.back().size == parts[i].offset)
+			pieces.back().size += parts[i].size;
+		else
+			pieces.push_back(parts[i]);
+	}
+	if (filesize > INT_MAX)
+	{
+		skipped.push_back(path + ": it's too big");
+		return;
+	}
+
+	IsoEntry entry;
+	entry.path = path;
+	entry.offset = pieces.empty() ? 0 : pieces[0].offset;
+	entry.size = filesize;
+	if (pieces.size() > 1)
+		entry.extents = pieces;
+	entries.push_back(entry);
+}
+
+void IsoImage::copy_data(const IsoEntry& entry, int pos, int n, char* out) const
+{
+	if (entry.extents.empty())
+	{
+		std::memcpy(out, data + entry.offset + pos, n);
+		return;
+	}
+	for (size_t i = 0; i < entry.extents.size() && n > 0; i++)
+	{
+		const IsoExtent& extent = entry.extents[i];
+		if (pos >= extent.size)
+		{
+			pos -= extent.size;
+			continue;
+		}
+		int count = (int)std::min((long long)n, extent.size - pos);
+		std::memcpy(out, data + extent.offset + pos, count);
+		out += count;
+		n -= count;
+		pos = 0;
+	}
+}
+
+const IsoEntry* IsoImage::find(const std::string& path) const
+{
+	std::string key = to_lower(path);
+	std::replace(key.begin(), key.end(), '\\', '/');
+	std::map<std::string, int>::const_iterator it = lookup.find(key);
+	if (it == lookup.end())
+		return 0;
+	return &entries[it->second];
+}
+
+bool is_iso_image(const std::string& path)
+{
+	if (path.size() < 4 || to_lower(path.substr(path.size() - 4)) != ".iso")
+		return false;
+#ifdef _WIN32
+	struct _stati64 st;
+	return _stati64(path.c_str(), &st) == 0 && (st.st_mode & _S_IFREG);
+#else
+	struct stat st;
+	return stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode);
+#endif
+}
+
+// images mapped so far, unmapped at exit
+struct OpenImages
+{
+	~OpenImages()
+	{
+		for (std::map<std::string, IsoImage*>::iterator it = images.begin();
+			it != images.end(); ++it)
+		{
+			delete it->second;
+		}
+	}
+
+	std::map<std::string, IsoImage*> images;
+	std::mutex mutex;
+};
+
+static OpenImages open_images;
+
+IsoImage& get_iso_image(const std::string& filename)
+{
+	std::lock_guard<std::mutex> lock(open_images.mutex);
+	IsoImage*& image = open_images.images[filename];
+	if (!image)
+	{
+		try
+		{
+			image = new IsoImage(filename);
+		}
+		catch (...)
+		{
+			open_images.images.erase(filename);
+			throw;
+		}
+	}
+	return *image;
+}
+
+bool find_image_file(const std::string& path, IsoImage*& image, const IsoEntry*& entry)
+{
+	// the image is the part of the path up to the first component
+	// that is one
+	std::string::size_type sep = path.find_first_of("/\\");
+	while (sep != std::string::npos)
+	{
+		std::string prefix = path.substr(0, sep);
+		if (is_iso_image(prefix))
+		{
+			image = &get_iso_image(prefix);
+			entry = image->find(path.substr(sep + 1));
+			return entry != 0;
+		}
+		sep = path.find_first_of("/\\", sep + 1);
+	}
+	return false;
+}
+
+
+};	// end namespace RipUtil
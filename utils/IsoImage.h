@@ -0,0 +1,112 @@
+/* Reading inputs straight out of ISO9660 disc images (.iso), without
+   extracting them: an image is mapped into memory once, and each file
+   in it is a slice of the mapping, read in place.
+   A file in an image is named by the image's path followed by its path
+   in the image, e.g. "disc.iso/DATA/GAME.HE1". Names come from the
+   Joliet directory tree when the image has one, and are matched without
+   regard to case. A file recorded in several extents is one file; when
+   the extents don't follow each other in the image, it's read by copying
+   them together */
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+
+namespace RipUtil
+{
+
+
+namespace IsoConsts
+{
+	const static int sector_size = 2048;
+	const static int first_descriptor = 16;		// sector of the first volume descriptor
+	const static int max_descriptors = 64;		// most volume descriptors looked at
+	const static int max_depth = 32;			// deepest directory followed
+};
+
+// a piece of a file in an image
+struct IsoExtent
+{
+	long long offset;	// offset in the image
+	long long size;
+};
+
+// a file in an image
+struct IsoEntry
+{
+	std::string path;	// path in the image, '/' separated
+	long long offset;	// offset of its data in the image
+	int size;
+	// its pieces in file order, when it isn't in one piece of the
+	// image; empty when it is
+	std::vector<IsoExtent> extents;
+};
+
+class IsoImage
+{
+public:
+	// map the image at filename and read its directory tree; throws
+	// if it can't be opened or isn't ISO9660
+	IsoImage(const std::string& filename);
+	~IsoImage();
+
+	std::string get_fname() const { return filename; }
+	long long get_mtime() const { return mtime; }
+	// files in the image, in path order
+	const std::vector<IsoEntry>& get_entries() const { return entries; }
+	// the file at path in the image (any case), or 0 if there's none
+	const IsoEntry* find(const std::string& path) const;
+	// files in the image that can't be read, each as "path: why"
+	const std::vector<std::string>& get_skipped() const { return skipped; }
+	// is the data of entry in one piece of the mapping?
+	bool in_one_piece(const IsoEntry& entry) const { return entry.extents.empty(); }
+	// the data of entry, in place in the mapping; only for an entry in
+	// one piece
+	const char* get_data(const IsoEntry& entry) const { return data + entry.offset; }
+	// copy n bytes of entry's data, from pos on, to out, from whichever
+	// pieces they're in
+	void copy_data(const IsoEntry& entry, int pos, int n, char* out) const;
+
+private:
+	IsoImage(const IsoImage&);
+	IsoImage& operator=(const IsoImage&);
+
+	// add the files in the directory of dirsize bytes at sector extent
+	// to entries, their paths starting with prefix; dirsread holds the
+	// directories read so far
+	void read_directory(long long extent, long long dirsize, const std::string& prefix,
+		bool joliet, int depth, std::set<long long>& dirsread);
+	// add the file at path made of parts, or note why it can't be read
+	void add_entry(const std::string& path, const std::vector<IsoExtent>& parts,
+		bool interleaved);
+	void unmap();
+
+	std::string filename;
+	const char* data;		// the mapped image
+	long long size;
+	long long mtime;
+	std::vector<IsoEntry> entries;
+	std::vector<std::string> skipped;
+	std::map<std::string, int> lookup;	// lowercased path to entry
+#ifdef _WIN32
+	void* filehandle;
+	void* maphandle;
+#endif
+};
+
+// is path an image file (by its extension)?
+bool is_iso_image(const std::string& path);
+
+// the image at filename, mapped on first use and kept for the rest of
+// the process; throws as IsoImage() does
+IsoImage& get_iso_image(const std::string& filename);
+
+// if path names a file in an image, point image and entry to it and
+// return true
+bool find_image_file(const std::string& path, IsoImage*& image, const IsoEntry*& entry);
+
+
+};	// end namespace RipUtil
+
+#pragma once
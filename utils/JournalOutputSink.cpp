@@ -0,0 +1,141 @@
+#include "JournalOutputSink.h"
+#include "Checksums.h"
+#include "DatManip.h"
+#include "DefaultException.h"
+#include <vector>
+
+namespace RipUtil
+{
+
+
+JournalOutputSink::JournalOutputSink(OutputSink& target, const std::string& journalname,
+	const std::string& inputname, const std::string& settings)
+	: target(target), journalname(journalname), fp(0), numskipped(0)
+{
+	XXHash64 settingshash;
+	settingshash.update(settings.c_str(), settings.size());
+	char header[64];
+	std::sprintf(header, "journal %016llx %016llx", xxhash64_file(inputname),
+		settingshash.digest());
+
+	read_journal(header);
+
+	// rewrite the journal with just its complete records, dropping any
+	// partial one left by the interruption, then append to it
+	fp = std::fopen(journalname.c_str(), "wb");
+	if (!fp)
+		throw(DefaultException("could not open journal " + journalname));
+	std::fprintf(fp, "%s\n", header);
+	for (std::map<std::string, std::string>::const_iterator it = doneunits.begin();
+		it != doneunits.end(); ++it)
+		write_record(it->first, it->second);
+	std::fflush(fp);
+}
+
+JournalOutputSink::~JournalOutputSink()
+{
+	if (fp)
+		std::fclose(fp);
+}
+
+void JournalOutputSink::read_journal(const std::string& header)
+{
+	std::FILE* in = std::fopen(journalname.c_str(), "rb");
+	if (!in)
+		return;
+
+	std::vector<char> line(header.size() + 2);
+	if (!std::fgets(&line.front(), line.size(), in)
+		|| std::string(&line.front()) != header + "\n")
+	{
+		// a journal for some other input or settings
+		std::fclose(in);
+		return;
+	}
+
+	char module[256];
+	int offset;
+	int statelen;
+	while (std::fscanf(in, "unit %d %d %255[^\n]", &offset, &statelen, module) == 3)
+	{
+		if (statelen < 0 || std::fgetc(in) != '\n')
+			break;
+		size_t statesize = statelen;
+		std::string state(statesize, 0);
+		if (statesize && std::fread(&state[0], 1, statesize, in) != statesize)
+			break;
+		if (std::fgetc(in) != '\n')
+			break;
+		doneunits[std::string(module) + " " + to_string(offset)] = state;
+	}
+	std::fclose(in);
+}
+
+void JournalOutputSink::write_record(const std::string& key, const std::string& state)
+{
+	// key is "<module> <offset>"
+	std::string::size_type space = key.find_last_of(' ');
+	std::fprintf(fp, "unit %s %d %s\n", key.substr(space + 1).c_str(),
+		(int)state.size(), key.substr(0, space).c_str());
+	std::fwrite(state.c_str(), 1, state.size(), fp);
+	std::fputc('\n', fp);
+}
+
+std::string JournalOutputSink::get_unit_key(int offset)
+{
+	std::string key = module + " " + to_string(offset);
+	++keycounts[key];
+	return key;
+}
+
+bool JournalOutputSink::begin_unit(int offset, std::string& state)
+{
+	unitkey = get_unit_key(offset);
+	// an offset seen again can't be told apart in the journal
+	if (keycounts[unitkey] > 1)
+	{
+		unitkey = "";
+		return true;
+	}
+
+	std::map<std::string, std::string>::const_iterator it = doneunits.find(unitkey);
+	if (it == doneunits.end())
+		return true;
+
+	state = it->second;
+	unitkey = "";
+	++numskipped;
+	return false;
+}
+
+void JournalOutputSink::end_unit(const std::string& state)
+{
+	if (unitkey.empty())
+		return;
+
+	// the unit's output has to be written before it's recorded; the
+	// rest of what flush() does waits for the end of the input
+	target.sync();
+	write_record(unitkey, state);
+	if (std::fflush(fp) != 0)
+		throw(DefaultException("error writing to journal " + journalname));
+	unitkey = "";
+}
+
+void JournalOutputSink::remove_journal()
+{
+	if (fp)
+		std::fclose(fp);
+	fp = 0;
+	std::remove(journalname.c_str());
+}
+
+int JournalOutputSink::copy_from_stream(MembufStream& stream, int n)
+{
+	long long before = target.get_file_size();
+	target.write_from(stream, n);
+	return target.get_file_size() - before;
+}
+
+
+};	// end namespace RipUtil
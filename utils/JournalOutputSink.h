@@ -0,0 +1,78 @@
+/* Output sink for resumable rips: as each unit of the input (a room,
+   an object...) is finished, a record of it is appended to a journal,
+   and a rerun over the same input with the same settings skips the
+   units it lists. Before a unit is recorded, all of its output is
+   synced to the target (see OutputSink::sync()), so a run killed at
+   any point leaves only complete units in the journal.
+   The journal starts with the line
+     journal <input hash> <settings hash>
+   followed by one record per finished unit:
+     unit <offset> <state length> <module>
+     <state>
+   where state is any data the module needs from a unit it skips */
+
+#include "OutputSink.h"
+#include <string>
+#include <map>
+#include <cstdio>
+
+namespace RipUtil
+{
+
+
+class JournalOutputSink : public OutputSink
+{
+public:
+	// continue the journal in journalname if it is for the same input
+	// and settings, or start a new one
+	JournalOutputSink(OutputSink& target, const std::string& journalname,
+		const std::string& inputname, const std::string& settings);
+	~JournalOutputSink();
+
+	// name of the module whose units follow
+	void set_module(const std::string& module) { this->module = module; }
+
+	bool begin_asset(int offset) { return target.begin_asset(offset); }
+	void end_asset() { target.end_asset(); }
+	bool begin_unit(int offset, std::string& state);
+	void end_unit(const std::string& state);
+	void flush() { target.flush(); }
+	void sync() { target.sync(); }
+
+	// the run is complete: delete the journal
+	void remove_journal();
+
+	int get_num_skipped() const { return numskipped; }
+
+protected:
+	void open_file(const std::string& filename, long long size) { target.open(filename, size); }
+	void write_bytes(const char* data, int n) { target.write(data, n); }
+	void close_file() { target.close(); }
+	int copy_from_stream(MembufStream& stream, int n);
+	char* reserve_bytes(int n) { return target.reserve_write(n); }
+	void commit_bytes(int n) { target.commit_write(); }
+
+private:
+	// load the records of an existing journal, if it's ours
+	void read_journal(const std::string& header);
+	void write_record(const std::string& key, const std::string& state);
+	// key of the unit at offset, for the current module
+	std::string get_unit_key(int offset);
+
+	OutputSink& target;
+	std::string journalname;
+	std::FILE* fp;
+	std::string module;
+
+	// units finished by an earlier run, and their saved state
+	std::map<std::string, std::string> doneunits;
+	std::map<std::string, int> keycounts;
+	int numskipped;
+
+	std::string unitkey;	// unit being ripped
+};
+
+
+};	// end namespace RipUtil
+
+#pragma once
@@ -1,5 +1,6 @@
 #include "MembufStream.h"
 #include "DatManip.h"
+#include "DefaultException.h"
 #include <fstream>
 #include <algorithm>
 #include <cstring>
@@ -19,6 +20,9 @@ MembufStream::MembufStream(const std::string& fname, Fmode mode, char decoder, i
 		stream.open(fname.c_str(), std::ios_base::binary);
 		fmode = mode;
 		break;
+	// data in memory is passed to the other constructors
+	case MembufStream::mem: case MembufStream::view:
+		throw(DefaultException("no data in memory given for " + fname));
 	}
 	if (!stream.good()) throw(FileOpenException(fname));
 	// get filesize
@@ -44,36 +48,66 @@ MembufStream::MembufStream(const std::string& fname, Fmode mode, char decoder, i
 	}
 }
 
+MembufStream::MembufStream(const char* data, int size, const std::string& name, char decoder)
+	: buf(0), filename(name), bufsize(0), eof_flag(false), decoding_byte(decoder)
+{
+	buffer_data(data, size, mem);
+}
+
+MembufStream::MembufStream(const char* data, int size, const std::string& name,
+	Fmode mode, char decoder)
+	: buf(0), filename(name), bufsize(0), eof_flag(false), decoding_byte(decoder)
+{
+	buffer_data(data, size, mode == view ? view : mem);
+}
+
 MembufStream::~MembufStream() 
 {
-	delete[] buf;
+	if (fmode != view)
+		delete[] buf;
+}
+
+void MembufStream::buffer_data(const char* data, int size, Fmode mode)
+{
+	fmode = mode;
+	fsize = std::max(0, size);
+	maxbufsize = fsize;
+	// the whole input is buffered once, and never refilled
+	if (fmode == view)
+		buf = const_cast<char*>(data);
+	else
+	{
+		buf = new char[fsize];
+		if (fsize > 0)
+			std::memcpy(buf, data, fsize);
+	}
+	bufsize = fsize;
+	gpos = 0;
+	buf_gpos = 0;
 }
 
 char* MembufStream::fill_buffer(int pos) 
 {
-	// calculate size of new buffer
-	int nextbufpos = pos + maxbufsize;
-	if (nextbufpos <= fsize) 
-		stream.seekg(nextbufpos);
-	else 
-		stream.seekg(0, stream.end);
-	int newsize = (int)stream.tellg() - pos;
+	if (fmode != rb)
+		return buf;
+	// the new buffer ends at the end of the file at most
+	pos = std::max(0, std::min(pos, fsize));
+	int newsize = std::min(maxbufsize, fsize - pos);
 	// clear buffer and read new data
 	delete[] buf;
+	buf = 0;
+	bufsize = 0;
 	if (newsize > 0) 
 	{
 		buf = new char[newsize];
 		bufsize = newsize;
+		// a read that failed before mustn't keep this one from seeking
+		stream.clear();
 		stream.seekg(pos);
 		stream.read(buf, newsize);
 		eof_clear();
-		return buf;
-	}
-	else 
-	{
-		bufsize = 0;
-		return 0;
 	}
+	return buf;
 }
 
 int MembufStream::seekg(int pos) 
@@ -139,6 +173,12 @@ int MembufStream::seek_bytes(const char* b, int n)
 
 char MembufStream::get() 
 {
+	// there's no byte at the end of the file
+	if (buf_gpos >= bufsize)
+	{
+		eof_flag = true;
+		return 0;
+	}
 	char c = buf[buf_gpos];
 	advanceg();
 	if (decoding_byte == 0)
@@ -149,7 +189,7 @@ char MembufStream::get()
 
 char MembufStream::reverse_get() 
 {
-	char c = buf[buf_gpos];
+	char c = buf_gpos < bufsize ? buf[buf_gpos] : 0;
 	rewindg();
 	if (decoding_byte == 0)
 		return c;
@@ -157,6 +197,12 @@ char MembufStream::reverse_get()
 		return decode_byte(c);
 }
 
+const char* MembufStream::peek(int& n)
+{
+	n = std::max(0, std::min(n, bufsize - buf_gpos));
+	return buf + buf_gpos;
+}
+
 MembufStream& MembufStream::read(char* s, int n, DatManip::End e) 
 {
 	int remaining = n;
@@ -166,6 +212,13 @@ MembufStream& MembufStream::read(char* s, int n, DatManip::End e)
 		// copy to end of buffer
 		int bytestocopy = std::min(bufsize - buf_gpos, remaining);
 		char* start = f - remaining;
+		// past the end of the file, the rest reads as zeroes
+		if (bytestocopy <= 0)
+		{
+			std::memset(start, 0, remaining);
+			eof_flag = true;
+			break;
+		}
 		memcpy(start, buf + buf_gpos, bytestocopy);
 		advanceg(bytestocopy);
 		remaining -= bytestocopy;
@@ -197,6 +250,15 @@ int MembufStream::read_int(int n, DatManip::End e)
 
 int MembufStream::reset()
 {
+	// nothing to reopen
+	if (fmode != rb)
+	{
+		decoding_byte = 0;
+		gpos = 0;
+		buf_gpos = 0;
+		return gpos;
+	}
+
 	stream.close();
 	if (eof()) eof_clear();
 	decoding_byte = 0;
@@ -221,6 +283,14 @@ int MembufStream::reset()
 	return gpos;
 }
 
+int MembufStream::rewind()
+{
+	clear();
+	decoding_byte = 0;
+	seekg(0);
+	return gpos;
+}
+
 char MembufStream::decode_byte(char& byte) 
 {
 	return byte ^= decoding_byte;
@@ -228,24 +298,27 @@ char MembufStream::decode_byte(char& byte)
 
 int MembufStream::advanceg(int num) 
 {
-	for (int i = 0; i < num; i++) 
+	// can't advance past EOF
+	num = std::min(num, fsize - gpos);
+	while (num > 0) 
 	{
-		// can't advance past EOF
-		if (gpos != fsize) 
+		// step to the end of the buffer at most
+		int step = std::min(num, bufsize - buf_gpos);
+		if (step <= 0)
+			break;
+		gpos += step;
+		buf_gpos += step;
+		num -= step;
+		// if we advanced past end of buf, rebuffer
+		if (buf_gpos >= bufsize && gpos != fsize) 
 		{
-			gpos += 1;
-			buf_gpos += 1;
-			// if we advanced past end of buf, rebuffer
-			if (buf_gpos >= bufsize && gpos != fsize) 
-			{
-				fill_buffer(gpos);
-				buf_gpos = 0;
-			}
-			// if we hit EOF, set EOF flag
-			else if (gpos >= fsize) 
-			{
-				eof_flag = true;
-			}
+			fill_buffer(gpos);
+			buf_gpos = 0;
+		}
+		// if we hit EOF, set EOF flag
+		else if (gpos >= fsize) 
+		{
+			eof_flag = true;
 		}
 	}
 	return buf_gpos;
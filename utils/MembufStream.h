@@ -28,11 +28,21 @@ public:
 	// file access modes
 	enum Fmode 
 	{ 
-		rb
+		rb,
+		mem,	// reading a copy of data already in memory
+		view	// reading data already in memory in place
 	};
 
 	MembufStream(const std::string& fname, Fmode mode, char decoder = 0,
 		int buffersize = def_bufsize);
+	// read from a copy of size bytes of data; name stands in for
+	// the filename
+	MembufStream(const char* data, int size, const std::string& name,
+		char decoder = 0);
+	// read size bytes of data as mode says: a copy (mem) or in place
+	// (view), in which case data must outlive the stream
+	MembufStream(const char* data, int size, const std::string& name,
+		Fmode mode, char decoder = 0);
 	~MembufStream();
 	
 	std::string get_fname() { return filename; }
@@ -43,6 +53,8 @@ public:
 	int tellg() { return gpos; }
 	int get_buf_gpos() { return buf_gpos; }
 	char get_decoding_byte() { return decoding_byte; }
+	// is the input in memory rather than read from a file?
+	bool in_memory() { return fmode != rb; }
 
 	void set_decoding_byte(char new_decoding_byte) 
 	{ 
@@ -69,11 +81,17 @@ public:
 	// the position of the next occurence or EOF if none
 	int seek_bytes(const char* b, int n);
 
-	// return current char and increment get position
+	// return current char and increment get position; at end of
+	// file, return 0 and set eof
 	char get();
 	// return current char and decrement get position
 	char reverse_get();
-	// read n chars into s
+	// return a pointer to the buffered bytes at the get position
+	// without advancing it; n is reduced to the number available
+	// in the buffer. bytes are returned as stored (not decoded)
+	const char* peek(int& n);
+	// read n chars into s; those past end of file are zeroes, and
+	// set eof
 	MembufStream& read(char* s, int n, DatManip::End e = DatManip::be);
 	// read n chars and return the result as an int of the
 	// specified endianess
@@ -81,6 +99,9 @@ public:
 	// close and reopen file stream, resetting buffers/filepos
 	// return new buf_gpos (should always be 0)
 	int reset();
+	// return to file start and clear the decoding byte, like reset,
+	// but keep the buffer instead of reading the file again
+	int rewind();
 
 private:
 	MembufStream(const MembufStream&);
@@ -110,6 +131,8 @@ private:
 	bool eof_clear();
 	// decode an XORed byte
 	char decode_byte(char& byte);
+	// buffer size bytes of data, as mode says
+	void buffer_data(const char* data, int size, Fmode mode);
 };
 
 
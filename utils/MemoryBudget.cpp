@@ -0,0 +1,76 @@
+#include "MemoryBudget.h"
+#include <map>
+#include <mutex>
+
+namespace RipUtil
+{
+
+
+static long long memory_budget = MemoryBudgetConsts::unlimited;
+static std::map<std::string, int> budget_fallbacks;
+static std::mutex budget_fallbacks_mutex;
+
+void set_memory_budget(long long bytes)
+{
+	memory_budget = (bytes < 0) ? MemoryBudgetConsts::unlimited : bytes;
+}
+
+long long get_memory_budget()
+{
+	return memory_budget;
+}
+
+long long get_budget_share(int share)
+{
+	if (memory_budget == MemoryBudgetConsts::unlimited)
+		return MemoryBudgetConsts::unlimited;
+	return memory_budget / share;
+}
+
+void count_budget_fallback(const std::string& what)
+{
+	std::lock_guard<std::mutex> lock(budget_fallbacks_mutex);
+	++budget_fallbacks[what];
+}
+
+void print_budget_fallbacks(std::ostream& ostr)
+{
+	std::lock_guard<std::mutex> lock(budget_fallbacks_mutex);
+	for (std::map<std::string, int>::const_iterator it = budget_fallbacks.begin();
+		it != budget_fallbacks.end(); ++it)
+	{
+		ostr << "Memory budget: " << it->first << " (" << it->second << "x)" << '\n';
+	}
+}
+
+void save_budget_fallbacks(std::ostream& ostr)
+{
+	std::lock_guard<std::mutex> lock(budget_fallbacks_mutex);
+	for (std::map<std::string, int>::const_iterator it = budget_fallbacks.begin();
+		it != budget_fallbacks.end(); ++it)
+	{
+		ostr << "budget " << it->second << ' ' << it->first << '\n';
+	}
+}
+
+void load_budget_fallbacks(std::istream& istr)
+{
+	std::lock_guard<std::mutex> lock(budget_fallbacks_mutex);
+	// lines "budget <count> <what>", up to the first that isn't one
+	istr >> std::ws;
+	while (istr.peek() == 'b')
+	{
+		std::string tag;
+		int count;
+		std::string what;
+		if (!(istr >> tag >> count) || tag != "budget")
+			break;
+		istr.get();
+		std::getline(istr, what);
+		budget_fallbacks[what] += count;
+		istr >> std::ws;
+	}
+}
+
+
+};	// end namespace RipUtil
@@ -0,0 +1,49 @@
+/* Memory budget for a run (--max-memory): the parts of a rip that can
+   hold the most memory at once -- the input buffer, a room's worth of
+   decoded chunks, output waiting to be written, looped audio -- each
+   get a share of it, and take a slower path rather than go over.
+   The times they do are counted, for the report at the end of the run */
+
+#include <string>
+#include <ostream>
+#include <istream>
+
+namespace RipUtil
+{
+
+
+namespace MemoryBudgetConsts
+{
+	const static long long unlimited = -1;
+	// shares of the budget, as the fraction 1/share
+	const static int input_share = 4;	// buffered input
+	const static int unit_share = 2;	// a room or other unit, decoded
+	const static int queue_share = 4;	// output waiting to be written
+	// smallest window worth reading the input through
+	const static int min_input_window = 1048576;
+};
+
+// set the budget in bytes (or unlimited)
+void set_memory_budget(long long bytes);
+long long get_memory_budget();
+
+// most bytes something taking its 1/share of the budget may use,
+// or unlimited
+long long get_budget_share(int share);
+
+// count a slower path taken to stay within the budget, described
+// by what (e.g. "input read through a window")
+void count_budget_fallback(const std::string& what);
+
+// print how often each slower path was taken
+void print_budget_fallbacks(std::ostream& ostr);
+
+// pass the counts from one process to another: save_budget_fallbacks()
+// writes them in a form load_budget_fallbacks() adds to its own
+void save_budget_fallbacks(std::ostream& ostr);
+void load_budget_fallbacks(std::istream& istr);
+
+
+};	// end namespace RipUtil
+
+#pragma once
@@ -0,0 +1,281 @@
+#include "OutputSink.h"
+#include "DefaultException.h"
+#include <algorithm>
+#include <cstring>
+
+#ifdef __linux__
+#include <sys/sendfile.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace RipUtil
+{
+
+
+void OutputSink::write_file(const std::string& filename, const char* data, int n)
+{
+	open(filename, n);
+	if (n > 0)
+		write(data, n);
+	close();
+}
+
+void OutputSink::write_file_from(const std::string& filename, MembufStream& stream, int n)
+{
+	open(filename, std::max(0, std::min(n, stream.get_fsize() - stream.tellg())));
+	write_from(stream, n);
+	close();
+}
+
+int OutputSink::copy_from_stream(MembufStream& stream, int n)
+{
+	n = std::max(0, std::min(n, stream.get_fsize() - stream.tellg()));
+
+	// encoded input has to be decoded on the way through
+	if (stream.get_decoding_byte() != 0)
+	{
+		char* chunk = new char[OutputSinkConsts::copy_chunk_size];
+		for (int remaining = n; remaining > 0; )
+		{
+			int len = std::min(remaining, OutputSinkConsts::copy_chunk_size);
+			stream.read(chunk, len);
+			write_bytes(chunk, len);
+			remaining -= len;
+		}
+		delete[] chunk;
+		return n;
+	}
+
+	// otherwise write straight out of the stream's buffer
+	for (int remaining = n; remaining > 0; )
+	{
+		int len = remaining;
+		const char* data = stream.peek(len);
+		if (len <= 0)
+			return n - remaining;
+		write_bytes(data, len);
+		stream.seek_off(len);
+		remaining -= len;
+	}
+	return n;
+}
+
+char* OutputSink::reserve_bytes(int n)
+{
+	if ((int)scratch.size() < n)
+		scratch.resize(n);
+	return scratch.empty() ? 0 : &scratch.front();
+}
+
+void OutputSink::commit_bytes(int n)
+{
+	write_bytes(scratch.empty() ? 0 : &scratch.front(), n);
+}
+
+FileOutputSink::~FileOutputSink()
+{
+	if (fp)
+		std::fclose(fp);
+#ifdef __linux__
+	if (map)
+		munmap(map, mapsize);
+	if (outfd >= 0)
+		::close(outfd);
+	if (infd >= 0)
+		::close(infd);
+#endif
+}
+
+void FileOutputSink::open_file(const std::string& filename, long long size)
+{
+	// a writer may have thrown before closing its last file
+	if (fp)
+		std::fclose(fp);
+	fp = 0;
+#ifdef __linux__
+	if (map)
+	{
+		munmap(map, mapsize);
+		map = 0;
+	}
+	if (outfd >= 0)
+	{
+		::close(outfd);
+		outfd = -1;
+	}
+#endif
+
+	outname = filename;
+	if (size >= OutputSinkConsts::mmap_min_size && open_mapped(size))
+		return;
+	fp = std::fopen(filename.c_str(), "wb");
+	if (!fp) throw(DefaultException("error writing to file " + filename));
+}
+
+bool FileOutputSink::open_mapped(long long size)
+{
+#ifdef __linux__
+	int fd = ::open(outname.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd < 0)
+		return false;
+	// allocate the blocks up front, so filling the mapping can't fail
+	// on a full disk; where that isn't supported, stdio is used instead,
+	// as a sparse mapping would fault rather than report a full disk
+	if (fallocate(fd, 0, 0, size) != 0)
+	{
+		::close(fd);
+		return false;
+	}
+	void* p = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (p == MAP_FAILED)
+	{
+		::close(fd);
+		return false;
+	}
+	outfd = fd;
+	map = (char*)p;
+	mapsize = size;
+	mappos = 0;
+	return true;
+#else
+	return false;
+#endif
+}
+
+void FileOutputSink::unmap_to_stream()
+{
+#ifdef __linux__
+	munmap(map, mapsize);
+	map = 0;
+	if (ftruncate(outfd, mappos) != 0 || lseek(outfd, mappos, SEEK_SET) != mappos)
+		throw(DefaultException("error writing to file " + outname));
+	fp = fdopen(outfd, "wb");
+	if (!fp) throw(DefaultException("error writing to file " + outname));
+	outfd = -1;
+#endif
+}
+
+void FileOutputSink::write_bytes(const char* data, int n)
+{
+	if (map)
+	{
+		if (mappos + n <= mapsize)
+		{
+			std::memcpy(map + mappos, data, n);
+			mappos += n;
+			return;
+		}
+		unmap_to_stream();
+	}
+	if ((int)std::fwrite(data, 1, n, fp) != n)
+		throw(DefaultException("error writing to file " + outname));
+}
+
+char* FileOutputSink::reserve_bytes(int n)
+{
+	if (map)
+	{
+		if (mappos + n <= mapsize)
+			return map + mappos;
+		unmap_to_stream();
+	}
+	return OutputSink::reserve_bytes(n);
+}
+
+void FileOutputSink::commit_bytes(int n)
+{
+	// filled in place
+	if (map)
+		mappos += n;
+	else
+		OutputSink::commit_bytes(n);
+}
+
+void FileOutputSink::close_file()
+{
+#ifdef __linux__
+	if (map)
+	{
+		// trim the file if less was written than announced
+		bool failed = (munmap(map, mapsize) != 0);
+		map = 0;
+		if (mappos < mapsize && ftruncate(outfd, mappos) != 0)
+			failed = true;
+		if (::close(outfd) != 0)
+			failed = true;
+		outfd = -1;
+		if (failed)
+			throw(DefaultException("error writing to file " + outname));
+		return;
+	}
+#endif
+	int err = std::fclose(fp);
+	fp = 0;
+	if (err != 0)
+		throw(DefaultException("error writing to file " + outname));
+}
+
+int FileOutputSink::copy_from_stream(MembufStream& stream, int n)
+{
+#ifdef __linux__
+	if (stream.get_decoding_byte() == 0 && !stream.in_memory())
+	{
+		n = std::max(0, std::min(n, stream.get_fsize() - stream.tellg()));
+
+		// a mapped file takes the copy at its write position,
+		// if it fits; stdio output is flushed first
+		if (map && mappos + n > mapsize)
+			unmap_to_stream();
+		int destfd = map ? outfd : -1;
+		if (!map && std::fflush(fp) == 0)
+			destfd = fileno(fp);
+
+		// keep the input file open across copies
+		if (infd < 0 || inname != stream.get_fname())
+		{
+			if (infd >= 0)
+				::close(infd);
+			inname = stream.get_fname();
+			infd = ::open(inname.c_str(), O_RDONLY | O_CLOEXEC);
+		}
+
+		if (infd >= 0 && destfd >= 0)
+		{
+			loff_t inoff = stream.tellg();
+			loff_t outoff = mappos;
+			int copied = 0;
+			while (copied < n)
+			{
+				ssize_t len = copy_file_range(infd, &inoff, destfd,
+					map ? &outoff : 0, n - copied, 0);
+				if (len <= 0)
+					break;
+				copied += len;
+			}
+			// older kernels and some filesystems can't copy_file_range;
+			// sendfile only writes at the file position
+			off_t sendoff = inoff;
+			while (!map && copied < n)
+			{
+				ssize_t len = sendfile(destfd, infd, &sendoff, n - copied);
+				if (len <= 0)
+					break;
+				copied += len;
+			}
+			if (map)
+				mappos += copied;
+			stream.seek_off(copied);
+			// anything left goes through the stream buffer
+			if (copied < n)
+				copied += OutputSink::copy_from_stream(stream, n - copied);
+			return copied;
+		}
+	}
+#endif
+	return OutputSink::copy_from_stream(stream, n);
+}
+
+
+};	// end namespace RipUtil
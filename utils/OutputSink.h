@@ -0,0 +1,189 @@
+/* Destination for ripped output files. Writers open a named file,
+   write its contents and close it; where the bytes end up (plain
+   files, an archive, a background writer...) is up to the sink */
+
+#include "MembufStream.h"
+#include <string>
+#include <vector>
+#include <cstdio>
+
+namespace RipUtil
+{
+
+
+class BitmapData;
+class PCMData;
+
+
+namespace OutputSinkConsts
+{
+	// size hint for files whose length isn't known in advance
+	const static long long unknown_size = -1;
+	// chunk size for copying encoded (XORed) input
+	const static int copy_chunk_size = 65536;
+	// files of at least this announced size are written through a
+	// memory mapping where supported; smaller ones aren't worth the
+	// mmap/munmap calls
+	const static long long mmap_min_size = 262144;
+};
+
+class OutputSink
+{
+public:
+	OutputSink()
+		: filesize(0), reserved(0) { };
+	virtual ~OutputSink() { };
+
+	// begin a new output file; only one file is open at a time
+	// size is the final length of the file if known in advance
+	void open(const std::string& filename,
+		long long size = OutputSinkConsts::unknown_size)
+	{
+		filesize = 0;
+		open_file(filename, size);
+	}
+	// append n bytes to the open file
+	void write(const char* data, int n)
+	{
+		write_bytes(data, n);
+		filesize += n;
+	}
+	void put(char c) { write(&c, 1); }
+	// append n bytes read from the get position of stream, advancing it
+	// (stopping short at end of file); raw input is copied without an
+	// intermediate buffer, straight from the input file where possible
+	void write_from(MembufStream& stream, int n)
+	{
+		filesize += copy_from_stream(stream, n);
+	}
+	// get space for the next n bytes of the open file, to be filled
+	// in place by the caller and then written by commit_write();
+	// nothing else may be written in between
+	char* reserve_write(int n)
+	{
+		reserved = n;
+		return reserve_bytes(n);
+	}
+	void commit_write()
+	{
+		commit_bytes(reserved);
+		filesize += reserved;
+		reserved = 0;
+	}
+	// finish the open file
+	void close() { close_file(); }
+	// write a complete file in one call
+	void write_file(const std::string& filename, const char* data, int n);
+	// write a complete file of n bytes copied from stream
+	void write_file_from(const std::string& filename, MembufStream& stream, int n);
+	// complete all pending output; called once at the end of a run
+	virtual void flush() { };
+	// write out the files closed so far, without finishing what flush()
+	// does once per run (manifests, archive trailers); sinks that hold
+	// back closed files override it
+	virtual void sync() { };
+
+	// incremental rips: start the output of the asset at offset in the
+	// input; false means its files from the last run are still current,
+	// and the caller should skip decoding it. files written until
+	// end_asset() or the next begin_asset() belong to the asset
+	virtual bool begin_asset(int offset) { return true; }
+	virtual void end_asset() { };
+	// resumable rips: start the unit (room, object...) at offset in
+	// the input; false means an interrupted run already finished it,
+	// and the caller should skip past it. state is what the caller
+	// needs to keep from a skipped unit: saved by end_unit(), and
+	// handed back by begin_unit()
+	virtual bool begin_unit(int offset, std::string& state) { return true; }
+	virtual void end_unit(const std::string& state = "") { };
+
+	// sinks that want images and audio decoded rather than encoded:
+	// writers hand them to take_bitmap()/take_audio() instead, under
+	// the name of the file they would have written
+	virtual bool wants_decoded() const { return false; }
+	virtual void take_bitmap(const std::string& filename, BitmapData& bmp) { };
+	virtual void take_audio(const std::string& filename, PCMData& pcm) { };
+
+	// number of bytes written to the open (or last closed) file
+	long long get_file_size() const { return filesize; }
+
+protected:
+	virtual void open_file(const std::string& filename, long long size) = 0;
+	virtual void write_bytes(const char* data, int n) = 0;
+	virtual void close_file() = 0;
+	// copy up to n bytes from stream with write_bytes(), returning
+	// the number copied; sinks may override this with a direct copy
+	virtual int copy_from_stream(MembufStream& stream, int n);
+	// space for reserve_write(); by default a scratch buffer that
+	// commit_bytes() passes to write_bytes()
+	virtual char* reserve_bytes(int n);
+	virtual void commit_bytes(int n);
+
+private:
+	long long filesize;
+	int reserved;
+	std::vector<char> scratch;
+};
+
+// writes each output to its own file on disk
+// on Linux, raw input is copied kernel-side with copy_file_range/sendfile,
+// and large files of known size are preallocated and written through
+// a memory mapping
+class FileOutputSink : public OutputSink
+{
+public:
+	FileOutputSink()
+		: fp(0), infd(-1), outfd(-1), map(0), mapsize(0), mappos(0) { };
+	~FileOutputSink();
+
+protected:
+	void open_file(const std::string& filename, long long size);
+	void write_bytes(const char* data, int n);
+	void close_file();
+	int copy_from_stream(MembufStream& stream, int n);
+	char* reserve_bytes(int n);
+	void commit_bytes(int n);
+
+private:
+	// preallocate and map the open file; false if that isn't possible
+	bool open_mapped(long long size);
+	// the file outgrew its mapping: continue with stdio at the same position
+	void unmap_to_stream();
+
+	std::FILE* fp;
+	std::string outname;
+	// input file descriptor for kernel-side copies
+	int infd;
+	std::string inname;
+	// mapped output file
+	int outfd;
+	char* map;
+	long long mapsize;
+	long long mappos;
+};
+
+// discards everything written to it, keeping only a count of the
+// files and bytes, so decoding and encoding can be timed without I/O
+class NullOutputSink : public OutputSink
+{
+public:
+	NullOutputSink()
+		: numfiles(0), totalbytes(0) { };
+
+	int get_num_files() const { return numfiles; }
+	long long get_total_bytes() const { return totalbytes; }
+
+protected:
+	void open_file(const std::string& filename, long long size) { };
+	void write_bytes(const char* data, int n) { totalbytes += n; }
+	void close_file() { ++numfiles; }
+
+private:
+	int numfiles;
+	long long totalbytes;
+};
+
+
+};	// end namespace RipUtil
+
+#pragma once
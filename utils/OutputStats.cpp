@@ -0,0 +1,68 @@
+#include "OutputStats.h"
+#include <map>
+#include <mutex>
+
+namespace RipUtil
+{
+
+
+// files and bytes written for one format
+struct OutputTotals
+{
+	OutputTotals()
+		: files(0), bytes(0) { };
+
+	int files;
+	long long bytes;
+};
+
+static std::map<std::string, OutputTotals> output_totals;
+static std::mutex output_totals_mutex;
+
+void count_output_bytes(const std::string& format, long long bytes)
+{
+	std::lock_guard<std::mutex> lock(output_totals_mutex);
+	OutputTotals& totals = output_totals[format];
+	++(totals.files);
+	totals.bytes += bytes;
+}
+
+void print_output_stats(std::ostream& ostr)
+{
+	std::lock_guard<std::mutex> lock(output_totals_mutex);
+	for (std::map<std::string, OutputTotals>::const_iterator it = output_totals.begin();
+		it != output_totals.end(); ++it)
+	{
+		ostr << "Output " << it->first << ": " << it->second.files << " files, "
+			<< it->second.bytes << " bytes" << '\n';
+	}
+}
+
+void save_output_stats(std::ostream& ostr)
+{
+	std::lock_guard<std::mutex> lock(output_totals_mutex);
+	for (std::map<std::string, OutputTotals>::const_iterator it = output_totals.begin();
+		it != output_totals.end(); ++it)
+	{
+		ostr << "output " << it->first << ' ' << it->second.files << ' '
+			<< it->second.bytes << '\n';
+	}
+}
+
+void load_output_stats(std::istream& istr)
+{
+	std::lock_guard<std::mutex> lock(output_totals_mutex);
+	std::string tag;
+	std::string format;
+	int files;
+	long long bytes;
+	while (istr >> tag >> format >> files >> bytes && tag == "output")
+	{
+		OutputTotals& totals = output_totals[format];
+		totals.files += files;
+		totals.bytes += bytes;
+	}
+}
+
+
+};	// end namespace RipUtil
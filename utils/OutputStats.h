@@ -0,0 +1,26 @@
+/* Running totals of output written, per file format */
+
+#include <string>
+#include <ostream>
+#include <istream>
+
+namespace RipUtil
+{
+
+
+// add a written file of the given size to the totals for its format
+// (e.g. "bmp", "png", "wav", "flac")
+void count_output_bytes(const std::string& format, long long bytes);
+
+// print the number of files and bytes written for each format
+void print_output_stats(std::ostream& ostr);
+
+// pass the totals from one process to another: save_output_stats()
+// writes them in a form load_output_stats() adds to its own
+void save_output_stats(std::ostream& ostr);
+void load_output_stats(std::istream& istr);
+
+
+};	// end namespace RipUtil
+
+#pragma once
@@ -1,7 +1,9 @@
 #include "PCMData.h"
 #include "DatManip.h"
 #include "DefaultException.h"
-#include <fstream>
+#include "FLACEncoder.h"
+#include "OutputStats.h"
+#include "MemoryBudget.h"
 #include <cmath>
 #include <cstring>
 
@@ -79,7 +81,7 @@ void PCMData::linear_fade(int fadestart, int fadeend, double level)
 	fadeend *= bytespersamp;
 
 	double fadediff = ((double)1 - level)/fade_granularity;
-	int fadestep = fadesamps/fade_granularity;
+	int fadestep = std::max(1, fadesamps/fade_granularity);
 
 	int samplerange = static_cast<int> (std::pow((double)2, sampwidth));
 
@@ -148,6 +150,7 @@ void PCMData::add_loop(int loopstart, int loopend, int loops,
 		delete[] waveform;
 		waveform = newwave;
 		wavesize = newlen;
+		wavecapacity = newlen;
 		linear_fade(fadestart/bytespersamp, fadestart/bytespersamp + fadesamps);
 	}
 	else if (loopstyle == tailloop)
@@ -160,6 +163,7 @@ void PCMData::add_loop(int loopstart, int loopend, int loops,
 		delete[] waveform;
 		waveform = newwave;
 		wavesize = newlen;
+		wavecapacity = newlen;
 	}
 }
 
@@ -224,6 +228,7 @@ bool PCMData::convert_sampwidth(int bitspersamp, DatManip::Sign s)
 		delete[] waveform;
 		sign = s;
 		wavesize = wavesize/(sampwidth/8) * bytespersamp;
+		wavecapacity = wavesize;
 		sampwidth = bitspersamp;
 		waveform = new_wave;
 	}
@@ -302,17 +307,8 @@ void PCMData::normalize()
 	delete[] bytes;
 }
 
-void write_pcmdata_wave(PCMData& dat, const std::string& outfile,
-	int ignorebytes, int ignoreend)
+void write_wave_header(OutputSink& sink, PCMData& dat, int size)
 {
-	// disallow negative ignore values
-	ignorebytes = std::max(0, ignorebytes);
-	ignoreend = std::max(0, ignoreend);
-
-	int size = std::max(0, dat.get_wavesize() - ignorebytes - ignoreend);
-
-	std::ofstream ofs(outfile.c_str(), std::ios_base::binary);
-	if (!ofs) throw(DefaultException("error writing to file"));
 	// RIFF header
 	// chunk id: "RIFF"
 	char chunksize[4];
@@ -350,30 +346,361 @@ void write_pcmdata_wave(PCMData& dat, const std::string& outfile,
 	swap_end(subchunk2size, 4);
 
 	// write data
-	ofs.write(WaveWriterConsts::riff_chunk_id, 4);
-	ofs.write(chunksize, 4);
-	ofs.write(WaveWriterConsts::riff_format_id, 4);
-	ofs.write(WaveWriterConsts::riff_schunk1_id, 4);
-	ofs.write(subchunk1size, 4);
-	ofs.write(audioformat, 2);
-	ofs.write(numchannels, 2);
-	ofs.write(samplerate, 4);
-	ofs.write(byterate, 4);
-	ofs.write(blockalign, 2);
-	ofs.write(bitspersample, 2);
-	ofs.write(WaveWriterConsts::riff_schunk2_id, 4);
-	ofs.write(subchunk2size, 4);
+	sink.write(WaveWriterConsts::riff_chunk_id, 4);
+	sink.write(chunksize, 4);
+	sink.write(WaveWriterConsts::riff_format_id, 4);
+	sink.write(WaveWriterConsts::riff_schunk1_id, 4);
+	sink.write(subchunk1size, 4);
+	sink.write(audioformat, 2);
+	sink.write(numchannels, 2);
+	sink.write(samplerate, 4);
+	sink.write(byterate, 4);
+	sink.write(blockalign, 2);
+	sink.write(bitspersample, 2);
+	sink.write(WaveWriterConsts::riff_schunk2_id, 4);
+	sink.write(subchunk2size, 4);
+}
+
+void take_pcmdata(OutputSink& sink, PCMData& dat, const std::string& outfile,
+	int ignorebytes, int ignoreend)
+{
+	ignorebytes = std::min(std::max(0, ignorebytes), dat.get_wavesize());
+	ignoreend = std::max(0, ignoreend);
+	if (ignorebytes == 0 && ignoreend == 0)
+	{
+		sink.take_audio(outfile, dat);
+		return;
+	}
+
+	int size = std::max(0, dat.get_wavesize() - ignorebytes - ignoreend);
+	PCMData trimmed(dat.get_waveform() + ignorebytes, size, dat.get_channels(),
+		dat.get_samprate(), dat.get_sampwidth());
+	trimmed.set_signed(static_cast<DatManip::Sign>(dat.get_signed()));
+	trimmed.set_end(static_cast<DatManip::End>(dat.get_end()));
+	sink.take_audio(outfile, trimmed);
+	delete[] trimmed.get_waveform();
+}
+
+void write_pcmdata_wave(OutputSink& sink, PCMData& dat, const std::string& outfile,
+	int ignorebytes, int ignoreend)
+{
+	if (sink.wants_decoded())
+	{
+		take_pcmdata(sink, dat, outfile, ignorebytes, ignoreend);
+		return;
+	}
+
+	// disallow negative ignore values
+	ignorebytes = std::max(0, ignorebytes);
+	ignoreend = std::max(0, ignoreend);
+
+	int size = std::max(0, dat.get_wavesize() - ignorebytes - ignoreend);
+
+	sink.open(outfile, WaveWriterConsts::header_size + size);
+	write_wave_header(sink, dat, size);
 
 	if (dat.get_end() == DatManip::be)
 	{
 		dat.convert_endianess(DatManip::le);
-		ofs.write(dat.get_waveform() + ignorebytes, 
+		sink.write(dat.get_waveform() + ignorebytes, 
 			size);
 		dat.convert_endianess(DatManip::be);
 	}
 	else
-		ofs.write(dat.get_waveform() + ignorebytes,
+		sink.write(dat.get_waveform() + ignorebytes,
 			size);
+
+	count_output_bytes("wav", sink.get_file_size());
+	sink.close();
+}
+
+// write len bytes of silence at the given zero level
+static void write_wave_silence(OutputSink& sink, PCMData& dat, int len)
+{
+	int bytespersamp = dat.get_sampwidth()/8;
+	const int bufsamps = 4096;
+	char* buf = new char[bufsamps * bytespersamp];
+	to_bytes(dat.get_zerolevel(), buf, bytespersamp, DatManip::le);
+	for (int i = 1; i < bufsamps; i++)
+		std::memcpy(buf + i * bytespersamp, buf, bytespersamp);
+	while (len > 0)
+	{
+		int n = std::min(len, bufsamps * bytespersamp);
+		sink.write(buf, n);
+		len -= n;
+	}
+	delete[] buf;
+}
+
+void write_pcmdata_wave_looped(OutputSink& sink, PCMData& dat, const std::string& outfile,
+	int loopstart, int loopend, int loops, 
+	PCMData::LoopStyle loopstyle, double fadetime, double trailsilence)
+{
+	// convert sample positions to byte positions
+	int bytespersamp = dat.get_sampwidth()/8;
+	int wavesize = dat.get_wavesize();
+	loopstart = std::min(std::max(0, loopstart * bytespersamp), wavesize);
+	loopend = std::min(std::max(loopstart, loopend * bytespersamp), wavesize);
+	int looplen = loopend - loopstart;
+	// nothing to loop
+	if (looplen <= 0 || loops < 0)
+	{
+		write_pcmdata_wave(sink, dat, outfile);
+		return;
+	}
+
+	// loop a copy in memory, as for FLAC
+	if (sink.wants_decoded())
+	{
+		PCMData looped(dat.get_waveform(), dat.get_wavesize(), dat.get_channels(),
+			dat.get_samprate(), dat.get_sampwidth());
+		looped.set_signed(static_cast<DatManip::Sign>(dat.get_signed()));
+		looped.set_end(static_cast<DatManip::End>(dat.get_end()));
+		// positions were converted to bytes above
+		looped.add_loop(loopstart / bytespersamp, loopend / bytespersamp, loops,
+			loopstyle, fadetime, trailsilence);
+		sink.take_audio(outfile, looped);
+		delete[] looped.get_waveform();
+		return;
+	}
+
+	// calculate final size (as add_loop() does)
+	int fadesamps = 0;
+	int tailsize;
+	int newlen;
+	if (loopstyle == PCMData::fadeloop)
+	{
+		fadesamps = static_cast<int> (fadetime * dat.get_samprate());
+		tailsize = fadesamps * bytespersamp;
+		newlen = static_cast<int> (loopend + looplen * loops
+			+ (fadetime + trailsilence) * dat.get_samprate() * bytespersamp);
+	}
+	else
+	{
+		tailsize = wavesize - loopend;
+		newlen = static_cast<int> (wavesize + looplen * loops
+			+ trailsilence * dat.get_samprate() * bytespersamp);
+	}
+	int silsize = std::max(0, newlen - (loopend + looplen * loops + tailsize));
+	newlen = loopend + looplen * loops + tailsize + silsize;
+
+	sink.open(outfile, WaveWriterConsts::header_size + newlen);
+
+	bool was_be = (dat.get_end() == DatManip::be);
+	if (was_be)
+		dat.convert_endianess(DatManip::le);
+
+	write_wave_header(sink, dat, newlen);
+
+	// original wave up to loop point, then each loop from the same slice
+	const char* waveform = dat.get_waveform();
+	sink.write(waveform, loopend);
+	for (int i = 0; i < loops; i++)
+		sink.write(waveform + loopstart, looplen);
+
+	if (loopstyle == PCMData::fadeloop)
+	{
+		// continue into the loop while fading out
+		double fadediff = (double)1/PCMData::fade_granularity;
+		int fadestep = std::max(1, fadesamps/PCMData::fade_granularity);
+		int range = static_cast<int> (std::pow((double)2, dat.get_sampwidth()));
+		bool is_unsigned = (dat.get_signed() == DatManip::has_nosign);
+		double fadeamt = 1.0;
+
+		const int bufsamps = 4096;
+		char* buf = new char[bufsamps * bytespersamp];
+		int bufpos = 0;
+		for (int i = 0; i < fadesamps; i++)
+		{
+			// fade is applied to signed samples
+			int sample = to_int(waveform + loopstart + i * bytespersamp % looplen,
+				bytespersamp, DatManip::le, 
+				is_unsigned ? DatManip::has_nosign : DatManip::has_sign);
+			if (is_unsigned)
+				sample -= range/2;
+			sample = static_cast<int> (sample * fadeamt);
+			if (is_unsigned)
+				sample += range/2;
+			to_bytes(sample, buf + bufpos, bytespersamp, DatManip::le);
+			bufpos += bytespersamp;
+			if (bufpos == bufsamps * bytespersamp)
+			{
+				sink.write(buf, bufpos);
+				bufpos = 0;
+			}
+			if (!(i % fadestep))
+				fadeamt -= fadediff;
+		}
+		sink.write(buf, bufpos);
+		delete[] buf;
+	}
+	else
+	{
+		// "tail" from past loop point
+		sink.write(waveform + loopend, tailsize);
+	}
+
+	write_wave_silence(sink, dat, silsize);
+	count_output_bytes("wav", sink.get_file_size());
+	sink.close();
+
+	if (was_be)
+		dat.convert_endianess(DatManip::be);
+}
+
+
+void write_pcmdata(OutputSink& sink, PCMData& dat, const std::string& outfile,
+	PCMData::AudioFormat format, int ignorebytes, int ignoreend)
+{
+	if (format == PCMData::flacformat && flac_can_encode(dat))
+		write_pcmdata_flac(sink, dat, outfile + ".flac", ignorebytes, ignoreend);
+	else
+		write_pcmdata_wave(sink, dat, outfile + ".wav", ignorebytes, ignoreend);
+}
+
+// a waveform as add_loop() would loop it, made a slice at a time: the
+// waveform up to the loop end, the loops, the tail (the faded start of
+// the loop, or the rest of the waveform) and trailing silence
+struct LoopedWave
+{
+	const char* waveform;
+	int loopstart;		// byte positions
+	int loopend;
+	int loops;
+	const char* tail;
+	int tailsize;
+	char silence;		// byte the silence is filled with
+	int newlen;
+	int bytesperframe;	// bytes of a sample of every channel
+};
+
+// FLACSampleSource for a LoopedWave
+static void read_looped_wave(void* context, int start, int count, char* buf)
+{
+	const LoopedWave& wave = *static_cast<LoopedWave*>(context);
+	long long pos = (long long)start * wave.bytesperframe;
+	long long end = pos + (long long)count * wave.bytesperframe;
+	int looplen = wave.loopend - wave.loopstart;
+	long long loopsend = wave.loopend + (long long)looplen * wave.loops;
+	while (pos < end)
+	{
+		const char* from;
+		long long n;
+		if (pos < wave.loopend)
+		{
+			from = wave.waveform + pos;
+			n = wave.loopend - pos;
+		}
+		else if (pos < loopsend)
+		{
+			int inloop = (pos - wave.loopend) % looplen;
+			from = wave.waveform + wave.loopstart + inloop;
+			n = looplen - inloop;
+		}
+		else if (pos < loopsend + wave.tailsize)
+		{
+			from = wave.tail + (pos - loopsend);
+			n = loopsend + wave.tailsize - pos;
+		}
+		else
+		{
+			from = 0;
+			n = end - pos;
+		}
+		n = std::min(n, end - pos);
+		if (from)
+			std::memcpy(buf, from, n);
+		else
+			std::memset(buf, wave.silence, n);
+		buf += n;
+		pos += n;
+	}
+}
+
+// encode dat looped as add_loop() would, without holding the looped
+// copy: positions are in samples, and must lie within the waveform
+static void write_pcmdata_flac_looped(OutputSink& sink, PCMData& dat, const std::string& outfile,
+	int loopstart, int loopend, int loops, 
+	PCMData::LoopStyle loopstyle, double fadetime, double trailsilence)
+{
+	int bytespersamp = dat.get_sampwidth()/8;
+	LoopedWave wave;
+	wave.waveform = dat.get_waveform();
+	wave.loopstart = loopstart * bytespersamp;
+	wave.loopend = loopend * bytespersamp;
+	wave.loops = loops;
+	wave.bytesperframe = dat.get_channels() * bytespersamp;
+	int looplen = wave.loopend - wave.loopstart;
+
+	// sizes as add_loop() works them out
+	PCMData fade(dat.get_channels(), dat.get_samprate(), dat.get_sampwidth());
+	if (loopstyle == PCMData::fadeloop)
+	{
+		wave.newlen = static_cast<int> (wave.loopend + looplen * loops
+			+ (fadetime + trailsilence) * dat.get_samprate() * bytespersamp);
+		// the fade is short, so it's made whole
+		int fadesamps = static_cast<int> (fadetime * dat.get_samprate());
+		fade.resize_wave(fadesamps * bytespersamp);
+		fade.set_signed(static_cast<DatManip::Sign>(dat.get_signed()));
+		fade.set_end(static_cast<DatManip::End>(dat.get_end()));
+		for (int i = 0; i < fadesamps; i++)
+		{
+			std::memcpy(fade.get_waveform() + i * bytespersamp,
+				wave.waveform + wave.loopstart + i * bytespersamp % looplen, bytespersamp);
+		}
+		fade.linear_fade(0, fadesamps);
+		wave.tail = fade.get_waveform();
+		wave.tailsize = fade.get_wavesize();
+		wave.silence = fade.get_zerolevel();
+	}
+	else
+	{
+		wave.newlen = static_cast<int> (dat.get_wavesize() + looplen * loops
+			+ trailsilence * dat.get_samprate() * bytespersamp);
+		wave.tail = wave.waveform + wave.loopend;
+		wave.tailsize = dat.get_wavesize() - wave.loopend;
+		wave.silence = 0;
+	}
+
+	write_flac_streamed(sink, dat, outfile, wave.newlen / wave.bytesperframe,
+		read_looped_wave, &wave);
+	delete[] fade.get_waveform();
+}
+
+void write_pcmdata_looped(OutputSink& sink, PCMData& dat, const std::string& outfile,
+	PCMData::AudioFormat format, int loopstart, int loopend, int loops, 
+	PCMData::LoopStyle loopstyle, double fadetime, double trailsilence)
+{
+	// the FLAC encoder takes the whole waveform, so a copy is looped in
+	// memory; if that copy won't fit in the memory budget, the loops
+	// are encoded a few frames at a time instead, to the same file
+	long long share = get_budget_share(MemoryBudgetConsts::unit_share);
+	int bytespersamp = dat.get_sampwidth()/8;
+	long long loopedsize = dat.get_wavesize()
+		+ (long long)std::max(0, loopend - loopstart) * bytespersamp * std::max(0, loops);
+	bool fits = (share == MemoryBudgetConsts::unlimited || loopedsize <= share);
+	bool inwave = (loopstart >= 0 && loopstart < loopend && loops >= 0
+		&& (long long)loopend * bytespersamp <= dat.get_wavesize());
+	if (format == PCMData::flacformat && flac_can_encode(dat) && !fits && inwave
+		&& !sink.wants_decoded())
+	{
+		count_budget_fallback("looped audio encoded to FLAC in pieces");
+		write_pcmdata_flac_looped(sink, dat, outfile + ".flac", loopstart, loopend, loops,
+			loopstyle, fadetime, trailsilence);
+	}
+	else if (format == PCMData::flacformat && flac_can_encode(dat))
+	{
+		PCMData looped(dat.get_waveform(), dat.get_wavesize(), dat.get_channels(),
+			dat.get_samprate(), dat.get_sampwidth());
+		looped.set_signed(static_cast<DatManip::Sign>(dat.get_signed()));
+		looped.set_end(static_cast<DatManip::End>(dat.get_end()));
+		looped.add_loop(loopstart, loopend, loops, loopstyle, fadetime, trailsilence);
+		write_pcmdata_flac(sink, looped, outfile + ".flac");
+		delete[] looped.get_waveform();
+	}
+	else
+		write_pcmdata_wave_looped(sink, dat, outfile + ".wav", loopstart, loopend, loops,
+			loopstyle, fadetime, trailsilence);
 }
 
 
@@ -6,6 +6,7 @@
 #include <string>
 
 #include "DatManip.h"
+#include "OutputSink.h"
 
 namespace RipUtil
 {
@@ -21,6 +22,8 @@ namespace WaveWriterConsts
 		= { 'f', 'm', 't', ' ' };
 	const static char riff_schunk2_id[4]
 		= { 'd', 'a', 't', 'a' };
+	// size of the header written by write_wave_header
+	const static int header_size = 44;
 };
 
 class PCMData 
@@ -30,23 +33,31 @@ public:
 	{
 		fadeloop, tailloop
 	};
+	enum AudioFormat
+	{
+		waveformat, flacformat
+	};
 	PCMData()
-		: waveform(0), wavesize(0), channels(0), samprate(0), sampwidth(0),
+		: waveform(0), wavesize(0), wavecapacity(0), 
+		channels(0), samprate(0), sampwidth(0),
 		sign(DatManip::has_nosign), end(DatManip::le), 
 		looping(false), loopstart(0), loopend(0) { };
 	PCMData(int chans, int srate, int swidth)
-		: waveform(0), wavesize(0), channels(chans), samprate(srate), sampwidth(swidth),
+		: waveform(0), wavesize(0), wavecapacity(0), 
+		channels(chans), samprate(srate), sampwidth(swidth),
 		sign(DatManip::has_nosign), end(DatManip::le), 
 		looping(false), loopstart(0), loopend(0) { };
 	PCMData(int size, int chans, int srate, int swidth)
-		: waveform(0), wavesize(size), channels(chans), samprate(srate), sampwidth(swidth),
+		: waveform(0), wavesize(size), wavecapacity(0), 
+		channels(chans), samprate(srate), sampwidth(swidth),
 		sign(DatManip::has_nosign), end(DatManip::le), 
 		looping(false), loopstart(0), loopend(0)
 	{ 
 		resize_wave(size);
 	}
 	PCMData(char* s, int size, int chans, int srate, int swidth)
-		: waveform(0), wavesize(size), channels(chans), samprate(srate), sampwidth(swidth),
+		: waveform(0), wavesize(size), wavecapacity(0), 
+		channels(chans), samprate(srate), sampwidth(swidth),
 		sign(DatManip::has_nosign), end(DatManip::le), 
 		looping(false), loopstart(0), loopend(0)
 	{ 
@@ -78,6 +89,7 @@ public:
 		delete[] waveform;
 		waveform = s;
 		wavesize = n;
+		wavecapacity = n;
 	}
 	// destroy existing waveform and copy in s
 	void set_wave(char* s, int n)
@@ -91,15 +103,26 @@ public:
 		delete[] waveform;
 		waveform = new char[n];
 		wavesize = n;
+		wavecapacity = n;
 	}
-	// resize, preserving existing waveform
-	void resize_and_copy_wave(int n)
+	// make room for at least n bytes without changing size,
+	// preserving existing waveform
+	void reserve_wave(int n)
 	{
+		if (n <= wavecapacity)
+			return;
 		char* newwaveform = new char[n];
-		int sz = std::min(wavesize, n);
-		std::memcpy(newwaveform, waveform, sz);
+		std::memcpy(newwaveform, waveform, wavesize);
 		delete[] waveform;
 		waveform = newwaveform;
+		wavecapacity = n;
+	}
+	// resize, preserving existing waveform
+	// growth is geometric so that repeated appends are linear overall
+	void resize_and_copy_wave(int n)
+	{
+		if (n > wavecapacity)
+			reserve_wave(std::max(n, wavecapacity + wavecapacity/2));
 		wavesize = n;
 	}
 	// add data to end of waveform
@@ -110,7 +133,12 @@ public:
 		std::memcpy(waveform + oldsize, s, n);
 	}
 
-	void set_waveform(char* new_waveform)	{ waveform = new_waveform; }
+	// waveform must be new[]'d with at least the current wavesize
+	void set_waveform(char* new_waveform)	
+	{ 
+		waveform = new_waveform; 
+		wavecapacity = wavesize;
+	}
 	void set_wavesize(int new_wavesize)		{ wavesize = new_wavesize; }
 	void set_channels(int new_channels)		{ channels = new_channels; }
 	void set_samprate(int new_samprate)		{ samprate = new_samprate; }
@@ -136,12 +164,14 @@ public:
 	bool convert_sampwidth(int bitspersamp, DatManip::Sign s);
 	// amplify waveform to maximum threshold
 	void normalize();
-private:
+
 	// number of stages in adding a fade
 	const static int fade_granularity = 1024;
 
+private:
 	char* waveform;			// raw waveform data (channel interleaved)
-	int wavesize;			// length of waveform data array
+	int wavesize;			// length of waveform data
+	int wavecapacity;		// allocated size of waveform data array
 	int channels;			// number of channels
 	int samprate;			// playback rate
 	int sampwidth;			// bits per sample
@@ -152,10 +182,40 @@ private:
 	int loopend;
 };
 
+// write a RIFF WAVE header for a data chunk of the given size
+void write_wave_header(OutputSink& sink, PCMData& dat, int size);
+
+// hand PCMData to a sink that takes audio decoded (see
+// OutputSink::wants_decoded()), trimmed as write_pcmdata_wave() would
+void take_pcmdata(OutputSink& sink, PCMData& dat, const std::string& outfile,
+	int ignorebytes = 0, int ignoreend = 0);
+
 // write out PCMData as a RIFF WAVE file
-void write_pcmdata_wave(PCMData& dat, const std::string& outfile,
+void write_pcmdata_wave(OutputSink& sink, PCMData& dat, const std::string& outfile,
 	int ignorebytes = 0, int ignoreend = 0);
 
+// write out PCMData as a RIFF WAVE file, adding loops as add_loop()
+// would but rendering them straight to the file: the loop body is
+// rewritten from the source waveform for each iteration and the fade
+// and trailing silence are generated on the fly
+void write_pcmdata_wave_looped(OutputSink& sink, PCMData& dat, const std::string& outfile,
+	int loopstart, int loopend, int loops, 
+	PCMData::LoopStyle loopstyle = PCMData::fadeloop, double fadetime = 0,
+	double trailsilence = 0);
+
+// write out PCMData in the given format, adding the format's
+// extension to outfile
+// formats that can't hold the data fall back to RIFF WAVE
+void write_pcmdata(OutputSink& sink, PCMData& dat, const std::string& outfile,
+	PCMData::AudioFormat format, int ignorebytes = 0, int ignoreend = 0);
+
+// write out PCMData in the given format with loops added,
+// as write_pcmdata_wave_looped()
+void write_pcmdata_looped(OutputSink& sink, PCMData& dat, const std::string& outfile,
+	PCMData::AudioFormat format, int loopstart, int loopend, int loops, 
+	PCMData::LoopStyle loopstyle = PCMData::fadeloop, double fadetime = 0,
+	double trailsilence = 0);
+
 
 };
 
@@ -0,0 +1,136 @@
+#include "ShardedOutputSink.h"
+#include "DefaultException.h"
+#include <vector>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#include <sys/types.h>
+#endif
+
+namespace RipUtil
+{
+
+
+ShardedOutputSink::ShardedOutputSink(OutputSink& target, ShardLayout layout,
+	int fanout, bool makedirs)
+	: target(target), layout(layout), fanout(fanout < 1 ? 1 : fanout), makedirs(makedirs)
+{
+
+}
+
+// is s a nonempty string of digits?
+static bool is_number(const std::string& s)
+{
+	if (s.empty())
+		return false;
+	for (std::string::size_type i = 0; i < s.length(); i++)
+	{
+		if (s[i] < '0' || s[i] > '9')
+			return false;
+	}
+	return true;
+}
+
+std::string ShardedOutputSink::get_shard_name(const std::string& filename) const
+{
+	if (layout == flatlayout)
+		return filename;
+
+	std::string::size_type slash = filename.find_last_of("/\\");
+	std::string dir = (slash == std::string::npos) ? "" : filename.substr(0, slash + 1);
+	std::string base = (slash == std::string::npos) ? filename : filename.substr(slash + 1);
+
+	if (layout == hashlayout)
+	{
+		// FNV-1a
+		unsigned int hash = 2166136261u;
+		for (std::string::size_type i = 0; i < base.length(); i++)
+		{
+			hash ^= (unsigned char)base[i];
+			hash *= 16777619u;
+		}
+		int bucket = hash % fanout;
+
+		// fixed-width hex bucket names
+		int digits = 1;
+		for (int f = fanout - 1; f > 15; f >>= 4)
+			++digits;
+		std::string bucketname;
+		for (int i = digits - 1; i >= 0; i--)
+			bucketname += "0123456789abcdef"[(bucket >> (4 * i)) & 0xF];
+		return dir + bucketname + "/" + base;
+	}
+
+	// resource layout: each "-name-number" run closes a group, and all
+	// but the last group (up to max_resource_depth) become directories
+	std::string stem = base.substr(0, base.find_last_of('.'));
+	std::vector<std::string::size_type> groupends;
+	std::string::size_type start = 0;
+	while (start <= stem.length())
+	{
+		std::string::size_type end = stem.find('-', start);
+		if (end == std::string::npos)
+			end = stem.length();
+		if (is_number(stem.substr(start, end - start)))
+			groupends.push_back(end);
+		start = end + 1;
+	}
+
+	std::string sharddir;
+	std::string::size_type groupstart = 0;
+	for (int i = 0; i + 1 < (int)groupends.size()
+		&& i < ShardConsts::max_resource_depth; i++)
+	{
+		sharddir += stem.substr(groupstart, groupends[i] - groupstart) + "/";
+		groupstart = groupends[i] + 1;
+	}
+	return dir + sharddir + base;
+}
+
+void ShardedOutputSink::make_dirs(const std::string& dir)
+{
+	// create each level in turn; existing ones just fail
+	for (std::string::size_type pos = dir.find_first_of("/\\", 1);
+		; pos = dir.find_first_of("/\\", pos + 1))
+	{
+		std::string path = dir.substr(0, pos);
+#ifdef _WIN32
+		_mkdir(path.c_str());
+#else
+		mkdir(path.c_str(), 0755);
+#endif
+		if (pos == std::string::npos)
+			break;
+	}
+}
+
+void ShardedOutputSink::open_file(const std::string& filename, long long size)
+{
+	std::string name = get_shard_name(filename);
+	if (makedirs && layout != flatlayout)
+	{
+		std::string::size_type slash = name.find_last_of("/\\");
+		if (slash != std::string::npos)
+		{
+			std::string dir = name.substr(0, slash);
+			if (!createddirs.count(dir))
+			{
+				make_dirs(dir);
+				createddirs.insert(dir);
+			}
+		}
+	}
+	target.open(name, size);
+}
+
+int ShardedOutputSink::copy_from_stream(MembufStream& stream, int n)
+{
+	long long before = target.get_file_size();
+	target.write_from(stream, n);
+	return target.get_file_size() - before;
+}
+
+
+};	// end namespace RipUtil
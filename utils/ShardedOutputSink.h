@@ -0,0 +1,74 @@
+/* Output sink that spreads files over subdirectories instead of
+   putting every output of a run into one flat directory, then passes
+   them on to another sink.
+   resource layout: one directory per room/resource, taken from the
+     "-name-number" groups of the filename, e.g.
+     game-room-12-akos-3-im-7.bmp -> game-room-12/akos-3/game-room-12-akos-3-im-7.bmp
+   hash layout: a fixed number of buckets chosen by hashing the name, e.g.
+     game-room-12-akos-3-im-7.bmp -> 5c/game-room-12-akos-3-im-7.bmp */
+
+#include "OutputSink.h"
+#include <string>
+#include <set>
+
+namespace RipUtil
+{
+
+
+namespace ShardConsts
+{
+	// default number of hash buckets
+	const static int default_fanout = 256;
+	// most directory levels the resource layout creates
+	const static int max_resource_depth = 2;
+};
+
+class ShardedOutputSink : public OutputSink
+{
+public:
+	enum ShardLayout
+	{
+		flatlayout,
+		resourcelayout,
+		hashlayout
+	};
+
+	// makedirs: create the subdirectories on disk as they're needed
+	// (not needed for archives)
+	ShardedOutputSink(OutputSink& target, ShardLayout layout,
+		int fanout = ShardConsts::default_fanout, bool makedirs = true);
+
+	void flush() { target.flush(); }
+	void sync() { target.sync(); }
+	bool begin_asset(int offset) { return target.begin_asset(offset); }
+	void end_asset() { target.end_asset(); }
+	bool begin_unit(int offset, std::string& state) { return target.begin_unit(offset, state); }
+	void end_unit(const std::string& state) { target.end_unit(state); }
+
+	// the name a file is written under
+	std::string get_shard_name(const std::string& filename) const;
+
+protected:
+	void open_file(const std::string& filename, long long size);
+	void write_bytes(const char* data, int n) { target.write(data, n); }
+	void close_file() { target.close(); }
+	int copy_from_stream(MembufStream& stream, int n);
+	char* reserve_bytes(int n) { return target.reserve_write(n); }
+	void commit_bytes(int n) { target.commit_write(); }
+
+private:
+	// create dir and any missing parents
+	void make_dirs(const std::string& dir);
+
+	OutputSink& target;
+	ShardLayout layout;
+	int fanout;
+	bool makedirs;
+	// directories known to exist
+	std::set<std::string> createddirs;
+};
+
+
+};	// end namespace RipUtil
+
+#pragma once
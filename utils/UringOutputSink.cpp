@@ -0,0 +1,356 @@
+#include "UringOutputSink.h"
+#include "DefaultException.h"
+#include <cstring>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define HAVE_IO_URING
+#endif
+#endif
+
+#ifdef HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace RipUtil
+{
+
+
+#ifdef HAVE_IO_URING
+
+// mapped submission/completion rings of one io_uring instance
+struct UringRing
+{
+	int fd;
+	void* sqring;
+	size_t sqringsize;
+	void* cqring;
+	size_t cqringsize;
+	io_uring_sqe* sqes;
+	size_t sqessize;
+
+	unsigned* sqtail;
+	unsigned* sqmask;
+	unsigned* sqarray;
+	unsigned* cqhead;
+	unsigned* cqtail;
+	unsigned* cqmask;
+	io_uring_cqe* cqes;
+};
+
+static void close_ring(UringRing* ring)
+{
+	if (ring->sqes)
+		munmap(ring->sqes, ring->sqessize);
+	if (ring->cqring && ring->cqring != ring->sqring)
+		munmap(ring->cqring, ring->cqringsize);
+	if (ring->sqring)
+		munmap(ring->sqring, ring->sqringsize);
+	close(ring->fd);
+	delete ring;
+}
+
+// set up a ring with a table of batch_files direct descriptors,
+// or return 0 if the kernel can't do that
+static UringRing* open_ring()
+{
+	io_uring_params params;
+	std::memset(&params, 0, sizeof(params));
+	int fd = syscall(__NR_io_uring_setup, UringConsts::ring_entries, &params);
+	if (fd < 0)
+		return 0;
+
+	UringRing* ring = new UringRing;
+	std::memset(ring, 0, sizeof(UringRing));
+	ring->fd = fd;
+
+	// opening into direct descriptors needs 5.15; CQE_SKIP (5.17)
+	// is the nearest feature bit that implies it
+	if (!(params.features & IORING_FEAT_SINGLE_MMAP)
+		|| !(params.features & IORING_FEAT_CQE_SKIP))
+	{
+		close_ring(ring);
+		return 0;
+	}
+
+	ring->sqringsize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	ring->cqringsize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+	if (ring->cqringsize > ring->sqringsize)
+		ring->sqringsize = ring->cqringsize;
+	ring->sqessize = params.sq_entries * sizeof(io_uring_sqe);
+
+	void* sqring = mmap(0, ring->sqringsize, PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+	void* sqes = mmap(0, ring->sqessize, PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+	ring->sqring = (sqring == MAP_FAILED) ? 0 : sqring;
+	ring->cqring = ring->sqring;
+	ring->sqes = (sqes == MAP_FAILED) ? 0 : (io_uring_sqe*)sqes;
+	if (!ring->sqring || !ring->sqes)
+	{
+		close_ring(ring);
+		return 0;
+	}
+
+	char* sq = (char*)ring->sqring;
+	ring->sqtail = (unsigned*)(sq + params.sq_off.tail);
+	ring->sqmask = (unsigned*)(sq + params.sq_off.ring_mask);
+	ring->sqarray = (unsigned*)(sq + params.sq_off.array);
+	char* cq = (char*)ring->cqring;
+	ring->cqhead = (unsigned*)(cq + params.cq_off.head);
+	ring->cqtail = (unsigned*)(cq + params.cq_off.tail);
+	ring->cqmask = (unsigned*)(cq + params.cq_off.ring_mask);
+	ring->cqes = (io_uring_cqe*)(cq + params.cq_off.cqes);
+
+	// empty slots for the files of one batch
+	int slots[UringConsts::batch_files];
+	for (int i = 0; i < UringConsts::batch_files; i++)
+		slots[i] = -1;
+	if (syscall(__NR_io_uring_register, fd, IORING_REGISTER_FILES,
+		slots, UringConsts::batch_files) < 0)
+	{
+		close_ring(ring);
+		return 0;
+	}
+
+	return ring;
+}
+
+// claim the next free submission queue entry
+static io_uring_sqe* get_sqe(UringRing* ring, unsigned& tail)
+{
+	unsigned index = tail & *ring->sqmask;
+	ring->sqarray[index] = index;
+	io_uring_sqe* sqe = &ring->sqes[index];
+	std::memset(sqe, 0, sizeof(io_uring_sqe));
+	++tail;
+	return sqe;
+}
+
+#else
+
+struct UringRing
+{
+};
+
+static UringRing* open_ring()
+{
+	return 0;
+}
+
+static void close_ring(UringRing* ring)
+{
+	delete ring;
+}
+
+#endif
+
+
+UringOutputSink::UringOutputSink()
+	: ring(open_ring()), batchbytes(0), current(0)
+{
+
+}
+
+UringOutputSink::~UringOutputSink()
+{
+	try
+	{
+		submit_batch();
+	}
+	catch (...)
+	{
+
+	}
+	delete current;
+	if (ring)
+		close_ring(ring);
+}
+
+void UringOutputSink::open_file(const std::string& filename, long long size)
+{
+	if (!ring)
+	{
+		fallback.open(filename, size);
+		return;
+	}
+
+	// a writer may have thrown before closing its last file
+	delete current;
+	current = new PendingFile;
+	current->filename = filename;
+	if (size > 0)
+		current->data.reserve(size);
+}
+
+void UringOutputSink::write_bytes(const char* data, int n)
+{
+	if (!ring)
+		fallback.write(data, n);
+	else
+		current->data.insert(current->data.end(), data, data + n);
+}
+
+char* UringOutputSink::reserve_bytes(int n)
+{
+	if (!ring)
+		return fallback.reserve_write(n);
+
+	int start = current->data.size();
+	current->data.resize(start + n);
+	return current->data.empty() ? 0 : &current->data.front() + start;
+}
+
+void UringOutputSink::commit_bytes(int n)
+{
+	if (!ring)
+		fallback.commit_write();
+}
+
+void UringOutputSink::close_file()
+{
+	if (!ring)
+	{
+		fallback.close();
+		return;
+	}
+
+	// files in a batch are written concurrently: a rewrite of a file
+	// already in the batch has to wait for the next one
+	if (batchnames.count(current->filename))
+		submit_batch();
+
+	batch.push_back(current);
+	batchnames.insert(current->filename);
+	batchbytes += current->data.size();
+	current = 0;
+
+	if (batch.size() >= UringConsts::batch_files
+		|| batchbytes >= UringConsts::batch_bytes)
+		submit_batch();
+}
+
+void UringOutputSink::flush()
+{
+	submit_batch();
+}
+
+void UringOutputSink::submit_batch()
+{
+	if (batch.empty())
+		return;
+
+	std::vector<PendingFile*> files;
+	files.swap(batch);
+	batchnames.clear();
+	batchbytes = 0;
+
+#ifdef HAVE_IO_URING
+	// queue openat -> write -> close for each file, with the file in
+	// direct descriptor slot i; the write is hard-linked to the close
+	// so the slot is released even if the write falls short
+	unsigned tail = *ring->sqtail;
+	for (size_t i = 0; i < files.size(); i++)
+	{
+		io_uring_sqe* sqe = get_sqe(ring, tail);
+		sqe->opcode = IORING_OP_OPENAT;
+		sqe->fd = AT_FDCWD;
+		sqe->addr = (unsigned long)files[i]->filename.c_str();
+		sqe->len = 0644;
+		sqe->open_flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+		sqe->file_index = i + 1;
+		sqe->flags = IOSQE_IO_LINK;
+		sqe->user_data = i * 3;
+
+		sqe = get_sqe(ring, tail);
+		sqe->opcode = IORING_OP_WRITE;
+		sqe->fd = i;
+		sqe->addr = (unsigned long)(files[i]->data.empty() ? 0 : &files[i]->data.front());
+		sqe->len = files[i]->data.size();
+		sqe->off = 0;
+		sqe->flags = IOSQE_FIXED_FILE | IOSQE_IO_HARDLINK;
+		sqe->user_data = i * 3 + 1;
+
+		sqe = get_sqe(ring, tail);
+		sqe->opcode = IORING_OP_CLOSE;
+		sqe->file_index = i + 1;
+		sqe->user_data = i * 3 + 2;
+	}
+	__atomic_store_n(ring->sqtail, tail, __ATOMIC_RELEASE);
+
+	// submit everything and reap completions until all have arrived
+	std::vector<bool> openfailed(files.size(), false);
+	std::vector<bool> writeshort(files.size(), false);
+	int tosubmit = files.size() * 3;
+	int pending = tosubmit;
+	bool ringfailed = false;
+	while (pending > 0)
+	{
+		int ret = syscall(__NR_io_uring_enter, ring->fd, tosubmit, 1,
+			IORING_ENTER_GETEVENTS, 0, 0);
+		if (ret < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			ringfailed = true;
+			break;
+		}
+		tosubmit -= ret;
+
+		unsigned head = *ring->cqhead;
+		unsigned cqtail = __atomic_load_n(ring->cqtail, __ATOMIC_ACQUIRE);
+		while (head != cqtail)
+		{
+			io_uring_cqe* cqe = &ring->cqes[head & *ring->cqmask];
+			int i = cqe->user_data / 3;
+			int op = cqe->user_data % 3;
+			if (op == 0 && cqe->res < 0)
+				openfailed[i] = true;
+			else if (op == 1 && cqe->res != (int)files[i]->data.size())
+				writeshort[i] = true;
+			++head;
+			--pending;
+		}
+		__atomic_store_n(ring->cqhead, head, __ATOMIC_RELEASE);
+	}
+
+	// redo anything io_uring didn't finish with plain writes; an open
+	// failure is retried too, so it's reported the usual way
+	std::string errfile;
+	for (size_t i = 0; i < files.size(); i++)
+	{
+		if (ringfailed || openfailed[i] || writeshort[i])
+		{
+			try
+			{
+				fallback.write_file(files[i]->filename,
+					files[i]->data.empty() ? 0 : &files[i]->data.front(),
+					files[i]->data.size());
+			}
+			catch (DefaultException&)
+			{
+				if (errfile.empty())
+					errfile = files[i]->filename;
+			}
+		}
+		delete files[i];
+	}
+
+	// the ring can't be trusted after a failed enter
+	if (ringfailed)
+	{
+		close_ring(ring);
+		ring = 0;
+	}
+	if (!errfile.empty())
+		throw(DefaultException("error writing to file " + errfile));
+#endif
+}
+
+
+};	// end namespace RipUtil
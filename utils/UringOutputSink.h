@@ -0,0 +1,74 @@
+/* Output sink that writes plain files through Linux io_uring.
+   Completed files are collected into batches, and the open, write and
+   close of every file in a batch go to the kernel in one submission,
+   instead of three system calls per file. Where io_uring isn't
+   available (other platforms, old kernels, disabled by policy) it
+   falls back to writing each file with a FileOutputSink */
+
+#include "OutputSink.h"
+#include <string>
+#include <vector>
+#include <set>
+
+namespace RipUtil
+{
+
+
+namespace UringConsts
+{
+	// submit a batch once it holds this many files...
+	const static int batch_files = 64;
+	// ...or this many bytes
+	const static int batch_bytes = 8 * 1024 * 1024;
+	// submission queue size: an open, write and close per file
+	const static int ring_entries = 256;
+};
+
+// kernel ring state; only defined where io_uring is available
+struct UringRing;
+
+class UringOutputSink : public OutputSink
+{
+public:
+	UringOutputSink();
+	~UringOutputSink();
+
+	// submit the pending batch and wait for it to complete
+	void flush();
+	void sync() { flush(); }
+
+	// false if io_uring couldn't be set up and files are written
+	// through the fallback sink
+	bool using_uring() const { return ring != 0; }
+
+protected:
+	void open_file(const std::string& filename, long long size);
+	void write_bytes(const char* data, int n);
+	void close_file();
+	// reserved space is filled directly in the file's buffer
+	char* reserve_bytes(int n);
+	void commit_bytes(int n);
+
+private:
+	// a completed file waiting for its batch to be submitted
+	struct PendingFile
+	{
+		std::string filename;
+		std::vector<char> data;
+	};
+
+	void submit_batch();
+
+	UringRing* ring;
+	FileOutputSink fallback;
+
+	std::vector<PendingFile*> batch;
+	std::set<std::string> batchnames;
+	long long batchbytes;
+	PendingFile* current;	// file being collected
+};
+
+
+};	// end namespace RipUtil
+
+#pragma once
@@ -0,0 +1,154 @@
+#include "WorkShardOutputSink.h"
+#include <algorithm>
+
+namespace RipUtil
+{
+
+
+// mix the bits of key, so that neighbouring offsets spread evenly
+// over the shards (the same on every platform)
+static unsigned long long mix_key(unsigned long long key)
+{
+	key ^= key >> 33;
+	key *= 0xff51afd7ed558ccdULL;
+	key ^= key >> 33;
+	key *= 0xc4ceb9fe1a85ec53ULL;
+	key ^= key >> 33;
+	return key;
+}
+
+WorkShardOutputSink::WorkShardOutputSink(OutputSink& target, int shard, int shards,
+	const std::string& inputname)
+	: target(target), shard(shard), shards(shards < 1 ? 1 : shards),
+	inputowned(false), inunit(false), unitowned(false), unitpassed(false),
+	inasset(false), assetowned(false), filepassed(false), numskipped(0)
+{
+	// FNV-1a of the name
+	unsigned long long namekey = 0xcbf29ce484222325ULL;
+	for (std::string::size_type i = 0; i < inputname.size(); i++)
+	{
+		namekey ^= (unsigned char)inputname[i];
+		namekey *= 0x100000001b3ULL;
+	}
+	inputowned = owns(namekey);
+}
+
+bool WorkShardOutputSink::owns(unsigned long long key) const
+{
+	return (int)(mix_key(key) % shards) == shard;
+}
+
+bool WorkShardOutputSink::writing() const
+{
+	if (inasset)
+		return assetowned;
+	if (inunit)
+		return unitowned;
+	return inputowned;
+}
+
+bool WorkShardOutputSink::begin_asset(int offset)
+{
+	end_asset();
+	inasset = true;
+	// the assets of a unit go with it
+	assetowned = inunit ? unitowned : owns(offset);
+	if (!assetowned)
+	{
+		if (!inunit)
+			++numskipped;
+		return false;
+	}
+	return target.begin_asset(offset);
+}
+
+void WorkShardOutputSink::end_asset()
+{
+	if (inasset && assetowned)
+		target.end_asset();
+	inasset = false;
+}
+
+bool WorkShardOutputSink::begin_unit(int offset, std::string& state)
+{
+	end_asset();
+	inunit = true;
+	unitowned = owns(offset);
+	unitpassed = false;
+	if (!unitowned)
+		++numskipped;
+	if (!unitowned && !inputowned)
+	{
+		state = "";
+		inunit = false;
+		return false;
+	}
+	unitpassed = true;
+	if (!target.begin_unit(offset, state))
+	{
+		inunit = false;
+		unitpassed = false;
+		return false;
+	}
+	return true;
+}
+
+void WorkShardOutputSink::end_unit(const std::string& state)
+{
+	end_asset();
+	if (inunit && unitpassed)
+		target.end_unit(state);
+	inunit = false;
+	unitpassed = false;
+}
+
+void WorkShardOutputSink::open_file(const std::string& filename, long long size)
+{
+	filepassed = writing();
+	if (filepassed)
+		target.open(filename, size);
+}
+
+void WorkShardOutputSink::write_bytes(const char* data, int n)
+{
+	if (filepassed)
+		target.write(data, n);
+}
+
+void WorkShardOutputSink::close_file()
+{
+	if (filepassed)
+		target.close();
+	filepassed = false;
+}
+
+int WorkShardOutputSink::copy_from_stream(MembufStream& stream, int n)
+{
+	if (filepassed)
+	{
+		long long before = target.get_file_size();
+		target.write_from(stream, n);
+		return target.get_file_size() - before;
+	}
+	// still move past the data, as a write would
+	int left = stream.get_fsize() - stream.tellg();
+	n = std::max(0, std::min(n, left));
+	stream.seek_off(n);
+	return n;
+}
+
+char* WorkShardOutputSink::reserve_bytes(int n)
+{
+	if (filepassed)
+		return target.reserve_write(n);
+	return OutputSink::reserve_bytes(n);
+}
+
+void WorkShardOutputSink::commit_bytes(int n)
+{
+	if (filepassed)
+		target.commit_write();
+}
+
+
+};	// end namespace RipUtil
@@ -0,0 +1,70 @@
+/* Output sink for splitting one rip across several processes (or
+   machines): of n shards, this one keeps only its own share of the
+   units (rooms, objects...) and assets the module marks, and passes
+   their output on to another sink. Units and assets are given out by
+   a hash of their offset in the input, and the output that belongs to
+   no unit or asset (strings, transcripts, metadata...) by a hash of
+   the input's name, so the same files go to the same shard on every
+   run and every machine, and the n shards' output together is that of
+   a single run.
+   Units that aren't ours are skipped, except by the shard that writes
+   the input's own output, which still walks them (skipping all their
+   assets) for what that output collects from every unit */
+
+#include "OutputSink.h"
+#include <string>
+
+namespace RipUtil
+{
+
+
+class WorkShardOutputSink : public OutputSink
+{
+public:
+	// shard is this process's number, from 0 to shards - 1;
+	// inputname is the input's name without its path
+	WorkShardOutputSink(OutputSink& target, int shard, int shards,
+		const std::string& inputname);
+
+	bool begin_asset(int offset);
+	void end_asset();
+	bool begin_unit(int offset, std::string& state);
+	void end_unit(const std::string& state);
+	void flush() { target.flush(); }
+	void sync() { target.sync(); }
+
+	int get_num_skipped() const { return numskipped; }
+
+protected:
+	void open_file(const std::string& filename, long long size);
+	void write_bytes(const char* data, int n);
+	void close_file();
+	int copy_from_stream(MembufStream& stream, int n);
+	char* reserve_bytes(int n);
+	void commit_bytes(int n);
+
+private:
+	// is the unit or asset at offset ours?
+	bool owns(unsigned long long key) const;
+	// does output written now belong to this shard?
+	bool writing() const;
+
+	OutputSink& target;
+	int shard;
+	int shards;
+	bool inputowned;	// the input's own output is ours
+
+	bool inunit;
+	bool unitowned;
+	bool unitpassed;	// begin_unit() was passed to the target
+	bool inasset;
+	bool assetowned;
+	bool filepassed;	// the open file is going to the target
+
+	int numskipped;		// units and assets left to other shards
+};
+
+
+};	// end namespace RipUtil
+
+#pragma once
@@ -0,0 +1,90 @@
+#include "WorkerThreads.h"
+#include "DefaultException.h"
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <string>
+
+namespace RipUtil
+{
+
+
+static int worker_threads = 0;
+
+void set_worker_threads(int n)
+{
+	worker_threads = (n < 0) ? 0 : n;
+}
+
+int get_worker_threads()
+{
+	if (worker_threads > 0)
+		return worker_threads;
+	int hwthreads = std::thread::hardware_concurrency();
+	return (hwthreads > 0) ? hwthreads : 1;
+}
+
+// shared state for one run_parallel call
+struct ParallelJobs
+{
+	void (*func)(void*, int);
+	void* context;
+	int numjobs;
+	std::atomic<int> nextjob;
+	std::mutex errlock;
+	bool failed;
+	std::string errmess;
+};
+
+static void run_parallel_worker(ParallelJobs* jobs)
+{
+	int i;
+	while ((i = jobs->nextjob++) < jobs->numjobs)
+	{
+		try
+		{
+			jobs->func(jobs->context, i);
+		}
+		catch (DefaultException& e)
+		{
+			std::lock_guard<std::mutex> lock(jobs->errlock);
+			if (!jobs->failed)
+				jobs->errmess = e.what();
+			jobs->failed = true;
+		}
+		catch (std::exception& e)
+		{
+			std::lock_guard<std::mutex> lock(jobs->errlock);
+			if (!jobs->failed)
+				jobs->errmess = e.what();
+			jobs->failed = true;
+		}
+	}
+}
+
+void run_parallel(void (*func)(void*, int), void* context, int numjobs)
+{
+	ParallelJobs jobs;
+	jobs.func = func;
+	jobs.context = context;
+	jobs.numjobs = numjobs;
+	jobs.nextjob = 0;
+	jobs.failed = false;
+
+	// the calling thread works too
+	int numthreads = std::min(get_worker_threads(), numjobs) - 1;
+	std::vector<std::thread> threads;
+	for (int i = 0; i < numthreads; i++)
+		threads.push_back(std::thread(run_parallel_worker, &jobs));
+	run_parallel_worker(&jobs);
+	for (size_t i = 0; i < threads.size(); i++)
+		threads[i].join();
+
+	if (jobs.failed)
+		throw(DefaultException(jobs.errmess));
+}
+
+
+};	// end namespace RipUtil
@@ -0,0 +1,24 @@
+/* Helper for spreading independent jobs (blocks of audio, bands of
+   an image, etc.) across a number of worker threads */
+
+namespace RipUtil
+{
+
+
+// set number of threads used by run_parallel
+// 0 = number of hardware threads
+void set_worker_threads(int n);
+
+// get number of threads used by run_parallel
+int get_worker_threads();
+
+// call func(context, i) for each i in [0, numjobs), spreading the calls
+// over the worker threads, and return once all of them have completed.
+// if any call throws, the first error is rethrown as a DefaultException
+// after all threads have finished
+void run_parallel(void (*func)(void*, int), void* context, int numjobs);
+
+
+};	// end namespace RipUtil
+
+#pragma once
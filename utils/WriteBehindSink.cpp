@@ -0,0 +1,188 @@
+#include "WriteBehindSink.h"
+#include "DefaultException.h"
+#include <exception>
+
+namespace RipUtil
+{
+
+
+WriteBehindSink::WriteBehindSink(int numthreads, long long maxqueued)
+	: ownstargets(true), maxqueued(maxqueued), queuedbytes(0), pending(0),
+	stopping(false), failed(false), current(0)
+{
+	if (numthreads < 1)
+		numthreads = 1;
+	for (int i = 0; i < numthreads; i++)
+		targets.push_back(new FileOutputSink);
+	start_threads();
+}
+
+WriteBehindSink::WriteBehindSink(OutputSink& target, long long maxqueued)
+	: ownstargets(false), maxqueued(maxqueued), queuedbytes(0), pending(0),
+	stopping(false), failed(false), current(0)
+{
+	targets.push_back(&target);
+	start_threads();
+}
+
+WriteBehindSink::~WriteBehindSink()
+{
+	{
+		std::lock_guard<std::mutex> lk(lock);
+		stopping = true;
+	}
+	filequeued.notify_all();
+	for (size_t i = 0; i < threads.size(); i++)
+		threads[i].join();
+
+	// anything left over was abandoned by an error
+	for (size_t i = 0; i < queues.size(); i++)
+	{
+		for (size_t j = 0; j < queues[i].size(); j++)
+			delete queues[i][j];
+	}
+	delete current;
+	if (ownstargets)
+	{
+		for (size_t i = 0; i < targets.size(); i++)
+			delete targets[i];
+	}
+}
+
+void WriteBehindSink::start_threads()
+{
+	queues.resize(targets.size());
+	for (size_t i = 0; i < targets.size(); i++)
+		threads.push_back(std::thread(io_thread, this, i));
+}
+
+void WriteBehindSink::io_thread(WriteBehindSink* wbs, int i)
+{
+	std::unique_lock<std::mutex> lk(wbs->lock);
+	std::deque<PendingFile*>& queue = wbs->queues[i];
+	while (true)
+	{
+		while (!wbs->stopping && queue.empty())
+			wbs->filequeued.wait(lk);
+		if (queue.empty())
+			return;
+
+		PendingFile* file = queue.front();
+		queue.pop_front();
+		int size = file->data.size();
+		lk.unlock();
+
+		std::string err;
+		try
+		{
+			wbs->targets[i]->write_file(file->filename,
+				size ? &file->data.front() : 0, size);
+		}
+		catch (DefaultException& e)
+		{
+			err = e.what();
+		}
+		catch (std::exception& e)
+		{
+			err = e.what();
+		}
+		delete file;
+
+		lk.lock();
+		if (!err.empty() && !wbs->failed)
+		{
+			wbs->failed = true;
+			wbs->errmess = err;
+		}
+		wbs->queuedbytes -= size;
+		--(wbs->pending);
+		wbs->filewritten.notify_all();
+	}
+}
+
+void WriteBehindSink::throw_if_failed()
+{
+	if (failed)
+		throw(DefaultException(errmess));
+}
+
+void WriteBehindSink::open_file(const std::string& filename, long long size)
+{
+	// a writer may have thrown before closing its last file
+	delete current;
+	current = new PendingFile;
+	current->filename = filename;
+	if (size > 0)
+		current->data.reserve(size);
+}
+
+void WriteBehindSink::write_bytes(const char* data, int n)
+{
+	current->data.insert(current->data.end(), data, data + n);
+}
+
+char* WriteBehindSink::reserve_bytes(int n)
+{
+	int start = current->data.size();
+	current->data.resize(start + n);
+	return current->data.empty() ? 0 : &current->data.front() + start;
+}
+
+void WriteBehindSink::commit_bytes(int n)
+{
+	// reserve_bytes() already put the bytes in the file's buffer
+}
+
+void WriteBehindSink::close_file()
+{
+	PendingFile* file = current;
+	current = 0;
+	long long size = file->data.size();
+
+	// files with the same name always go to the same thread
+	unsigned int hash = 0;
+	for (size_t i = 0; i < file->filename.length(); i++)
+		hash = hash * 31 + (unsigned char)file->filename[i];
+	int i = hash % queues.size();
+
+	std::unique_lock<std::mutex> lk(lock);
+	// backpressure: wait for room, unless the queue is empty
+	// (a single file larger than the limit must still get through)
+	while (!failed && queuedbytes > 0 && queuedbytes + size > maxqueued)
+		filewritten.wait(lk);
+	if (failed)
+	{
+		delete file;
+		throw_if_failed();
+	}
+	queues[i].push_back(file);
+	queuedbytes += size;
+	++pending;
+	lk.unlock();
+	filequeued.notify_all();
+}
+
+void WriteBehindSink::flush()
+{
+	wait_written();
+	for (size_t i = 0; i < targets.size(); i++)
+		targets[i]->flush();
+}
+
+void WriteBehindSink::sync()
+{
+	wait_written();
+	for (size_t i = 0; i < targets.size(); i++)
+		targets[i]->sync();
+}
+
+void WriteBehindSink::wait_written()
+{
+	std::unique_lock<std::mutex> lk(lock);
+	while (pending > 0)
+		filewritten.wait(lk);
+	throw_if_failed();
+}
+
+
+};	// end namespace RipUtil
@@ -0,0 +1,90 @@
+/* Output sink that hands completed files to background I/O threads,
+   so ripping and encoding continue while earlier files are written.
+   Each file is collected in its own buffer, which the queue takes
+   ownership of on close(); close() blocks while more than a given
+   number of bytes are waiting to be written */
+
+#include "OutputSink.h"
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace RipUtil
+{
+
+
+namespace WriteBehindConsts
+{
+	// default limit on bytes waiting in the queue
+	const static long long default_max_queued = 64 * 1024 * 1024;
+};
+
+class WriteBehindSink : public OutputSink
+{
+public:
+	// write plain files using numthreads I/O threads
+	WriteBehindSink(int numthreads,
+		long long maxqueued = WriteBehindConsts::default_max_queued);
+	// write to target (e.g. an archive) from a single I/O thread,
+	// in the order files were closed
+	WriteBehindSink(OutputSink& target,
+		long long maxqueued = WriteBehindConsts::default_max_queued);
+	~WriteBehindSink();
+
+	// wait until every queued file has been written, then flush the
+	// target sink(s); rethrows the first error from an I/O thread
+	void flush();
+	// wait until every queued file has been written, then sync the
+	// target sink(s)
+	void sync();
+
+protected:
+	void open_file(const std::string& filename, long long size);
+	void write_bytes(const char* data, int n);
+	void close_file();
+	// reserved space is filled directly in the file's buffer
+	char* reserve_bytes(int n);
+	void commit_bytes(int n);
+
+private:
+	// a completed file waiting to be written
+	struct PendingFile
+	{
+		std::string filename;
+		std::vector<char> data;
+	};
+
+	void start_threads();
+	static void io_thread(WriteBehindSink* wbs, int i);
+	void throw_if_failed();
+	// wait until every queued file has been written; rethrows the
+	// first error from an I/O thread
+	void wait_written();
+
+	// one target sink and queue per I/O thread; files go to a queue
+	// chosen by name, so rewrites of the same file stay in order
+	std::vector<OutputSink*> targets;
+	std::vector<std::deque<PendingFile*> > queues;
+	std::vector<std::thread> threads;
+	bool ownstargets;
+
+	std::mutex lock;
+	std::condition_variable filequeued;
+	std::condition_variable filewritten;
+	long long maxqueued;
+	long long queuedbytes;
+	int pending;			// files queued or being written
+	bool stopping;
+	bool failed;
+	std::string errmess;
+
+	PendingFile* current;	// file being collected
+};
+
+
+};	// end namespace RipUtil
+
+#pragma once